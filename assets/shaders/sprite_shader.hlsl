@@ -6,6 +6,8 @@ cbuffer VsConstantBuffer : register(b0) {
 
 cbuffer VsSpriteInfoBuffer : register(b1) {
 	float4x4 transform;
+	// Offset and size of the sprite on its texture, which may be an atlas page
+	float4 uvRect;
 }
 
 struct VertexInput {
@@ -21,7 +23,7 @@ struct PixelInput {
 PixelInput vertex(VertexInput input) {
 	PixelInput output;
 	output.position = mul(projection, mul(transform, input.position));
-	output.textureCoord = input.textureCoord;
+	output.textureCoord = uvRect.xy + input.textureCoord * uvRect.zw;
 	return output;
 }
 
@@ -1,3 +1,9 @@
+cbuffer PsConstantBuffer : register(b0) {
+	float4x4 projection;
+	// Fraction of the screen the scene is drawn to
+	float2 renderScale;
+}
+
 struct VertexInput {
 	float4 position : POSITION;
 };
@@ -41,7 +47,7 @@ float star(float2 uv, float flare) {
 }
 
 float4 pixel(PixelInput input) : SV_TARGET {
-	float2 uv = (input.position.xy - float2(1920.0f, 1080.0f) * 0.5f) / 1080.0f;
+	float2 uv = (input.position.xy / renderScale - float2(1920.0f, 1080.0f) * 0.5f) / 1080.0f;
 	uv *= 50.0f;
 
 	float3 color = float3(0.0f, 0.0f, 0.0f);
@@ -0,0 +1,40 @@
+Texture2D scene : register(t0);
+
+cbuffer PsConstantBuffer : register(b0) {
+	float4x4 projection;
+	// Fraction of the scene texture that was drawn to
+	float2 renderScale;
+}
+
+struct VertexInput {
+	float4 position : POSITION;
+};
+
+struct PixelInput {
+	float4 position : SV_POSITION;
+	float2 textureCoord : TEXCOORD;
+};
+
+PixelInput vertex(VertexInput input) {
+	PixelInput output;
+	output.position = input.position;
+	output.textureCoord = float2(input.position.x * 0.5f + 0.5f, 0.5f - input.position.y * 0.5f) * renderScale;
+	return output;
+}
+
+SamplerState sceneSampler {
+	Filter = MIN_MAG_MIP_LINEAR;
+	AddressU = CLAMP;
+	AddressV = CLAMP;
+};
+
+float4 pixel(PixelInput input) : SV_TARGET {
+	// Stop the filtering pulling in texels from outside what was drawn
+	float width;
+	float height;
+	scene.GetDimensions(width, height);
+	float2 textureCoord = min(input.textureCoord, renderScale - 0.5f / float2(width, height));
+
+	// Blending leaves the sprites' alpha in the scene, it's opaque by now
+	return float4(scene.Sample(sceneSampler, textureCoord).rgb, 1.0f);
+}
\ No newline at end of file
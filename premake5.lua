@@ -30,4 +30,222 @@ project 'SBDS'
 
   filter 'system:Windows'
     defines { 'WIN32', 'UNICODE' }
-    links { 'user32', 'gdi32', 'd3d11', 'd3dcompiler', 'd2d1', 'dwrite', 'dxgi', 'Xaudio2', 'ole32' }
\ No newline at end of file
+    links { 'user32', 'gdi32', 'd3d11', 'd3dcompiler', 'd2d1', 'dwrite', 'dxgi', 'Xaudio2', 'ole32' }
+
+-- Compiles the text ship templates into the binary cache the game loads,
+-- see tools/template_compiler/main.cpp
+filter {}
+
+project 'TemplateCompiler'
+  kind 'ConsoleApp'
+  language 'C++'
+  cppdialect 'C++17'
+  files { 'tools/template_compiler/main.cpp' }
+  defines { 'ASSET_PATH="./assets/"' }
+
+  filter 'configurations:Release'
+    defines { 'NDEBUG' }
+    optimize 'On'
+
+  filter 'configurations:Debug'
+    symbols 'On'
+
+  filter 'platforms:Win64'
+    architecture 'x86_64'
+-- Runs headless battles for balancing and benchmarking the combat code, see
+-- tools/combat_sim/main.cpp
+filter {}
+
+project 'CombatSim'
+  kind 'ConsoleApp'
+  language 'C++'
+  cppdialect 'C++17'
+  files { 'tools/combat_sim/main.cpp' }
+  defines { 'ASSET_PATH="./assets/"', 'PROFILER_DISABLED' }
+
+  filter 'configurations:Release'
+    defines { 'NDEBUG' }
+    optimize 'On'
+
+  filter 'configurations:Debug'
+    symbols 'On'
+
+  filter 'platforms:Win64'
+    architecture 'x86_64'
+-- Measures how much the render thread overlaps the game thread, see
+-- tools/render_pipeline/main.cpp
+filter {}
+
+project 'RenderPipeline'
+  kind 'ConsoleApp'
+  language 'C++'
+  cppdialect 'C++17'
+  files { 'tools/render_pipeline/main.cpp' }
+  defines { 'ASSET_PATH="./assets/"' }
+
+  filter 'configurations:Release'
+    defines { 'NDEBUG' }
+    optimize 'On'
+
+  filter 'configurations:Debug'
+    symbols 'On'
+
+  filter 'platforms:Win64'
+    architecture 'x86_64'
+-- Draws a test scene with the software renderer for image diffs and
+-- benchmarks, see tools/software_renderer/main.cpp
+filter {}
+
+project 'SoftwareRenderer'
+  kind 'ConsoleApp'
+  language 'C++'
+  cppdialect 'C++17'
+  files { 'tools/software_renderer/main.cpp' }
+  defines { 'ASSET_PATH="./assets/"' }
+
+  filter 'configurations:Release'
+    defines { 'NDEBUG' }
+    optimize 'On'
+
+  filter 'configurations:Debug'
+    symbols 'On'
+
+  filter 'platforms:Win64'
+    architecture 'x86_64'
+-- Runs the render scale controller against a simulated GPU load, see
+-- tools/render_scale/main.cpp
+filter {}
+
+project 'RenderScale'
+  kind 'ConsoleApp'
+  language 'C++'
+  cppdialect 'C++17'
+  files { 'tools/render_scale/main.cpp' }
+
+  filter 'configurations:Release'
+    defines { 'NDEBUG' }
+    optimize 'On'
+
+  filter 'configurations:Debug'
+    symbols 'On'
+
+  filter 'platforms:Win64'
+    architecture 'x86_64'
+-- Packs sprite images into atlas pages and writes the manifest the sprite
+-- loader reads, see tools/atlas_packer/main.cpp
+filter {}
+
+project 'AtlasPacker'
+  kind 'ConsoleApp'
+  language 'C++'
+  cppdialect 'C++17'
+  files { 'tools/atlas_packer/main.cpp' }
+  defines { 'ASSET_PATH="./assets/"' }
+
+  filter 'configurations:Release'
+    defines { 'NDEBUG' }
+    optimize 'On'
+
+  filter 'configurations:Debug'
+    symbols 'On'
+
+  filter 'platforms:Win64'
+    architecture 'x86_64'
+-- Compresses textures to BC1/BC3/BC7 with mips for the sprite loader, see
+-- tools/texture_compressor/main.cpp
+filter {}
+
+project 'TextureCompressor'
+  kind 'ConsoleApp'
+  language 'C++'
+  cppdialect 'C++17'
+  files { 'tools/texture_compressor/main.cpp' }
+  defines { 'ASSET_PATH="./assets/"' }
+
+  filter 'configurations:Release'
+    defines { 'NDEBUG' }
+    optimize 'On'
+
+  filter 'configurations:Debug'
+    symbols 'On'
+
+  filter 'platforms:Win64'
+    architecture 'x86_64'
+-- Times finding the samples in thousands of WAVs with the RIFF parser against
+-- the old seek and read per chunk, see tools/wav_bench/main.cpp
+filter {}
+
+project 'WavBench'
+  kind 'ConsoleApp'
+  language 'C++'
+  cppdialect 'C++17'
+  files { 'tools/wav_bench/main.cpp' }
+
+  filter 'configurations:Release'
+    defines { 'NDEBUG' }
+    optimize 'On'
+
+  filter 'configurations:Debug'
+    symbols 'On'
+
+  filter 'platforms:Win64'
+    architecture 'x86_64'
+-- Compresses sound effects and music to .bsnd files that are streamed and
+-- decoded ahead in their place, see tools/audio_encoder/main.cpp
+filter {}
+
+project 'AudioEncoder'
+  kind 'ConsoleApp'
+  language 'C++'
+  cppdialect 'C++17'
+  files { 'tools/audio_encoder/main.cpp' }
+  defines { 'ASSET_PATH="./assets/"' }
+
+  filter 'configurations:Release'
+    defines { 'NDEBUG' }
+    optimize 'On'
+
+  filter 'configurations:Debug'
+    symbols 'On'
+
+  filter 'platforms:Win64'
+    architecture 'x86_64'
+-- Times the vector and matrix types against the ones they replaced, see
+-- tools/math_bench/main.cpp
+filter {}
+
+project 'MathBench'
+  kind 'ConsoleApp'
+  language 'C++'
+  cppdialect 'C++17'
+  files { 'tools/math_bench/main.cpp' }
+
+  filter 'configurations:Release'
+    defines { 'NDEBUG' }
+    optimize 'On'
+
+  filter 'configurations:Debug'
+    symbols 'On'
+
+  filter 'platforms:Win64'
+    architecture 'x86_64'
+-- Draws the package menu's text with the glyph atlas and reports how often
+-- the text run cache is hit, see tools/text_bench/main.cpp
+filter {}
+
+project 'TextBench'
+  kind 'ConsoleApp'
+  language 'C++'
+  cppdialect 'C++17'
+  files { 'tools/text_bench/main.cpp' }
+  defines { 'ASSET_PATH="./assets/"' }
+
+  filter 'configurations:Release'
+    defines { 'NDEBUG' }
+    optimize 'On'
+
+  filter 'configurations:Debug'
+    symbols 'On'
+
+  filter 'platforms:Win64'
+    architecture 'x86_64'
\ No newline at end of file
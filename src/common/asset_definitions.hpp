@@ -26,13 +26,22 @@ const wchar_t *textureNames[] = {
 	_TextureAssetFileNames::marketPlace1
 };
 
+// Used to refer to textures by name in data files
+const char *textureAssetNames[] = {
+	"ship",
+	"enemyShip",
+	"background",
+	"marketPlace1"
+};
+
 enum class SoundAssetId : u8 {
 	left,
 	right,
 	stereo,
 	doomDeath,
 	cha_ching,
-	wahoo
+	wahoo,
+	_length
 };
 
 namespace _SoundAssetFileNames {
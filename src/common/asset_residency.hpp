@@ -0,0 +1,176 @@
+#pragma once
+
+#include "types/core.hpp"
+
+struct AssetResidencyStats {
+	u64 residentBytes;
+	u64 peakBytes;
+	u32 loads;
+	u32 evictions;
+};
+
+// Keeps track of which assets are loaded and what they cost, and decides what
+// to load ahead of time and what to free to stay under a budget. It doesn't
+// load anything itself, the owner of the assets does and reports back.
+//
+// Nothing used this frame is ever evicted. After that, assets that aren't
+// wanted at all go first, least recently used first, and then the least
+// wanted of the ones that are.
+//
+// Example:
+//
+//     AssetResidency<TextureAssetId> residency;
+//     residency.budget = 64 * MEGABYTE;
+//
+//     // Every frame
+//     residency.touch(sprite.assetId, frame);
+//     TextureAssetId load;
+//     TextureAssetId evictions[(size_t)TextureAssetId::_length];
+//     u32 evictionCount;
+//     if (residency.nextLoad(wanted, wantedCount, frame, &load, evictions, &evictionCount)) {
+//         // Free `evictions`, calling `evicted` for each, then load `load`
+//         // and call `loaded` with its size
+//     }
+//
+// `Id` is an asset id enum ending in `_length`
+template<typename Id>
+struct AssetResidency {
+	static const size_t Count = (size_t)Id::_length;
+
+	struct Entry {
+		// Kept after eviction as a guess for the next time it's loaded
+		u64 bytes = 0;
+		u64 lastUsed = 0;
+		bool resident = false;
+	};
+
+	Entry entries[Count];
+	u64 budget = 0;
+	AssetResidencyStats stats = {};
+
+	void touch(Id id, u64 frame) {
+		this->entries[(size_t)id].lastUsed = frame;
+	}
+
+	void loaded(Id id, u64 bytes, u64 frame) {
+		Entry &entry = this->entries[(size_t)id];
+		if (entry.resident) {
+			this->stats.residentBytes -= entry.bytes;
+		}
+
+		entry.bytes = bytes;
+		entry.lastUsed = frame;
+		entry.resident = true;
+
+		this->stats.residentBytes += bytes;
+		this->stats.peakBytes = this->stats.residentBytes > this->stats.peakBytes ? this->stats.residentBytes : this->stats.peakBytes;
+		this->stats.loads++;
+	}
+
+	void evicted(Id id) {
+		Entry &entry = this->entries[(size_t)id];
+		if (!entry.resident) {
+			return;
+		}
+
+		entry.resident = false;
+		this->stats.residentBytes -= entry.bytes;
+		this->stats.evictions++;
+	}
+
+	bool isResident(Id id) const {
+		return this->entries[(size_t)id].resident;
+	}
+
+	// The most wanted asset that isn't loaded yet and what to free first to
+	// make room for it. False once everything wanted is loaded or the next one
+	// won't fit without freeing something more wanted.
+	bool nextLoad(const Id *wanted, u32 wantedCount, u64 frame, Id *load, Id *evictions, u32 *evictionCount) {
+		*evictionCount = 0;
+		for (u32 rank = 0; rank < wantedCount; rank++) {
+			const Id id = wanted[rank];
+			if (this->entries[(size_t)id].resident) {
+				continue;
+			}
+
+			*load = id;
+			return this->chooseEvictions(this->entries[(size_t)id].bytes, wanted, wantedCount, rank, frame, evictions, evictionCount);
+		}
+
+		return false;
+	}
+
+	// What to free to get back under budget after loading something that
+	// had to be loaded, which can leave it over. The first `requiredCount`
+	// wanted and whatever's used this frame stay even if that's not enough.
+	u32 trim(const Id *wanted, u32 wantedCount, u32 requiredCount, u64 frame, Id *evictions) {
+		u32 evictionCount = 0;
+		u64 freed = 0;
+		Id victim;
+		while (
+			this->stats.residentBytes - freed > this->budget &&
+			(victim = this->leastWanted(wanted, wantedCount, requiredCount, frame, evictions, evictionCount)) != Id::_length
+		) {
+			evictions[evictionCount++] = victim;
+			freed += this->entries[(size_t)victim].bytes;
+		}
+		return evictionCount;
+	}
+
+protected:
+	bool chooseEvictions(u64 bytes, const Id *wanted, u32 wantedCount, u32 rank, u64 frame, Id *evictions, u32 *evictionCount) {
+		u64 freed = 0;
+		while (this->stats.residentBytes + bytes - freed > this->budget) {
+			const Id victim = this->leastWanted(wanted, wantedCount, rank, frame, evictions, *evictionCount);
+			if (victim == Id::_length) {
+				*evictionCount = 0;
+				return false;
+			}
+
+			evictions[(*evictionCount)++] = victim;
+			freed += this->entries[(size_t)victim].bytes;
+		}
+		return true;
+	}
+
+	// Resident, not used this frame, not already chosen and not in the first
+	// `protectedCount` wanted, `_length` if there's nothing left
+	Id leastWanted(const Id *wanted, u32 wantedCount, u32 protectedCount, u64 frame, const Id *chosen, u32 chosenCount) const {
+		Id victim = Id::_length;
+		// Unwanted assets sort before every wanted one, by when they were last
+		// used, and wanted ones by how far down the list they are
+		u64 victimScore = ~0ull;
+
+		for (size_t i = 0; i < Count; i++) {
+			const Id id = (Id)i;
+			const Entry &entry = this->entries[i];
+			if (!entry.resident || entry.lastUsed == frame) {
+				continue;
+			}
+
+			bool skip = false;
+			for (u32 c = 0; c < chosenCount && !skip; c++) {
+				skip = chosen[c] == id;
+			}
+
+			u32 rank = wantedCount;
+			for (u32 w = 0; w < wantedCount; w++) {
+				if (wanted[w] == id) {
+					rank = w;
+					break;
+				}
+			}
+			if (skip || rank < protectedCount) {
+				continue;
+			}
+
+			const u64 score = rank == wantedCount ? entry.lastUsed : (1ull << 63) + (wantedCount - rank);
+			if (score < victimScore) {
+				victimScore = score;
+				victim = id;
+			}
+		}
+
+		return victim;
+	}
+};
\ No newline at end of file
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <cassert>
+
+#include "common/culling.hpp"
+#include "common/window_config.hpp"
+#include "types/core.hpp"
+#include "types/matrix.hpp"
+#include "types/simd.hpp"
+#include "types/vector.hpp"
+
+// Looks at `position` in game space, where the origin starts in the middle of
+// the screen and y is up, with `zoom` screen pixels to a game unit. The
+// view-projection and the world to screen terms are rebuilt whenever the
+// camera moves rather than every time a position is transformed.
+//
+// Example:
+//
+//     gameState->camera.zoomAt(gameState->input.mouse, 1.25f);
+//     const Vec2<f32> screenPosition = gameState->camera.worldToScreen(ship.position);
+//
+//     // Many positions at once, `stride` is the bytes from one to the next
+//     camera.worldToScreen(&targets.data[0].position, targets.length, sizeof(ShipTarget), screenPositions);
+//
+struct Camera {
+	Camera() {
+		this->rebuild();
+	}
+
+	void setViewport(f32 width, f32 height) {
+		assert(width > 0.0f && height > 0.0f);
+		this->viewportSize = Vec2<f32>(width, height);
+		this->rebuild();
+	}
+
+	void setPosition(const Vec2<f32> &position) {
+		this->position = position;
+		this->rebuild();
+	}
+
+	void setZoom(f32 zoom) {
+		assert(zoom > 0.0f);
+		this->zoom = zoom;
+		this->rebuild();
+	}
+
+	// Moves the view by a distance in screen pixels, so dragging by the mouse
+	// movement keeps the point under the cursor
+	void pan(const Vec2<f32> &screenDelta) {
+		this->position = this->position + Vec2<f32>(-screenDelta.x, screenDelta.y) * (1.0f / this->zoom);
+		this->rebuild();
+	}
+
+	// Scales the zoom by `factor` keeping whatever is under `screenPoint` in
+	// place, the result is clamped to `minZoom` and `maxZoom`
+	void zoomAt(const Vec2<f32> &screenPoint, f32 factor, f32 minZoom = 0.05f, f32 maxZoom = 20.0f) {
+		const Vec2<f32> anchor = this->screenToWorld(screenPoint);
+
+		f32 zoom = this->zoom * factor;
+		zoom = zoom < minZoom ? minZoom : zoom;
+		zoom = zoom > maxZoom ? maxZoom : zoom;
+		this->zoom = zoom;
+		this->rebuild();
+
+		// Shift so the anchor ends up back under the screen point
+		const Vec2<f32> moved = this->worldToScreen(Vec3<f32>(anchor.x, anchor.y));
+		this->pan(screenPoint - moved);
+	}
+
+	const Vec2<f32> &getPosition() const {
+		return this->position;
+	}
+
+	f32 getZoom() const {
+		return this->zoom;
+	}
+
+	// Game space to clip space, for the sprite shader
+	const Mat4 &getViewProjection() const {
+		return this->viewProjection;
+	}
+
+	Vec2<f32> worldToScreen(const Vec3<f32> &position) const {
+		return Vec2<f32>(
+			position.x * this->screenScale.x + this->screenOffset.x,
+			position.y * this->screenScale.y + this->screenOffset.y
+		);
+	}
+
+	void worldToScreen(const Vec3<f32> *positions, size_t count, size_t stride, Vec2<f32> *screenPositions) const {
+		const u8 *position = (const u8*)positions;
+		size_t i = 0;
+
+#ifdef USE_SSE
+		// Two positions a lane pair each
+		const __m128 scale = _mm_setr_ps(this->screenScale.x, this->screenScale.y, this->screenScale.x, this->screenScale.y);
+		const __m128 offset = _mm_setr_ps(this->screenOffset.x, this->screenOffset.y, this->screenOffset.x, this->screenOffset.y);
+		for (; i + 2 <= count; i += 2) {
+			__m128 xy = _mm_loadl_pi(_mm_setzero_ps(), (const __m64*)position);
+			xy = _mm_loadh_pi(xy, (const __m64*)(position + stride));
+			_mm_storeu_ps(&screenPositions[i].x, _mm_add_ps(_mm_mul_ps(xy, scale), offset));
+			position += stride * 2;
+		}
+#endif
+
+		for (; i < count; i++) {
+			screenPositions[i] = this->worldToScreen(*(const Vec3<f32>*)position);
+			position += stride;
+		}
+	}
+
+	void worldToScreen(const Vec3<f32> *positions, size_t count, Vec2<f32> *screenPositions) const {
+		this->worldToScreen(positions, count, sizeof(Vec3<f32>), screenPositions);
+	}
+
+	Vec2<f32> screenToWorld(const Vec2<f32> &screenPosition) const {
+		return Vec2<f32>(
+			(screenPosition.x - this->screenOffset.x) / this->screenScale.x,
+			(screenPosition.y - this->screenOffset.y) / this->screenScale.y
+		);
+	}
+
+	// What's on screen in game space, for culling sprites
+	CullBounds visibleBounds() const {
+		const Vec2<f32> halfSize = this->viewportSize * (0.5f / this->zoom);
+		return { this->position - halfSize, this->position + halfSize };
+	}
+
+protected:
+	Vec2<f32> position;
+	f32 zoom = 1.0f;
+	Vec2<f32> viewportSize = Vec2<f32>(screenWidth, screenHeight);
+
+	Mat4 viewProjection;
+	Vec2<f32> screenScale;
+	Vec2<f32> screenOffset;
+
+	void rebuild() {
+		const f32 x = 2.0f * this->zoom / this->viewportSize.x;
+		const f32 y = 2.0f * this->zoom / this->viewportSize.y;
+		this->viewProjection = Mat4(
+			Vec4(x, 0.0f, 0.0f, 0.0f),
+			Vec4(0.0f, y, 0.0f, 0.0f),
+			Vec4(0.0f, 0.0f, 1.0f, 0.0f),
+			Vec4(-this->position.x * x, -this->position.y * y, 0.0f, 1.0f)
+		);
+
+		// Screen space has the origin in the top left and y down
+		this->screenScale = Vec2<f32>(this->zoom, -this->zoom);
+		this->screenOffset = Vec2<f32>(
+			this->viewportSize.x * 0.5f - this->position.x * this->zoom,
+			this->viewportSize.y * 0.5f + this->position.y * this->zoom
+		);
+	}
+};
\ No newline at end of file
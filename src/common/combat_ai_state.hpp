@@ -0,0 +1,31 @@
+#pragma once
+
+#include "common/entity.hpp"
+#include "types/core.hpp"
+
+// Every AI ship makes a fresh decision at least this often, unless the
+// budget runs out first
+#define COMBAT_AI_DECISION_FRAMES 8
+#define COMBAT_AI_BUDGET_MS 0.5f
+
+// Attached to the ships the AI controls. Their weapons follow whatever the
+// ship last decided on.
+struct ShipAi {
+	Entity target = ENTITY_NONE;
+};
+
+struct CombatAiStats {
+	u32 decisions = 0;
+	// Ships that were due a decision but had to wait for the next frame
+	u32 deferred = 0;
+	u64 ticks = 0;
+};
+
+struct CombatAiState {
+	// Dense index into the `ShipAi` store of the next ship to decide
+	size_t cursor = 0;
+	// 0 removes the limit, e.g. when the results need to be deterministic
+	f32 budgetMilliseconds = COMBAT_AI_BUDGET_MS;
+	// Covers the latest update only
+	CombatAiStats stats;
+};
\ No newline at end of file
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <cassert>
+
+#include "common/combat_ai_state.hpp"
+#include "common/entity.hpp"
+#include "common/ship_target.hpp"
+#include "common/sprite.hpp"
+#include "common/weapon.hpp"
+#include "types/core.hpp"
+
+#define COMBAT_ENTITY_MAX 4096
+#define COMBAT_SHIP_MAX 512
+#define COMBAT_TARGET_MAX 1024
+#define COMBAT_WEAPON_MAX 1024
+
+enum class Faction : u8 {
+	ally,
+	enemy
+};
+
+struct CombatShip {
+	Faction faction;
+	// The ship is destroyed once it has no targets left
+	u32 targetCount = 0;
+	// Its targets and weapons, linked through `CombatEntities::nextChild`
+	Entity firstChild = ENTITY_NONE;
+};
+
+// Every ship, target and weapon in combat is an entity. Ships have a
+// `CombatShip` and the `Sprite` they're drawn with, while targets and weapons
+// point back at the ship that owns them so a ship can have as many of either
+// as it needs. Ships flown by the AI also have a `ShipAi`. Systems loop over
+// only the store they care about.
+//
+// Each ship also keeps a list of its targets and weapons so destroying it
+// costs as much as it has of them, not as many as there are in combat.
+struct CombatEntities {
+	EntityPool<COMBAT_ENTITY_MAX> entities;
+	ComponentStore<CombatShip, COMBAT_SHIP_MAX, COMBAT_ENTITY_MAX> ships;
+	ComponentStore<Sprite, COMBAT_SHIP_MAX, COMBAT_ENTITY_MAX> sprites;
+	ComponentStore<ShipTarget, COMBAT_TARGET_MAX, COMBAT_ENTITY_MAX> targets;
+	ComponentStore<Weapon, COMBAT_WEAPON_MAX, COMBAT_ENTITY_MAX> weapons;
+	ComponentStore<ShipAi, COMBAT_SHIP_MAX, COMBAT_ENTITY_MAX> ai;
+	// By entity index, the next target or weapon on the same ship
+	Entity nextChild[COMBAT_ENTITY_MAX];
+
+	Entity createShip(Faction faction, const Sprite &sprite) {
+		const Entity ship = this->entities.create();
+
+		CombatShip combatShip = {};
+		combatShip.faction = faction;
+		this->ships.add(ship, combatShip);
+		this->sprites.add(ship, sprite);
+
+		return ship;
+	}
+
+	Entity addTarget(Entity ship, ShipTarget target) {
+		CombatShip *combatShip = this->ships.get(ship);
+		assert(combatShip != nullptr);
+		combatShip->targetCount++;
+
+		const Entity entity = this->entities.create();
+		target.ship = ship;
+		this->targets.add(entity, target);
+		this->linkChild(combatShip, entity);
+		return entity;
+	}
+
+	Entity addWeapon(Entity ship, Weapon weapon) {
+		CombatShip *combatShip = this->ships.get(ship);
+		assert(combatShip != nullptr);
+
+		const Entity entity = this->entities.create();
+		weapon.ship = ship;
+		this->weapons.add(entity, weapon);
+		this->linkChild(combatShip, entity);
+		return entity;
+	}
+
+	// Returns whether that was the last of its ship's targets, false for a
+	// target that's already gone
+	bool destroyTarget(Entity target) {
+		const ShipTarget *targetComponent = this->targets.get(target);
+		if (targetComponent == nullptr) {
+			return false;
+		}
+
+		CombatShip *combatShip = this->ships.get(targetComponent->ship);
+		if (combatShip != nullptr) {
+			combatShip->targetCount--;
+			this->unlinkChild(combatShip, target);
+		}
+
+		this->targets.remove(target);
+		this->entities.destroy(target);
+		return combatShip != nullptr && combatShip->targetCount == 0;
+	}
+
+	// Takes the ship's weapons and targets with it
+	void destroyShip(Entity ship) {
+		const CombatShip *combatShip = this->ships.get(ship);
+		assert(combatShip != nullptr);
+
+		for (Entity child = combatShip->firstChild; child != ENTITY_NONE;) {
+			const Entity next = this->nextChild[entityIndex(child)];
+			if (this->weapons.has(child)) {
+				this->weapons.remove(child);
+			} else {
+				this->targets.remove(child);
+			}
+			this->entities.destroy(child);
+			child = next;
+		}
+
+		if (this->ai.has(ship)) {
+			this->ai.remove(ship);
+		}
+
+		this->ships.remove(ship);
+		this->sprites.remove(ship);
+		this->entities.destroy(ship);
+	}
+
+	// Faction of the ship owning a target or weapon
+	Faction factionOf(Entity ship) const {
+		const CombatShip *combatShip = this->ships.get(ship);
+		assert(combatShip != nullptr);
+		return combatShip->faction;
+	}
+
+	void clear() {
+		this->entities = {};
+		this->ships.clear();
+		this->sprites.clear();
+		this->targets.clear();
+		this->weapons.clear();
+		this->ai.clear();
+	}
+
+protected:
+	void linkChild(CombatShip *combatShip, Entity child) {
+		this->nextChild[entityIndex(child)] = combatShip->firstChild;
+		combatShip->firstChild = child;
+	}
+
+	// Walks only the ship's own list, a handful of entries
+	void unlinkChild(CombatShip *combatShip, Entity child) {
+		Entity *link = &combatShip->firstChild;
+		while (*link != child) {
+			assert(*link != ENTITY_NONE);
+			link = &this->nextChild[entityIndex(*link)];
+		}
+		*link = this->nextChild[entityIndex(child)];
+	}
+};
\ No newline at end of file
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstring>
+
+#include "types/core.hpp"
+#include "utils/audio_codec.hpp"
+
+#define COMPRESSED_AUDIO_MAGIC 0x4e534253 // "SBSN"
+// Bump whenever the layout changes so old files are rebuilt
+#define COMPRESSED_AUDIO_VERSION 1
+// Replaces the source sound's extension, mars.wav is compressed to mars.bsnd
+#define COMPRESSED_AUDIO_EXTENSION ".bsnd"
+
+// Followed by the blocks, every one AUDIO_BLOCK_FRAMES long but the last
+struct CompressedAudioHeader {
+	u32 magic;
+	u16 version;
+	u8 channels;
+	u8 padding;
+	u32 sampleRate;
+	u32 frameCount;
+	u32 dataSize;
+};
+
+// Hands back one decoded block at a time, from the start again after the end
+// if it's asked to
+struct CompressedAudioStream {
+	CompressedAudioHeader header;
+	const u8 *blocks;
+	u32 nextBlock;
+
+	bool isFinished() const {
+		return this->nextBlock * AUDIO_BLOCK_FRAMES >= this->header.frameCount;
+	}
+
+	// Decodes the next block into `out`, which needs room for
+	// AUDIO_BLOCK_FRAMES frames, and returns how many frames it was
+	u32 decodeNext(s16 *out) {
+		if (this->isFinished()) {
+			return 0;
+		}
+
+		const u32 start = this->nextBlock * AUDIO_BLOCK_FRAMES;
+		const u32 frames = this->header.frameCount - start < AUDIO_BLOCK_FRAMES ? this->header.frameCount - start : AUDIO_BLOCK_FRAMES;
+		const size_t offset = (size_t)this->nextBlock * AudioCodec::blockSize(this->header.channels, AUDIO_BLOCK_FRAMES);
+		AudioCodec::decodeBlock(this->blocks + offset, this->header.channels, frames, out);
+
+		this->nextBlock++;
+		return frames;
+	}
+
+	void rewind() {
+		this->nextBlock = 0;
+	}
+};
+
+namespace CompressedAudio {
+	size_t dataSize(u32 channels, u32 frameCount) {
+		const u32 fullBlocks = frameCount / AUDIO_BLOCK_FRAMES;
+		const u32 remainder = frameCount % AUDIO_BLOCK_FRAMES;
+		size_t size = (size_t)fullBlocks * AudioCodec::blockSize(channels, AUDIO_BLOCK_FRAMES);
+		if (remainder > 0) {
+			size += AudioCodec::blockSize(channels, remainder);
+		}
+		return size;
+	}
+
+	// Checks the header against the file's size, false for anything that
+	// should be rebuilt
+	bool readHeader(const u8 *data, size_t size, CompressedAudioHeader *header) {
+		if (size < sizeof(*header)) {
+			return false;
+		}
+		memcpy(header, data, sizeof(*header));
+
+		return
+			header->magic == COMPRESSED_AUDIO_MAGIC &&
+			header->version == COMPRESSED_AUDIO_VERSION &&
+			header->channels > 0 &&
+			header->channels <= AUDIO_CHANNEL_MAX &&
+			header->sampleRate > 0 &&
+			header->frameCount > 0 &&
+			header->dataSize == dataSize(header->channels, header->frameCount) &&
+			sizeof(*header) + header->dataSize == size;
+	}
+
+	// `data` has to outlive the stream
+	bool open(const u8 *data, size_t size, CompressedAudioStream *stream) {
+		*stream = {};
+		if (!readHeader(data, size, &stream->header)) {
+			return false;
+		}
+
+		stream->blocks = data + sizeof(stream->header);
+		return true;
+	}
+};
\ No newline at end of file
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstring>
+
+#include "types/core.hpp"
+#include "utils/block_compression.hpp"
+
+#define COMPRESSED_TEXTURE_MAGIC 0x58544253 // "SBTX"
+// Bump whenever the layout changes so old files are rebuilt
+#define COMPRESSED_TEXTURE_VERSION 1
+// Replaces the source image's extension, ship.png is compressed to ship.btex
+#define COMPRESSED_TEXTURE_EXTENSION ".btex"
+#define COMPRESSED_TEXTURE_MIP_MAX 14
+
+// Followed by every mip's blocks, largest first, ready to hand to the GPU
+struct CompressedTextureHeader {
+	u32 magic;
+	u16 version;
+	u8 format;
+	u8 mipCount;
+	// Rounded up to whole blocks, with the edges stretched to fill
+	u16 width;
+	u16 height;
+	// The size of the source image inside that
+	u16 imageWidth;
+	u16 imageHeight;
+	u32 dataSize;
+};
+
+namespace CompressedTexture {
+	u32 mipSize(u32 size, u32 level) {
+		return size >> level > 0 ? size >> level : 1;
+	}
+
+	// Down to 1x1
+	u32 fullMipCount(u32 width, u32 height) {
+		u32 count = 1;
+		while ((width >> count) > 0 || (height >> count) > 0) {
+			count++;
+		}
+		return count < COMPRESSED_TEXTURE_MIP_MAX ? count : COMPRESSED_TEXTURE_MIP_MAX;
+	}
+
+	size_t dataSize(BlockFormat format, u32 width, u32 height, u32 mipCount) {
+		size_t size = 0;
+		for (u32 level = 0; level < mipCount; level++) {
+			size += BlockCompression::levelSize(format, mipSize(width, level), mipSize(height, level));
+		}
+		return size;
+	}
+
+	// Checks the header against the file's size, false for anything that
+	// should be rebuilt
+	bool readHeader(const u8 *data, size_t size, CompressedTextureHeader *header) {
+		if (size < sizeof(*header)) {
+			return false;
+		}
+		memcpy(header, data, sizeof(*header));
+
+		return
+			header->magic == COMPRESSED_TEXTURE_MAGIC &&
+			header->version == COMPRESSED_TEXTURE_VERSION &&
+			header->format < (u8)BlockFormat::_length &&
+			header->mipCount > 0 &&
+			header->mipCount <= fullMipCount(header->width, header->height) &&
+			header->width % 4 == 0 &&
+			header->height % 4 == 0 &&
+			header->imageWidth > 0 &&
+			header->imageWidth <= header->width &&
+			header->imageHeight > 0 &&
+			header->imageHeight <= header->height &&
+			header->dataSize == dataSize((BlockFormat)header->format, header->width, header->height, header->mipCount) &&
+			sizeof(*header) + header->dataSize == size;
+	}
+};
\ No newline at end of file
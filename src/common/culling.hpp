@@ -0,0 +1,172 @@
+#pragma once
+
+#include <cassert>
+#include <cmath>
+
+#include "common/asset_definitions.hpp"
+#include "common/sprite.hpp"
+#include "common/ui_element.hpp"
+#include "common/window_config.hpp"
+#include "types/array.hpp"
+#include "types/core.hpp"
+#include "types/vector.hpp"
+
+// Zero until the texture has been loaded
+struct TextureSize {
+	u16 width;
+	u16 height;
+};
+
+struct TextureSizes {
+	TextureSize sizes[(size_t)TextureAssetId::_length];
+};
+
+// Axis aligned box, in game space for sprites and screen pixels for UI
+struct CullBounds {
+	Vec2<f32> min;
+	Vec2<f32> max;
+
+	bool overlaps(const CullBounds &other) const {
+		return
+			this->min.x < other.max.x && this->max.x > other.min.x &&
+			this->min.y < other.max.y && this->max.y > other.min.y;
+	}
+};
+
+struct CullStats {
+	u32 sprites;
+	u32 culledSprites;
+	u32 uiElements;
+	u32 culledUIElements;
+};
+
+// Drops sprites and UI elements that can't touch the viewport before they're
+// handed to the renderer. Anything whose size isn't known yet is kept.
+//
+// Example:
+//
+//     CullStats stats = {};
+//     Culling::cullSprites(sprites.data, sprites.length, textureSizes, camera.visibleBounds(), &packet->sprites, &stats);
+//     Culling::cullUIElements(uiElements.data, uiElements.length, Culling::screenViewport(), &packet->uiElements, &stats);
+//
+namespace Culling {
+	CullBounds screenViewport() {
+		return { Vec2<f32>(0.0f, 0.0f), Vec2<f32>(screenWidth, screenHeight) };
+	}
+
+	// Box around the sprite's quad in game space once it's rotated, false if
+	// the texture hasn't been loaded yet
+	bool spriteBounds(const Sprite &sprite, const TextureSizes &textureSizes, CullBounds *bounds) {
+		const TextureSize &size = textureSizes.sizes[(size_t)sprite.assetId];
+		if (size.width == 0 || size.height == 0) {
+			return false;
+		}
+
+		const f32 halfWidth = size.width * 0.5f * fabsf(sprite.scale.x);
+		const f32 halfHeight = size.height * 0.5f * fabsf(sprite.scale.y);
+
+		f32 extentX = halfWidth;
+		f32 extentY = halfHeight;
+		if (sprite.angle != 0.0f) {
+			const f32 radians = sprite.angle * (f32)M_PI / 180.0f;
+			const f32 c = fabsf(cosf(radians));
+			const f32 s = fabsf(sinf(radians));
+			extentX = c * halfWidth + s * halfHeight;
+			extentY = s * halfWidth + c * halfHeight;
+		}
+
+		const Vec3<f32> &center = sprite.position;
+		bounds->min = Vec2<f32>(center.x - extentX, center.y - extentY);
+		bounds->max = Vec2<f32>(center.x + extentX, center.y + extentY);
+		return true;
+	}
+
+	// Covers the stroke as well as the fill
+	CullBounds elementBounds(const UIElement &element) {
+		CullBounds bounds = {};
+
+		switch (element.type) {
+			case UIType::text: {
+				// NOTE: Text isn't clipped to its box so this allows it to spill
+				// out by a line, the game's boxes are sized to fit their text.
+				const UITextData &text = element.text;
+				const f32 padding = text.fontSize;
+				bounds.min = Vec2<f32>(text.position.x - padding, text.position.y - padding);
+				bounds.max = Vec2<f32>(text.position.x + text.width + padding, text.position.y + text.height + padding);
+			} break;
+
+			case UIType::line: {
+				const UILineData &line = element.line;
+				const f32 padding = line.thickness * 0.5f;
+				bounds.min = Vec2<f32>(fminf(line.start.x, line.end.x) - padding, fminf(line.start.y, line.end.y) - padding);
+				bounds.max = Vec2<f32>(fmaxf(line.start.x, line.end.x) + padding, fmaxf(line.start.y, line.end.y) + padding);
+			} break;
+
+			case UIType::circle: {
+				const UICircleData &circle = element.circle;
+				const f32 extent = circle.radius + circle.strokeWidth * 0.5f;
+				bounds.min = Vec2<f32>(circle.position.x - extent, circle.position.y - extent);
+				bounds.max = Vec2<f32>(circle.position.x + extent, circle.position.y + extent);
+			} break;
+
+			case UIType::traingle: {
+				const Vec2<f32> *points = element.triangle.points.data;
+				bounds.min = Vec2<f32>(fminf(points[0].x, fminf(points[1].x, points[2].x)), fminf(points[0].y, fminf(points[1].y, points[2].y)));
+				bounds.max = Vec2<f32>(fmaxf(points[0].x, fmaxf(points[1].x, points[2].x)), fmaxf(points[0].y, fmaxf(points[1].y, points[2].y)));
+			} break;
+
+			case UIType::rectangle: {
+				const UIRectangleData &rectangle = element.rectangle;
+				const f32 padding = rectangle.strokeWidth * 0.5f;
+				bounds.min = Vec2<f32>(rectangle.position.x - padding, rectangle.position.y - padding);
+				bounds.max = Vec2<f32>(rectangle.position.x + rectangle.width + padding, rectangle.position.y + rectangle.height + padding);
+			} break;
+
+			default: {
+				assert(false);
+			} break;
+		}
+
+		return bounds;
+	}
+
+	template<size_t Size>
+	void cullSprites(
+		const Sprite *sprites,
+		size_t count,
+		const TextureSizes &textureSizes,
+		const CullBounds &viewport,
+		Array<Sprite, Size> *visible,
+		CullStats *stats
+	) {
+		for (size_t i = 0; i < count; i++) {
+			CullBounds bounds;
+			if (spriteBounds(sprites[i], textureSizes, &bounds) && !bounds.overlaps(viewport)) {
+				stats->culledSprites++;
+				continue;
+			}
+
+			visible->push(sprites[i]);
+			stats->sprites++;
+		}
+	}
+
+	template<size_t Size>
+	void cullUIElements(
+		const UIElement *elements,
+		size_t count,
+		const CullBounds &viewport,
+		Array<UIElement, Size> *visible,
+		CullStats *stats
+	) {
+		for (size_t i = 0; i < count; i++) {
+			if (!elementBounds(elements[i]).overlaps(viewport)) {
+				stats->culledUIElements++;
+				continue;
+			}
+
+			visible->push(elements[i]);
+			stats->uiElements++;
+		}
+	}
+};
\ No newline at end of file
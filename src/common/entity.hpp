@@ -0,0 +1,172 @@
+#pragma once
+
+#include <cassert>
+
+#include "types/core.hpp"
+
+// The low 16 bits index into the component stores' sparse arrays and the high
+// 16 bits count how many times that index has been reused, so a handle kept
+// around after its entity was destroyed won't match whatever replaced it.
+typedef u32 Entity;
+const Entity ENTITY_NONE = (Entity)-1;
+
+#define ENTITY_INDEX_BITS 16
+#define ENTITY_INDEX_MASK ((1u << ENTITY_INDEX_BITS) - 1)
+
+u32 entityIndex(Entity entity) {
+	return entity & ENTITY_INDEX_MASK;
+}
+
+template<size_t Size>
+struct EntityPool {
+	// NOTE: The top index is never handed out so no entity can equal
+	// `ENTITY_NONE`.
+	static_assert(Size <= ENTITY_INDEX_MASK, "EntityPool size exceeds entity index range");
+
+	size_t length = 0;
+
+	EntityPool() {
+		for (size_t i = 0; i < Size; i++) {
+			this->generations[i] = 0;
+			this->nextFree[i] = (u32)i + 1;
+		}
+		this->freeHead = 0;
+	}
+
+	Entity create() {
+		assert(this->freeHead < Size);
+
+		const u32 index = this->freeHead;
+		this->freeHead = this->nextFree[index];
+		this->nextFree[index] = ALIVE;
+		this->length++;
+		return ((Entity)this->generations[index] << ENTITY_INDEX_BITS) | index;
+	}
+
+	void destroy(Entity entity) {
+		assert(this->isAlive(entity));
+
+		const u32 index = entityIndex(entity);
+		this->generations[index]++;
+		this->nextFree[index] = this->freeHead;
+		this->freeHead = index;
+		this->length--;
+	}
+
+	bool isAlive(Entity entity) const {
+		const u32 index = entityIndex(entity);
+		return
+			entity != ENTITY_NONE &&
+			index < Size &&
+			this->generations[index] == (u16)(entity >> ENTITY_INDEX_BITS) &&
+			this->nextFree[index] == ALIVE;
+	}
+
+protected:
+	// Stands in for the next free index while the entity is alive
+	static const u32 ALIVE = (u32)-1;
+
+	u16 generations[Size];
+	u32 nextFree[Size];
+	u32 freeHead;
+};
+
+// Dense array of one component type with a sparse index from entity to
+// component. Iterating touches nothing but the components themselves and
+// removing swaps the last component into the gap, so order isn't kept.
+//
+// Example:
+//
+//     ComponentStore<Weapon, 256, 1024> weapons;
+//     weapons.add(entity, weapon);
+//
+//     for (Weapon &weapon : weapons) {
+//         ...
+//     }
+//
+//     // Walk backwards when removing while iterating
+//     for (size_t i = weapons.length; i-- > 0;) {
+//         if (shouldRemove(weapons.data[i])) {
+//             weapons.remove(weapons.entities[i]);
+//         }
+//     }
+//
+template<typename T, size_t Size, size_t EntitySize>
+struct ComponentStore {
+	size_t length = 0;
+	T data[Size];
+	// Owner of the component at the same index in `data`
+	Entity entities[Size];
+
+	T *add(Entity entity, const T &component) {
+		assert(entityIndex(entity) < EntitySize);
+		assert(!this->has(entity));
+		assert(this->length < Size);
+
+		const size_t i = this->length++;
+		this->data[i] = component;
+		this->entities[i] = entity;
+		this->sparse[entityIndex(entity)] = (u32)i;
+		return &this->data[i];
+	}
+
+	T *get(Entity entity) {
+		const size_t i = this->denseIndex(entity);
+		return i < this->length ? &this->data[i] : nullptr;
+	}
+
+	const T *get(Entity entity) const {
+		const size_t i = this->denseIndex(entity);
+		return i < this->length ? &this->data[i] : nullptr;
+	}
+
+	bool has(Entity entity) const {
+		return this->denseIndex(entity) < this->length;
+	}
+
+	void remove(Entity entity) {
+		const size_t i = this->denseIndex(entity);
+		assert(i < this->length);
+
+		const size_t last = --this->length;
+		this->data[i] = this->data[last];
+		this->entities[i] = this->entities[last];
+		this->sparse[entityIndex(this->entities[i])] = (u32)i;
+	}
+
+	void clear() {
+		this->length = 0;
+	}
+
+	T *begin() {
+		return this->data;
+	}
+
+	const T *begin() const {
+		return this->data;
+	}
+
+	T *end() {
+		return &this->data[this->length];
+	}
+
+	const T *end() const {
+		return &this->data[this->length];
+	}
+
+protected:
+	// Only trusted once the dense entry it points at is checked to belong to the
+	// same entity, so it never needs clearing
+	u32 sparse[EntitySize] = {};
+
+	// `length` if the entity doesn't have the component
+	size_t denseIndex(Entity entity) const {
+		const u32 index = entityIndex(entity);
+		if (entity == ENTITY_NONE || index >= EntitySize) {
+			return this->length;
+		}
+
+		const u32 i = this->sparse[index];
+		return i < this->length && this->entities[i] == entity ? i : this->length;
+	}
+};
\ No newline at end of file
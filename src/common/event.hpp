@@ -1,13 +1,154 @@
 #pragma once
 
+#include <cassert>
+
+#include "common/asset_definitions.hpp"
+#include "common/entity.hpp"
+#include "common/projectile.hpp"
+#include "common/ship.hpp"
 #include "common/ship_target.hpp"
+#include "common/shipment.hpp"
+#include "common/system_location.hpp"
 #include "types/array.hpp"
 #include "types/core.hpp"
 
 struct TargetDestroyedEvent {
-	ShipTarget *target;
+	Entity target;
+};
+
+struct ShipmentDeliveredEvent {
+	CreditValue creditAward;
+	SystemLocation *to;
+};
+
+struct RefuelEvent {
+	SystemLocation *location;
+	FuelValue fuel;
+};
+
+struct SoundEvent {
+	SoundAssetId assetId;
+};
+
+// Subscribers receive every pending event of a type in one call so they can
+// process the whole batch in a single loop.
+template<typename T>
+using EventHandler = void (*)(struct GameState *gameState, const T *events, size_t count);
+
+struct EventQueueStats {
+	u32 peakDepth = 0;
+	u32 overflowCount = 0;
 };
 
+// Fixed size ring buffer of events with frame scoped lifetime. Events are
+// published at any point during the frame, handed to the subscribers in
+// batches by `dispatch` and anything left over is dropped by `endFrame`.
+template<typename T, size_t Size>
+struct EventQueue {
+	Array<EventHandler<T>, 4> subscribers;
+	EventQueueStats stats;
+	EventQueueStats lastFrameStats;
+
+	size_t capacity() const {
+		return Size;
+	}
+
+	size_t depth() const {
+		return this->writeIndex - this->readIndex;
+	}
+
+	bool publish(const T &event) {
+		if (this->depth() == Size) {
+			this->stats.overflowCount++;
+			return false;
+		}
+
+		this->data[this->writeIndex % Size] = event;
+		this->writeIndex++;
+
+		const u32 depth = (u32)this->depth();
+		if (depth > this->stats.peakDepth) {
+			this->stats.peakDepth = depth;
+		}
+		return true;
+	}
+
+	// Used by consumers that live outside of the game code (e.g. the platform
+	// layer) and so can't register as a subscriber.
+	bool pop(T *event) {
+		if (this->depth() == 0) {
+			return false;
+		}
+
+		*event = this->data[this->readIndex % Size];
+		this->readIndex++;
+		return true;
+	}
+
+	void subscribe(EventHandler<T> handler) {
+		this->subscribers.push(handler);
+	}
+
+	void dispatch(struct GameState *gameState) {
+		if (this->subscribers.length == 0) {
+			return;
+		}
+
+		// NOTE: Subscribers may publish more events of the same type while
+		// handling a batch. The read index is only moved on after every
+		// subscriber has seen the batch so those new events can't overwrite it.
+		while (this->depth() > 0) {
+			const size_t start = this->readIndex % Size;
+			const size_t count = this->depth() < Size - start ? this->depth() : Size - start;
+
+			for (EventHandler<T> handler : this->subscribers) {
+				handler(gameState, &this->data[start], count);
+			}
+
+			this->readIndex += count;
+		}
+	}
+
+	void endFrame() {
+		this->readIndex = this->writeIndex = 0;
+		this->lastFrameStats = this->stats;
+		this->stats = {};
+	}
+
+protected:
+	T data[Size];
+	u32 readIndex = 0;
+	u32 writeIndex = 0;
+};
+
+typedef EventQueue<SoundEvent, 8> SoundEventQueue;
+
 struct Events {
-	Array<TargetDestroyedEvent, 10> targetDestroyed;	
+	// NOTE: Sized so every hit in a frame can destroy its target, targets are
+	// only removed in response to these so none can be dropped.
+	EventQueue<TargetDestroyedEvent, PROJECTILE_MAX> targetDestroyed;
+	EventQueue<ShipmentDeliveredEvent, 32> shipmentDelivered;
+	EventQueue<RefuelEvent, 4> refuel;
+
+	// Consumed by the platform layer
+	SoundEventQueue sound;
+
+	void dispatch(struct GameState *gameState) {
+		this->targetDestroyed.dispatch(gameState);
+		this->shipmentDelivered.dispatch(gameState);
+		this->refuel.dispatch(gameState);
+	}
+
+	void clearSubscribers() {
+		this->targetDestroyed.subscribers.clear();
+		this->shipmentDelivered.subscribers.clear();
+		this->refuel.subscribers.clear();
+	}
+
+	void endFrame() {
+		this->targetDestroyed.endFrame();
+		this->shipmentDelivered.endFrame();
+		this->refuel.endFrame();
+		this->sound.endFrame();
+	}
 };
\ No newline at end of file
@@ -0,0 +1,266 @@
+#pragma once
+
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+
+#include "common/asset_definitions.hpp"
+#include "types/array.hpp"
+#include "types/core.hpp"
+#include "utils/profiler.hpp"
+
+#define FRAME_HISTOGRAM_SUB_BUCKET_BITS 4
+#define FRAME_HISTOGRAM_SUB_BUCKETS (1 << FRAME_HISTOGRAM_SUB_BUCKET_BITS)
+#define FRAME_HISTOGRAM_MAX_BIT 26
+#define FRAME_HISTOGRAM_BUCKETS (FRAME_HISTOGRAM_SUB_BUCKETS * (FRAME_HISTOGRAM_MAX_BIT - FRAME_HISTOGRAM_SUB_BUCKET_BITS + 2))
+#define FRAME_WINDOW_SIZE 600
+#define FRAME_HITCH_MAX 64
+#define FRAME_HITCH_ZONES 8
+
+// Frame times in microseconds, bucketed the same way as an HDR histogram:
+// every power of two range is split into `FRAME_HISTOGRAM_SUB_BUCKETS`
+// linear buckets, so the error on any recorded value stays under 1/16th of it
+// no matter whether the frame took 2ms or 2s.
+struct FrameTimeHistogram {
+	u32 counts[FRAME_HISTOGRAM_BUCKETS] = {};
+	u64 total = 0;
+	u32 maxMicroseconds = 0;
+
+	static size_t bucketFor(u32 microseconds) {
+		if (microseconds < FRAME_HISTOGRAM_SUB_BUCKETS) {
+			return microseconds;
+		}
+
+		u32 highestBit = FRAME_HISTOGRAM_SUB_BUCKET_BITS;
+		while (highestBit < FRAME_HISTOGRAM_MAX_BIT && (microseconds >> (highestBit + 1)) != 0) {
+			highestBit++;
+		}
+
+		const u32 shift = highestBit - FRAME_HISTOGRAM_SUB_BUCKET_BITS;
+		u32 subBucket = (microseconds >> shift) - FRAME_HISTOGRAM_SUB_BUCKETS;
+		if (subBucket >= FRAME_HISTOGRAM_SUB_BUCKETS) {
+			// Clamp anything past the last range into its final bucket
+			subBucket = FRAME_HISTOGRAM_SUB_BUCKETS - 1;
+		}
+
+		return FRAME_HISTOGRAM_SUB_BUCKETS * (shift + 1) + subBucket;
+	}
+
+	static u32 bucketLowerBound(size_t bucket) {
+		if (bucket < FRAME_HISTOGRAM_SUB_BUCKETS) {
+			return (u32)bucket;
+		}
+
+		const u32 shift = (u32)(bucket / FRAME_HISTOGRAM_SUB_BUCKETS) - 1;
+		const u32 subBucket = (u32)(bucket % FRAME_HISTOGRAM_SUB_BUCKETS);
+		return (FRAME_HISTOGRAM_SUB_BUCKETS + subBucket) << shift;
+	}
+
+	static u32 bucketUpperBound(size_t bucket) {
+		return bucket + 1 < FRAME_HISTOGRAM_BUCKETS ? bucketLowerBound(bucket + 1) : (u32)-1;
+	}
+
+	void add(u32 microseconds) {
+		this->counts[bucketFor(microseconds)]++;
+		this->total++;
+		if (microseconds > this->maxMicroseconds) {
+			this->maxMicroseconds = microseconds;
+		}
+	}
+
+	void remove(u32 microseconds) {
+		const size_t bucket = bucketFor(microseconds);
+		assert(this->counts[bucket] > 0);
+		this->counts[bucket]--;
+		this->total--;
+	}
+
+	// Upper bound of the bucket the given percentile (0-100) falls into
+	u32 percentile(f32 percentile) const {
+		if (this->total == 0) {
+			return 0;
+		}
+
+		const u64 target = (u64)ceil(this->total * (f64)percentile / 100.0);
+		u64 seen = 0;
+		for (size_t i = 0; i < FRAME_HISTOGRAM_BUCKETS; i++) {
+			seen += this->counts[i];
+			if (seen >= target && this->counts[i] > 0) {
+				const u32 upperBound = bucketUpperBound(i);
+				return upperBound < this->maxMicroseconds ? upperBound : this->maxMicroseconds;
+			}
+		}
+		return this->maxMicroseconds;
+	}
+};
+
+// What was being loaded or switched during a frame, filled in by the
+// platform layer as the frame runs.
+struct FrameLoadSnapshot {
+	Array<TextureAssetId, 8> textures;
+	MusicAssetId music = MusicAssetId::none;
+	u32 sounds = 0;
+	bool sceneChanged = false;
+};
+
+struct FrameHitchZone {
+	const char *name;
+	f32 milliseconds;
+};
+
+// The slowest zones one thread finished in its last frame, slowest first
+struct FrameHitchZones : Array<FrameHitchZone, FRAME_HITCH_ZONES> {
+	// Must be called after `Profiler::endFrame` on the thread being captured
+	void capture() {
+		this->clear();
+
+		const f64 ticksPerSecond = Profiler::ticksPerSecond();
+		const Profiler::ZoneStats *stats = Profiler::threadStats();
+		for (Profiler::ZoneId id = 0; id < Profiler::registeredZoneCount(); id++) {
+			if (stats[id].lastFrameTicks == 0) {
+				continue;
+			}
+
+			FrameHitchZone zone = {};
+			zone.name = Profiler::zoneName(id);
+			zone.milliseconds = (f32)Profiler::ticksToMilliseconds(stats[id].lastFrameTicks, ticksPerSecond);
+
+			size_t insertAt = this->length;
+			while (insertAt > 0 && this->data[insertAt - 1].milliseconds < zone.milliseconds) {
+				insertAt--;
+			}
+			if (insertAt == FRAME_HITCH_ZONES) {
+				continue;
+			}
+
+			if (this->length < FRAME_HITCH_ZONES) {
+				this->length++;
+			}
+			for (size_t i = this->length - 1; i > insertAt; i--) {
+				this->data[i] = this->data[i - 1];
+			}
+			this->data[insertAt] = zone;
+		}
+	}
+};
+
+struct FrameHitch {
+	u64 frame;
+	f32 milliseconds;
+	FrameLoadSnapshot loads;
+	FrameHitchZones zones;
+	// From the last frame the render thread finished, which is the one the
+	// game thread waits on when the render thread falls behind
+	FrameHitchZones renderZones;
+};
+
+struct FrameStats {
+	f32 budget = 1.0f / 60.0f;
+	// A frame counts as a hitch once it takes this many times the budget
+	f32 hitchMultiplier = 2.0f;
+
+	u64 frameCount = 0;
+	u64 hitchCount = 0;
+	FrameTimeHistogram overall;
+	FrameTimeHistogram rolling;
+
+	// Must be called after `Profiler::endFrame` so the zone timings belong to
+	// the frame that is being ended.
+	void endFrame(f32 seconds, const FrameLoadSnapshot &loads, const FrameHitchZones &renderZones) {
+		const u32 microseconds = (u32)(seconds * 1e6f);
+
+		if (this->frameCount >= FRAME_WINDOW_SIZE) {
+			this->rolling.remove(this->window[this->frameCount % FRAME_WINDOW_SIZE]);
+		}
+		this->window[this->frameCount % FRAME_WINDOW_SIZE] = microseconds;
+		this->rolling.add(microseconds);
+		this->overall.add(microseconds);
+
+		if (seconds > this->budget * this->hitchMultiplier) {
+			this->recordHitch(seconds, loads, renderZones);
+		}
+
+		this->frameCount++;
+	}
+
+	size_t storedHitches() const {
+		return this->hitchCount < FRAME_HITCH_MAX ? (size_t)this->hitchCount : FRAME_HITCH_MAX;
+	}
+
+	bool dump(const char *path) const {
+		FILE *file = fopen(path, "w");
+		if (file == nullptr) {
+			return false;
+		}
+
+		const f32 percentiles[] = { 50.0f, 90.0f, 99.0f, 99.9f };
+
+		fprintf(file, "Frames: %llu\n", this->frameCount);
+		fprintf(file, "Budget: %.2fms (hitch over %.2fms)\n", this->budget * 1e3f, this->budget * this->hitchMultiplier * 1e3f);
+		fprintf(file, "Hitches: %llu\n\n", this->hitchCount);
+
+		for (f32 percentile : percentiles) {
+			fprintf(file, "p%g: %.2fms\n", percentile, this->overall.percentile(percentile) / 1e3f);
+		}
+		fprintf(file, "max: %.2fms\n\n", this->overall.maxMicroseconds / 1e3f);
+
+		fprintf(file, "Histogram (ms):\n");
+		for (size_t i = 0; i < FRAME_HISTOGRAM_BUCKETS; i++) {
+			if (this->overall.counts[i] == 0) {
+				continue;
+			}
+			fprintf(
+				file,
+				"  %8.2f - %8.2f: %u\n",
+				FrameTimeHistogram::bucketLowerBound(i) / 1e3f,
+				FrameTimeHistogram::bucketUpperBound(i) / 1e3f,
+				this->overall.counts[i]
+			);
+		}
+
+		// Oldest first, the buffer wraps once there have been more than
+		// `FRAME_HITCH_MAX` hitches
+		const size_t first = this->hitchCount > FRAME_HITCH_MAX ? this->hitchCount % FRAME_HITCH_MAX : 0;
+
+		fprintf(file, "\nHitches (most recent %zu):\n", this->storedHitches());
+		for (size_t i = 0; i < this->storedHitches(); i++) {
+			const FrameHitch &hitch = this->hitches[(first + i) % FRAME_HITCH_MAX];
+			fprintf(file, "  Frame %llu: %.2fms%s\n", hitch.frame, hitch.milliseconds, hitch.loads.sceneChanged ? " (scene change)" : "");
+
+			for (TextureAssetId texture : hitch.loads.textures) {
+				fprintf(file, "    Texture load: %ls\n", textureNames[(size_t)texture]);
+			}
+			if (hitch.loads.music != MusicAssetId::none) {
+				fprintf(file, "    Music load: %ls\n", musicNames[(size_t)hitch.loads.music]);
+			}
+			if (hitch.loads.sounds > 0) {
+				fprintf(file, "    Sounds played: %u\n", hitch.loads.sounds);
+			}
+			for (const FrameHitchZone &zone : hitch.zones) {
+				fprintf(file, "    %s: %.3fms\n", zone.name, zone.milliseconds);
+			}
+			for (const FrameHitchZone &zone : hitch.renderZones) {
+				fprintf(file, "    Render thread %s: %.3fms\n", zone.name, zone.milliseconds);
+			}
+		}
+
+		fclose(file);
+		return true;
+	}
+
+protected:
+	u32 window[FRAME_WINDOW_SIZE];
+	FrameHitch hitches[FRAME_HITCH_MAX];
+
+	void recordHitch(f32 seconds, const FrameLoadSnapshot &loads, const FrameHitchZones &renderZones) {
+		FrameHitch &hitch = this->hitches[this->hitchCount % FRAME_HITCH_MAX];
+		hitch = {};
+		hitch.frame = this->frameCount;
+		hitch.milliseconds = seconds * 1e3f;
+		hitch.loads = loads;
+		hitch.zones.capture();
+		hitch.renderZones = renderZones;
+
+		this->hitchCount++;
+	}
+};
\ No newline at end of file
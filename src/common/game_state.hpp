@@ -3,15 +3,21 @@
 #include <cmath>
 
 #include "common/asset_definitions.hpp"
+#include "common/camera.hpp"
+#include "common/combat_ai_state.hpp"
+#include "common/combat_entities.hpp"
 #include "common/editor_state.hpp"
 #include "common/event.hpp"
 #include "common/game_definitions.hpp"
 #include "common/input.hpp"
 #include "common/load_queue.hpp"
 #include "common/projectile.hpp"
+#include "common/render_queue.hpp"
+#include "common/scene_manifest.hpp"
 #include "common/ship.hpp"
 #include "common/ship_target.hpp"
 #include "common/shipment.hpp"
+#include "common/shipment_store.hpp"
 #include "common/sprite.hpp"
 #include "common/system_location.hpp"
 #include "common/templates.hpp"
@@ -20,10 +26,6 @@
 #include "common/weapon.hpp"
 #include "types/array.hpp"
 
-typedef Array<Sprite, 10> SpriteBuffer;
-typedef LoadQueue<TextureAssetId, 8> TextureLoadQueue;
-typedef LoadQueue<SoundAssetId, 8> SoundLoadQueue;
-
 typedef void (*UpdateSystem)(struct GameState *gameState, f32 delta);
 
 const int CREDIT_MAX = 10000;
@@ -32,19 +34,23 @@ const int WEIGHT_MAX = 500;
 const int WEIGHT_MIN = 1;
 const int AVAILABLE_SHIPMENT_MAX = 4;
 const int SHIPMENT_MAX = 10;
+const int SYSTEM_LOCATION_MAX = 6;
+
+typedef ShipmentStore<SHIPMENT_MAX, SYSTEM_LOCATION_MAX> Shipments;
 
 struct GameState {
 	GameState() {}
 
 	// Combat data
-	Array<AimlessProjectile, 100> aimlessProjectiles;
 	Ship playerShip;
-	Array<Ship, 2> allyShips;
-	Array<Ship, 2> enemyShips;
-	Array<Projectile, 100> projectiles;
+	CombatEntities combat;
+	CombatAiState combatAi;
+	ProjectilePool projectiles;
+	ProjectileStats projectileStats;
+	Array<ProjectileHit, PROJECTILE_MAX> hits;
 
 	// System view data
-	Array<SystemLocation, 6> systemLocations;
+	Array<SystemLocation, SYSTEM_LOCATION_MAX> systemLocations;
 	SystemLocation *selectedLocation = nullptr;
 	SystemLocation *highlightedLocation = nullptr;
 	SystemLocation *targetLocation = nullptr;
@@ -53,27 +59,28 @@ struct GameState {
 	// Journey data
 	f32 journeyProgress = 0.0f;
 	DayValue daysPassed = 0;
+	TweenBinding journeyProgressBinding = TWEEN_BINDING_NONE;
+	TweenBinding daysPassedBinding = TWEEN_BINDING_NONE;
+	TweenBinding fuelBinding = TWEEN_BINDING_NONE;
 
 	// Delivery data
 	u32 deliveriesMade = 0;
-	Array<Shipment, SHIPMENT_MAX> shipments;
+	Shipments shipments;
 	Array<Shipment, AVAILABLE_SHIPMENT_MAX> availableShipments;
 
-	// Refuelling data
-	bool isRefuelling = false;
-
 	// Platform/game common data
+	Camera camera;
 	CreditValue credits = 1000;
 	Events events;
 	Input input;
 	SpriteBuffer sprites;
 	Templates templates;
+	SceneAssets scene;
 	TextureLoadQueue textureLoadQueue;
-	SoundLoadQueue soundLoadQueue;
 	MusicAssetId pendingMusicItem = MusicAssetId::none;
 	UIElementBuffer uiElements;
 	Array<UpdateSystem, 1> updateSystems;
-	Array<Tween, 16> tweens;
+	Tweens tweens;
 
 #ifdef DEBUG
 	EditorState editorState;
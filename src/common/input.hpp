@@ -19,6 +19,8 @@ enum class Cursor {
 struct Input {
 	Cursor cursor = Cursor::arrow;
 	wchar_t keyDown = '\0';
+	// Notches scrolled this frame, positive away from the user
+	f32 wheel = 0.0f;
 	Vec2<f32> mouse;
 	Vec2<f32> previousMouse;
 	ButtonState primaryButton;
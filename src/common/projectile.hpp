@@ -1,21 +1,50 @@
 #pragma once 
 
+#include "common/entity.hpp"
 #include "common/game_definitions.hpp"
 #include "common/ship_target.hpp"
 #include "types/core.hpp"
+#include "types/pool.hpp"
+
+// Each projectile can hit at most once a frame so this also bounds the hits
+#define PROJECTILE_MAX 256
+
+enum class ProjectileState : u8 {
+	homing,
+	// Its target was destroyed before it landed, it carries on in the same
+	// direction until its lifetime runs out
+	aimless
+};
 
 struct Projectile {
+	ProjectileState state = ProjectileState::homing;
 	Vec3<f32> position;
-	// TODO(steven): target may not always be valid. For example: if it gets destroyed
-	ShipTarget *target;
-	HealthValue damage;
 	f32 speed = 1.0f;
-};
 
-struct AimlessProjectile {
-	Vec3<f32> position;
+	// Homing, checked against the target store every update since it may have
+	// been destroyed
+	Entity target = ENTITY_NONE;
+	HealthValue damage;
+
+	// Aimless
 	Vec3<f32> direction;
-	f32 speed = 1.0f;
 	f32 lifetime = 10.0f;
 	f32 tick = 0.0f;
+};
+
+typedef Pool<Projectile, PROJECTILE_MAX> ProjectilePool;
+
+// Running totals since the battle started
+struct ProjectileStats {
+	u32 fired = 0;
+	// Shots lost to a full pool
+	u32 dropped = 0;
+	u32 hits = 0;
+};
+
+// Recorded by `Combat::updateProjectiles` and applied to the target's health
+// later in the frame by `Combat::resolveHits`
+struct ProjectileHit {
+	Entity target;
+	HealthValue damage;
 };
\ No newline at end of file
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <cassert>
+
+#include "common/asset_definitions.hpp"
+#include "common/asset_residency.hpp"
+#include "common/combat_entities.hpp"
+#include "common/culling.hpp"
+#include "common/frame_stats.hpp"
+#include "common/load_queue.hpp"
+#include "common/render_scale.hpp"
+#include "common/scene_manifest.hpp"
+#include "common/sprite.hpp"
+#include "common/text_run_cache.hpp"
+#include "common/ui_element_buffer.hpp"
+#include "types/array.hpp"
+#include "types/core.hpp"
+#include "types/matrix.hpp"
+#include "utils/profiler.hpp"
+#include "utils/thread.hpp"
+
+// Room for every ship in combat plus the background
+typedef Array<Sprite, COMBAT_SHIP_MAX + 16> SpriteBuffer;
+typedef LoadQueue<TextureAssetId, 8> TextureLoadQueue;
+
+// Everything the render thread needs to draw a frame, copied out of the game
+// state so the game can move on to the next frame while it's drawn.
+struct RenderPacket {
+	u64 frame;
+	u64 submitTicks;
+
+	TextureLoadQueue textureLoads;
+	// Loaded in the background, after `textureLoads`
+	TexturePrefetchList texturePrefetches;
+	SpriteBuffer sprites;
+	UIElementBuffer uiElements;
+	// The game camera's, sprites are in game space
+	Mat4 viewProjection;
+
+	// Written by the render thread once it's drawn the packet, the game
+	// thread sees it when the packet comes back round to be filled in again
+	TextRunCacheStats textRunStats;
+	TextureSizes textureSizes;
+	RenderScaleStats renderScaleStats;
+	AssetResidencyStats textureResidencyStats;
+	FrameHitchZones renderZones;
+};
+
+struct RenderQueueStats {
+	u64 frames = 0;
+	// Game thread waiting for the render thread to give a packet back
+	u64 gameWaitTicks = 0;
+	// Render thread waiting for the game thread to submit a packet
+	u64 renderWaitTicks = 0;
+	u64 renderTicks = 0;
+	// From submit until the render thread is done with the packet
+	u64 latencyTicks = 0;
+	u64 maxLatencyTicks = 0;
+	u64 lastRenderTicks = 0;
+	u64 lastLatencyTicks = 0;
+};
+
+// Hands render packets from the game thread to the render thread. With two
+// packets the game fills in the next frame while the previous one is drawn
+// and only waits once it gets a whole frame ahead, which also caps the added
+// latency at a frame.
+//
+// Example:
+//
+//     // Game thread, every frame
+//     RenderPacket *packet = queue.beginWrite();
+//     ...
+//     queue.submit();
+//
+//     // Render thread
+//     while (RenderPacket *packet = queue.beginRead()) {
+//         ...
+//         queue.endRead();
+//     }
+//
+//     // Game thread, once the render thread should stop after drawing what's
+//     // already been submitted
+//     queue.close();
+//
+struct RenderQueue {
+	RenderPacket packets[2];
+
+	RenderPacket *beginWrite() {
+		const u64 start = Profiler::now();
+		ScopedLock lock(&this->mutex);
+		while (!this->closed && (this->reading == this->writing || this->ready == this->writing)) {
+			this->condition.wait(&this->mutex);
+		}
+		this->stats.gameWaitTicks += Profiler::now() - start;
+
+		return &this->packets[this->writing];
+	}
+
+	void submit() {
+		const u64 start = Profiler::now();
+		ScopedLock lock(&this->mutex);
+		while (!this->closed && this->ready != NONE) {
+			this->condition.wait(&this->mutex);
+		}
+		this->stats.gameWaitTicks += Profiler::now() - start;
+
+		RenderPacket &packet = this->packets[this->writing];
+		packet.frame = this->submitted++;
+		packet.submitTicks = Profiler::now();
+
+		this->ready = this->writing;
+		this->writing = 1 - this->writing;
+		this->condition.notifyAll();
+	}
+
+	// Null once the queue is closed and the last packet submitted has been read
+	RenderPacket *beginRead() {
+		const u64 start = Profiler::now();
+		ScopedLock lock(&this->mutex);
+		while (!this->closed && this->ready == NONE) {
+			this->condition.wait(&this->mutex);
+		}
+		this->stats.renderWaitTicks += Profiler::now() - start;
+
+		if (this->ready == NONE) {
+			return nullptr;
+		}
+
+		this->reading = this->ready;
+		this->ready = NONE;
+		this->readStart = Profiler::now();
+		this->condition.notifyAll();
+		return &this->packets[this->reading];
+	}
+
+	void endRead() {
+		ScopedLock lock(&this->mutex);
+		assert(this->reading != NONE);
+
+		const u64 now = Profiler::now();
+		const u64 latency = now - this->packets[this->reading].submitTicks;
+		RenderQueueStats &stats = this->stats;
+		stats.frames++;
+		stats.lastRenderTicks = now - this->readStart;
+		stats.renderTicks += stats.lastRenderTicks;
+		stats.lastLatencyTicks = latency;
+		stats.latencyTicks += latency;
+		stats.maxLatencyTicks = latency > stats.maxLatencyTicks ? latency : stats.maxLatencyTicks;
+
+		this->reading = NONE;
+		this->condition.notifyAll();
+	}
+
+	void close() {
+		ScopedLock lock(&this->mutex);
+		this->closed = true;
+		this->condition.notifyAll();
+	}
+
+	RenderQueueStats getStats() {
+		ScopedLock lock(&this->mutex);
+		return this->stats;
+	}
+
+protected:
+	static const u32 NONE = 2;
+
+	Mutex mutex;
+	ConditionVariable condition;
+	RenderQueueStats stats;
+	u32 writing = 0;
+	u32 ready = NONE;
+	u32 reading = NONE;
+	u64 readStart = 0;
+	u64 submitted = 0;
+	bool closed = false;
+};
\ No newline at end of file
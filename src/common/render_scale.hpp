@@ -0,0 +1,145 @@
+#pragma once
+
+#include <cassert>
+#include <cmath>
+
+#include "types/core.hpp"
+
+struct RenderScaleConfig {
+	// GPU time a frame should fit in, leaving some of the vsync interval spare
+	f32 targetMilliseconds = 14.0f;
+	f32 minScale = 0.5f;
+	f32 maxScale = 1.0f;
+	// Scales are kept to multiples of this so the render size doesn't change
+	// on every frame
+	f32 step = 0.05f;
+	// Only goes back up if the frame is expected to stay under this fraction
+	// of the target at the higher scale, the gap stops it flip-flopping
+	f32 raiseThreshold = 0.85f;
+	// Timings arrive a few frames late, so after a change this many frames
+	// are ignored before the next one
+	u32 settleFrames = 4;
+	// How much of a new timing goes into the average, rises are followed
+	// faster than falls
+	f32 riseSmoothing = 0.5f;
+	f32 fallSmoothing = 0.1f;
+};
+
+// Handed back to the game with each render packet
+struct RenderScaleStats {
+	f32 scale = 1.0f;
+	f32 gpuMilliseconds;
+	f32 cpuMilliseconds;
+	// Over the target but lowering the scale wouldn't help
+	bool cpuBound;
+	u32 changes;
+};
+
+// Picks the resolution scale the scene is drawn at to keep the GPU frame time
+// under a target. The GPU time is taken to scale with the number of pixels
+// drawn, so the scale that would just fit is the current one times the square
+// root of target over time. Scaling down happens as soon as the average goes
+// over the target, scaling up a step at a time once it's comfortably under.
+//
+// Example:
+//
+//     RenderScaleController controller;
+//
+//     // Every frame, with whatever timings have come back
+//     renderer->setRenderScale(controller.getScale());
+//     ...
+//     controller.update(gpuMilliseconds, cpuMilliseconds);
+//
+struct RenderScaleController {
+	RenderScaleConfig config;
+
+	void reset() {
+		this->stats = {};
+		this->stats.scale = this->config.maxScale;
+		this->framesSinceChange = 0;
+		this->smoothedGpuMilliseconds = 0.0f;
+		this->primed = false;
+	}
+
+	// Feeds in the timings of one finished frame, returns the scale to draw
+	// the next frame at
+	f32 update(f32 gpuMilliseconds, f32 cpuMilliseconds) {
+		const RenderScaleConfig &config = this->config;
+		RenderScaleStats &stats = this->stats;
+		assert(config.minScale > 0.0f && config.minScale <= config.maxScale);
+
+		if (!this->primed) {
+			this->smoothedGpuMilliseconds = gpuMilliseconds;
+			this->primed = true;
+		} else {
+			const f32 smoothing = gpuMilliseconds > this->smoothedGpuMilliseconds ? config.riseSmoothing : config.fallSmoothing;
+			this->smoothedGpuMilliseconds += (gpuMilliseconds - this->smoothedGpuMilliseconds) * smoothing;
+		}
+
+		const f32 gpu = this->smoothedGpuMilliseconds;
+		stats.gpuMilliseconds = gpu;
+		stats.cpuMilliseconds = cpuMilliseconds;
+		// The frame takes as long as the slower side, if that's the CPU
+		// drawing fewer pixels won't speed it up
+		stats.cpuBound = cpuMilliseconds > config.targetMilliseconds && cpuMilliseconds >= gpu;
+
+		if (++this->framesSinceChange <= config.settleFrames || gpu <= 0.0f) {
+			return stats.scale;
+		}
+
+		f32 scale = stats.scale;
+		if (gpu > config.targetMilliseconds && !stats.cpuBound) {
+			// Always at least a step, the fit is rounded down to one
+			const f32 fit = scale * sqrtf(config.targetMilliseconds / gpu);
+			scale = fminf(this->quantise(fit), scale - config.step);
+		} else if (gpu < config.targetMilliseconds * config.raiseThreshold) {
+			const f32 raised = this->quantise(scale + config.step);
+			const f32 expected = gpu * (raised * raised) / (scale * scale);
+			if (expected < config.targetMilliseconds * config.raiseThreshold) {
+				scale = raised;
+			}
+		}
+
+		scale = fmaxf(config.minScale, fminf(config.maxScale, scale));
+		if (scale != stats.scale) {
+			// Carry the average over to the new scale rather than waiting for
+			// it to catch up
+			const f32 ratio = scale / stats.scale;
+			this->smoothedGpuMilliseconds *= ratio * ratio;
+
+			stats.scale = scale;
+			stats.changes++;
+			this->framesSinceChange = 0;
+		}
+
+		return stats.scale;
+	}
+
+	f32 getScale() const {
+		return this->stats.scale;
+	}
+
+	const RenderScaleStats &getStats() const {
+		return this->stats;
+	}
+
+protected:
+	RenderScaleStats stats = {};
+	u32 framesSinceChange = 0;
+	f32 smoothedGpuMilliseconds = 0.0f;
+	bool primed = false;
+
+	f32 quantise(f32 scale) const {
+		// The bias keeps exact multiples from rounding down a step
+		return floorf(scale / this->config.step + 0.001f) * this->config.step;
+	}
+};
+
+namespace RenderScale {
+	// Size of one side of the scene at a scale, kept even so the upscale
+	// lines texels up with pixels at half size
+	u32 scaledSize(u32 size, f32 scale) {
+		const u32 scaled = (u32)(size * scale * 0.5f + 0.5f) * 2;
+		return scaled < 2 ? 2 : (scaled > size ? size : scaled);
+	}
+};
\ No newline at end of file
@@ -5,6 +5,6 @@
 struct SaveData {
 	bool pending = false;
 	String16<64> path;
-	char buffer[4096];
+	char buffer[8192];
 	size_t size;
 };
\ No newline at end of file
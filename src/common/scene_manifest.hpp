@@ -0,0 +1,136 @@
+#pragma once
+
+#include "common/asset_definitions.hpp"
+#include "types/array.hpp"
+#include "types/core.hpp"
+
+#define SCENE_NEXT_MAX 3
+// The scene being shown and every scene it could go to next
+#define SCENE_PREFETCH_MAX ((SCENE_NEXT_MAX + 1) * (size_t)TextureAssetId::_length)
+#define SCENE_SOUND_PREFETCH_MAX ((SCENE_NEXT_MAX + 1) * (size_t)SoundAssetId::_length)
+#define SCENE_LIST(_array) _array, sizeof(_array) / sizeof(_array[0])
+
+enum class SceneId : u8 {
+	systemSelect,
+	systemView,
+	packageMenu,
+	combat,
+	_length
+};
+
+const char *sceneNames[] = {
+	"systemSelect",
+	"systemView",
+	"packageMenu",
+	"combat"
+};
+
+// Everything a scene needs before it can be shown and the scenes it can go
+// to, so their assets can be loaded while this one's still up. Ship templates
+// are left out, they're all loaded at startup.
+struct SceneManifest {
+	const TextureAssetId *textures;
+	u32 textureCount;
+	const SoundAssetId *sounds;
+	u32 soundCount;
+	MusicAssetId music;
+	// Most likely first
+	const SceneId *next;
+	u32 nextCount;
+};
+
+namespace _SceneManifests {
+	const TextureAssetId systemSelectTextures[] = { TextureAssetId::background };
+	// Back from the package menu it's usually off on another journey
+	const SceneId systemSelectNext[] = { SceneId::systemView, SceneId::packageMenu };
+
+	const TextureAssetId systemViewTextures[] = { TextureAssetId::background };
+	const SceneId systemViewNext[] = { SceneId::systemSelect };
+
+	const TextureAssetId packageMenuTextures[] = { TextureAssetId::marketPlace1 };
+	const SoundAssetId packageMenuSounds[] = { SoundAssetId::cha_ching, SoundAssetId::wahoo };
+	const SceneId packageMenuNext[] = { SceneId::systemSelect };
+
+	const TextureAssetId combatTextures[] = { TextureAssetId::ship, TextureAssetId::enemyShip, TextureAssetId::background };
+	const SceneId combatNext[] = { SceneId::systemSelect };
+};
+
+const SceneManifest sceneManifests[] = {
+	{ SCENE_LIST(_SceneManifests::systemSelectTextures), nullptr, 0, MusicAssetId::mars, SCENE_LIST(_SceneManifests::systemSelectNext) },
+	{ SCENE_LIST(_SceneManifests::systemViewTextures), nullptr, 0, MusicAssetId::mars, SCENE_LIST(_SceneManifests::systemViewNext) },
+	{ SCENE_LIST(_SceneManifests::packageMenuTextures), SCENE_LIST(_SceneManifests::packageMenuSounds), MusicAssetId::mars, SCENE_LIST(_SceneManifests::packageMenuNext) },
+	{ SCENE_LIST(_SceneManifests::combatTextures), nullptr, 0, MusicAssetId::mars, SCENE_LIST(_SceneManifests::combatNext) }
+};
+
+// Which scene is up and where it's likely to go, set by the scenes as they
+// change and read by the platform to load ahead
+struct SceneAssets {
+	SceneId current = SceneId::_length;
+	// Most likely first
+	Array<SceneId, SCENE_NEXT_MAX> upcoming;
+	MusicAssetId music = MusicAssetId::none;
+};
+
+// Assets in the order they're wanted. The first `requiredCount` belong to
+// the scene being shown, the rest to the scenes after it.
+template<typename T, size_t Size>
+struct PrefetchList {
+	Array<T, Size> assets;
+	u32 requiredCount = 0;
+
+	void add(T assetId) {
+		for (T existing : this->assets) {
+			if (existing == assetId) {
+				return;
+			}
+		}
+		this->assets.push(assetId);
+	}
+};
+
+typedef PrefetchList<TextureAssetId, SCENE_PREFETCH_MAX> TexturePrefetchList;
+typedef PrefetchList<SoundAssetId, SCENE_SOUND_PREFETCH_MAX> SoundPrefetchList;
+
+namespace SceneManifests {
+	void gatherTextures(const SceneAssets &scene, TexturePrefetchList *list) {
+		list->assets.clear();
+		list->requiredCount = 0;
+		if (scene.current == SceneId::_length) {
+			return;
+		}
+
+		const SceneManifest &current = sceneManifests[(size_t)scene.current];
+		for (u32 i = 0; i < current.textureCount; i++) {
+			list->add(current.textures[i]);
+		}
+		list->requiredCount = (u32)list->assets.length;
+
+		for (SceneId next : scene.upcoming) {
+			const SceneManifest &manifest = sceneManifests[(size_t)next];
+			for (u32 i = 0; i < manifest.textureCount; i++) {
+				list->add(manifest.textures[i]);
+			}
+		}
+	}
+
+	void gatherSounds(const SceneAssets &scene, SoundPrefetchList *list) {
+		list->assets.clear();
+		list->requiredCount = 0;
+		if (scene.current == SceneId::_length) {
+			return;
+		}
+
+		const SceneManifest &current = sceneManifests[(size_t)scene.current];
+		for (u32 i = 0; i < current.soundCount; i++) {
+			list->add(current.sounds[i]);
+		}
+		list->requiredCount = (u32)list->assets.length;
+
+		for (SceneId next : scene.upcoming) {
+			const SceneManifest &manifest = sceneManifests[(size_t)next];
+			for (u32 i = 0; i < manifest.soundCount; i++) {
+				list->add(manifest.sounds[i]);
+			}
+		}
+	}
+};
\ No newline at end of file
@@ -8,11 +8,15 @@
 
 typedef f32 FuelValue;
 
+// Only what a template can hold, ships in combat can have any number
+#define SHIP_TARGET_MAX 16
+#define SHIP_WEAPON_MAX 16
+
 // NOTE(steven): Not sure if we want to extend sprite because we may end up using
 // data from Sprite that's not needed for the Ship
 struct Ship : Sprite {
 	FuelValue fuelTankCapacity = 0;
 	FuelValue fuel = 0;
-	Array<ShipTarget, 2> targets;
-	Array<Weapon, 2> weapons;
+	Array<ShipTarget, SHIP_TARGET_MAX> targets;
+	Array<Weapon, SHIP_WEAPON_MAX> weapons;
 };
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "common/entity.hpp"
 #include "common/game_definitions.hpp"
 #include "types/core.hpp"
 #include "types/vector.hpp"
@@ -9,4 +10,6 @@ struct ShipTarget {
 	HealthValue health = 0;
 	Vec3<f32> position;
 	f32 selectRadius;
+	// Ship the target belongs to once it's in combat
+	Entity ship = ENTITY_NONE;
 };
\ No newline at end of file
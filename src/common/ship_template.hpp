@@ -0,0 +1,461 @@
+#pragma once
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+
+#include "common/asset_definitions.hpp"
+#include "common/ship.hpp"
+#include "types/core.hpp"
+#include "utils/hash.hpp"
+
+#define SHIP_TEMPLATE_SOURCE_EXTENSION L".txt"
+#define SHIP_TEMPLATE_CACHE_EXTENSION L".bin"
+#define SHIP_TEMPLATE_SOURCE_MAX 8192
+#define SHIP_TEMPLATE_CACHE_MAX 2048
+#define SHIP_TEMPLATE_CACHE_MAGIC 0x54534253 // "SBST"
+// Bump whenever the text or cache layout changes so old caches are rebuilt
+#define SHIP_TEMPLATE_CACHE_VERSION 1
+
+struct ShipTemplateError {
+	u32 line;
+	char message[96];
+};
+
+struct ShipTemplateCacheHeader {
+	u32 magic;
+	u16 version;
+	u16 payloadSize;
+	u64 sourceHash;
+};
+
+// Ship templates are written by hand (or by the ship editor) in a line based
+// text format and compiled ahead of time into a binary cache by
+// tools/template_compiler:
+//
+//     # Comments run to the end of the line
+//     asset ship
+//     scale 0.5 0.5
+//     angle -95
+//     fuelTankCapacity 100
+//     fuel 100
+//
+//     # Every key after `target` or `weapon` belongs to that target or weapon,
+//     # positions are relative to the ship
+//     target
+//         maxHealth 100
+//         health 100
+//         position 0 -100 0
+//         selectRadius 50
+//
+//     weapon
+//         position 200 0 0
+//         selectRadius 50
+//         damage 20
+//         projectileSpeed 180
+//         cooldown 1
+//
+// A ship can have up to SHIP_TARGET_MAX targets and SHIP_WEAPON_MAX weapons,
+// each a block of its own. The cache stores the hash of the text it was built
+// from, loaders only parse the text when that hash no longer matches.
+namespace ShipTemplate {
+	enum class Block {
+		ship,
+		target,
+		weapon
+	};
+
+	// Carriage returns are skipped so a checkout that converts line endings
+	// doesn't make every cache stale
+	u64 hashSource(const char *text, size_t length) {
+		const u32 version = SHIP_TEMPLATE_CACHE_VERSION;
+		u64 hash = hashBytes(&version, sizeof(version));
+		for (size_t i = 0; i < length; i++) {
+			if (text[i] != '\r') {
+				hash = hashBytes(&text[i], 1, hash);
+			}
+		}
+		return hash;
+	}
+
+	bool fail(ShipTemplateError *error, u32 line, const char *message) {
+		error->line = line;
+		snprintf(error->message, sizeof(error->message), "%s", message);
+		return false;
+	}
+
+	bool isSpace(char c) {
+		return c == ' ' || c == '\t' || c == '\r';
+	}
+
+	bool isLineEnd(const char *values) {
+		while (isSpace(*values)) {
+			values++;
+		}
+		return *values == '\0';
+	}
+
+	bool readFloats(const char *values, f32 *result, size_t count) {
+		for (size_t i = 0; i < count; i++) {
+			int consumed = 0;
+			if (sscanf(values, " %f%n", &result[i], &consumed) != 1) {
+				return false;
+			}
+			values += consumed;
+		}
+		return isLineEnd(values);
+	}
+
+	bool readHealth(const char *values, HealthValue *result) {
+		unsigned int value = 0;
+		int consumed = 0;
+		if (sscanf(values, " %u%n", &value, &consumed) != 1 || value > (HealthValue)-1) {
+			return false;
+		}
+
+		*result = (HealthValue)value;
+		return isLineEnd(values + consumed);
+	}
+
+	bool readAsset(const char *values, TextureAssetId *result) {
+		char name[32];
+		int consumed = 0;
+		if (sscanf(values, " %31s%n", name, &consumed) != 1 || !isLineEnd(values + consumed)) {
+			return false;
+		}
+
+		for (size_t i = 0; i < (size_t)TextureAssetId::_length; i++) {
+			if (strcmp(name, textureAssetNames[i]) == 0) {
+				*result = (TextureAssetId)i;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool parse(const char *text, size_t length, Ship *ship, ShipTemplateError *error) {
+		*ship = {};
+
+		Block block = Block::ship;
+		u32 lineNumber = 0;
+		size_t lineStart = 0;
+
+		while (lineStart < length) {
+			lineNumber++;
+
+			size_t lineEnd = lineStart;
+			while (lineEnd < length && text[lineEnd] != '\n') {
+				lineEnd++;
+			}
+
+			char line[128];
+			const size_t lineLength = lineEnd - lineStart;
+			if (lineLength >= sizeof(line)) {
+				return fail(error, lineNumber, "line is too long");
+			}
+			memcpy(line, &text[lineStart], lineLength);
+			line[lineLength] = '\0';
+			lineStart = lineEnd + 1;
+
+			char *comment = strchr(line, '#');
+			if (comment != nullptr) {
+				*comment = '\0';
+			}
+
+			char key[32];
+			int consumed = 0;
+			if (sscanf(line, " %31s%n", key, &consumed) != 1) {
+				continue;
+			}
+			const char *values = line + consumed;
+
+			bool valid = true;
+			if (strcmp(key, "target") == 0 || strcmp(key, "weapon") == 0) {
+				if (!isLineEnd(values)) {
+					return fail(error, lineNumber, "unexpected value after block name");
+				}
+
+				const bool isTarget = key[0] == 't';
+				const size_t count = isTarget ? ship->targets.length : ship->weapons.length;
+				const size_t limit = isTarget ? SHIP_TARGET_MAX : SHIP_WEAPON_MAX;
+				if (count == limit) {
+					char message[sizeof(error->message)];
+					snprintf(message, sizeof(message), "too many %ss (max %zu)", key, limit);
+					return fail(error, lineNumber, message);
+				}
+
+				if (isTarget) {
+					ship->targets.push({});
+					block = Block::target;
+				} else {
+					ship->weapons.push({});
+					block = Block::weapon;
+				}
+			} else if (block == Block::target) {
+				ShipTarget &target = ship->targets[ship->targets.length - 1];
+				if (strcmp(key, "maxHealth") == 0) {
+					valid = readHealth(values, &target.maxHealth);
+				} else if (strcmp(key, "health") == 0) {
+					valid = readHealth(values, &target.health);
+				} else if (strcmp(key, "position") == 0) {
+					valid = readFloats(values, &target.position.x, 3);
+				} else if (strcmp(key, "selectRadius") == 0) {
+					valid = readFloats(values, &target.selectRadius, 1) && target.selectRadius >= 0.0f;
+				} else {
+					return fail(error, lineNumber, "unknown target key");
+				}
+			} else if (block == Block::weapon) {
+				Weapon &weapon = ship->weapons[ship->weapons.length - 1];
+				if (strcmp(key, "position") == 0) {
+					valid = readFloats(values, &weapon.position.x, 3);
+				} else if (strcmp(key, "selectRadius") == 0) {
+					valid = readFloats(values, &weapon.selectRadius, 1) && weapon.selectRadius >= 0.0f;
+				} else if (strcmp(key, "damage") == 0) {
+					valid = readHealth(values, &weapon.damage);
+				} else if (strcmp(key, "projectileSpeed") == 0) {
+					valid = readFloats(values, &weapon.projectileSpeed, 1) && weapon.projectileSpeed >= 0.0f;
+				} else if (strcmp(key, "cooldown") == 0) {
+					valid = readFloats(values, &weapon.cooldown, 1) && weapon.cooldown > 0.0f;
+				} else {
+					return fail(error, lineNumber, "unknown weapon key");
+				}
+			} else {
+				if (strcmp(key, "asset") == 0) {
+					valid = readAsset(values, &ship->assetId);
+				} else if (strcmp(key, "scale") == 0) {
+					valid = readFloats(values, &ship->scale.x, 2) && ship->scale.x > 0.0f && ship->scale.y > 0.0f;
+				} else if (strcmp(key, "angle") == 0) {
+					valid = readFloats(values, &ship->angle, 1);
+				} else if (strcmp(key, "fuelTankCapacity") == 0) {
+					valid = readFloats(values, &ship->fuelTankCapacity, 1) && ship->fuelTankCapacity >= 0.0f;
+				} else if (strcmp(key, "fuel") == 0) {
+					valid = readFloats(values, &ship->fuel, 1) && ship->fuel >= 0.0f;
+				} else {
+					return fail(error, lineNumber, "unknown ship key");
+				}
+			}
+
+			if (!valid) {
+				char message[sizeof(error->message)];
+				snprintf(message, sizeof(message), "invalid value for '%s'", key);
+				return fail(error, lineNumber, message);
+			}
+		}
+
+		if (ship->fuel > ship->fuelTankCapacity) {
+			return fail(error, lineNumber, "fuel is more than fuelTankCapacity");
+		}
+		for (const ShipTarget &target : ship->targets) {
+			if (target.health > target.maxHealth) {
+				return fail(error, lineNumber, "target health is more than maxHealth");
+			}
+		}
+
+		return true;
+	}
+
+	// Shortest of the two that still reads back as the same value, so saved
+	// templates stay readable
+	void formatFloat(f32 value, char *buffer, size_t size) {
+		snprintf(buffer, size, "%.6g", value);
+		if (strtof(buffer, nullptr) != value) {
+			snprintf(buffer, size, "%.9g", value);
+		}
+	}
+
+	struct TextStream {
+		char *data;
+		size_t size;
+		size_t length = 0;
+		bool overflow = false;
+
+		void append(const char *format, ...) {
+			if (this->overflow) {
+				return;
+			}
+
+			va_list arguments;
+			va_start(arguments, format);
+			const int written = vsnprintf(this->data + this->length, this->size - this->length, format, arguments);
+			va_end(arguments);
+
+			if (written < 0 || (size_t)written >= this->size - this->length) {
+				this->overflow = true;
+				return;
+			}
+			this->length += written;
+		}
+	};
+
+	// Returns the length of the text or 0 if it didn't fit in `buffer`
+	size_t write(const Ship &ship, char *buffer, size_t size) {
+		TextStream stream = {};
+		stream.data = buffer;
+		stream.size = size;
+		char a[24], b[24], c[24];
+
+		stream.append("asset %s\n", textureAssetNames[(size_t)ship.assetId]);
+		formatFloat(ship.scale.x, a, sizeof(a));
+		formatFloat(ship.scale.y, b, sizeof(b));
+		stream.append("scale %s %s\n", a, b);
+		formatFloat(ship.angle, a, sizeof(a));
+		stream.append("angle %s\n", a);
+		formatFloat(ship.fuelTankCapacity, a, sizeof(a));
+		stream.append("fuelTankCapacity %s\n", a);
+		formatFloat(ship.fuel, a, sizeof(a));
+		stream.append("fuel %s\n", a);
+
+		for (const ShipTarget &target : ship.targets) {
+			stream.append("\ntarget\n");
+			stream.append("\tmaxHealth %u\n", (u32)target.maxHealth);
+			stream.append("\thealth %u\n", (u32)target.health);
+			formatFloat(target.position.x, a, sizeof(a));
+			formatFloat(target.position.y, b, sizeof(b));
+			formatFloat(target.position.z, c, sizeof(c));
+			stream.append("\tposition %s %s %s\n", a, b, c);
+			formatFloat(target.selectRadius, a, sizeof(a));
+			stream.append("\tselectRadius %s\n", a);
+		}
+
+		for (const Weapon &weapon : ship.weapons) {
+			stream.append("\nweapon\n");
+			formatFloat(weapon.position.x, a, sizeof(a));
+			formatFloat(weapon.position.y, b, sizeof(b));
+			formatFloat(weapon.position.z, c, sizeof(c));
+			stream.append("\tposition %s %s %s\n", a, b, c);
+			formatFloat(weapon.selectRadius, a, sizeof(a));
+			stream.append("\tselectRadius %s\n", a);
+			stream.append("\tdamage %u\n", (u32)weapon.damage);
+			formatFloat(weapon.projectileSpeed, a, sizeof(a));
+			stream.append("\tprojectileSpeed %s\n", a);
+			formatFloat(weapon.cooldown, a, sizeof(a));
+			stream.append("\tcooldown %s\n", a);
+		}
+
+		return stream.overflow ? 0 : stream.length;
+	}
+
+	// Only the authored fields are stored, runtime state like a weapon's target
+	// is left to its defaults when read back
+	struct CacheStream {
+		u8 *data;
+		size_t size;
+		size_t offset = 0;
+		bool overflow = false;
+
+		template<typename T>
+		void write(const T &value) {
+			if (this->offset + sizeof(T) > this->size) {
+				this->overflow = true;
+				return;
+			}
+			memcpy(this->data + this->offset, &value, sizeof(T));
+			this->offset += sizeof(T);
+		}
+
+		template<typename T>
+		void read(T *value) {
+			if (this->offset + sizeof(T) > this->size) {
+				this->overflow = true;
+				return;
+			}
+			memcpy(value, this->data + this->offset, sizeof(T));
+			this->offset += sizeof(T);
+		}
+	};
+
+	template<typename T>
+	void serialise(CacheStream *stream, T *value, bool reading) {
+		if (reading) {
+			stream->read(value);
+		} else {
+			stream->write(*value);
+		}
+	}
+
+	// Same field order both ways so the reader and writer can't drift apart
+	void serialiseShip(CacheStream *stream, Ship *ship, bool reading) {
+		serialise(stream, &ship->assetId, reading);
+		serialise(stream, &ship->scale, reading);
+		serialise(stream, &ship->angle, reading);
+		serialise(stream, &ship->fuelTankCapacity, reading);
+		serialise(stream, &ship->fuel, reading);
+
+		u8 targetCount = (u8)ship->targets.length;
+		serialise(stream, &targetCount, reading);
+		u8 weaponCount = (u8)ship->weapons.length;
+		serialise(stream, &weaponCount, reading);
+		if (reading && (targetCount > SHIP_TARGET_MAX || weaponCount > SHIP_WEAPON_MAX)) {
+			stream->overflow = true;
+			return;
+		}
+		ship->targets.length = targetCount;
+		ship->weapons.length = weaponCount;
+
+		for (ShipTarget &target : ship->targets) {
+			serialise(stream, &target.maxHealth, reading);
+			serialise(stream, &target.health, reading);
+			serialise(stream, &target.position, reading);
+			serialise(stream, &target.selectRadius, reading);
+		}
+
+		for (Weapon &weapon : ship->weapons) {
+			serialise(stream, &weapon.position, reading);
+			serialise(stream, &weapon.selectRadius, reading);
+			serialise(stream, &weapon.damage, reading);
+			serialise(stream, &weapon.projectileSpeed, reading);
+			serialise(stream, &weapon.cooldown, reading);
+		}
+	}
+
+	// Returns the size of the cache or 0 if it didn't fit in `buffer`
+	size_t writeCache(const Ship &ship, u64 sourceHash, u8 *buffer, size_t size) {
+		if (size < sizeof(ShipTemplateCacheHeader)) {
+			return 0;
+		}
+
+		CacheStream stream = {};
+		stream.data = buffer + sizeof(ShipTemplateCacheHeader);
+		stream.size = size - sizeof(ShipTemplateCacheHeader);
+		serialiseShip(&stream, (Ship*)&ship, false);
+		if (stream.overflow) {
+			return 0;
+		}
+
+		ShipTemplateCacheHeader header = {};
+		header.magic = SHIP_TEMPLATE_CACHE_MAGIC;
+		header.version = SHIP_TEMPLATE_CACHE_VERSION;
+		header.payloadSize = (u16)stream.offset;
+		header.sourceHash = sourceHash;
+		memcpy(buffer, &header, sizeof(header));
+
+		return sizeof(header) + stream.offset;
+	}
+
+	// Fails if the cache is malformed, from another version or was built from
+	// different source text
+	bool readCache(const u8 *data, size_t size, u64 sourceHash, Ship *ship) {
+		ShipTemplateCacheHeader header;
+		if (size < sizeof(header)) {
+			return false;
+		}
+		memcpy(&header, data, sizeof(header));
+
+		if (
+			header.magic != SHIP_TEMPLATE_CACHE_MAGIC ||
+			header.version != SHIP_TEMPLATE_CACHE_VERSION ||
+			header.sourceHash != sourceHash ||
+			sizeof(header) + header.payloadSize != size
+		) {
+			return false;
+		}
+
+		*ship = {};
+
+		CacheStream stream = {};
+		stream.data = (u8*)data + sizeof(header);
+		stream.size = header.payloadSize;
+		serialiseShip(&stream, ship, true);
+		return !stream.overflow && stream.offset == stream.size && (size_t)ship->assetId < (size_t)TextureAssetId::_length;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,204 @@
+#pragma once
+
+#include <cassert>
+
+#include "common/shipment.hpp"
+#include "common/system_location.hpp"
+#include "types/core.hpp"
+
+typedef u16 ShipmentHandle;
+const ShipmentHandle SHIPMENT_HANDLE_NONE = (ShipmentHandle)-1;
+
+// Fixed capacity storage for the shipments the player is carrying. Every
+// shipment lives in a stable slot and is linked into two per-location buckets
+// (one for its destination and one for its origin) so that questions like
+// "what can be delivered here?" only touch the shipments that match.
+//
+// Buckets are doubly linked in insertion order, which gives O(1) `push` and
+// `remove` while keeping the order of the remaining shipments stable. Removing
+// the shipment currently being visited while iterating over a bucket is safe.
+//
+// Example:
+//
+//     for (ShipmentHandle handle : store.to(gameState->dockedLocation)) {
+//         const Shipment &shipment = store[handle];
+//         ...
+//         store.remove(handle);
+//     }
+//
+template<size_t Size, size_t LocationCount>
+struct ShipmentStore {
+	static_assert(Size < SHIPMENT_HANDLE_NONE, "ShipmentStore size exceeds handle range");
+
+	struct Links {
+		ShipmentHandle next = SHIPMENT_HANDLE_NONE;
+		ShipmentHandle previous = SHIPMENT_HANDLE_NONE;
+	};
+
+	struct Bucket {
+		ShipmentHandle head = SHIPMENT_HANDLE_NONE;
+		ShipmentHandle tail = SHIPMENT_HANDLE_NONE;
+		size_t length = 0;
+	};
+
+	struct BucketView {
+		struct Iterator {
+			const Links *links;
+			ShipmentHandle handle;
+
+			ShipmentHandle operator *() const {
+				return this->handle;
+			}
+
+			Iterator &operator ++() {
+				this->handle = this->links[this->handle].next;
+				return *this;
+			}
+
+			bool operator !=(const Iterator &other) const {
+				return this->handle != other.handle;
+			}
+		};
+
+		const Links *links;
+		const Bucket *bucket;
+
+		Iterator begin() const {
+			return { this->links, this->bucket->head };
+		}
+
+		Iterator end() const {
+			return { this->links, SHIPMENT_HANDLE_NONE };
+		}
+
+		bool empty() const {
+			return this->bucket->length == 0;
+		}
+
+		size_t length() const {
+			return this->bucket->length;
+		}
+	};
+
+	size_t length = 0;
+
+	ShipmentStore() {
+		this->clear();
+	}
+
+	Shipment &operator [](ShipmentHandle handle) {
+		assert(handle < Size && this->used[handle]);
+		return this->shipments[handle];
+	}
+
+	const Shipment &operator [](ShipmentHandle handle) const {
+		assert(handle < Size && this->used[handle]);
+		return this->shipments[handle];
+	}
+
+	void clear() {
+		this->length = 0;
+
+		for (size_t i = 0; i < Size; i++) {
+			this->used[i] = false;
+			this->toLinks[i] = {};
+			this->fromLinks[i] = {};
+			this->nextFree[i] = i + 1 < Size ? (ShipmentHandle)(i + 1) : SHIPMENT_HANDLE_NONE;
+		}
+		this->freeHead = 0;
+
+		for (size_t i = 0; i < LocationCount; i++) {
+			this->toBuckets[i] = {};
+			this->fromBuckets[i] = {};
+		}
+	}
+
+	bool isFull() const {
+		return this->length == Size;
+	}
+
+	ShipmentHandle push(const Shipment &shipment) {
+		assert(!this->isFull());
+		assert(shipment.from != nullptr && shipment.to != nullptr);
+
+		const ShipmentHandle handle = this->freeHead;
+		this->freeHead = this->nextFree[handle];
+
+		this->shipments[handle] = shipment;
+		this->used[handle] = true;
+		this->length++;
+
+		this->link(this->toLinks, &this->toBuckets[shipment.to->id], handle);
+		this->link(this->fromLinks, &this->fromBuckets[shipment.from->id], handle);
+
+		return handle;
+	}
+
+	void remove(ShipmentHandle handle) {
+		assert(handle < Size && this->used[handle]);
+
+		const Shipment &shipment = this->shipments[handle];
+		this->unlink(this->toLinks, &this->toBuckets[shipment.to->id], handle);
+		this->unlink(this->fromLinks, &this->fromBuckets[shipment.from->id], handle);
+
+		this->used[handle] = false;
+		this->length--;
+
+		this->nextFree[handle] = this->freeHead;
+		this->freeHead = handle;
+	}
+
+	// Shipments whose destination is `location`
+	BucketView to(const SystemLocation *location) const {
+		return { this->toLinks, &this->toBuckets[location->id] };
+	}
+
+	// Shipments that were picked up at `location`
+	BucketView from(const SystemLocation *location) const {
+		return { this->fromLinks, &this->fromBuckets[location->id] };
+	}
+
+protected:
+	Shipment shipments[Size];
+	bool used[Size];
+	Links toLinks[Size];
+	Links fromLinks[Size];
+	ShipmentHandle nextFree[Size];
+	ShipmentHandle freeHead;
+	Bucket toBuckets[LocationCount];
+	Bucket fromBuckets[LocationCount];
+
+	void link(Links *links, Bucket *bucket, ShipmentHandle handle) {
+		links[handle].previous = bucket->tail;
+		links[handle].next = SHIPMENT_HANDLE_NONE;
+
+		if (bucket->tail != SHIPMENT_HANDLE_NONE) {
+			links[bucket->tail].next = handle;
+		} else {
+			bucket->head = handle;
+		}
+
+		bucket->tail = handle;
+		bucket->length++;
+	}
+
+	// NOTE: The removed slot keeps its `next` link so that an iterator
+	// currently pointing at it can still step forward.
+	void unlink(Links *links, Bucket *bucket, ShipmentHandle handle) {
+		const Links &removed = links[handle];
+
+		if (removed.previous != SHIPMENT_HANDLE_NONE) {
+			links[removed.previous].next = removed.next;
+		} else {
+			bucket->head = removed.next;
+		}
+
+		if (removed.next != SHIPMENT_HANDLE_NONE) {
+			links[removed.next].previous = removed.previous;
+		} else {
+			bucket->tail = removed.previous;
+		}
+
+		bucket->length--;
+	}
+};
\ No newline at end of file
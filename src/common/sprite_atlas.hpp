@@ -0,0 +1,451 @@
+#pragma once
+
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+
+#include "common/asset_definitions.hpp"
+#include "types/array.hpp"
+#include "types/core.hpp"
+#include "types/vector.hpp"
+#include "utils/memory.hpp"
+
+#define SPRITE_ATLAS_PAGE_MAX 8
+#define SPRITE_ATLAS_SKYLINE_MAX 1024
+#define SPRITE_ATLAS_NAME_MAX 24
+#define SPRITE_ATLAS_ENTRY_MAX 64
+#define SPRITE_ATLAS_MANIFEST_MAX 4096
+#define SPRITE_ATLAS_NO_PAGE 0xff
+#define SPRITE_ATLAS_DIRECTORY "img/atlas/"
+#define SPRITE_ATLAS_MANIFEST_NAME "atlas.bin"
+// Formatted with the page's index
+#define SPRITE_ATLAS_PAGE_NAME "page%u.png"
+#define SPRITE_ATLAS_MANIFEST_PATH GET_ASSET_PATH(SPRITE_ATLAS_DIRECTORY SPRITE_ATLAS_MANIFEST_NAME)
+#define SPRITE_ATLAS_PAGE_PATH GET_ASSET_PATH(SPRITE_ATLAS_DIRECTORY SPRITE_ATLAS_PAGE_NAME)
+#define SPRITE_ATLAS_MAGIC 0x54414253 // "SBAT"
+// Bump whenever the manifest layout changes so old atlases are rebuilt
+#define SPRITE_ATLAS_VERSION 1
+
+struct AtlasRect {
+	u16 x;
+	u16 y;
+	u16 width;
+	u16 height;
+};
+
+struct SpriteAtlasEntry {
+	u8 page = SPRITE_ATLAS_NO_PAGE;
+	// Where the image is on the page, not counting the padding round it
+	AtlasRect rect;
+};
+
+struct SpriteAtlasPage {
+	u16 width;
+	u16 height;
+};
+
+// Which page each texture was packed into and where, textures that weren't
+// packed are loaded on their own
+struct SpriteAtlasManifest {
+	u32 pageCount;
+	SpriteAtlasPage pages[SPRITE_ATLAS_PAGE_MAX];
+	SpriteAtlasEntry entries[(size_t)TextureAssetId::_length];
+};
+
+// Textures are stored by name so adding or reordering TextureAssetIds doesn't
+// make the atlas point at the wrong images
+struct SpriteAtlasFileHeader {
+	u32 magic;
+	u16 version;
+	u16 pageCount;
+	u16 entryCount;
+	u16 padding;
+};
+
+struct SpriteAtlasFileEntry {
+	char name[SPRITE_ATLAS_NAME_MAX];
+	u8 page;
+	u8 padding;
+	AtlasRect rect;
+};
+
+struct AtlasPackerConfig {
+	u16 pageWidth = 2048;
+	u16 pageHeight = 2048;
+	// Pixels left round each image, filled by stretching its edges so
+	// filtering at the border doesn't pick up the neighbouring image
+	u16 padding = 1;
+};
+
+struct AtlasPlacement {
+	u8 page;
+	AtlasRect rect;
+};
+
+// Packs images into as few pages as it can with a skyline: each page keeps
+// the height of the packed images along its width, and every image goes
+// where its top ends up lowest, leaving the least gap under it. Images are
+// placed tallest first, which is what keeps the skyline flat.
+//
+// Example:
+//
+//     AtlasPacker *packer = Memory::create<AtlasPacker>(MemoryTag::textures);
+//     if (packer->pack(sizes, count, placements)) {
+//         for (u32 page = 0; page < packer->getPageCount(); page++) {
+//             const SpriteAtlasPage size = packer->getPageSize(page);
+//             ...
+//         }
+//     }
+//
+struct AtlasPacker {
+	AtlasPackerConfig config;
+
+	// `sizes` holds each image's width and height, the x and y are ignored.
+	// Fails if an image is bigger than a page or they don't all fit in
+	// SPRITE_ATLAS_PAGE_MAX pages.
+	bool pack(const AtlasRect *sizes, u32 count, AtlasPlacement *placements) {
+		assert(this->config.pageWidth > 0 && this->config.pageHeight > 0);
+		this->pageCount = 0;
+
+		SortedSize *order = Memory::allocateArray<SortedSize>(MemoryTag::textures, count > 0 ? count : 1);
+		for (u32 i = 0; i < count; i++) {
+			order[i] = { sizes[i].width, sizes[i].height, i };
+		}
+		qsort(order, count, sizeof(SortedSize), compareSizes);
+
+		bool succeeded = true;
+		for (u32 i = 0; i < count && succeeded; i++) {
+			const SortedSize &size = order[i];
+			const u32 width = size.width + this->config.padding * 2u;
+			const u32 height = size.height + this->config.padding * 2u;
+			if (width > this->config.pageWidth || height > this->config.pageHeight) {
+				succeeded = false;
+				break;
+			}
+
+			// The first page with room, the pages before are usually close to
+			// full so it's rare to go back more than one
+			succeeded = false;
+			for (u32 page = 0; page < SPRITE_ATLAS_PAGE_MAX && !succeeded; page++) {
+				if (page == this->pageCount) {
+					this->openPage();
+				}
+
+				u16 x;
+				u16 y;
+				if (this->place(&this->pages[page], width, height, &x, &y)) {
+					AtlasPlacement &placement = placements[size.index];
+					placement.page = (u8)page;
+					placement.rect = { (u16)(x + this->config.padding), (u16)(y + this->config.padding), size.width, size.height };
+					succeeded = true;
+				}
+			}
+		}
+
+		Memory::release(order);
+		return succeeded;
+	}
+
+	u32 getPageCount() const {
+		return this->pageCount;
+	}
+
+	// Trimmed to what was used, rounded up to whole 4x4 blocks
+	SpriteAtlasPage getPageSize(u32 page) const {
+		assert(page < this->pageCount);
+		const Page &packed = this->pages[page];
+
+		const u32 width = (packed.usedWidth + 3u) & ~3u;
+		const u32 height = (packed.usedHeight + 3u) & ~3u;
+		return {
+			(u16)(width < this->config.pageWidth ? width : this->config.pageWidth),
+			(u16)(height < this->config.pageHeight ? height : this->config.pageHeight)
+		};
+	}
+
+protected:
+	struct SortedSize {
+		u16 width;
+		u16 height;
+		u32 index;
+	};
+
+	struct SkylineNode {
+		u16 x;
+		u16 y;
+		u16 width;
+	};
+
+	struct Page {
+		Array<SkylineNode, SPRITE_ATLAS_SKYLINE_MAX> skyline;
+		u16 usedWidth;
+		u16 usedHeight;
+	};
+
+	Page pages[SPRITE_ATLAS_PAGE_MAX];
+	u32 pageCount = 0;
+
+	// Tallest first, then widest, then in the order given so packing the
+	// same images always gives the same atlas
+	static int compareSizes(const void *a, const void *b) {
+		const SortedSize &left = *(const SortedSize*)a;
+		const SortedSize &right = *(const SortedSize*)b;
+		if (left.height != right.height) {
+			return left.height > right.height ? -1 : 1;
+		}
+		if (left.width != right.width) {
+			return left.width > right.width ? -1 : 1;
+		}
+		return left.index < right.index ? -1 : (left.index > right.index ? 1 : 0);
+	}
+
+	void openPage() {
+		Page &page = this->pages[this->pageCount++];
+		page.skyline.clear();
+		page.skyline.push({ 0, 0, this->config.pageWidth });
+		page.usedWidth = 0;
+		page.usedHeight = 0;
+	}
+
+	// Where the bottom of an image starting at node `index` would sit, false
+	// if it would go off the page. `waste` is the area left empty under it.
+	bool fit(const Page &page, u32 index, u32 width, u32 height, u32 *y, u32 *waste) const {
+		const SkylineNode &start = page.skyline.data[index];
+		if (start.x + width > this->config.pageWidth) {
+			return false;
+		}
+
+		u32 top = 0;
+		s32 widthLeft = (s32)width;
+		for (u32 i = index; widthLeft > 0; i++) {
+			// The skyline covers the whole width so this can't run off the end
+			assert(i < page.skyline.length);
+			top = page.skyline.data[i].y > top ? page.skyline.data[i].y : top;
+			if (top + height > this->config.pageHeight) {
+				return false;
+			}
+			widthLeft -= page.skyline.data[i].width;
+		}
+
+		u32 empty = 0;
+		widthLeft = (s32)width;
+		for (u32 i = index; widthLeft > 0; i++) {
+			const SkylineNode &node = page.skyline.data[i];
+			const u32 covered = (s32)node.width < widthLeft ? node.width : (u32)widthLeft;
+			empty += (top - node.y) * covered;
+			widthLeft -= node.width;
+		}
+
+		*y = top;
+		*waste = empty;
+		return true;
+	}
+
+	bool place(Page *page, u32 width, u32 height, u16 *x, u16 *y) {
+		u32 bestIndex = 0;
+		u32 bestTop = 0xffffffff;
+		u32 bestWaste = 0xffffffff;
+
+		for (u32 i = 0; i < page->skyline.length; i++) {
+			u32 top;
+			u32 waste;
+			if (!this->fit(*page, i, width, height, &top, &waste)) {
+				continue;
+			}
+
+			if (top + height < bestTop || (top + height == bestTop && waste < bestWaste)) {
+				bestIndex = i;
+				bestTop = top + height;
+				bestWaste = waste;
+			}
+		}
+
+		// NOTE: Each image adds at most one node, so running out of nodes
+		// means the page is full of tiny images. Treated as the page being
+		// full rather than growing the skyline.
+		if (bestTop == 0xffffffff || page->skyline.length == SPRITE_ATLAS_SKYLINE_MAX) {
+			return false;
+		}
+
+		*x = page->skyline.data[bestIndex].x;
+		*y = (u16)(bestTop - height);
+		this->raise(page, bestIndex, width, (u16)bestTop);
+
+		const u32 right = *x + width;
+		page->usedWidth = right > page->usedWidth ? (u16)right : page->usedWidth;
+		page->usedHeight = bestTop > page->usedHeight ? (u16)bestTop : page->usedHeight;
+		return true;
+	}
+
+	// Puts a node of `width` at `top` where node `index` starts, trimming
+	// the ones it covers and merging neighbours left at the same height
+	void raise(Page *page, u32 index, u32 width, u16 top) {
+		Array<SkylineNode, SPRITE_ATLAS_SKYLINE_MAX> &skyline = page->skyline;
+		const SkylineNode raised = { skyline.data[index].x, top, (u16)width };
+		const u32 right = raised.x + width;
+
+		// Whatever sticks out past the new node's right edge stays
+		u32 end = index;
+		while (end < skyline.length && skyline.data[end].x + skyline.data[end].width <= right) {
+			end++;
+		}
+
+		SkylineNode remainder = {};
+		const bool split = end < skyline.length && skyline.data[end].x < right;
+		if (split) {
+			const SkylineNode &node = skyline.data[end];
+			remainder = { (u16)right, node.y, (u16)(node.x + node.width - right) };
+			end++;
+		}
+
+		// Swap nodes [index, end) for the new node and the remainder
+		const u32 inserted = split ? 2 : 1;
+		const u32 removed = end - index;
+		const u32 tail = (u32)skyline.length - end;
+		memmove(&skyline.data[index + inserted], &skyline.data[end], tail * sizeof(SkylineNode));
+		skyline.length = skyline.length - removed + inserted;
+		skyline.data[index] = raised;
+		if (split) {
+			skyline.data[index + 1] = remainder;
+		}
+
+		u32 write = 0;
+		for (u32 read = 0; read < skyline.length; read++) {
+			if (write > 0 && skyline.data[write - 1].y == skyline.data[read].y) {
+				skyline.data[write - 1].width += skyline.data[read].width;
+			} else {
+				skyline.data[write++] = skyline.data[read];
+			}
+		}
+		skyline.length = write;
+	}
+};
+
+namespace SpriteAtlas {
+	// Offset and size on the page in texture coordinates
+	Vec4 uvRect(const SpriteAtlasManifest &manifest, TextureAssetId assetId) {
+		const SpriteAtlasEntry &entry = manifest.entries[(size_t)assetId];
+		if (entry.page == SPRITE_ATLAS_NO_PAGE) {
+			return Vec4(0.0f, 0.0f, 1.0f, 1.0f);
+		}
+
+		const SpriteAtlasPage &page = manifest.pages[entry.page];
+		return Vec4(
+			(f32)entry.rect.x / page.width,
+			(f32)entry.rect.y / page.height,
+			(f32)entry.rect.width / page.width,
+			(f32)entry.rect.height / page.height
+		);
+	}
+
+	// Copies an image onto its page and stretches its edge pixels out over
+	// `padding` pixels on every side
+	void blit(u32 *page, u32 pageWidth, u32 pageHeight, const AtlasRect &rect, const u32 *pixels, u32 padding) {
+		const s32 left = (s32)rect.x - (s32)padding;
+		const s32 top = (s32)rect.y - (s32)padding;
+		const s32 right = rect.x + rect.width + padding;
+		const s32 bottom = rect.y + rect.height + padding;
+
+		for (s32 y = top < 0 ? 0 : top; y < bottom && y < (s32)pageHeight; y++) {
+			s32 sourceY = y - rect.y;
+			sourceY = sourceY < 0 ? 0 : (sourceY >= rect.height ? rect.height - 1 : sourceY);
+			const u32 *source = pixels + (size_t)sourceY * rect.width;
+			u32 *destination = page + (size_t)y * pageWidth;
+
+			for (s32 x = left < 0 ? 0 : left; x < right && x < (s32)pageWidth; x++) {
+				s32 sourceX = x - rect.x;
+				sourceX = sourceX < 0 ? 0 : (sourceX >= rect.width ? rect.width - 1 : sourceX);
+				destination[x] = source[sourceX];
+			}
+		}
+	}
+
+	// Returns the size of the manifest or 0 if it didn't fit in `buffer`
+	size_t writeManifest(const SpriteAtlasManifest &manifest, u8 *buffer, size_t size) {
+		u32 entryCount = 0;
+		for (const SpriteAtlasEntry &entry : manifest.entries) {
+			entryCount += entry.page != SPRITE_ATLAS_NO_PAGE;
+		}
+
+		const size_t pagesSize = manifest.pageCount * sizeof(SpriteAtlasPage);
+		const size_t total = sizeof(SpriteAtlasFileHeader) + pagesSize + entryCount * sizeof(SpriteAtlasFileEntry);
+		if (total > size) {
+			return 0;
+		}
+
+		SpriteAtlasFileHeader header = {};
+		header.magic = SPRITE_ATLAS_MAGIC;
+		header.version = SPRITE_ATLAS_VERSION;
+		header.pageCount = (u16)manifest.pageCount;
+		header.entryCount = (u16)entryCount;
+		memcpy(buffer, &header, sizeof(header));
+		memcpy(buffer + sizeof(header), manifest.pages, pagesSize);
+
+		u8 *entries = buffer + sizeof(header) + pagesSize;
+		for (size_t i = 0; i < (size_t)TextureAssetId::_length; i++) {
+			const SpriteAtlasEntry &entry = manifest.entries[i];
+			if (entry.page == SPRITE_ATLAS_NO_PAGE) {
+				continue;
+			}
+
+			SpriteAtlasFileEntry fileEntry = {};
+			strncpy(fileEntry.name, textureAssetNames[i], SPRITE_ATLAS_NAME_MAX - 1);
+			fileEntry.page = entry.page;
+			fileEntry.rect = entry.rect;
+			memcpy(entries, &fileEntry, sizeof(fileEntry));
+			entries += sizeof(fileEntry);
+		}
+
+		return total;
+	}
+
+	// Fails if the manifest is malformed or from another version. Textures it
+	// names that no longer exist are skipped.
+	bool readManifest(const u8 *data, size_t size, SpriteAtlasManifest *manifest) {
+		*manifest = {};
+
+		SpriteAtlasFileHeader header;
+		if (size < sizeof(header)) {
+			return false;
+		}
+		memcpy(&header, data, sizeof(header));
+
+		const size_t pagesSize = header.pageCount * sizeof(SpriteAtlasPage);
+		if (
+			header.magic != SPRITE_ATLAS_MAGIC ||
+			header.version != SPRITE_ATLAS_VERSION ||
+			header.pageCount > SPRITE_ATLAS_PAGE_MAX ||
+			header.entryCount > SPRITE_ATLAS_ENTRY_MAX ||
+			sizeof(header) + pagesSize + header.entryCount * sizeof(SpriteAtlasFileEntry) != size
+		) {
+			return false;
+		}
+
+		manifest->pageCount = header.pageCount;
+		memcpy(manifest->pages, data + sizeof(header), pagesSize);
+
+		const u8 *entries = data + sizeof(header) + pagesSize;
+		for (u32 i = 0; i < header.entryCount; i++) {
+			SpriteAtlasFileEntry fileEntry;
+			memcpy(&fileEntry, entries + i * sizeof(fileEntry), sizeof(fileEntry));
+			fileEntry.name[SPRITE_ATLAS_NAME_MAX - 1] = '\0';
+
+			if (fileEntry.page >= header.pageCount) {
+				return false;
+			}
+			const SpriteAtlasPage &page = manifest->pages[fileEntry.page];
+			if (fileEntry.rect.x + fileEntry.rect.width > page.width || fileEntry.rect.y + fileEntry.rect.height > page.height) {
+				return false;
+			}
+
+			for (size_t id = 0; id < (size_t)TextureAssetId::_length; id++) {
+				if (strcmp(fileEntry.name, textureAssetNames[id]) == 0) {
+					manifest->entries[id].page = fileEntry.page;
+					manifest->entries[id].rect = fileEntry.rect;
+				}
+			}
+		}
+
+		return true;
+	}
+};
\ No newline at end of file
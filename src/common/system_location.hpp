@@ -5,6 +5,8 @@
 #include "types/vector.hpp"
 
 struct SystemLocation {
+	// Index into `GameState::systemLocations`
+	u8 id = 0;
 	String16<32> name;
 	Rgba color = Rgba(1.0f, 1.0f, 1.0f, 1.0f);
 	struct {
@@ -9,7 +9,7 @@ struct TemplateData {
 	T data;
 };
 
-typedef Array<TemplateData<Ship>, 2> ShipTemplates;
+typedef Array<TemplateData<Ship>, 3> ShipTemplates;
 
 struct Templates {
 	ShipTemplates ships;
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <cassert>
+#include <wchar.h>
+
+#include "common/ui_element.hpp"
+#include "types/core.hpp"
+#include "utils/hash.hpp"
+
+// Everything that affects how a piece of text is laid out. Position and color
+// are left out on purpose as they can change without needing a new layout.
+struct TextRunKey {
+	u64 hash;
+	String16<100> text;
+	String16<32> font;
+	f32 fontSize;
+	f32 width, height;
+	UITextAlignment horizontalAlignment;
+	UITextAlignment verticalAlignment;
+
+	TextRunKey() = default;
+
+	TextRunKey(const UITextData &element) :
+		text(element.text),
+		font(element.font),
+		fontSize(element.fontSize),
+		width(element.width),
+		height(element.height),
+		horizontalAlignment(element.horizontalAlignment),
+		verticalAlignment(element.verticalAlignment)
+	{
+		this->hash = hashBytes(this->text.data, wcslen(this->text.data) * sizeof(wchar_t));
+		this->hash = hashBytes(this->font.data, wcslen(this->font.data) * sizeof(wchar_t), this->hash);
+		this->hash = hashBytes(&this->fontSize, sizeof(this->fontSize), this->hash);
+		this->hash = hashBytes(&this->width, sizeof(this->width), this->hash);
+		this->hash = hashBytes(&this->height, sizeof(this->height), this->hash);
+		this->hash = hashBytes(&this->horizontalAlignment, sizeof(this->horizontalAlignment), this->hash);
+		this->hash = hashBytes(&this->verticalAlignment, sizeof(this->verticalAlignment), this->hash);
+	}
+
+	bool operator ==(const TextRunKey &other) const {
+		return 
+			this->hash == other.hash &&
+			this->fontSize == other.fontSize &&
+			this->width == other.width &&
+			this->height == other.height &&
+			this->horizontalAlignment == other.horizontalAlignment &&
+			this->verticalAlignment == other.verticalAlignment &&
+			wcscmp(this->text.data, other.text.data) == 0 &&
+			wcscmp(this->font.data, other.font.data) == 0;
+	}
+};
+
+struct TextRunCacheStats {
+	u32 hits = 0;
+	u32 misses = 0;
+	u32 evictions = 0;
+};
+
+// Keeps hold of up to `Size` laid out text runs so that text that doesn't
+// change from frame to frame (labels, dates, package details, ...) is only
+// laid out once. `T` is whatever the renderer needs to draw a run. The cache
+// never creates or frees those itself, on a miss the least recently used slot
+// is handed back (along with whatever it held before) to be rebuilt.
+//
+// Example:
+//
+//     bool miss;
+//     Layout **layout = cache.fetch(TextRunKey(text), &miss);
+//     if (miss) {
+//         release(*layout);
+//         *layout = createLayout(text);
+//     }
+//     draw(*layout, text.position);
+//
+template<typename T, size_t Size>
+struct TextRunCache {
+	TextRunCacheStats stats;
+	TextRunCacheStats lastFrameStats;
+
+	TextRunCache() {
+		for (size_t i = 0; i < Size; i++) {
+			this->payloads[i] = {};
+			this->lastUsed[i] = 0;
+			this->occupied[i] = false;
+		}
+	}
+
+	size_t capacity() const {
+		return Size;
+	}
+
+	size_t length() const {
+		size_t length = 0;
+		for (size_t i = 0; i < Size; i++) {
+			length += this->occupied[i];
+		}
+		return length;
+	}
+
+	T *fetch(const TextRunKey &key, bool *miss) {
+		this->useCount++;
+
+		// NOTE: The hashes are kept apart from the rest of the key so this
+		// scan stays within a few cache lines.
+		size_t leastRecent = 0;
+		for (size_t i = 0; i < Size; i++) {
+			if (this->occupied[i] && this->hashes[i] == key.hash && this->keys[i] == key) {
+				this->lastUsed[i] = this->useCount;
+				this->stats.hits++;
+				*miss = false;
+				return &this->payloads[i];
+			}
+
+			if (this->lastUsed[i] < this->lastUsed[leastRecent]) {
+				leastRecent = i;
+			}
+		}
+
+		if (this->occupied[leastRecent]) {
+			this->stats.evictions++;
+		}
+
+		this->hashes[leastRecent] = key.hash;
+		this->keys[leastRecent] = key;
+		this->lastUsed[leastRecent] = this->useCount;
+		this->occupied[leastRecent] = true;
+		this->stats.misses++;
+
+		*miss = true;
+		return &this->payloads[leastRecent];
+	}
+
+	// For releasing everything the renderer stored in the cache
+	T *begin() {
+		return this->payloads;
+	}
+
+	T *end() {
+		return &this->payloads[Size];
+	}
+
+	void endFrame() {
+		this->lastFrameStats = this->stats;
+		this->stats = {};
+	}
+
+protected:
+	u64 hashes[Size];
+	TextRunKey keys[Size];
+	T payloads[Size];
+	u32 lastUsed[Size];
+	bool occupied[Size];
+	u32 useCount = 0;
+};
\ No newline at end of file
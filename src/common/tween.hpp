@@ -1,19 +1,273 @@
 #pragma once
 
+#include <cassert>
+#include <cfloat>
+
 #include "types/core.hpp"
+#include "types/vector.hpp"
+
+enum class TweenEasing {
+	linear,
+	quadIn,
+	quadOut,
+	quadInOut,
+	cubicIn,
+	cubicOut,
+	cubicInOut,
+	count
+};
+
+// Tweens don't hold on to the value they animate directly. Instead they refer
+// to an entry in their channel's binding table, so when the value moves the
+// owner only has to `rebind` it rather than hunt down every tween using it.
+typedef u16 TweenBinding;
+const TweenBinding TWEEN_BINDING_NONE = (TweenBinding)-1;
+
+// Maps linear progress to eased progress for a whole group at once. The easing
+// is the same for every tween in a group so the switch is only taken once and
+// each loop is a straight line of arithmetic the compiler can vectorise.
+void easeTweens(TweenEasing easing, const f32 *progress, f32 *eased, size_t count) {
+	switch (easing) {
+		case TweenEasing::linear: {
+			for (size_t i = 0; i < count; i++) {
+				eased[i] = progress[i];
+			}
+		} break;
+
+		case TweenEasing::quadIn: {
+			for (size_t i = 0; i < count; i++) {
+				const f32 t = progress[i];
+				eased[i] = t * t;
+			}
+		} break;
+
+		case TweenEasing::quadOut: {
+			for (size_t i = 0; i < count; i++) {
+				const f32 t = 1.0f - progress[i];
+				eased[i] = 1.0f - t * t;
+			}
+		} break;
+
+		case TweenEasing::quadInOut: {
+			for (size_t i = 0; i < count; i++) {
+				const f32 t = progress[i];
+				const f32 u = 2.0f - 2.0f * t;
+				eased[i] = t < 0.5f ? 2.0f * t * t : 1.0f - u * u * 0.5f;
+			}
+		} break;
+
+		case TweenEasing::cubicIn: {
+			for (size_t i = 0; i < count; i++) {
+				const f32 t = progress[i];
+				eased[i] = t * t * t;
+			}
+		} break;
+
+		case TweenEasing::cubicOut: {
+			for (size_t i = 0; i < count; i++) {
+				const f32 t = 1.0f - progress[i];
+				eased[i] = 1.0f - t * t * t;
+			}
+		} break;
+
+		case TweenEasing::cubicInOut: {
+			for (size_t i = 0; i < count; i++) {
+				const f32 t = progress[i];
+				const f32 u = 2.0f - 2.0f * t;
+				eased[i] = t < 0.5f ? 4.0f * t * t * t : 1.0f - u * u * u * 0.5f;
+			}
+		} break;
+
+		default: {
+			assert(false);
+		} break;
+	}
+}
+
+// All the tweens of one value type that share an easing, stored as parallel
+// arrays so each step of the update is a tight loop over a single field.
+template<typename T, size_t Size>
+struct TweenGroup {
+	size_t length = 0;
+	T from[Size];
+	T difference[Size];
+	f32 progress[Size];
+	f32 rate[Size];
+	TweenBinding binding[Size];
+
+	bool isFull() const {
+		return this->length == Size;
+	}
+
+	void push(TweenBinding binding, const T &from, const T &to, f32 duration) {
+		assert(!this->isFull());
+
+		const size_t i = this->length++;
+		this->from[i] = from;
+		this->difference[i] = to - from;
+		this->progress[i] = 0.0f;
+		this->rate[i] = duration > 0.0f ? 1.0f / duration : FLT_MAX;
+		this->binding[i] = binding;
+	}
+
+	void remove(size_t i) {
+		assert(i < this->length);
+
+		const size_t last = --this->length;
+		this->from[i] = this->from[last];
+		this->difference[i] = this->difference[last];
+		this->progress[i] = this->progress[last];
+		this->rate[i] = this->rate[last];
+		this->binding[i] = this->binding[last];
+	}
+
+	void update(TweenEasing easing, f32 delta, T *const *targets) {
+		const size_t length = this->length;
+
+		for (size_t i = 0; i < length; i++) {
+			const f32 progress = this->progress[i] + delta * this->rate[i];
+			this->progress[i] = progress < 1.0f ? progress : 1.0f;
+		}
 
-enum TweenValueType {
-	float32,
-	int32
+		f32 eased[Size];
+		easeTweens(easing, this->progress, eased, length);
+
+		for (size_t i = 0; i < length; i++) {
+			*targets[this->binding[i]] = (T)(this->from[i] + this->difference[i] * eased[i]);
+		}
+
+		// NOTE: Walk backwards so the tween swapped into a removed slot has
+		// already been visited.
+		for (size_t i = length; i-- > 0;) {
+			if (this->progress[i] == 1.0f) {
+				this->remove(i);
+			}
+		}
+	}
+};
+
+// Every tween animating a value of type `T`, split into one group per easing.
+//
+// Example:
+//
+//     TweenBinding binding = tweens.float32.bind(&foo.alpha);
+//     tweens.float32.start(binding, 0.0f, 1.0f, 0.5f, TweenEasing::quadOut);
+//     ...
+//     // `foo` was copied somewhere else
+//     tweens.float32.rebind(binding, &movedFoo.alpha);
+//
+template<typename T, size_t GroupSize, size_t BindingSize>
+struct TweenChannel {
+	static_assert(BindingSize < TWEEN_BINDING_NONE, "TweenChannel binding size exceeds handle range");
+
+	TweenGroup<T, GroupSize> groups[(size_t)TweenEasing::count];
+
+	TweenChannel() {
+		for (size_t i = 0; i < BindingSize; i++) {
+			this->targets[i] = nullptr;
+			this->nextFree[i] = i + 1 < BindingSize ? (TweenBinding)(i + 1) : TWEEN_BINDING_NONE;
+		}
+		this->freeHead = 0;
+	}
+
+	TweenBinding bind(T *target) {
+		assert(target != nullptr);
+		assert(this->freeHead != TWEEN_BINDING_NONE);
+
+		const TweenBinding binding = this->freeHead;
+		this->freeHead = this->nextFree[binding];
+		this->targets[binding] = target;
+		return binding;
+	}
+
+	void rebind(TweenBinding binding, T *target) {
+		assert(binding < BindingSize && this->targets[binding] != nullptr);
+		assert(target != nullptr);
+		this->targets[binding] = target;
+	}
+
+	// Stops anything still animating the binding and frees it up for reuse.
+	void unbind(TweenBinding binding) {
+		this->cancel(binding);
+
+		this->targets[binding] = nullptr;
+		this->nextFree[binding] = this->freeHead;
+		this->freeHead = binding;
+	}
+
+	void start(TweenBinding binding, const T &from, const T &to, f32 duration, TweenEasing easing = TweenEasing::linear) {
+		assert(binding < BindingSize && this->targets[binding] != nullptr);
+		this->groups[(size_t)easing].push(binding, from, to, duration);
+	}
+
+	// Leaves the bound value wherever the tweens last put it.
+	void cancel(TweenBinding binding) {
+		assert(binding < BindingSize && this->targets[binding] != nullptr);
+
+		for (TweenGroup<T, GroupSize> &group : this->groups) {
+			for (size_t i = group.length; i-- > 0;) {
+				if (group.binding[i] == binding) {
+					group.remove(i);
+				}
+			}
+		}
+	}
+
+	bool isTweening(TweenBinding binding) const {
+		for (const TweenGroup<T, GroupSize> &group : this->groups) {
+			for (size_t i = 0; i < group.length; i++) {
+				if (group.binding[i] == binding) {
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	size_t length() const {
+		size_t length = 0;
+		for (const TweenGroup<T, GroupSize> &group : this->groups) {
+			length += group.length;
+		}
+		return length;
+	}
+
+	void update(f32 delta) {
+		for (size_t i = 0; i < (size_t)TweenEasing::count; i++) {
+			this->groups[i].update((TweenEasing)i, delta, this->targets);
+		}
+	}
+
+protected:
+	T *targets[BindingSize];
+	TweenBinding nextFree[BindingSize];
+	TweenBinding freeHead;
 };
 
-struct Tween {
-	#define MAX_TWEEN_VALUE_SIZE sizeof(Vec3<f32>)
+struct Tweens {
+	#define TWEEN_GROUP_MAX 256
+	#define TWEEN_BINDING_MAX 256
+
+	TweenChannel<f32, TWEEN_GROUP_MAX, TWEEN_BINDING_MAX> float32;
+	TweenChannel<s32, TWEEN_GROUP_MAX, TWEEN_BINDING_MAX> int32;
+	TweenChannel<Vec2<f32>, TWEEN_GROUP_MAX, TWEEN_BINDING_MAX> vec2;
+	TweenChannel<Vec3<f32>, TWEEN_GROUP_MAX, TWEEN_BINDING_MAX> vec3;
+	TweenChannel<Rgba, TWEEN_GROUP_MAX, TWEEN_BINDING_MAX> rgba;
+
+	size_t length() const {
+		return
+			this->float32.length() +
+			this->int32.length() +
+			this->vec2.length() +
+			this->vec3.length() +
+			this->rgba.length();
+	}
 
-	TweenValueType type;
-	char from[MAX_TWEEN_VALUE_SIZE];
-	char to[MAX_TWEEN_VALUE_SIZE];
-	void *value;
-	f32 duration = 0;
-	f32 progress = 0;
+	void update(f32 delta) {
+		this->float32.update(delta);
+		this->int32.update(delta);
+		this->vec2.update(delta);
+		this->vec3.update(delta);
+		this->rgba.update(delta);
+	}
 };
\ No newline at end of file
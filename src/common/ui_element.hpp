@@ -1,5 +1,6 @@
 #pragma once
 
+#include "common/input.hpp"
 #include "types/array.hpp"
 #include "types/core.hpp"
 #include "types/string.hpp"
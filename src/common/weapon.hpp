@@ -1,5 +1,6 @@
 #pragma once
 
+#include "common/entity.hpp"
 #include "common/game_definitions.hpp"
 #include "common/ship_target.hpp"
 #include "types/core.hpp"
@@ -13,6 +14,9 @@ struct Weapon {
 	f32 projectileSpeed;
 	f32 cooldown = 1.0f;
 	f32 cooldownTick = 0.0f;
-	ShipTarget *target;
 	bool firing = false;
+	// Ship the weapon belongs to once it's in combat and the target entity
+	// it's firing at
+	Entity ship = ENTITY_NONE;
+	Entity target = ENTITY_NONE;
 };
\ No newline at end of file
@@ -3,6 +3,7 @@
 #ifdef DEBUG
 
 #include "common/game_state.hpp"
+#include "common/ship_template.hpp"
 #include "editor/utils.hpp"
 
 namespace ShipEditor {
@@ -72,11 +73,16 @@ namespace ShipEditor {
 			SaveData &saveData = gameState->editorState.saveData;
 
 			saveData.pending = true;
-			swprintf_s(saveData.path.data, GET_ASSET_PATH("data/templates/%s"), state.shipTemplate->fileName.data);
-			// TODO(steven): Obviously dumping the binary data to file is not an ideal 
-			// solution but it works ok for now. Do proper serialisation.
-			memcpy(saveData.buffer, (void*)&state.shipTemplate->data, sizeof(Ship));
-			saveData.size = sizeof(Ship);
+			swprintf_s(
+				saveData.path.data, 
+				GET_ASSET_PATH("data/templates/%s%s"), 
+				state.shipTemplate->fileName.data, 
+				SHIP_TEMPLATE_SOURCE_EXTENSION
+			);
+			// NOTE: Only the source is saved, the game parses it until the template
+			// compiler is run again to rebuild the cache.
+			saveData.size = ShipTemplate::write(state.shipTemplate->data, saveData.buffer, sizeof(saveData.buffer));
+			assert(saveData.size > 0);
 		}
 	}
 };
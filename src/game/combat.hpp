@@ -3,220 +3,295 @@
 #include <cmath>
 
 #include "common/game_state.hpp"
-#include "game/utils.hpp"
+#include "game/combat_ai.hpp"
+#include "game/scene.hpp"
 #include "types/core.hpp"
-#include "utils/reducer.hpp"
+#include "utils/profiler.hpp"
 
 namespace Combat {
 	// Forward declerations
 	void updateWeaponCooldowns(GameState *gameState, f32 delta);
 	void updateProjectiles(GameState *gameState, f32 delta);
-	void processEvents(GameState *gameState);
+	void resolveHits(GameState *gameState);
+	void onTargetDestroyed(GameState *gameState, const TargetDestroyedEvent *events, size_t count);
+	void removeDestroyedTargets(GameState *gameState, const TargetDestroyedEvent *events, size_t count);
 	void update(GameState *gameState, f32 delta);
-	void updateTargets(GameState *gameState);
-	template<size_t Size> void updateShips(Array<Ship, Size> *ships);
-	void updateAimlessProjectiles(GameState *gameState, f32 delta);
+	void simulate(GameState *gameState, f32 delta);
 	void renderCombatVisuals(GameState *gameState);
 	void handleUserTargeting(GameState *gameState);
-	void drawWeapon(GameState *gameState, const Weapon &weapon, const Rgba &color);
-	void drawTarget(GameState *gameState, const ShipTarget &target, const Rgba &color);
-	bool isShipAlive(Ship &ship);
-
-	template<typename T, size_t Size>
-	void addSprites(SpriteBuffer *sprites, Array<T, Size> toRender) {
-		for (const T &sprite : toRender) {
-			sprites->push((Sprite)sprite);
+	void drawWeapon(GameState *gameState, const Weapon &weapon, Vec2<f32> screenPosition, const Rgba &color);
+	void drawTarget(GameState *gameState, const ShipTarget &target, Vec2<f32> screenPosition, const Rgba &color);
+	Entity findTargetAt(GameState *gameState, Vec2<f32> screenPosition, Faction faction, Vec2<f32> *targetScreenPosition);
+
+	void addSprites(SpriteBuffer *sprites, const CombatEntities &combat) {
+		for (const Sprite &sprite : combat.sprites) {
+			sprites->push(sprite);
+		}
+	}
+
+	// Clears out the previous battle, leaves the update systems alone so it
+	// can also be used to run battles without the rest of the game
+	void startBattle(GameState *gameState) {
+		gameState->events.dispatch(gameState);
+		gameState->events.clearSubscribers();
+		gameState->events.targetDestroyed.subscribe(&onTargetDestroyed);
+		// NOTE: Must come after anything else reacting to destroyed targets,
+		// the targets are gone once it's run.
+		gameState->events.targetDestroyed.subscribe(&removeDestroyedTargets);
+
+		gameState->combat.clear();
+		gameState->combatAi.cursor = 0;
+		gameState->projectiles.clear();
+		gameState->projectileStats = {};
+		gameState->hits.clear();
+	}
+
+	// Adds a ship built from a template. The template's targets and weapons
+	// are placed relative to the ship.
+	Entity spawnShip(CombatEntities *combat, const Ship &shipTemplate, Faction faction, Vec3<f32> position) {
+		Sprite sprite = shipTemplate;
+		sprite.position = position;
+		const Entity ship = combat->createShip(faction, sprite);
+
+		for (ShipTarget target : shipTemplate.targets) {
+			target.position += position;
+			combat->addTarget(ship, target);
+		}
+
+		for (Weapon weapon : shipTemplate.weapons) {
+			weapon.position += position;
+			combat->addWeapon(ship, weapon);
 		}
+
+		return ship;
 	}
 
 	void setup(GameState *gameState) {
+		startBattle(gameState);
+		gameState->camera = Camera();
+
 		gameState->updateSystems.clear();
 		gameState->updateSystems.push(&update);
 
-		gameState->textureLoadQueue.push(TextureAssetId::ship);
-		gameState->textureLoadQueue.push(TextureAssetId::enemyShip);
-		gameState->textureLoadQueue.push(TextureAssetId::background);
+		Scene::enter(gameState, SceneId::combat);
+
+		CombatEntities &combat = gameState->combat;
 
 		// Ally ship
 		{
-			Ship ship = {};
-			ship.assetId = TextureAssetId::ship;
-			ship.position = Vec3(0.0f, -300.0f);
-			ship.scale = Vec2(0.5f, 0.5f);
-			ship.angle = -95.0f;
+			Sprite sprite = {};
+			sprite.assetId = TextureAssetId::ship;
+			sprite.position = Vec3(0.0f, -300.0f);
+			sprite.scale = Vec2(0.5f, 0.5f);
+			sprite.angle = -95.0f;
+			const Entity ship = combat.createShip(Faction::ally, sprite);
 			
 			ShipTarget target = {};
 			target.health = 100;
 			target.maxHealth = 100;
 			target.position = Vec3(0.0f, -400.0f);
 			target.selectRadius = 50.0f;
-			ship.targets.push(target);
+			combat.addTarget(ship, target);
 
 			Weapon weapon = {};
 			weapon.position = Vec3(200.0f, -300.0f);
 			weapon.selectRadius = 50.0f;
 			weapon.damage = 20;
 			weapon.projectileSpeed = 180.0f;
-			ship.weapons.push(weapon);
-
-			gameState->allyShips.push(ship);
+			combat.addWeapon(ship, weapon);
 		}
 
 		// Enemy ship
 		{
-			Ship enemyShip = {};
-			enemyShip.assetId = TextureAssetId::enemyShip;
-			enemyShip.position = Vec3(0.0f, 300.0f);
-			enemyShip.scale = Vec2(0.2f, 0.2f);
-			enemyShip.angle = -180.0f;
+			Sprite sprite = {};
+			sprite.assetId = TextureAssetId::enemyShip;
+			sprite.position = Vec3(0.0f, 300.0f);
+			sprite.scale = Vec2(0.2f, 0.2f);
+			sprite.angle = -180.0f;
+			const Entity enemyShip = combat.createShip(Faction::enemy, sprite);
 
 			ShipTarget target = {};
 			target.maxHealth = 200;
 			target.health = 100;
 			target.position = Vec3(0.0f, 400.0f);
 			target.selectRadius = 50.0f;
-			enemyShip.targets.push(target);
+			combat.addTarget(enemyShip, target);
 
 			Weapon weapon = {};
 			weapon.position = Vec3(0.0f, 300.0f);
 			weapon.selectRadius = 50.0f;
-			enemyShip.weapons.push(weapon);
+			weapon.damage = 10;
+			weapon.projectileSpeed = 150.0f;
+			weapon.cooldown = 1.5f;
+			combat.addWeapon(enemyShip, weapon);
 
-			gameState->enemyShips.push(enemyShip);
+			combat.ai.add(enemyShip, ShipAi{});
 		}
 	}
 
 	void update(GameState *gameState, f32 delta) {
-		SpriteBuffer &sprites = gameState->sprites;
+		PROFILE_ZONE("Combat::update");
 
-		addSprites(&sprites, gameState->allyShips);
-		addSprites(&sprites, gameState->enemyShips);
+		const Input &input = gameState->input;
+		if (input.wheel != 0.0f) {
+			gameState->camera.zoomAt(input.mouse, powf(1.25f, input.wheel), 0.5f, 2.0f);
+		}
 
-		updateWeaponCooldowns(gameState, delta);
-		updateProjectiles(gameState, delta);
-		processEvents(gameState);
-		updateTargets(gameState);
-		updateShips(&gameState->allyShips);
-		updateShips(&gameState->enemyShips);
-		updateAimlessProjectiles(gameState, delta);
+		addSprites(&gameState->sprites, gameState->combat);
+		simulate(gameState, delta);
 		renderCombatVisuals(gameState);
 		handleUserTargeting(gameState);
 	}
 
-	// TODO(steven): Cleanup
+	// Everything in a combat frame that doesn't draw or read input
+	void simulate(GameState *gameState, f32 delta) {
+		CombatAi::update(gameState);
+		updateWeaponCooldowns(gameState, delta);
+		updateProjectiles(gameState, delta);
+		resolveHits(gameState);
+		gameState->events.dispatch(gameState);
+	}
+
 	void handleUserTargeting(GameState *gameState) {
-		for (Ship &ship : gameState->allyShips) {
-			Weapon *targetingWeapon = nullptr;
-			Vec2<f32> weaponScreenPosition;
-			Vec2<f32> targetScreenPosition;
-
-			for (Weapon &weapon : ship.weapons) {
-				if (gameState->input.primaryButton.down) {
-					weaponScreenPosition = gameToScreen(weapon.position);
-					f32 difference = gameState->input.primaryButton.start.distanceTo(weaponScreenPosition);
-
-					if (difference < weapon.selectRadius) {
-						targetingWeapon = &weapon;
-						weapon.firing = false;
-
-						for (Ship &enemyShip : gameState->enemyShips) {
-							for (ShipTarget &target : enemyShip.targets) {
-								targetScreenPosition = gameToScreen(target.position);
-								difference = gameState->input.mouse.distanceTo(targetScreenPosition) ;
-
-								if (difference < target.selectRadius) {
-									weapon.target = &target;
-									break;
-								} else {
-									weapon.target = nullptr;
-								}
-							}
-						}
-
-						break;
-					}
-				} else if (weapon.target != nullptr) {
-					weapon.firing = true;
-				}
+		PROFILE_ZONE("Combat::handleUserTargeting");
+
+		CombatEntities &combat = gameState->combat;
+		const Camera &camera = gameState->camera;
+		const ButtonState &primaryButton = gameState->input.primaryButton;
+		const Vec2<f32> worldStart = camera.screenToWorld(primaryButton.start);
+
+		Weapon *targetingWeapon = nullptr;
+		Vec2<f32> weaponScreenPosition;
+		Vec2<f32> targetScreenPosition;
+
+		for (Weapon &weapon : combat.weapons) {
+			if (combat.factionOf(weapon.ship) != Faction::ally) {
+				continue;
 			}
 
-			if (targetingWeapon != nullptr) {
-				// Draw targeting line
-				UILineData drawLine = {};
-				drawLine.start = weaponScreenPosition;
+			if (primaryButton.down) {
+				// Only one weapon can be aimed at a time
+				if (targetingWeapon != nullptr) {
+					continue;
+				}
+
+				if (worldStart.squaredDistanceTo(weapon.position) < weapon.selectRadius * weapon.selectRadius) {
+					targetingWeapon = &weapon;
+					weaponScreenPosition = camera.worldToScreen(weapon.position);
 
-				if (targetingWeapon->target != nullptr) {
-					drawLine.end = targetScreenPosition;
-				} else {
-					drawLine.end = gameState->input.mouse;
-					targetingWeapon->firing = false;
+					weapon.firing = false;
+					weapon.target = findTargetAt(gameState, gameState->input.mouse, Faction::enemy, &targetScreenPosition);
 				}
+			} else if (weapon.target != ENTITY_NONE) {
+				weapon.firing = true;
+			}
+		}
+
+		if (targetingWeapon != nullptr) {
+			// Draw targeting line
+			UILineData drawLine = {};
+			drawLine.start = weaponScreenPosition;
 
-				drawLine.thickness = 10.0f;
-				drawLine.color = Rgba(1.0f, 0.0f, 0.0f, 1.0f);			
-				gameState->uiElements.push(drawLine);
+			if (targetingWeapon->target != ENTITY_NONE) {
+				drawLine.end = targetScreenPosition;
+			} else {
+				drawLine.end = gameState->input.mouse;
 			}
+
+			drawLine.thickness = 10.0f;
+			drawLine.color = Rgba(1.0f, 0.0f, 0.0f, 1.0f);			
+			gameState->uiElements.push(drawLine);
 		}
 	}
 
-	void renderCombatVisuals(GameState *gameState) {
-		UIElementBuffer &uiElements = gameState->uiElements;
+	// First target of the faction under the screen position, if any. Select
+	// radiuses are in game units so they grow and shrink with the zoom.
+	Entity findTargetAt(GameState *gameState, Vec2<f32> screenPosition, Faction faction, Vec2<f32> *targetScreenPosition) {
+		const CombatEntities &combat = gameState->combat;
+		const Vec2<f32> worldPosition = gameState->camera.screenToWorld(screenPosition);
 
-		// Draw projectiles
-		for (const Projectile &projectile : gameState->projectiles) {
-			UICircleData bullet = {};
-			bullet.position = gameToScreen(projectile.position);
-			bullet.radius = 1.0f;
-			bullet.strokeWidth = 10.0f;
-			bullet.strokeColor = Rgba(0.0f, 0.0f, 1.0f, 1.0f);
-			uiElements.push(bullet);
-		}
+		for (size_t i = 0; i < combat.targets.length; i++) {
+			const ShipTarget &target = combat.targets.data[i];
+			if (combat.factionOf(target.ship) != faction) {
+				continue;
+			}
 
-		// Draw aimless prjectiles
-		for (const AimlessProjectile &aimless : gameState->aimlessProjectiles) {
-			UICircleData bullet = {};
-			bullet.position = gameToScreen(aimless.position);
-			bullet.radius = 1.0f;
-			bullet.strokeWidth = 10.0f;
-			bullet.strokeColor = Rgba(0.0f, 0.0f, 1.0f, 1.0f);
-			uiElements.push(bullet);
+			if (worldPosition.squaredDistanceTo(target.position) < target.selectRadius * target.selectRadius) {
+				*targetScreenPosition = gameState->camera.worldToScreen(target.position);
+				return combat.targets.entities[i];
+			}
 		}
 
-		// Draw ally ships
-		for (Ship &ship : gameState->allyShips) {
-			const Rgba allyColor(0.0f, 1.0f, 0.0f, 1.0f);
+		return ENTITY_NONE;
+	}
 
-			for (const Weapon &weapon : ship.weapons) {
-				drawWeapon(gameState, weapon, allyColor);
-			}
+	void renderCombatVisuals(GameState *gameState) {
+		PROFILE_ZONE("Combat::renderCombatVisuals");
 
-			for (const ShipTarget &target : ship.targets) {
-				drawTarget(gameState, target, allyColor);
+		UIElementBuffer &uiElements = gameState->uiElements;
+		const Camera &camera = gameState->camera;
+
+		// Draw projectiles, the pool has gaps so they're gathered first to be
+		// transformed in one go
+		{
+			Vec3<f32> positions[PROJECTILE_MAX];
+			Vec2<f32> screenPositions[PROJECTILE_MAX];
+			size_t count = 0;
+			for (const Projectile &projectile : gameState->projectiles) {
+				positions[count++] = projectile.position;
+			}
+			camera.worldToScreen(positions, count, screenPositions);
+
+			for (size_t i = 0; i < count; i++) {
+				UICircleData bullet = {};
+				bullet.position = screenPositions[i];
+				bullet.radius = 1.0f;
+				bullet.strokeWidth = 10.0f;
+				bullet.strokeColor = Rgba(0.0f, 0.0f, 1.0f, 1.0f);
+				uiElements.push(bullet);
 			}
 		}
 
-		// Draw enemy ships
-		for (Ship &ship : gameState->enemyShips) {
-			const Rgba enemyColor(1.0f, 0.0f, 0.0f, 1.0f);
+		// Draw ship weapons and targets
+		const CombatEntities &combat = gameState->combat;
+		const Rgba factionColors[] = {
+			Rgba(0.0f, 1.0f, 0.0f, 1.0f),
+			Rgba(1.0f, 0.0f, 0.0f, 1.0f)
+		};
+
+		{
+			const Weapon *weapons = combat.weapons.data;
+			const size_t count = combat.weapons.length;
+			Vec2<f32> screenPositions[COMBAT_WEAPON_MAX];
+			camera.worldToScreen(&weapons[0].position, count, sizeof(Weapon), screenPositions);
 
-			for (const Weapon &weapon : ship.weapons) {
-				drawWeapon(gameState, weapon, enemyColor);
+			for (size_t i = 0; i < count; i++) {
+				drawWeapon(gameState, weapons[i], screenPositions[i], factionColors[(size_t)combat.factionOf(weapons[i].ship)]);
 			}
+		}
+
+		{
+			const ShipTarget *targets = combat.targets.data;
+			const size_t count = combat.targets.length;
+			Vec2<f32> screenPositions[COMBAT_TARGET_MAX];
+			camera.worldToScreen(&targets[0].position, count, sizeof(ShipTarget), screenPositions);
 
-			for (const ShipTarget &target : ship.targets) {
-				drawTarget(gameState, target, enemyColor);
+			for (size_t i = 0; i < count; i++) {
+				drawTarget(gameState, targets[i], screenPositions[i], factionColors[(size_t)combat.factionOf(targets[i].ship)]);
 			}
 		}
 	}
 
 	// Draw combat ship targets
 	// TODO(steven): Just using debug circles for now, represent them another way
-	void drawTarget(GameState *gameState, const ShipTarget &target, const Rgba &color) {
+	void drawTarget(GameState *gameState, const ShipTarget &target, Vec2<f32> screenPosition, const Rgba &color) {
 		UIElementBuffer &uiElements = gameState->uiElements;
+		const f32 zoom = gameState->camera.getZoom();
+
 		UICircleData targetPoint = {};
-		targetPoint.position = gameToScreen(target.position);
+		targetPoint.position = screenPosition;
 		targetPoint.strokeWidth = 10.0f;
-		targetPoint.radius = target.selectRadius;
+		targetPoint.radius = target.selectRadius * zoom;
 		targetPoint.strokeStyle = UIStrokeStyle::dotted;
 		targetPoint.strokeColor = color;
 
@@ -224,20 +299,20 @@ namespace Combat {
 
 		UILineData healthBar = {};
 		const f32 healthScale = (f32)target.health / target.maxHealth;
-		healthBar.start = targetPoint.position + Vec2<f32>(-50.0f, -100.0f);
+		healthBar.start = targetPoint.position + Vec2<f32>(-50.0f, -100.0f * zoom);
 		healthBar.end = healthBar.start + Vec2<f32>(100.0f * healthScale, 0.0f);
 		healthBar.color = Rgba(abs(healthScale - 1.0f), healthScale, 0.0f, 1.0f);
 		healthBar.thickness = 20.0f;
 		uiElements.push(healthBar);
 	}
 
-	void drawWeapon(GameState *gameState, const Weapon &weapon, const Rgba &color) {
+	void drawWeapon(GameState *gameState, const Weapon &weapon, Vec2<f32> screenPosition, const Rgba &color) {
 		UIElementBuffer &uiElements = gameState->uiElements;
 
 		UICircleData weaponIndicator = {};
-		weaponIndicator.position = gameToScreen(weapon.position);
+		weaponIndicator.position = screenPosition;
 		weaponIndicator.strokeWidth = 10.0f;
-		weaponIndicator.radius = weapon.selectRadius;
+		weaponIndicator.radius = weapon.selectRadius * gameState->camera.getZoom();
 		weaponIndicator.strokeColor = color;
 		uiElements.push(weaponIndicator);
 
@@ -253,142 +328,171 @@ namespace Combat {
 		}
 	}
 
-	void processEvents(GameState *gameState) {
-		for (const TargetDestroyedEvent &event : gameState->events.targetDestroyed) {
-			for (Ship &ship : gameState->allyShips) {
-				for (Weapon &weapon : ship.weapons) {
-					if (weapon.target == event.target) {
-						weapon.firing = false;
-						weapon.target = nullptr;
-						weapon.cooldownTick = weapon.cooldown;
-					}
-				}
+	bool wasDestroyed(Entity target, const TargetDestroyedEvent *events, size_t count) {
+		for (size_t i = 0; i < count; i++) {
+			if (events[i].target == target) {
+				return true;
 			}
+		}
+		return false;
+	}
 
-			Reducer reducer(&gameState->projectiles);
-			for (Projectile &projectile : gameState->projectiles) {
-				reducer.next(&projectile);
-
-				if (projectile.target == event.target) {
-					reducer.remove();
-
-					AimlessProjectile aimless = {};
-					aimless.position = projectile.position;
-					aimless.speed = projectile.speed;
-
-					const Vec3 direction = (projectile.target->position - projectile.position).normalized();
-					aimless.direction = direction;
+	void onTargetDestroyed(GameState *gameState, const TargetDestroyedEvent *events, size_t count) {
+		CombatEntities &combat = gameState->combat;
 
-					gameState->aimlessProjectiles.push(aimless);
-				}
+		for (Weapon &weapon : combat.weapons) {
+			if (wasDestroyed(weapon.target, events, count)) {
+				weapon.firing = false;
+				weapon.target = ENTITY_NONE;
+				weapon.cooldownTick = weapon.cooldown;
 			}
-
-			reducer.finish();
 		}
-	}
 
-	void updateAimlessProjectiles(GameState *gameState, f32 delta) {
-		Reducer reducer(&gameState->aimlessProjectiles);
+		for (Projectile &projectile : gameState->projectiles) {
+			if (projectile.state != ProjectileState::homing || !wasDestroyed(projectile.target, events, count)) {
+				continue;
+			}
 
-		for (AimlessProjectile &aimless : gameState->aimlessProjectiles) {
-			reducer.next(&aimless);
+			// NOTE: Destroyed targets are only removed by `removeDestroyedTargets`,
+			// which is subscribed after this
+			const ShipTarget *target = combat.targets.get(projectile.target);
+			assert(target != nullptr);
 
-			aimless.tick += delta;
-			if (aimless.tick >= aimless.lifetime) {
-				reducer.remove();
-			} else {
-				aimless.position += aimless.direction * aimless.speed * delta;
-			}
+			projectile.state = ProjectileState::aimless;
+			projectile.direction = (target->position - projectile.position).normalized();
+			projectile.target = ENTITY_NONE;
+			projectile.tick = 0.0f;
 		}
-
-		reducer.finish();
 	}
 
 	void updateProjectiles(GameState *gameState, f32 delta) {
-		Reducer reducer(&gameState->projectiles);
+		PROFILE_ZONE("Combat::updateProjectiles");
 
-		for (Projectile &projectile : gameState->projectiles) {
-			reducer.next(&projectile);
+		const CombatEntities &combat = gameState->combat;
+		ProjectilePool &projectiles = gameState->projectiles;
+
+		for (Projectile &projectile : projectiles) {
+			if (projectile.state == ProjectileState::aimless) {
+				projectile.tick += delta;
+				if (projectile.tick >= projectile.lifetime) {
+					projectiles.release(&projectile);
+				} else {
+					projectile.position += projectile.direction * projectile.speed * delta;
+				}
+				continue;
+			}
 
-			const Vec3 diff = projectile.target->position - projectile.position;
-			const Vec3 direction = diff.normalized();
-			const f32 distance = diff.magnitude();
+			const ShipTarget *target = combat.targets.get(projectile.target);
+			if (target == nullptr) {
+				// The target's ship was destroyed some other way
+				projectiles.release(&projectile);
+				continue;
+			}
 
-			if (distance < 10.0f) {
-				reducer.remove();
+			const Vec3 diff = target->position - projectile.position;
+			const f32 squaredDistance = diff.squaredMagnitude();
 
-				HealthValue healthAfterDamage = projectile.target->health - projectile.damage;
+			if (squaredDistance < 10.0f * 10.0f) {
+				projectiles.release(&projectile);
 
-				projectile.target->health = max(0, healthAfterDamage);
-				if (projectile.target->health == 0) {
-					TargetDestroyedEvent event = {};
-					event.target = projectile.target;
-					gameState->events.targetDestroyed.push(event);
-				}
+				ProjectileHit hit = {};
+				hit.target = projectile.target;
+				hit.damage = projectile.damage;
+				gameState->hits.push(hit);
+				gameState->projectileStats.hits++;
 			} else {
+				const Vec3 direction = diff * reciprocalSqrt(squaredDistance);
 				projectile.position += direction * projectile.speed * delta;
 			}
 		}
-
-		reducer.finish();
 	}
 
-	template<size_t Size>
-	void updateShips(Array<Ship, Size> *ships) {
-		Reducer reducer(ships);
-
-		for (Ship &ship : *ships) {
-			reducer.next(&ship);
-			if (!isShipAlive(ship)) {
-				reducer.remove();
+	// Applies every hit recorded this frame. Hits are grouped by target so each
+	// target's health is written once with the summed damage and it's reported
+	// destroyed at most once, in order of entity rather than of whichever
+	// projectile happened to land first.
+	void resolveHits(GameState *gameState) {
+		PROFILE_ZONE("Combat::resolveHits");
+
+		CombatEntities &combat = gameState->combat;
+		Array<ProjectileHit, PROJECTILE_MAX> &hits = gameState->hits;
+
+		// NOTE: There are never more hits than projectiles so an insertion sort
+		// is plenty.
+		for (size_t i = 1; i < hits.length; i++) {
+			const ProjectileHit hit = hits.data[i];
+			size_t j = i;
+			for (; j > 0 && hits.data[j - 1].target > hit.target; j--) {
+				hits.data[j] = hits.data[j - 1];
 			}
+			hits.data[j] = hit;
 		}
 
-		reducer.finish();
-	}
+		for (size_t i = 0; i < hits.length;) {
+			const Entity entity = hits.data[i].target;
 
-	bool isShipAlive(Ship &ship) {
-		for (const ShipTarget &target : ship.targets) {
-			if (target.health > 0) {
-				return true;
+			u32 damage = 0;
+			for (; i < hits.length && hits.data[i].target == entity; i++) {
+				damage += hits.data[i].damage;
+			}
+
+			ShipTarget *target = combat.targets.get(entity);
+			if (target == nullptr || target->health == 0) {
+				continue;
+			}
+
+			target->health = target->health > damage ? (HealthValue)(target->health - damage) : 0;
+			if (target->health == 0) {
+				TargetDestroyedEvent event = {};
+				event.target = entity;
+				gameState->events.targetDestroyed.publish(event);
 			}
 		}
-		return false;
+
+		hits.clear();
 	}
 
-	void updateTargets(GameState *gameState) {
-		for (Ship &ship : gameState->enemyShips) {
-			Reducer reducer(&ship.targets);
+	// The only place targets are removed, along with any ship left without one
+	void removeDestroyedTargets(GameState *gameState, const TargetDestroyedEvent *events, size_t count) {
+		PROFILE_ZONE("Combat::removeDestroyedTargets");
 
-			for (ShipTarget &target : ship.targets) {
-				reducer.next(&target);
-				if (target.health == 0) {
-					reducer.remove();
-				}
+		CombatEntities &combat = gameState->combat;
+
+		for (size_t i = 0; i < count; i++) {
+			const ShipTarget *target = combat.targets.get(events[i].target);
+			if (target == nullptr) {
+				continue;
 			}
 
-			reducer.finish();
+			const Entity ship = target->ship;
+			if (combat.destroyTarget(events[i].target)) {
+				combat.destroyShip(ship);
+			}
 		}
 	}
 
 	void updateWeaponCooldowns(GameState *gameState, f32 delta) {
-		for (Ship &ship : gameState->allyShips) {
-			for (Weapon &weapon : ship.weapons) {
-				if (!weapon.firing) {
-					continue;
-				}
+		PROFILE_ZONE("Combat::updateWeaponCooldowns");
 
-				weapon.cooldownTick += delta;
-				if (weapon.cooldownTick >= weapon.cooldown) {
-					weapon.cooldownTick = fmod(weapon.cooldownTick, weapon.cooldown);
+		for (Weapon &weapon : gameState->combat.weapons) {
+			if (!weapon.firing) {
+				continue;
+			}
 
-					Projectile projectile = {};
-					projectile.damage = weapon.damage;
-					projectile.speed = weapon.projectileSpeed;
-					projectile.target = weapon.target;
-					projectile.position = weapon.position;
+			weapon.cooldownTick += delta;
+			if (weapon.cooldownTick >= weapon.cooldown) {
+				weapon.cooldownTick = fmod(weapon.cooldownTick, weapon.cooldown);
 
-					gameState->projectiles.push(projectile);
+				Projectile projectile = {};
+				projectile.damage = weapon.damage;
+				projectile.speed = weapon.projectileSpeed;
+				projectile.target = weapon.target;
+				projectile.position = weapon.position;
+
+				if (gameState->projectiles.create(projectile) != nullptr) {
+					gameState->projectileStats.fired++;
+				} else {
+					gameState->projectileStats.dropped++;
 				}
 			}
 		}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "common/game_state.hpp"
+#include "types/core.hpp"
+#include "utils/profiler.hpp"
+
+// Picks targets for the ships with a `ShipAi` and keeps their weapons firing
+// at them.
+//
+// Deciding means searching every target, so rather than every ship deciding
+// every frame a slice of them does, round robin, and the rest keep what they
+// had. The slice is sized so each ship decides every
+// `COMBAT_AI_DECISION_FRAMES` frames, but it's cut short once the frame's
+// budget is spent and picked up from there next frame.
+namespace CombatAi {
+	Faction opposing(Faction faction) {
+		return faction == Faction::ally ? Faction::enemy : Faction::ally;
+	}
+
+	// Closest target of the opposing faction to the ship
+	Entity chooseTarget(const CombatEntities &combat, Entity ship) {
+		const Faction faction = opposing(combat.factionOf(ship));
+		const Vec3<f32> position = combat.sprites.get(ship)->position;
+
+		Entity closest = ENTITY_NONE;
+		f32 closestSquaredDistance = 0.0f;
+
+		for (size_t i = 0; i < combat.targets.length; i++) {
+			const ShipTarget &target = combat.targets.data[i];
+			if (combat.factionOf(target.ship) != faction) {
+				continue;
+			}
+
+			const f32 squaredDistance = (target.position - position).squaredMagnitude();
+			if (closest == ENTITY_NONE || squaredDistance < closestSquaredDistance) {
+				closest = combat.targets.entities[i];
+				closestSquaredDistance = squaredDistance;
+			}
+		}
+
+		return closest;
+	}
+
+	void decide(GameState *gameState) {
+		CombatEntities &combat = gameState->combat;
+		CombatAiState &state = gameState->combatAi;
+
+		const size_t shipCount = combat.ai.length;
+		if (shipCount == 0) {
+			return;
+		}
+
+		const size_t due = (shipCount + COMBAT_AI_DECISION_FRAMES - 1) / COMBAT_AI_DECISION_FRAMES;
+		const u64 budgetTicks = state.budgetMilliseconds > 0.0f ? (u64)(state.budgetMilliseconds * 1e-3 * Profiler::ticksPerSecond()) : 0;
+		const u64 start = Profiler::now();
+
+		for (size_t i = 0; i < due; i++) {
+			// NOTE: At least one ship decides every frame so none can be starved
+			// by a budget that's too tight.
+			if (i > 0 && budgetTicks > 0 && Profiler::now() - start >= budgetTicks) {
+				state.stats.deferred += (u32)(due - i);
+				break;
+			}
+
+			if (state.cursor >= shipCount) {
+				state.cursor = 0;
+			}
+
+			const size_t index = state.cursor++;
+			combat.ai.data[index].target = chooseTarget(combat, combat.ai.entities[index]);
+			state.stats.decisions++;
+		}
+	}
+
+	// Cheap enough to run for every weapon every frame, catches targets that
+	// were destroyed since their ship's last decision
+	void aimWeapons(GameState *gameState) {
+		CombatEntities &combat = gameState->combat;
+
+		for (Weapon &weapon : combat.weapons) {
+			ShipAi *ai = combat.ai.get(weapon.ship);
+			if (ai == nullptr) {
+				continue;
+			}
+
+			if (!combat.targets.has(ai->target)) {
+				ai->target = ENTITY_NONE;
+			}
+
+			weapon.target = ai->target;
+			weapon.firing = ai->target != ENTITY_NONE;
+		}
+	}
+
+	void update(GameState *gameState) {
+		PROFILE_ZONE("CombatAi::update");
+
+		CombatAiState &state = gameState->combatAi;
+		state.stats = {};
+
+		const u64 start = Profiler::now();
+		decide(gameState);
+		aimWeapons(gameState);
+		state.stats.ticks = Profiler::now() - start;
+	}
+};
\ No newline at end of file
@@ -11,6 +11,8 @@
 namespace Game {
 	// Forward declerations
 	void debugUI(GameState *gameState, f32 delta);
+	template<typename T, size_t Size> 
+	void debugEventQueue(GameState *gameState, UITextData *text, const wchar_t *name, const EventQueue<T, Size> &queue);
 	void populateSystemLocations(GameState *gameState);
 
 	void setup(GameState *gameState) {
@@ -21,7 +23,10 @@ namespace Game {
 
 		Shipment package1 = Shipment{};
 
-		gameState->pendingMusicItem = MusicAssetId::mars;
+		Tweens &tweens = gameState->tweens;
+		gameState->journeyProgressBinding = tweens.float32.bind(&gameState->journeyProgress);
+		gameState->daysPassedBinding = tweens.int32.bind(&gameState->daysPassed);
+		gameState->fuelBinding = tweens.float32.bind(&gameState->playerShip.fuel);
 
 		populateSystemLocations(gameState);
 		SystemSelect::setup(gameState);
@@ -37,6 +42,8 @@ namespace Game {
 			system(gameState, delta);
 		}
 
+		gameState->events.dispatch(gameState);
+
 		updateTweens(gameState, delta);
 #ifdef DEBUG
 		debugUI(gameState, realDelta);
@@ -49,8 +56,7 @@ namespace Game {
 
 		wchar_t textBuffer[100] = {};
 
-		u8 fps = round(1 / delta);
-		swprintf_s(textBuffer, L"FPS: %d", fps);
+		swprintf_s(textBuffer, L"FPS: %.1f (%.2fms)", 1.0f / delta, delta * 1e3f);
 		UITextData text = {};
 		text.text = textBuffer;
 		text.font = L"consolas";
@@ -76,6 +82,46 @@ namespace Game {
 		text.text = textBuffer;
 		text.position.y += text.height;
 		uiElements.push(text);
+
+		swprintf_s(textBuffer, L"Tweens: %zu", gameState->tweens.length());
+		text.text = textBuffer;
+		text.position.y += text.height;
+		uiElements.push(text);
+
+		const CombatAiState &combatAi = gameState->combatAi;
+		swprintf_s(
+			textBuffer,
+			L"AI: %zu ships, %u decisions (deferred %u), %.3fms",
+			gameState->combat.ai.length,
+			combatAi.stats.decisions,
+			combatAi.stats.deferred,
+			Profiler::ticksToMilliseconds(combatAi.stats.ticks, Profiler::ticksPerSecond())
+		);
+		text.text = textBuffer;
+		text.position.y += text.height;
+		uiElements.push(text);
+
+		debugEventQueue(gameState, &text, L"Target Destroyed", gameState->events.targetDestroyed);
+		debugEventQueue(gameState, &text, L"Shipment Delivered", gameState->events.shipmentDelivered);
+		debugEventQueue(gameState, &text, L"Refuel", gameState->events.refuel);
+		debugEventQueue(gameState, &text, L"Sound", gameState->events.sound);
+	}
+
+	// Shows the previous frame's peak queue depth and dropped events
+	template<typename T, size_t Size> 
+	void debugEventQueue(GameState *gameState, UITextData *text, const wchar_t *name, const EventQueue<T, Size> &queue) {
+		wchar_t textBuffer[100] = {};
+		swprintf_s(
+			textBuffer, 
+			L"%s: %u/%zu (dropped %u)", 
+			name, 
+			queue.lastFrameStats.peakDepth, 
+			queue.capacity(), 
+			queue.lastFrameStats.overflowCount
+		);
+		text->text = textBuffer;
+		text->position.y += text->height;
+		gameState->uiElements.push(*text);
 	}
 #endif
 
@@ -114,5 +160,9 @@ namespace Game {
 		location.isMoon = false;
 		location.isRefuellingLocation = true;
 		gameState->systemLocations.push(location);
+
+		for (size_t i = 0; i < gameState->systemLocations.length; i++) {
+			gameState->systemLocations[i].id = i;
+		}
 	}
 };
\ No newline at end of file
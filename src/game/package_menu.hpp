@@ -3,8 +3,9 @@
 #include <cmath>
 
 #include "common/game_state.hpp"
-#include "game/utils.hpp"
+#include "game/scene.hpp"
 #include "types/core.hpp"
+#include "utils/profiler.hpp"
 
 namespace PackageMenu {
 	// Forward declerations
@@ -14,6 +15,8 @@ namespace PackageMenu {
 	void drawUI(GameState *gameState);
 	void drawPackageOptions(GameState *gameState);
 	void deliverPackages(GameState *gameState);
+	void deliverShipment(GameState *gameState, ShipmentHandle handle);
+	void onShipmentsDelivered(GameState *gameState, const ShipmentDeliveredEvent *events, size_t count);
 	
 	enum class PackageMenuState {
 		main,
@@ -25,24 +28,24 @@ namespace PackageMenu {
 	bool hasAvailablePackages = false;
 
 	void setup(GameState *gameState) {
-		gameState->textureLoadQueue.push(TextureAssetId::marketPlace1);
+		Scene::enter(gameState, SceneId::packageMenu);
+
+		gameState->events.dispatch(gameState);
+		gameState->events.clearSubscribers();
+		gameState->events.shipmentDelivered.subscribe(&onShipmentsDelivered);
 
 		gameState->updateSystems.clear();
 		gameState->updateSystems.push(&update);
+		gameState->camera = Camera();
 
 		mode = PackageMenuState::main;
 
-		hasAvailablePackages = false;
-		for (size_t i = 0; i < gameState->shipments.length; i++) {
-			// only show packages for current location
-			if (gameState->shipments[i].to == gameState->dockedLocation && gameState->shipments[i].available) {
-				hasAvailablePackages = true;
-				break;
-			}
-		}
+		hasAvailablePackages = !gameState->shipments.to(gameState->dockedLocation).empty();
 	}
 
 	void update(GameState *gameState, f32 delta) {
+		PROFILE_ZONE("PackageMenu::update");
+
 		drawBackground(gameState);
 		drawUI(gameState);
 	}
@@ -68,16 +71,9 @@ namespace PackageMenu {
 		const f32 packagePadding = 80.0f;
 
 		// Shipments for docked location
-		Array<int, 10> deliverableShipments;
+		const Shipments::BucketView deliverableShipments = gameState->shipments.to(gameState->dockedLocation);
 
-		for (size_t i = 0; i < gameState->shipments.length; i++) {
-			// only show packages for current location
-			if (gameState->shipments[i].to == gameState->dockedLocation) {
-				deliverableShipments.push(i);
-			}
-		}
-
-		int numOfPackages = deliverableShipments.length;
+		int numOfPackages = deliverableShipments.length();
 
 		// Calculate total width of all packages with padding
 		f32 totalWidth = (numOfPackages * packageWidth) + ((numOfPackages - 1) * packagePadding);
@@ -89,115 +85,103 @@ namespace PackageMenu {
 		//f32 startXPos = startingPoint - ((packagePadding / 2.0f) * (numOfPackages - 1)) - packageWidth;// (packageWidth / 2.0f);
 		f32 previousXPosDiff = 0.0f;
 
-		for (size_t i = 0; i < deliverableShipments.length; i++) {
-			// only show packages for current location
-			if (gameState->shipments[deliverableShipments[i]].to == gameState->dockedLocation) {
-				f32 xPos = startXPos + previousXPosDiff;
-				f32 yPos = (screenHeight / 2.0f) - 20.0f;
-
-				UITextData packageText = {};
-				swprintf_s(packageText.text.data, L"Package %d", deliverableShipments[i] + 1);
-				packageText.color = Rgba(1.0f, 1.0f, 1.0f, 1.0f);
-				packageText.font = L"consolas";
-				packageText.fontSize = 40.0f;
-				packageText.width = 200.0f;
-				packageText.height = 30.0f;
-				packageText.position = Vec2(xPos, yPos);
-				packageText.horizontalAlignment = UITextAlignment::start;
-				packageText.verticalAlignment = UITextAlignment::middle;
-				gameState->uiElements.push(packageText);
-
-				UITextData weightText = {};
-				swprintf_s(weightText.text.data, L"Weight: %f", gameState->shipments[deliverableShipments[i]].weight);
-				weightText.color = Rgba(1.0f, 1.0f, 1.0f, 1.0f);
-				weightText.font = L"consolas";
-				weightText.fontSize = 20.0f;
-				weightText.width = 200.0f;
-				weightText.height = 30.0f;
-				yPos += packageText.height + 20.0f;;
-				weightText.position = Vec2(xPos, yPos);
-				weightText.horizontalAlignment = UITextAlignment::start;
-				weightText.verticalAlignment = UITextAlignment::middle;
-				gameState->uiElements.push(weightText);
-
-				UITextData destinationText = {};
-				swprintf_s(destinationText.text.data, L"Destination: %s", gameState->shipments[deliverableShipments[i]].to->name);
-				destinationText.color = Rgba(1.0f, 1.0f, 1.0f, 1.0f);
-				destinationText.font = L"consolas";
-				destinationText.fontSize = 20.0f;
-				destinationText.width = 250.0f;
-				destinationText.height = 30.0f;
-				yPos += weightText.height;
-				destinationText.position = Vec2(xPos, yPos);
-				destinationText.horizontalAlignment = UITextAlignment::start;
-				destinationText.verticalAlignment = UITextAlignment::middle;
-				gameState->uiElements.push(destinationText);
-
-				UITextData creditText = {};
-				swprintf_s(creditText.text.data, L"Value: %d", gameState->shipments[deliverableShipments[i]].creditAward);
-				creditText.color = Rgba(1.0f, 1.0f, 1.0f, 1.0f);
-				creditText.font = L"consolas";
-				creditText.fontSize = 20.0f;
-				creditText.width = 200.0f;
-				creditText.height = 30.0f;
-				yPos += destinationText.height;
-				creditText.position = Vec2(xPos, yPos);
-				creditText.horizontalAlignment = UITextAlignment::start;
-				creditText.verticalAlignment = UITextAlignment::middle;
-				gameState->uiElements.push(creditText);
-
-				const bool enabled = gameState->shipments[deliverableShipments[i]].available;
-				const f32 alpha = enabled ? 1.0f : 0.4f;
-
-				UIButtonData button = {};
-				button.label.text = L"SELECT";
-				button.label.font = L"consolas";
-				button.label.color = Rgba(0.0f, 1.0f, 0.0f, 1.0f);
-				button.label.fontSize = 24.0f;
-				button.label.color = Rgba(1.0f, 1.0f, 1.0f, alpha);
-				button.color = Rgba(0.0f, 0.0f, 0.0f, alpha);
-				button.height = 70.0f;
-				button.width = 150.0f;
-				button.cornerRadius = 10.0f;
-				button.strokeColor = Rgba(0.62f, 0.62f, 0.62f, 1.0f);
-				button.strokeWidth = 5.0f;
-				button.enabled = enabled;
-				yPos += creditText.height;
-				button.position = Vec2(xPos, yPos);
-
-				previousXPosDiff += packageWidth + packagePadding;
-
-				if (enabled) {
-					button.handleInput(gameState->input);
-					if (button.checkInput(UIButtonInputState::over)) {
-						gameState->input.cursor = Cursor::pointer;
-						button.strokeColor = Rgba(0.0f, 1.0f, 0.0f, 1.0f);
-
-						if (button.checkInput(UIButtonInputState::down)) {
-							const f32 scale = 0.9f;
-							button.label.fontSize *= scale;
-							button.position += Vec2(
-								button.width - button.width * scale,
-								button.height - button.height * scale
-							) * 0.5f;
-							button.width *= scale;
-							button.height *= scale;
-							button.strokeWidth *= scale;
-
-							gameState->credits += gameState->shipments[deliverableShipments[i]].creditAward;
-							// Play cash sound
-							gameState->soundLoadQueue.push(SoundAssetId::cha_ching);
-							gameState->soundLoadQueue.push(SoundAssetId::wahoo);
-							gameState->shipments[deliverableShipments[i]].available = false;
-						}
-					}
+		int packageNumber = 0;
+		for (ShipmentHandle handle : deliverableShipments) {
+			const Shipment &shipment = gameState->shipments[handle];
+			packageNumber++;
+
+			f32 xPos = startXPos + previousXPosDiff;
+			f32 yPos = (screenHeight / 2.0f) - 20.0f;
+
+			UITextData packageText = {};
+			swprintf_s(packageText.text.data, L"Package %d", packageNumber);
+			packageText.color = Rgba(1.0f, 1.0f, 1.0f, 1.0f);
+			packageText.font = L"consolas";
+			packageText.fontSize = 40.0f;
+			packageText.width = 200.0f;
+			packageText.height = 30.0f;
+			packageText.position = Vec2(xPos, yPos);
+			packageText.horizontalAlignment = UITextAlignment::start;
+			packageText.verticalAlignment = UITextAlignment::middle;
+			gameState->uiElements.push(packageText);
+
+			UITextData weightText = {};
+			swprintf_s(weightText.text.data, L"Weight: %f", shipment.weight);
+			weightText.color = Rgba(1.0f, 1.0f, 1.0f, 1.0f);
+			weightText.font = L"consolas";
+			weightText.fontSize = 20.0f;
+			weightText.width = 200.0f;
+			weightText.height = 30.0f;
+			yPos += packageText.height + 20.0f;;
+			weightText.position = Vec2(xPos, yPos);
+			weightText.horizontalAlignment = UITextAlignment::start;
+			weightText.verticalAlignment = UITextAlignment::middle;
+			gameState->uiElements.push(weightText);
+
+			UITextData destinationText = {};
+			swprintf_s(destinationText.text.data, L"Destination: %s", shipment.to->name);
+			destinationText.color = Rgba(1.0f, 1.0f, 1.0f, 1.0f);
+			destinationText.font = L"consolas";
+			destinationText.fontSize = 20.0f;
+			destinationText.width = 250.0f;
+			destinationText.height = 30.0f;
+			yPos += weightText.height;
+			destinationText.position = Vec2(xPos, yPos);
+			destinationText.horizontalAlignment = UITextAlignment::start;
+			destinationText.verticalAlignment = UITextAlignment::middle;
+			gameState->uiElements.push(destinationText);
+
+			UITextData creditText = {};
+			swprintf_s(creditText.text.data, L"Value: %d", shipment.creditAward);
+			creditText.color = Rgba(1.0f, 1.0f, 1.0f, 1.0f);
+			creditText.font = L"consolas";
+			creditText.fontSize = 20.0f;
+			creditText.width = 200.0f;
+			creditText.height = 30.0f;
+			yPos += destinationText.height;
+			creditText.position = Vec2(xPos, yPos);
+			creditText.horizontalAlignment = UITextAlignment::start;
+			creditText.verticalAlignment = UITextAlignment::middle;
+			gameState->uiElements.push(creditText);
+
+			UIButtonData button = {};
+			button.label.text = L"SELECT";
+			button.label.font = L"consolas";
+			button.label.color = Rgba(0.0f, 1.0f, 0.0f, 1.0f);
+			button.label.fontSize = 24.0f;
+			button.label.color = Rgba(1.0f, 1.0f, 1.0f, 1.0f);
+			button.color = Rgba(0.0f, 0.0f, 0.0f, 1.0f);
+			button.height = 70.0f;
+			button.width = 150.0f;
+			button.cornerRadius = 10.0f;
+			button.strokeColor = Rgba(0.62f, 0.62f, 0.62f, 1.0f);
+			button.strokeWidth = 5.0f;
+			yPos += creditText.height;
+			button.position = Vec2(xPos, yPos);
+
+			previousXPosDiff += packageWidth + packagePadding;
+
+			button.handleInput(gameState->input);
+			if (button.checkInput(UIButtonInputState::over)) {
+				gameState->input.cursor = Cursor::pointer;
+				button.strokeColor = Rgba(0.0f, 1.0f, 0.0f, 1.0f);
+
+				if (button.checkInput(UIButtonInputState::down)) {
+					const f32 scale = 0.9f;
+					button.label.fontSize *= scale;
+					button.position += Vec2(
+						button.width - button.width * scale,
+						button.height - button.height * scale
+					) * 0.5f;
+					button.width *= scale;
+					button.height *= scale;
+					button.strokeWidth *= scale;
+
+					deliverShipment(gameState, handle);
 				}
-				gameState->uiElements.push(button);
 			}
+			gameState->uiElements.push(button);
 		}
-
-		// Probably can do this once per setup
-		deliverableShipments.clear();
 	}		
 
 	void drawPackages(GameState *gameState) {
@@ -271,7 +255,7 @@ namespace PackageMenu {
 			gameState->uiElements.push(creditText);
 
 			const bool selected = !gameState->availableShipments[i].available;
-			const bool atCapacity = gameState->shipments.length >= SHIPMENT_MAX;
+			const bool atCapacity = gameState->shipments.isFull();
 			const bool enabled = !selected && !atCapacity;
 			const f32 alpha = enabled ? 1.0f : 0.4f;
 
@@ -543,22 +527,34 @@ namespace PackageMenu {
 		gameState->uiElements.push(btnDropoff);
 	}
 
+	void deliverShipment(GameState *gameState, ShipmentHandle handle) {
+		const Shipment &shipment = gameState->shipments[handle];
+		gameState->credits += shipment.creditAward;
+
+		ShipmentDeliveredEvent event = {};
+		event.creditAward = shipment.creditAward;
+		event.to = shipment.to;
+		gameState->events.shipmentDelivered.publish(event);
+
+		gameState->shipments.remove(handle);
+	}
+
 	void deliverPackages(GameState *gameState)
 	{
-		for (size_t i = 0; i < gameState->shipments.length; i++) {
-			// only show packages for current location
-			if (gameState->shipments[i].to == gameState->dockedLocation) {
-				gameState->credits += gameState->shipments[i].creditAward;
-				// Play cash sound
-				gameState->shipments[i].available = false;
-			}
+		for (ShipmentHandle handle : gameState->shipments.to(gameState->dockedLocation)) {
+			deliverShipment(gameState, handle);
 		}
 
 		hasAvailablePackages = false;
+	}
+
+	void onShipmentsDelivered(GameState *gameState, const ShipmentDeliveredEvent *events, size_t count) {
+		gameState->deliveriesMade += count;
 
 		// TODO: Display "toast" of how much money (moo-la) has been made
 
-		gameState->soundLoadQueue.push(SoundAssetId::cha_ching);
-		gameState->soundLoadQueue.push(SoundAssetId::wahoo); // TODO: Add delay so this gets played 100 milliseconds after cha_ching
+		// Play cash sound once for the whole batch
+		gameState->events.sound.publish({ SoundAssetId::cha_ching });
+		gameState->events.sound.publish({ SoundAssetId::wahoo }); // TODO: Add delay so this gets played 100 milliseconds after cha_ching
 	}
 };
\ No newline at end of file
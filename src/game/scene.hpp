@@ -0,0 +1,50 @@
+#pragma once
+
+#include "common/game_state.hpp"
+#include "common/scene_manifest.hpp"
+
+namespace Scene {
+	// Called from each scene's setup. Queues the scene's textures, which the
+	// platform has usually loaded ahead of time already, and starts its music
+	// unless it's already playing.
+	void enter(GameState *gameState, SceneId id) {
+		const SceneManifest &manifest = sceneManifests[(size_t)id];
+		for (u32 i = 0; i < manifest.textureCount; i++) {
+			gameState->textureLoadQueue.push(manifest.textures[i]);
+		}
+
+		SceneAssets &scene = gameState->scene;
+		scene.current = id;
+		scene.upcoming.clear();
+		for (u32 i = 0; i < manifest.nextCount; i++) {
+			scene.upcoming.push(manifest.next[i]);
+		}
+
+		if (manifest.music != MusicAssetId::none && manifest.music != scene.music) {
+			gameState->pendingMusicItem = manifest.music;
+			scene.music = manifest.music;
+		}
+	}
+
+	// Moves a scene to the front of the ones to load ahead for, when what's
+	// happening makes it the most likely to come next
+	void expect(GameState *gameState, SceneId id) {
+		Array<SceneId, SCENE_NEXT_MAX> &upcoming = gameState->scene.upcoming;
+		size_t index = 0;
+		while (index < upcoming.length && upcoming[index] != id) {
+			index++;
+		}
+		if (index == upcoming.length) {
+			if (upcoming.length == upcoming.capacity()) {
+				upcoming.pop();
+			}
+			upcoming.push(id);
+			index = upcoming.length - 1;
+		}
+
+		for (; index > 0; index--) {
+			upcoming[index] = upcoming[index - 1];
+		}
+		upcoming[0] = id;
+	}
+};
\ No newline at end of file
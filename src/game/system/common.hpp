@@ -11,11 +11,15 @@ namespace SystemCommon {
 		gameState->uiElements.push(star);
 	}
 
+	// Follows the camera so it fills the screen at any zoom
 	void drawStarField(GameState *gameState) {
+		const Camera &camera = gameState->camera;
+		const f32 scale = 1.3f / camera.getZoom();
+
 		Sprite background = {};
 		background.assetId = TextureAssetId::background;
-		background.position = Vec3<f32>(0.0f, 0.0f, 0.9f);
-		background.scale = Vec2<f32>(1.3f, 1.3f);
+		background.position = Vec3<f32>(camera.getPosition().x, camera.getPosition().y, 0.9f);
+		background.scale = Vec2<f32>(scale, scale);
 		gameState->sprites.push(background);
 	}
 
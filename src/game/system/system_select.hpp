@@ -4,40 +4,16 @@
 
 #include "common/game_state.hpp"
 #include "game/date.hpp"
-#include "game/utils.hpp"
+#include "game/scene.hpp"
 #include "game/system/common.hpp"
 #include "game/system/system_view.hpp"
 #include "game/package_menu.hpp"
 #include "types/core.hpp"
 #include "types/vector.hpp"
+#include "utils/profiler.hpp"
 
 namespace SystemSelect {
 	void populateAvailablePackages(GameState *gameState) {
-		#pragma region Clear out any delivered packages
-
-		Array<Shipment, SHIPMENT_MAX> undeliveredShipments;
-
-		for (int i = gameState->shipments.length - 1; i > -1; i--) {
-			Shipment s = gameState->shipments[i];
-
-			// only show packages for current location
-			if (s.available) {
-				undeliveredShipments.push(s);
-			}
-
-			gameState->shipments.pop();
-		}
-
-		// Push all deliverable packages back in
-		for (int i = 0; i < undeliveredShipments.length; i++) {
-			gameState->shipments.push(undeliveredShipments[i]);
-		}
-
-		// Finally clear temporary array
-		undeliveredShipments.clear();
-
-		#pragma endregion
-
 		gameState->availableShipments.clear();
 
 		// Set the random seed based on number of days passed
@@ -123,45 +99,60 @@ namespace SystemSelect {
 	void drawLocations(GameState *gameState, f32 delta);
 	void drawVisitPlanetButton(GameState *gameState);
 	void drawIndicator(GameState *gameState);
-	void drawUI(GameState *gameState);
+	void drawUI(GameState *gameState, f32 delta);
 	f32 getDistanceFromStar(SystemLocation *location);
 	void highlightLocations(GameState *gameState);
 	void update(GameState *gameState, f32 delta);
 	void updateJourney(GameState *gameState, f32 delta);
-	void updateRefuel(GameState *gameState, f32 delta);
+	void onRefuel(GameState *gameState, const RefuelEvent *events, size_t count);
 
 	const f32 starRadius = 400.0f;
-	const Vec2<f32> starCenter = Vec3(-250.0f, 1080.0f * 0.5f);
+	// Where the star is drawn, mostly off the left of the screen
+	const Vec2<f32> starScreenPosition = Vec2(-250.0f, screenHeight * 0.5f);
 	const f32 minPlanetSpacing = 130.0f;
 	const f32 minMoonSpacing = minPlanetSpacing * 0.2f;
 	const FuelValue fuelBurnRate = 20;
+	const FuelValue refuelRate = 1.0f;
 	const f32 dayRate = 0.01f;
 	const f32 VISIT_PLANET_BUTTON_Y = 180.0f;
 
 	void setup(GameState *gameState) {
-		gameState->textureLoadQueue.push(TextureAssetId::background);
+		Scene::enter(gameState, SceneId::systemSelect);
+
+		gameState->events.dispatch(gameState);
+		gameState->events.clearSubscribers();
+		gameState->events.refuel.subscribe(&onRefuel);
 		
 		gameState->updateSystems.clear();
 		gameState->updateSystems.push(&update);
+
+		// Star at the origin, shifted to `starScreenPosition`
+		gameState->camera = Camera();
+		gameState->camera.pan(starScreenPosition - gameState->camera.worldToScreen(Vec3<f32>()));
 	}
 
 	void update(GameState *gameState, f32 delta) {
-		gameState->highlightedLocation = nullptr;
+		PROFILE_ZONE("SystemSelect::update");
 
-		if (gameState->input.keyDown == '\t') {
-			SystemView::setup(gameState);
-		}
+		gameState->highlightedLocation = nullptr;
 
 		updateJourney(gameState, delta);
-		if (gameState->isRefuelling) {
-			updateRefuel(gameState, delta);
+		// Arriving usually means visiting, so have the package menu ready
+		if (gameState->targetLocation != nullptr) {
+			Scene::expect(gameState, SceneId::packageMenu);
 		}
+
 		SystemCommon::drawStarField(gameState);
-		SystemCommon::drawCentralStar(gameState, starCenter, starRadius);
+		SystemCommon::drawCentralStar(gameState, gameState->camera.worldToScreen(Vec3<f32>()), starRadius);
 		drawLocations(gameState, delta);
 		drawIndicator(gameState);
 		highlightLocations(gameState);
-		drawUI(gameState);
+		drawUI(gameState, delta);
+
+		// NOTE: Switched last since the other view moves the camera.
+		if (gameState->input.keyDown == '\t') {
+			SystemView::setup(gameState);
+		}
 	}
 
 	void drawCredits(GameState *gameState) {
@@ -256,29 +247,20 @@ namespace SystemSelect {
 					button.height *= scale;
 					button.strokeWidth *= scale;
 				} else if (button.checkInput(UIButtonInputState::clicked)) {
-					Tween journeyTween = {};
-					journeyTween.duration = estimatedDays;
-					journeyTween.type = TweenValueType::float32;
-					*(f32*)journeyTween.from = 0.0f;
-					*(f32*)journeyTween.to = 1.0f;
-					journeyTween.value = &gameState->journeyProgress;
-					gameState->tweens.push(journeyTween);
-
-					Tween fuelTween = {};
-					fuelTween.duration = estimatedDays;
-					fuelTween.type = TweenValueType::float32;
-					*(f32*)fuelTween.from = gameState->playerShip.fuel;
-					*(f32*)fuelTween.to = gameState->playerShip.fuel - fuelConsumption;
-					fuelTween.value = &gameState->playerShip.fuel;
-					gameState->tweens.push(fuelTween);
-
-					Tween daysTween = {};
-					daysTween.duration = estimatedDays;
-					daysTween.type = TweenValueType::int32;
-					*(s32*)daysTween.from = gameState->daysPassed;
-					*(s32*)daysTween.to = gameState->daysPassed + estimatedDays;
-					daysTween.value = &gameState->daysPassed;
-					gameState->tweens.push(daysTween);
+					Tweens &tweens = gameState->tweens;
+					tweens.float32.start(gameState->journeyProgressBinding, 0.0f, 1.0f, estimatedDays);
+					tweens.float32.start(
+						gameState->fuelBinding, 
+						gameState->playerShip.fuel, 
+						gameState->playerShip.fuel - fuelConsumption, 
+						estimatedDays
+					);
+					tweens.int32.start(
+						gameState->daysPassedBinding, 
+						gameState->daysPassed, 
+						gameState->daysPassed + estimatedDays, 
+						estimatedDays
+					);
 
 					gameState->targetLocation = gameState->selectedLocation;
 					gameState->selectedLocation = nullptr;
@@ -292,7 +274,7 @@ namespace SystemSelect {
 		gameState->uiElements.push(estimatedDaysText);
 	}
 
-	void drawRefuelButton(GameState *gameState) {
+	void drawRefuelButton(GameState *gameState, f32 delta) {
 		const bool enabled =
 			gameState->playerShip.fuel < gameState->playerShip.fuelTankCapacity &&
 			gameState->credits > gameState->dockedLocation->fuelPrice;
@@ -315,9 +297,6 @@ namespace SystemSelect {
 
 		button.position = Vec2(1920.0f - button.width - 10.0f, VISIT_PLANET_BUTTON_Y + button.height + buttonOffset);
 
-		// initialise to not refuelling
-		gameState->isRefuelling = false;
-
 		if (enabled) {
 			button.handleInput(gameState->input);
 			if (button.checkInput(UIButtonInputState::over)) {
@@ -335,20 +314,10 @@ namespace SystemSelect {
 					button.height *= scale;
 					button.strokeWidth *= scale;
 
-					gameState->isRefuelling = true;
-
-					////if (refuelTween.progress == 0.0f || refuelTween.progress == 100.0f) {
-					//if (gameState->tweens.hasCapacity()) {
-					//	Tween refuelTween = {};
-					//	refuelTween.duration = 1.0f;
-					//	refuelTween.type = TweenValueType::float32;
-					//	*(f32 *)refuelTween.from = gameState->playerShip.fuel;
-					//	*(f32 *)refuelTween.to = gameState->playerShip.fuel + fuelAddition;
-					//	refuelTween.value = &gameState->playerShip.fuel;
-					//	gameState->tweens.push(refuelTween);
-
-					//	gameState->credits -= gameState->dockedLocation->fuelPrice;
-					//}
+					RefuelEvent event = {};
+					event.location = gameState->dockedLocation;
+					event.fuel = refuelRate * delta;
+					gameState->events.refuel.publish(event);
 				}
 			}
 		}
@@ -484,7 +453,10 @@ namespace SystemSelect {
 	}
 
 	void drawLocations(GameState *gameState, f32 delta) {
+		PROFILE_ZONE("SystemSelect::drawLocations");
+
 		const f32 orbitDistanceScale = 0.07f;
+		const Vec2<f32> starCenter = gameState->camera.worldToScreen(Vec3<f32>());
 
 		u8 moonOffset = 0;
 
@@ -548,9 +520,9 @@ namespace SystemSelect {
 				circle.position = circle.position * distance + orbitCenter;
 				location.position = circle.position; // Position used for orbiting moons
 
-				const f32 inputDistance = gameState->input.mouse.distanceTo(circle.position);
 				const f32 allowedInputArea = location.radius + minMoonSpacing * 0.5f;
-				const bool mouseIsOver = inputDistance <= allowedInputArea;
+				const f32 squaredInputArea = allowedInputArea * allowedInputArea;
+				const bool mouseIsOver = gameState->input.mouse.squaredDistanceTo(circle.position) <= squaredInputArea;
 				if (mouseIsOver) {
 					gameState->highlightedLocation = &location;
 				}
@@ -560,7 +532,7 @@ namespace SystemSelect {
 				if (mouseIsOver) {
 					if (
 						gameState->input.primaryButton.wasDown && 
-						gameState->input.primaryButton.start.distanceTo(circle.position) <= allowedInputArea
+						gameState->input.primaryButton.start.squaredDistanceTo(circle.position) <= squaredInputArea
 					) {
 						gameState->selectedLocation = &location;
 					}
@@ -582,7 +554,9 @@ namespace SystemSelect {
 		}
 	}
 
-	void drawUI(GameState *gameState) {
+	void drawUI(GameState *gameState, f32 delta) {
+		PROFILE_ZONE("SystemSelect::drawUI");
+
 		drawFuelGauge(gameState);
 		drawCredits(gameState);
 		drawDate(gameState);
@@ -592,7 +566,7 @@ namespace SystemSelect {
 		if (gameState->journeyProgress == 0.0f) {
 			drawVisitPlanetButton(gameState);
 			if (gameState->dockedLocation->isRefuellingLocation) {
-				drawRefuelButton(gameState);
+				drawRefuelButton(gameState, delta);
 			}
 		}
 	}
@@ -638,6 +612,8 @@ namespace SystemSelect {
 	}
 
 	void updateJourney(GameState *gameState, f32 delta) {
+		PROFILE_ZONE("SystemSelect::updateJourney");
+
 		if (gameState->targetLocation != nullptr && gameState->journeyProgress == 1.0f) {
 			gameState->dockedLocation = gameState->targetLocation;
 			gameState->targetLocation = nullptr;
@@ -649,15 +625,17 @@ namespace SystemSelect {
 		}
 	}
 
-	void updateRefuel(GameState *gameState, f32 delta) {
-		if (
-			gameState->playerShip.fuel < gameState->playerShip.fuelTankCapacity && 
-			gameState->credits > gameState->dockedLocation->fuelPrice
-		) {
-			FuelValue fuelAddition = 1.0f;
-			gameState->playerShip.fuel += fuelAddition * delta;
+	void onRefuel(GameState *gameState, const RefuelEvent *events, size_t count) {
+		for (size_t i = 0; i < count; i++) {
+			const RefuelEvent &event = events[i];
 
-			gameState->credits -= gameState->dockedLocation->fuelPrice * delta;
+			if (
+				gameState->playerShip.fuel < gameState->playerShip.fuelTankCapacity && 
+				gameState->credits > event.location->fuelPrice
+			) {
+				gameState->playerShip.fuel += event.fuel;
+				gameState->credits -= event.location->fuelPrice * event.fuel;
+			}
 		}
 	}
 };
\ No newline at end of file
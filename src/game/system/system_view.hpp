@@ -4,10 +4,11 @@
 
 #include "common/game_state.hpp"
 #include "types/vector.hpp"
+#include "game/scene.hpp"
 #include "game/system/common.hpp"
 #include "game/system/system_select.hpp"
-#include "game/utils.hpp"
 #include "types/core.hpp"
+#include "utils/profiler.hpp"
 
 namespace SystemSelect { void setup(GameState *gameState); };
 
@@ -16,29 +17,52 @@ namespace SystemView {
 	void drawLocations(GameState *gameState, f32 delta);
 	void update(GameState *gameState, f32 delta);
 
-	const f32 scale = 0.2f;
 	const f32 starRadius = 400.0f;
-	const Vec2<f32> starCenter = gameToScreen(Vec3<f32>());
+	const f32 minZoom = 0.05f;
+	const f32 maxZoom = 1.0f;
 
 	void setup(GameState *gameState) {
-		gameState->textureLoadQueue.push(TextureAssetId::background);
+		Scene::enter(gameState, SceneId::systemView);
+
+		// The star sits at the origin
+		gameState->camera = Camera();
+		gameState->camera.setZoom(0.2f);
+
+		gameState->events.dispatch(gameState);
+		gameState->events.clearSubscribers();
 
 		gameState->updateSystems.clear();
 		gameState->updateSystems.push(&update);
 	}
 
 	void update(GameState *gameState, f32 delta) {
+		PROFILE_ZONE("SystemView::update");
+
+		// Scroll to zoom and drag to pan around the system
+		const Input &input = gameState->input;
+		Camera &camera = gameState->camera;
+		if (input.wheel != 0.0f) {
+			camera.zoomAt(input.mouse, powf(1.25f, input.wheel), minZoom, maxZoom);
+		}
+		if (input.primaryButton.down && input.primaryButton.wasDown) {
+			camera.pan(input.mouseMovement());
+		}
+
 		SystemCommon::drawStarField(gameState);
+		SystemCommon::drawCentralStar(gameState, camera.worldToScreen(Vec3<f32>()), starRadius * camera.getZoom());
+		drawLocations(gameState, delta);
 
+		// NOTE: Switched last since the other view moves the camera.
 		if (gameState->input.keyDown == '\t') {
 			SystemSelect::setup(gameState);
 		}
-
-		SystemCommon::drawCentralStar(gameState, starCenter, starRadius * scale);
-		drawLocations(gameState, delta);
 	}
 
 	void drawLocations(GameState *gameState, f32 delta) {
+		const Camera &camera = gameState->camera;
+		const f32 scale = camera.getZoom();
+		const Vec2<f32> starCenter = camera.worldToScreen(Vec3<f32>());
+
 		u8 moonOffset = 0;
 
 		for (size_t i = 0; i < gameState->systemLocations.length; i++) {
@@ -52,14 +76,7 @@ namespace SystemView {
 			circle.radius = locationRadius;
 
 			SystemCommon::updateOrbitLocation(&location, delta);
-			circle.position = Vec2(1.0f, 0.0f);
-
-			const f32 ca = cos(location.orbit.angle);
-			const f32 sa = sin(location.orbit.angle);
-			circle.position = Vec2(
-				ca * circle.position.x - sa * circle.position.y, 
-				sa * circle.position.x + ca * circle.position.y
-			);
+			circle.position = Vec2(cosf(location.orbit.angle), sinf(location.orbit.angle));
 
 			f32 minRadius = starRadius * scale;
 			Vec2 orbitCenter = starCenter;
@@ -88,8 +105,9 @@ namespace SystemView {
 			location.position = circle.position; // Position used for orbiting moons
 			circle.position = Vec3(circle.position.x, circle.position.y);
 
-			const f32 distance = gameState->input.mouse.distanceTo(circle.position);
-			const bool mouseIsOver = distance <= locationRadius + 10.0f;
+			const f32 hoverRadius = locationRadius + 10.0f;
+			const f32 squaredDistance = gameState->input.mouse.squaredDistanceTo(circle.position);
+			const bool mouseIsOver = squaredDistance <= hoverRadius * hoverRadius;
 			if (mouseIsOver) {
 				circle.strokeWidth = 1.0f;
 				circle.strokeColor = Rgba(0.0f, 1.0f, 0.0f, 1.0f);
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdio>
+#include <cstring>
 #include <cmath>
 
 #include <d2d1.h>
@@ -13,23 +14,95 @@
 #include <wincodec.h>
 
 #include "common/asset_definitions.hpp"
+#include "common/camera.hpp"
+#include "common/render_scale.hpp"
 #include "common/sprite.hpp"
+#include "common/text_run_cache.hpp"
 #include "common/window_config.hpp"
 #include "common/ui_element.hpp"
 #include "platform/windows/dx3d_sprite_loader.hpp"
+#include "platform/windows/gpu_timer.hpp"
 #include "platform/windows/utils.hpp"
 #include "platform/windows/sprite_vertex.hpp"
 #include "types/core.hpp"
 #include "types/matrix.hpp"
 #include "types/vector.hpp"
+#include "utils/profiler.hpp"
+
+enum class ShaderId {
+	sprite,
+	starfield,
+	upscale,
+	_length
+};
+
+const wchar_t *shaderPaths[] = {
+	GET_ASSET_PATH("shaders/sprite_shader.hlsl"),
+	GET_ASSET_PATH("shaders/starfield_shader.hlsl"),
+	GET_ASSET_PATH("shaders/upscale_shader.hlsl")
+};
+
+struct ShaderBlobs {
+	ID3DBlob *vertex;
+	ID3DBlob *pixel;
+};
+
+void releaseShaderBlobs(ShaderBlobs *blobs) {
+	RELEASE_COM_OBJ(blobs->vertex)
+	RELEASE_COM_OBJ(blobs->pixel)
+}
+
+// Compiles the vertex and pixel stage of a shader file. Doesn't touch the
+// device so it's safe to call from any thread. Errors are logged rather than
+// asserted so a hot reload with a typo keeps the previous shader running.
+bool compileShaderBlobs(const wchar_t *fileName, ShaderBlobs *blobs) {
+	const char *entryPoints[] = { "vertex", "pixel" };
+	const char *targets[] = { "vs_4_0", "ps_4_0" };
+	ID3DBlob **outputs[] = { &blobs->vertex, &blobs->pixel };
+
+	*blobs = {};
+	for (size_t i = 0; i < 2; i++) {
+		ID3DBlob *errorBlob = nullptr;
+		const HRESULT result = D3DCompileFromFile(
+			fileName, 
+			nullptr, 
+			nullptr, 
+			entryPoints[i], 
+			targets[i], 
+			NULL, 
+			NULL, 
+			outputs[i], 
+			&errorBlob
+		);
+
+		if (!SUCCEEDED(result)) {
+			_com_error error(result);
+			LOG(L"Failed to compile %s (%hs): %s\n", fileName, entryPoints[i], error.ErrorMessage())
+			if (errorBlob != nullptr) {
+				LOG(L"%hs\n", (const char*)errorBlob->GetBufferPointer())
+			}
+
+			RELEASE_COM_OBJ(errorBlob)
+			releaseShaderBlobs(blobs);
+			return false;
+		}
+
+		RELEASE_COM_OBJ(errorBlob)
+	}
+
+	return true;
+}
 
 // TODO(steven): Move somewhere else and rename
 struct ConstantBuffer {
 	Mat4x4<f32> projection;
+	Vec2<f32> renderScale;
+	f32 padding[2];
 };
 
 struct SpriteInfoBuffer {
-	Mat4x4<f32> transform;
+	Mat4 transform;
+	Vec4 uvRect;
 };
 
 class DirectXRenderer {
@@ -51,6 +124,8 @@ protected:
 		ID3D11VertexShader *vertexShader;
 		ID3D11PixelShader *pixelShader;
 		ID3D11InputLayout *vertexBufferLayout;
+		// A unit quad every sprite is scaled from
+		ID3D11Buffer *vertexBuffer;
 		ID3D11Buffer *infoBuffer;
 	} spriteShader;
 
@@ -61,19 +136,50 @@ protected:
 		ID3D11PixelShader *pixelShader;
 	} starfieldShader;
 
+	// Draws the scene onto the back buffer when it's rendered below full size
+	struct {
+		ID3D11VertexShader *vertexShader;
+		ID3D11InputLayout *vertexBufferLayout;
+		ID3D11PixelShader *pixelShader;
+	} upscaleShader;
+
+	// The scene's drawn into the top left of these when it's scaled down
+	struct {
+		ID3D11Texture2D *texture;
+		ID3D11RenderTargetView *renderView;
+		ID3D11Texture2D *resolved;
+		ID3D11ShaderResourceView *resolvedView;
+	} scene;
+
 	ID3D11BlendState *blendState;
 	ID3D11Buffer *constantBuffer;
+	// What's in the constant buffer
+	Mat4 viewProjection;
+	// Fraction of the screen the scene is drawn to on each axis
+	Vec2<f32> renderScale = Vec2<f32>(1.0f, 1.0f);
+
+	GpuTimer gpuTimer;
+
+	TextRunCache<IDWriteTextLayout*, 128> textRunCache;
 
 public:
 	~DirectXRenderer() {
 		RELEASE_COM_OBJ(this->spriteShader.vertexShader)
 		RELEASE_COM_OBJ(this->spriteShader.pixelShader)
 		RELEASE_COM_OBJ(this->spriteShader.vertexBufferLayout)
+		RELEASE_COM_OBJ(this->spriteShader.vertexBuffer)
 		RELEASE_COM_OBJ(this->spriteShader.infoBuffer)
 		RELEASE_COM_OBJ(this->starfieldShader.vertexShader)
 		RELEASE_COM_OBJ(this->starfieldShader.pixelShader)
 		RELEASE_COM_OBJ(this->starfieldShader.vertexBufferLayout)
 		RELEASE_COM_OBJ(this->starfieldShader.vertexBuffer)
+		RELEASE_COM_OBJ(this->upscaleShader.vertexShader)
+		RELEASE_COM_OBJ(this->upscaleShader.pixelShader)
+		RELEASE_COM_OBJ(this->upscaleShader.vertexBufferLayout)
+		RELEASE_COM_OBJ(this->scene.texture)
+		RELEASE_COM_OBJ(this->scene.renderView)
+		RELEASE_COM_OBJ(this->scene.resolved)
+		RELEASE_COM_OBJ(this->scene.resolvedView)
 		RELEASE_COM_OBJ(this->swapChain)
 		RELEASE_COM_OBJ(this->deviceContext)
 		RELEASE_COM_OBJ(this->renderView)
@@ -85,6 +191,11 @@ public:
 		RELEASE_COM_OBJ(this->dWriteFactory)
 		RELEASE_COM_OBJ(this->blendState)
 		RELEASE_COM_OBJ(this->constantBuffer)
+		this->gpuTimer.release();
+
+		for (IDWriteTextLayout *&textLayout : this->textRunCache) {
+			RELEASE_COM_OBJ(textLayout)
+		}
 
 #ifdef DEBUG
 		ID3D11Debug *debug = nullptr;
@@ -103,8 +214,10 @@ public:
 		this->compileShaders();
 		this->createBlendState();
 		this->createDepthBuffer();
+		this->createSceneTargets();
 		this->createConstantBuffers();
 		this->create2dTarget();
+		this->gpuTimer.initialise(this->resources->device);
 
 		GetUserDefaultLocaleName(this->d2dLocaleName, LOCALE_NAME_MAX_LENGTH);
 	}
@@ -146,22 +259,9 @@ public:
 		ASSERT_HRESULT(result)
 	}
 
-	void drawUI(UIElement *uiElementBuffer, UINT bufferLength) const {
-		// Horizontal text alignment
-		DWRITE_TEXT_ALIGNMENT textAlignments[] = { 
-			DWRITE_TEXT_ALIGNMENT_LEADING, 
-			DWRITE_TEXT_ALIGNMENT_CENTER, 
-			DWRITE_TEXT_ALIGNMENT_TRAILING 
-		};
-
-		// Vertical text alignment
-		DWRITE_PARAGRAPH_ALIGNMENT paragraphAlignments[] = {
-			DWRITE_PARAGRAPH_ALIGNMENT_NEAR,
-			DWRITE_PARAGRAPH_ALIGNMENT_CENTER,
-			DWRITE_PARAGRAPH_ALIGNMENT_FAR
-		};
+	void drawUI(UIElement *uiElementBuffer, UINT bufferLength) {
+		PROFILE_ZONE("DirectXRenderer::drawUI");
 
-		IDWriteTextFormat *textFormat = nullptr;
 		ID2D1StrokeStyle *strokeStyle = nullptr;
 		ID2D1PathGeometry *geometry = nullptr;
 		ID2D1GeometrySink *sink = nullptr;
@@ -180,45 +280,19 @@ public:
 			if (element.type == UIType::text) {
 				const UITextData &text = element.text;
 
-				// TODO(steven): Re-use text formats
-				HRESULT result = this->dWriteFactory->CreateTextFormat(
-					text.font.data, 
-					nullptr, 
-					DWRITE_FONT_WEIGHT_REGULAR, 
-					DWRITE_FONT_STYLE_NORMAL, 
-					DWRITE_FONT_STRETCH_MEDIUM, 
-					text.fontSize, 
-					this->d2dLocaleName, 
-					&textFormat
-				);
-				ASSERT_HRESULT(result)
-
-				DWRITE_TEXT_ALIGNMENT textAlignment = textAlignments[(size_t)text.horizontalAlignment]; 
-				result = textFormat->SetTextAlignment(textAlignment);
-				ASSERT_HRESULT(result)
-
-				DWRITE_PARAGRAPH_ALIGNMENT paragraphAlignment = paragraphAlignments[(size_t)text.verticalAlignment];
-				textFormat->SetParagraphAlignment(paragraphAlignment);
-				ASSERT_HRESULT(result)
-
-				D2D1_RECT_F layoutRect = { 
-					text.position.x, 
-					text.position.y, 
-					text.position.x + text.width, 
-					text.position.y + text.height 
-				};
+				bool miss;
+				IDWriteTextLayout **textLayout = this->textRunCache.fetch(TextRunKey(text), &miss);
+				if (miss) {
+					RELEASE_COM_OBJ(*textLayout)
+					*textLayout = this->createTextLayout(text);
+				}
 
-				this->d2dRenderTarget->DrawText(
-					text.text.data, 
-					wcslen(text.text.data), 
-					textFormat, 
-					layoutRect, 
+				this->d2dRenderTarget->DrawTextLayout(
+					{ text.position.x, text.position.y }, 
+					*textLayout, 
 					this->d2dSolidBrush, 
-					D2D1_DRAW_TEXT_OPTIONS_NO_SNAP, 
-					DWRITE_MEASURING_MODE_NATURAL
+					D2D1_DRAW_TEXT_OPTIONS_NO_SNAP
 				);
-
-				RELEASE_COM_OBJ(textFormat)
 			} else if (element.type == UIType::line) {
 				const UILineData &line = element.line;
 
@@ -307,26 +381,138 @@ public:
 			HRESULT result = this->d2dRenderTarget->EndDraw();
 			ASSERT_HRESULT(result);
 		}
+
+		this->textRunCache.endFrame();
+	}
+
+	IDWriteTextLayout *createTextLayout(const UITextData &text) const {
+		PROFILE_ZONE("DirectXRenderer::createTextLayout");
+
+		// Horizontal text alignment
+		DWRITE_TEXT_ALIGNMENT textAlignments[] = { 
+			DWRITE_TEXT_ALIGNMENT_LEADING, 
+			DWRITE_TEXT_ALIGNMENT_CENTER, 
+			DWRITE_TEXT_ALIGNMENT_TRAILING 
+		};
+
+		// Vertical text alignment
+		DWRITE_PARAGRAPH_ALIGNMENT paragraphAlignments[] = {
+			DWRITE_PARAGRAPH_ALIGNMENT_NEAR,
+			DWRITE_PARAGRAPH_ALIGNMENT_CENTER,
+			DWRITE_PARAGRAPH_ALIGNMENT_FAR
+		};
+
+		IDWriteTextFormat *textFormat = nullptr;
+		HRESULT result = this->dWriteFactory->CreateTextFormat(
+			text.font.data, 
+			nullptr, 
+			DWRITE_FONT_WEIGHT_REGULAR, 
+			DWRITE_FONT_STYLE_NORMAL, 
+			DWRITE_FONT_STRETCH_MEDIUM, 
+			text.fontSize, 
+			this->d2dLocaleName, 
+			&textFormat
+		);
+		ASSERT_HRESULT(result)
+
+		DWRITE_TEXT_ALIGNMENT textAlignment = textAlignments[(size_t)text.horizontalAlignment]; 
+		result = textFormat->SetTextAlignment(textAlignment);
+		ASSERT_HRESULT(result)
+
+		DWRITE_PARAGRAPH_ALIGNMENT paragraphAlignment = paragraphAlignments[(size_t)text.verticalAlignment];
+		result = textFormat->SetParagraphAlignment(paragraphAlignment);
+		ASSERT_HRESULT(result)
+
+		IDWriteTextLayout *textLayout = nullptr;
+		result = this->dWriteFactory->CreateTextLayout(
+			text.text.data, 
+			wcslen(text.text.data), 
+			textFormat, 
+			text.width, 
+			text.height, 
+			&textLayout
+		);
+		ASSERT_HRESULT(result)
+
+		RELEASE_COM_OBJ(textFormat)
+		return textLayout;
+	}
+
+	const TextRunCacheStats &getTextRunStats() const {
+		return this->textRunCache.lastFrameStats;
+	}
+
+	// Only uploaded when the camera has moved
+	void setViewProjection(const Mat4 &viewProjection) {
+		if (memcmp(&viewProjection, &this->viewProjection, sizeof(Mat4)) == 0) {
+			return;
+		}
+		this->viewProjection = viewProjection;
+		this->updateConstantBuffer();
+	}
+
+	// Sets the resolution the scene is drawn at from the next `start`, UI is
+	// always drawn at full resolution
+	void setRenderScale(f32 scale) {
+		const Vec2<f32> renderScale(
+			(f32)RenderScale::scaledSize(screenWidth, scale) / screenWidth,
+			(f32)RenderScale::scaledSize(screenHeight, scale) / screenHeight
+		);
+		if (renderScale.x == this->renderScale.x && renderScale.y == this->renderScale.y) {
+			return;
+		}
+		this->renderScale = renderScale;
+		this->updateConstantBuffer();
+	}
+
+	// Milliseconds the GPU took over the latest frame that's come back, false
+	// if none has since the last call
+	bool collectGpuMilliseconds(f32 *milliseconds) {
+		return this->gpuTimer.collect(this->deviceContext, milliseconds);
+	}
+
+	void updateConstantBuffer() {
+		D3D11_MAPPED_SUBRESOURCE mappedResource;
+		HRESULT result = this->deviceContext->Map(
+			this->constantBuffer, 
+			NULL, 
+			D3D11_MAP_WRITE_DISCARD, 
+			NULL, 
+			&mappedResource
+		);
+		ASSERT_HRESULT(result)
+
+		ConstantBuffer *buffer = (ConstantBuffer*)mappedResource.pData;
+		buffer->projection = this->viewProjection.toMat4x4();
+		buffer->renderScale = this->renderScale;
+
+		this->deviceContext->Unmap(this->constantBuffer, 0);
 	}
 
 	void drawSprites(Sprite *sprites, UINT bufferLength) const {
+		PROFILE_ZONE("DirectXRenderer::drawSprites");
+
 		this->deviceContext->IASetPrimitiveTopology(D3D10_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
 		this->deviceContext->IASetInputLayout(this->spriteShader.vertexBufferLayout);
 
+		const UINT stride = sizeof(SpriteVertex);
+		const UINT offset = 0;
+		this->deviceContext->IASetVertexBuffers(0, 1, &this->spriteShader.vertexBuffer, &stride, &offset);
+
 		this->deviceContext->VSSetShader(this->spriteShader.vertexShader, nullptr, 0);
 		this->deviceContext->VSSetConstantBuffers(0, 1, &this->constantBuffer);
 		this->deviceContext->VSSetConstantBuffers(1, 1, &this->spriteShader.infoBuffer);
 
 		this->deviceContext->PSSetShader(this->spriteShader.pixelShader, nullptr, 0);
 
+		// Sprites from the same atlas page share a view, so runs of them only
+		// bind it once
+		ID3D11ShaderResourceView *boundView = nullptr;
+
 		for (UINT i = 0; i < bufferLength; i++) {
 			const Sprite &sprite = sprites[i];
 			const Dx3dSpriteResource &textureReference = this->resources->spriteResources[(size_t)sprite.assetId];
 
-			const UINT stride = sizeof(SpriteVertex);
-			const UINT offset = 0;
-			this->deviceContext->IASetVertexBuffers(0, 1, &textureReference.vertexBuffer, &stride, &offset);
-
 			D3D11_MAPPED_SUBRESOURCE mappedResource;
 			HRESULT result = this->deviceContext->Map(
 				this->spriteShader.infoBuffer, 
@@ -337,17 +523,18 @@ public:
 			);
 			ASSERT_HRESULT(result)
 
-			Mat4x4<f32> transform;
-			transform = transform.translate(sprite.position.x, sprite.position.y, sprite.position.z);
-			transform = transform.rotate(-sprite.angle * M_PI / 180);
-			transform = transform.scale(sprite.scale.x, sprite.scale.y);
-			
+			const Vec2<f32> size = Vec2<f32>(sprite.scale.x * textureReference.width, sprite.scale.y * textureReference.height);
+
 			SpriteInfoBuffer *buffer = (SpriteInfoBuffer*)mappedResource.pData;
-			buffer->transform = transform;
+			buffer->transform = Mat4::trs(sprite.position, -sprite.angle * (f32)M_PI / 180.0f, size);
+			buffer->uvRect = textureReference.uvRect;
 
 			this->deviceContext->Unmap(this->spriteShader.infoBuffer, 0);
 
-			this->deviceContext->PSSetShaderResources(0, 1, &textureReference.texture2dView);
+			if (textureReference.texture2dView != boundView) {
+				boundView = textureReference.texture2dView;
+				this->deviceContext->PSSetShaderResources(0, 1, &boundView);
+			}
 			this->deviceContext->Draw(4, 0);
 		}
 	}
@@ -362,19 +549,65 @@ public:
 
 		this->deviceContext->VSSetShader(this->starfieldShader.vertexShader, nullptr, 0);
 		this->deviceContext->PSSetShader(this->starfieldShader.pixelShader, nullptr, 0);
+		this->deviceContext->PSSetConstantBuffers(0, 1, &this->constantBuffer);
+
+		this->deviceContext->Draw(4, 0);
+	}
+
+	// Stretches the scene over the back buffer if it was drawn scaled down,
+	// call before drawing the UI
+	void upscaleScene() {
+		if (!this->isScaled()) {
+			return;
+		}
+		PROFILE_ZONE("DirectXRenderer::upscaleScene");
+
+		this->deviceContext->ResolveSubresource(
+			this->scene.resolved, 
+			0, 
+			this->scene.texture, 
+			0, 
+			DXGI_FORMAT_R8G8B8A8_UNORM
+		);
+
+		this->deviceContext->OMSetRenderTargets(1, &this->renderView, nullptr);
+		this->setViewport(screenWidth, screenHeight);
+
+		this->deviceContext->IASetPrimitiveTopology(D3D10_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+		this->deviceContext->IASetInputLayout(this->upscaleShader.vertexBufferLayout);
+
+		const UINT stride = sizeof(Vec3<f32>);
+		const UINT offset = 0;
+		this->deviceContext->IASetVertexBuffers(0, 1, &this->starfieldShader.vertexBuffer, &stride, &offset);
+
+		this->deviceContext->VSSetShader(this->upscaleShader.vertexShader, nullptr, 0);
+		this->deviceContext->VSSetConstantBuffers(0, 1, &this->constantBuffer);
+		this->deviceContext->PSSetShader(this->upscaleShader.pixelShader, nullptr, 0);
+		this->deviceContext->PSSetConstantBuffers(0, 1, &this->constantBuffer);
+		this->deviceContext->PSSetShaderResources(0, 1, &this->scene.resolvedView);
 
 		this->deviceContext->Draw(4, 0);
+
+		// Unbound so it can be resolved into again next frame
+		ID3D11ShaderResourceView *none = nullptr;
+		this->deviceContext->PSSetShaderResources(0, 1, &none);
 	}
 
-	void finish() const {
+	void finish() {
+		this->gpuTimer.end(this->deviceContext);
+
 		// TODO(steven): SyncInterval results in different framerate on different monitors
 		HRESULT result = this->swapChain->Present(1, 0);
 		ASSERT_HRESULT(result)
 	}
 
-	void start() const {
+	void start() {
+		this->gpuTimer.begin(this->deviceContext);
+
+		ID3D11RenderTargetView *sceneView = this->isScaled() ? this->scene.renderView : this->renderView;
+
 		const Rgba clearColor(0.0f, 0.2f, 0.4f, 1.0f);
-		this->deviceContext->ClearRenderTargetView(this->renderView, (f32*)&clearColor);
+		this->deviceContext->ClearRenderTargetView(sceneView, (f32*)&clearColor);
 
 		this->deviceContext->ClearDepthStencilView(
 			this->depthStencilView, 
@@ -385,31 +618,63 @@ public:
 
 		this->deviceContext->OMSetBlendState(this->blendState, 0, 0xffffffff);
 		this->deviceContext->OMSetDepthStencilState(this->depthStencilState, NULL);
-		this->deviceContext->OMSetRenderTargets(1, &this->renderView, this->depthStencilView);
+		this->deviceContext->OMSetRenderTargets(1, &sceneView, this->depthStencilView);
+		this->setViewport(
+			RenderScale::scaledSize(screenWidth, this->renderScale.x), 
+			RenderScale::scaledSize(screenHeight, this->renderScale.y)
+		);
 	}
 
-protected:
-	void compileSpriteShaders() {
-		ID3D10Blob *blob;
-		ID3D10Blob *errorBlob;
+	bool isScaled() const {
+		return this->renderScale.x < 1.0f || this->renderScale.y < 1.0f;
+	}
 
-		const wchar_t *fileName = GET_ASSET_PATH("shaders/sprite_shader.hlsl");
-		HRESULT result = D3DCompileFromFile(
-			fileName, 
-			nullptr, 
-			nullptr, 
-			"vertex", 
-			"vs_4_0", 
-			NULL, 
-			NULL, 
-			&blob, 
-			&errorBlob
-		); 
-		DETAILED_ASSERT_HRESULT(result, L"%hs\n", errorBlob->GetBufferPointer())
+	void compileShaders() {
+		for (size_t i = 0; i < (size_t)ShaderId::_length; i++) {
+			ShaderBlobs blobs;
+			const bool compiled = compileShaderBlobs(shaderPaths[i], &blobs);
+			assert(compiled);
+
+			this->swapShader((ShaderId)i, &blobs);
+		}
+
+		this->createSpriteVertexBuffer();
+		this->createStarfieldVertexBuffer();
+	}
 
-		result = this->resources->device->CreateVertexShader(
-			blob->GetBufferPointer(), 
-			blob->GetBufferSize(), 
+	// Replaces a shader with newly compiled blobs and releases them. Only call
+	// between frames so nothing is drawn while it's halfway swapped.
+	void swapShader(ShaderId id, ShaderBlobs *blobs) {
+		switch (id) {
+			case ShaderId::sprite: {
+				this->createSpriteShaders(blobs);
+			} break;
+
+			case ShaderId::starfield: {
+				this->createStarfieldShaders(blobs);
+			} break;
+
+			case ShaderId::upscale: {
+				this->createUpscaleShaders(blobs);
+			} break;
+
+			default: {
+				assert(false);
+			} break;
+		}
+
+		releaseShaderBlobs(blobs);
+	}
+
+protected:
+	void createSpriteShaders(const ShaderBlobs *blobs) {
+		RELEASE_COM_OBJ(this->spriteShader.vertexShader)
+		RELEASE_COM_OBJ(this->spriteShader.vertexBufferLayout)
+		RELEASE_COM_OBJ(this->spriteShader.pixelShader)
+
+		HRESULT result = this->resources->device->CreateVertexShader(
+			blobs->vertex->GetBufferPointer(), 
+			blobs->vertex->GetBufferSize(), 
 			NULL, 
 			&this->spriteShader.vertexShader
 		);
@@ -423,60 +688,70 @@ protected:
 		result = this->resources->device->CreateInputLayout(
 			inputElementDescriptions,
 			2,
-			blob->GetBufferPointer(),
-			blob->GetBufferSize(),
+			blobs->vertex->GetBufferPointer(),
+			blobs->vertex->GetBufferSize(),
 			&this->spriteShader.vertexBufferLayout
 		);
 		ASSERT_HRESULT(result)
 
-		result = D3DCompileFromFile(
-			fileName, 
-			nullptr, 
-			nullptr, 
-			"pixel", 
-			"ps_4_0", 
-			NULL, 
-			NULL, 
-			&blob,
-			&errorBlob
-		);
-		DETAILED_ASSERT_HRESULT(result, L"%hs\n", errorBlob->GetBufferPointer())
-
 		result = this->resources->device->CreatePixelShader(
-			blob->GetBufferPointer(),
-			blob->GetBufferSize(),
+			blobs->pixel->GetBufferPointer(),
+			blobs->pixel->GetBufferSize(),
 			NULL,
 			&this->spriteShader.pixelShader
 		);
 		ASSERT_HRESULT(result)
 	}
 
-	void compileStarfieldShaders() {
-		ID3D10Blob *blob;
-		ID3DBlob *errorBlob;
+	void createStarfieldShaders(const ShaderBlobs *blobs) {
+		RELEASE_COM_OBJ(this->starfieldShader.vertexShader)
+		RELEASE_COM_OBJ(this->starfieldShader.vertexBufferLayout)
+		RELEASE_COM_OBJ(this->starfieldShader.pixelShader)
 
-		const wchar_t *fileName = GET_ASSET_PATH("shaders/starfield_shader.hlsl");
-		HRESULT result = D3DCompileFromFile(
-			fileName, 
-			nullptr, 
-			nullptr, 
-			"vertex", 
-			"vs_4_0", 
+		HRESULT result = this->resources->device->CreateVertexShader(
+			blobs->vertex->GetBufferPointer(), 
+			blobs->vertex->GetBufferSize(), 
 			NULL, 
+			&this->starfieldShader.vertexShader
+		);
+		ASSERT_HRESULT(result)
+
+		D3D11_INPUT_ELEMENT_DESC inputElementDescriptions[] = {
+			{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		};
+
+		result = this->resources->device->CreateInputLayout(
+			inputElementDescriptions,
+			1,
+			blobs->vertex->GetBufferPointer(),
+			blobs->vertex->GetBufferSize(),
+			&this->starfieldShader.vertexBufferLayout
+		);
+		ASSERT_HRESULT(result)
+
+		result = this->resources->device->CreatePixelShader(
+			blobs->pixel->GetBufferPointer(), 
+			blobs->pixel->GetBufferSize(), 
 			NULL, 
-			&blob, 
-			&errorBlob
-		); 
-		DETAILED_ASSERT_HRESULT(result, L"%hs\n", errorBlob->GetBufferPointer())
+			&this->starfieldShader.pixelShader
+		);
+		ASSERT_HRESULT(result)
+	}
+
+	void createUpscaleShaders(const ShaderBlobs *blobs) {
+		RELEASE_COM_OBJ(this->upscaleShader.vertexShader)
+		RELEASE_COM_OBJ(this->upscaleShader.vertexBufferLayout)
+		RELEASE_COM_OBJ(this->upscaleShader.pixelShader)
 
-		result = this->resources->device->CreateVertexShader(
-			blob->GetBufferPointer(), 
-			blob->GetBufferSize(), 
+		HRESULT result = this->resources->device->CreateVertexShader(
+			blobs->vertex->GetBufferPointer(), 
+			blobs->vertex->GetBufferSize(), 
 			NULL, 
-			&this->starfieldShader.vertexShader
+			&this->upscaleShader.vertexShader
 		);
 		ASSERT_HRESULT(result)
 
+		// Shares the starfield's full screen quad
 		D3D11_INPUT_ELEMENT_DESC inputElementDescriptions[] = {
 			{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
 		};
@@ -484,12 +759,46 @@ protected:
 		result = this->resources->device->CreateInputLayout(
 			inputElementDescriptions,
 			1,
-			blob->GetBufferPointer(),
-			blob->GetBufferSize(),
-			&this->starfieldShader.vertexBufferLayout
+			blobs->vertex->GetBufferPointer(),
+			blobs->vertex->GetBufferSize(),
+			&this->upscaleShader.vertexBufferLayout
 		);
 		ASSERT_HRESULT(result)
 
+		result = this->resources->device->CreatePixelShader(
+			blobs->pixel->GetBufferPointer(), 
+			blobs->pixel->GetBufferSize(), 
+			NULL, 
+			&this->upscaleShader.pixelShader
+		);
+		ASSERT_HRESULT(result)
+	}
+
+	void createSpriteVertexBuffer() {
+		const SpriteVertex vertices[] = {
+			{ Vec3<f32>(-0.5f, -0.5f, 0.0f), Vec2<f32>(0.0f, 1.0f) },
+			{ Vec3<f32>(-0.5f, 0.5f, 0.0f), Vec2<f32>(0.0f, 0.0f) },
+			{ Vec3<f32>(0.5f, -0.5f, 0.0f), Vec2<f32>(1.0f, 1.0f) },
+			{ Vec3<f32>(0.5f, 0.5f, 0.0f), Vec2<f32>(1.0f, 0.0f) },
+		};
+
+		D3D11_BUFFER_DESC bufferDescription = {};
+		bufferDescription.Usage = D3D11_USAGE_DEFAULT;
+		bufferDescription.ByteWidth = sizeof(vertices);
+		bufferDescription.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+
+		D3D11_SUBRESOURCE_DATA subresourceData = {};
+		subresourceData.pSysMem = vertices;
+
+		HRESULT result = this->resources->device->CreateBuffer(
+			&bufferDescription, 
+			&subresourceData, 
+			&this->spriteShader.vertexBuffer
+		);
+		ASSERT_HRESULT(result)
+	}
+
+	void createStarfieldVertexBuffer() {
 		const Vec3<f32> vertices[] = { 
 			{ -1.0f, -1.0f },
 			{ -1.0f, 1.0f }, 
@@ -504,38 +813,12 @@ protected:
 		D3D11_SUBRESOURCE_DATA subresourceData = {};
 		subresourceData.pSysMem = vertices;
 
-		result = this->resources->device->CreateBuffer(
+		HRESULT result = this->resources->device->CreateBuffer(
 			&bufferDescription, 
 			&subresourceData, 
 			&this->starfieldShader.vertexBuffer
 		);
 		ASSERT_HRESULT(result)
-
-		result = D3DCompileFromFile(
-			fileName, 
-			nullptr, 
-			nullptr, 
-			"pixel", 
-			"ps_4_0", 
-			NULL, 
-			NULL, 
-			&blob, 
-			&errorBlob
-		);
-		DETAILED_ASSERT_HRESULT(result, L"%hs\n", errorBlob->GetBufferPointer())
-
-		result = this->resources->device->CreatePixelShader(
-			blob->GetBufferPointer(), 
-			blob->GetBufferSize(), 
-			NULL, 
-			&this->starfieldShader.pixelShader
-		);
-		ASSERT_HRESULT(result)
-	}
-
-	void compileShaders() {
-		this->compileSpriteShaders();
-		this->compileStarfieldShaders();
 	}
 
 	void createBlendState() {
@@ -555,28 +838,12 @@ protected:
 
 	void createConstantBuffers() {
 		{
-			ConstantBuffer buffer = {};
+			// Starts off looking at the middle of the screen like a new camera
+			this->viewProjection = Camera().getViewProjection();
 
-			const f32 left = -((f32)screenWidth / 2);
-			const f32 right = (f32)screenWidth / 2;
-			const f32 top = (f32)screenHeight / 2;
-			const f32 bottom = -((f32)screenHeight / 2);
-			const f32 front = -1.0f;
-			const f32 back = 1.0f;
-
-			const f32 x0 = 2.0f / (right - left);
-			const f32 y1 = 2.0f / (top - bottom);
-			const f32 z2 = 2.0f / (back - front);
-			const f32 x3 = -(right + left) / (right - left);
-			const f32 y3 = -(top + bottom) / (top - bottom);
-			const f32 z3 = -(back + front) / (back - front);
-
-			buffer.projection = Mat4x4<f32>(
-				x0, 0.0f, 0.0f, x3,
-				0.0f, y1, 0.0f, y3,
-				0.0f, 0.0f, z2, z3,
-				0.0f, 0.0f, 0.0f, 1.0f
-			);
+			ConstantBuffer buffer = {};
+			buffer.projection = this->viewProjection.toMat4x4();
+			buffer.renderScale = this->renderScale;
 
 			D3D11_BUFFER_DESC bufferDescription = {};
 			bufferDescription.Usage = D3D11_USAGE_DYNAMIC;
@@ -662,6 +929,47 @@ protected:
 		RELEASE_COM_OBJ(depthStencil)
 	}
 
+	// Full size so changing the scale never has to recreate them, the scene
+	// is multisampled like the back buffer so it can share the depth buffer
+	void createSceneTargets() {
+		D3D11_TEXTURE2D_DESC textureDescription = {};
+		textureDescription.Width = screenWidth;
+		textureDescription.Height = screenHeight;
+		textureDescription.MipLevels = 1;
+		textureDescription.ArraySize = 1;
+		textureDescription.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+		textureDescription.SampleDesc.Count = 4;
+		textureDescription.SampleDesc.Quality = 0;
+		textureDescription.Usage = D3D11_USAGE_DEFAULT;
+		textureDescription.BindFlags = D3D11_BIND_RENDER_TARGET;
+
+		HRESULT result = this->resources->device->CreateTexture2D(&textureDescription, NULL, &this->scene.texture);
+		ASSERT_HRESULT(result)
+
+		result = this->resources->device->CreateRenderTargetView(this->scene.texture, NULL, &this->scene.renderView);
+		ASSERT_HRESULT(result)
+
+		textureDescription.SampleDesc.Count = 1;
+		textureDescription.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+		result = this->resources->device->CreateTexture2D(&textureDescription, NULL, &this->scene.resolved);
+		ASSERT_HRESULT(result)
+
+		result = this->resources->device->CreateShaderResourceView(this->scene.resolved, NULL, &this->scene.resolvedView);
+		ASSERT_HRESULT(result)
+	}
+
+	void setViewport(u32 width, u32 height) {
+		D3D11_VIEWPORT viewport = {};
+		viewport.TopLeftX = 0;
+		viewport.TopLeftY = 0;
+		viewport.Width = (f32)width;
+		viewport.Height = (f32)height;
+		viewport.MinDepth = 0.0f;
+		viewport.MaxDepth = 1.0f;
+		this->deviceContext->RSSetViewports(1, &viewport);
+	}
+
 	void createDeviceAndSwapChain(HWND windowHandle) {
 		DXGI_SWAP_CHAIN_DESC swapChainDescription = {};
 		swapChainDescription.BufferCount = 1;
@@ -721,13 +1029,6 @@ protected:
 
 		RELEASE_COM_OBJ(backBuffer)
 
-		D3D11_VIEWPORT viewport = {};
-		viewport.TopLeftX = 0;
-		viewport.TopLeftY = 0;
-		viewport.Width = screenWidth;
-		viewport.Height = screenHeight;
-		viewport.MinDepth = 0.0f;
-		viewport.MaxDepth = 1.0f;
-		this->deviceContext->RSSetViewports(1, &viewport);
+		this->setViewport(screenWidth, screenHeight);
 	}
 };
\ No newline at end of file
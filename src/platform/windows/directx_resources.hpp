@@ -3,12 +3,19 @@
 #include <d3d11.h>
 
 #include "common/asset_definitions.hpp"
+#include "types/vector.hpp"
 
 struct Dx3dSpriteResource {
 	bool loaded = false;
+	UINT width;
+	UINT height;
+	// What it costs in video memory, its share of the page for atlas textures
+	UINT bytes;
+	// Textures packed into an atlas share its page, each holds a reference
 	ID3D11Texture2D *texture2d;
 	ID3D11ShaderResourceView *texture2dView;
-	ID3D11Buffer *vertexBuffer;
+	// Offset and size of the image on the texture in texture coordinates
+	Vec4 uvRect;
 };
 
 struct DirectXResources {
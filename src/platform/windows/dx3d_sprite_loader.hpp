@@ -4,21 +4,55 @@
 #include <combaseapi.h>
 #include <wincodec.h>
 #include <d3d11.h>
-#include <malloc.h>
 
 #include "common/asset_definitions.hpp"
+#include "common/asset_residency.hpp"
+#include "common/compressed_texture.hpp"
+#include "common/culling.hpp"
 #include "common/game_state.hpp"
+#include "common/scene_manifest.hpp"
+#include "common/sprite_atlas.hpp"
 #include "platform/windows/directx_resources.hpp"
+#include "platform/windows/file_loader.hpp"
 #include "platform/windows/utils.hpp"
-#include "platform/windows/sprite_vertex.hpp"
+#include "utils/memory.hpp"
+#include "utils/thread.hpp"
+
+#define SPRITE_TEXTURE_BUDGET (128 * MEGABYTE)
 
 class Dx3dSpriteLoader {
 protected:
 	IWICImagingFactory *imagingFactory;
 	DirectXResources *resources;
+	SpriteAtlasManifest atlas = {};
+	// Textures on an atlas page come and go together, each with its share
+	// of the page's size
+	AssetResidency<TextureAssetId> residency;
+	u64 frame = 0;
+
+	// Loads the upcoming scenes' textures one at a time, the render thread
+	// installs them once they're done. Guarded by `prefetchMutex`.
+	Thread prefetchThread;
+	Mutex prefetchMutex;
+	ConditionVariable prefetchCondition;
+	TextureAssetId prefetching = TextureAssetId::_length;
+	bool prefetchDone = false;
+	bool prefetchStopping = false;
+	Dx3dSpriteResource prefetched = {};
 
 public:
 	~Dx3dSpriteLoader() {
+		{
+			ScopedLock lock(&this->prefetchMutex);
+			this->prefetchStopping = true;
+			this->prefetchCondition.notifyAll();
+		}
+		this->prefetchThread.join();
+
+		// Finished but never installed
+		RELEASE_COM_OBJ(this->prefetched.texture2d)
+		RELEASE_COM_OBJ(this->prefetched.texture2dView)
+
 		this->unload();
 		RELEASE_COM_OBJ(this->imagingFactory)
 	}
@@ -34,74 +68,105 @@ public:
 			(void**)&this->imagingFactory
 		);
 		ASSERT_HRESULT(result)
-	}
 
-	// TODO(steven): Load in a seperate thread
-  void load(TextureLoadQueue *loadQueue) {
-		if (loadQueue->length == 0) {
-			return;
+		// Without an atlas (or with one from an older build) every texture is
+		// loaded on its own
+		u8 manifest[SPRITE_ATLAS_MANIFEST_MAX];
+		size_t manifestSize = 0;
+		if (
+			!tryLoad(SPRITE_ATLAS_MANIFEST_PATH, manifest, sizeof(manifest), &manifestSize) ||
+			!SpriteAtlas::readManifest(manifest, manifestSize, &this->atlas)
+		) {
+			this->atlas = {};
 		}
 
-		// NOTE(steven): Increase size of buffer if needed
-		BYTE *buffer = (BYTE*)malloc(100000000);
+		this->residency.budget = SPRITE_TEXTURE_BUDGET;
+		if (!this->prefetchThread.start(prefetchMain, this)) {
+			LOG(L"Couldn't start the prefetch thread, prefetching on the render thread instead\n")
+		}
+	}
+
+	// Loads whatever the game needs right now, waiting on the prefetch thread
+	// when it's already loading it
+	void load(TextureLoadQueue *loadQueue, u64 frame) {
+		this->frame = frame;
 
 		for (TextureAssetId assetId : *loadQueue) {
-			Dx3dSpriteResource &spriteResource = resources->spriteResources[(size_t)assetId];
-			if (spriteResource.loaded) {
+			if (this->isPrefetching(assetId)) {
+				this->collectPrefetch(true);
+			}
+			if (this->resources->spriteResources[(size_t)assetId].loaded) {
+				this->touch(assetId);
 				continue;
 			}
 
-			LPCWSTR fileName = textureNames[(size_t)assetId];
+			this->loadNow(assetId);
+		}
 
-			IWICBitmapDecoder *bitmapDecoder;
-			HRESULT result = imagingFactory->CreateDecoderFromFilename(
-				fileName, 
-				NULL, 
-				GENERIC_READ, 
-				WICDecodeMetadataCacheOnLoad, 
-				&bitmapDecoder
-			);
-			ASSERT_HRESULT(result)
+		loadQueue->clear();
+	}
 
-			IWICBitmapFrameDecode *frameDecode;
-			result = bitmapDecoder->GetFrame(0, &frameDecode);
-			ASSERT_HRESULT(result)
+	// Keeps what's on screen, frees what's gone over budget and starts loading
+	// the next texture the upcoming scenes will want. Call after `load`.
+	void prefetch(const TexturePrefetchList &prefetches, const Sprite *sprites, size_t spriteCount, u64 frame) {
+		this->frame = frame;
 
-			WICPixelFormatGUID wicPixelFormat;
-			result = frameDecode->GetPixelFormat(&wicPixelFormat);
-			ASSERT_HRESULT(result)
+		this->collectPrefetch(false);
 
-			DXGI_FORMAT dxgiFormat;
-			const bool formatConverted = this->getDxgiFormat(&wicPixelFormat, &dxgiFormat);
-			const UINT bitsPerPixel = this->getBitsPerPixel(wicPixelFormat);
+		// Anything drawn has to be there, even if that means a stall
+		for (size_t i = 0; i < spriteCount; i++) {
+			const TextureAssetId assetId = sprites[i].assetId;
+			if (this->isPrefetching(assetId)) {
+				this->collectPrefetch(true);
+			}
+			if (!this->resources->spriteResources[(size_t)assetId].loaded) {
+				this->loadNow(assetId);
+			}
+			this->touch(assetId);
+		}
 
-			UINT width = 0, height = 0;
-			frameDecode->GetSize(&width, &height);
+		TextureAssetId wanted[(size_t)TextureAssetId::_length];
+		u32 requiredCount = 0;
+		const u32 wantedCount = this->wantedTextures(prefetches, wanted, &requiredCount);
 
-			spriteResource.vertexBuffer = this->createVertexBuffer(width, height);
+		TextureAssetId evictions[(size_t)TextureAssetId::_length];
+		u32 evictionCount = this->residency.trim(wanted, wantedCount, requiredCount, frame, evictions);
+		this->evict(evictions, evictionCount);
 
-			const UINT stride = bitsPerPixel / 8; 
-			const UINT rowStride = stride * width;
-			const UINT bufferSize = width * height * stride;
-			this->createTextureBuffer(
-				frameDecode, 
-				buffer, 
-				bufferSize, 
-				rowStride, 
-				wicPixelFormat, 
-				formatConverted
-			);
+		if (this->prefetching != TextureAssetId::_length) {
+			return;
+		}
 
-			spriteResource.texture2d = this->createTexture2d(buffer, dxgiFormat, width, height, rowStride);
-			spriteResource.texture2dView = this->createTexture2dView(spriteResource.texture2d, dxgiFormat);
-			spriteResource.loaded = true;
+		TextureAssetId next;
+		if (!this->residency.nextLoad(wanted, wantedCount, frame, &next, evictions, &evictionCount)) {
+			return;
+		}
+		this->evict(evictions, evictionCount);
 
-			RELEASE_COM_OBJ(bitmapDecoder)
-			RELEASE_COM_OBJ(frameDecode)
+		// Without the thread nothing would ever finish it, so it's loaded here
+		// and costs this frame the time instead
+		if (!this->prefetchThread.running) {
+			this->loadNow(next);
+			return;
 		}
 
-		loadQueue->clear();
-		free(buffer);
+		ScopedLock lock(&this->prefetchMutex);
+		this->prefetching = next;
+		this->prefetchDone = false;
+		this->prefetchCondition.notifyAll();
+	}
+
+	const AssetResidencyStats &getResidencyStats() const {
+		return this->residency.stats;
+	}
+
+	// Zero for anything that hasn't been loaded
+	void getTextureSizes(TextureSizes *sizes) const {
+		for (size_t i = 0; i < (size_t)TextureAssetId::_length; i++) {
+			const Dx3dSpriteResource &spriteResource = this->resources->spriteResources[i];
+			sizes->sizes[i].width = spriteResource.loaded ? (u16)spriteResource.width : 0;
+			sizes->sizes[i].height = spriteResource.loaded ? (u16)spriteResource.height : 0;
+		}
 	}
 
 protected:
@@ -172,33 +237,377 @@ protected:
 		return DXGI_FORMAT_UNKNOWN;
 	}
 
-	ID3D11Buffer *createVertexBuffer(UINT width, UINT height) const {
-		f32 halfWidth = (f32)width * 0.5;
-		f32 halfHeight = (f32)height * 0.5;
-		SpriteVertex vertices[] = {
-			{ Vec3<f32>(-halfWidth, -halfHeight, 0.0f), Vec2<f32>(0.0f, 1.0f) },
-			{ Vec3<f32>(-halfWidth, halfHeight, 0.0f), Vec2<f32>(0.0f, 0.0f) },
-			{ Vec3<f32>(halfWidth, -halfHeight, 0.0f), Vec2<f32>(1.0f, 1.0f) },
-			{ Vec3<f32>(halfWidth, halfHeight, 0.0f), Vec2<f32>(1.0f, 0.0f) },
+	// Decodes an image file into a texture, `buffer` is grown to fit it
+	void loadTexture(LPCWSTR fileName, BYTE **buffer, UINT *bufferCapacity, Dx3dSpriteResource *spriteResource) {
+		if (this->loadCompressedTexture(fileName, buffer, bufferCapacity, spriteResource)) {
+			return;
+		}
+
+		IWICBitmapDecoder *bitmapDecoder;
+		HRESULT result = imagingFactory->CreateDecoderFromFilename(
+			fileName, 
+			NULL, 
+			GENERIC_READ, 
+			WICDecodeMetadataCacheOnLoad, 
+			&bitmapDecoder
+		);
+		ASSERT_HRESULT(result)
+
+		IWICBitmapFrameDecode *frameDecode;
+		result = bitmapDecoder->GetFrame(0, &frameDecode);
+		ASSERT_HRESULT(result)
+
+		WICPixelFormatGUID wicPixelFormat;
+		result = frameDecode->GetPixelFormat(&wicPixelFormat);
+		ASSERT_HRESULT(result)
+
+		DXGI_FORMAT dxgiFormat;
+		const bool formatConverted = this->getDxgiFormat(&wicPixelFormat, &dxgiFormat);
+		const UINT bitsPerPixel = this->getBitsPerPixel(wicPixelFormat);
+
+		UINT width = 0, height = 0;
+		frameDecode->GetSize(&width, &height);
+
+		spriteResource->width = width;
+		spriteResource->height = height;
+
+		const UINT stride = bitsPerPixel / 8; 
+		const UINT rowStride = stride * width;
+		const UINT bufferSize = width * height * stride;
+		if (bufferSize > *bufferCapacity) {
+			Memory::release(*buffer);
+			*buffer = Memory::allocateArray<BYTE>(MemoryTag::textures, bufferSize);
+			*bufferCapacity = bufferSize;
+		}
+
+		this->createTextureBuffer(
+			frameDecode, 
+			*buffer, 
+			bufferSize, 
+			rowStride, 
+			wicPixelFormat, 
+			formatConverted
+		);
+
+		spriteResource->texture2d = this->createTexture2d(*buffer, dxgiFormat, width, height, rowStride);
+		spriteResource->texture2dView = this->createTexture2dView(spriteResource->texture2d, dxgiFormat, 1);
+		spriteResource->uvRect = Vec4(0.0f, 0.0f, 1.0f, 1.0f);
+		spriteResource->bytes = bufferSize;
+
+		RELEASE_COM_OBJ(bitmapDecoder)
+		RELEASE_COM_OBJ(frameDecode)
+	}
+
+	// Uploads the .btex next to the image when there's one, already block
+	// compressed with its mips so there's nothing to decode. Anything missing
+	// or out of date falls back to the image.
+	bool loadCompressedTexture(LPCWSTR fileName, BYTE **buffer, UINT *bufferCapacity, Dx3dSpriteResource *spriteResource) {
+		wchar_t path[MAX_PATH];
+		wchar_t *extension = nullptr;
+		if (wcscpy_s(path, MAX_PATH, fileName) != 0 || (extension = wcsrchr(path, L'.')) == nullptr) {
+			return false;
+		}
+		*extension = L'\0';
+		if (wcscat_s(path, MAX_PATH, L"" COMPRESSED_TEXTURE_EXTENSION) != 0) {
+			return false;
+		}
+
+		// Older than the image means the image has been edited since
+		WIN32_FILE_ATTRIBUTE_DATA attributes;
+		WIN32_FILE_ATTRIBUTE_DATA imageAttributes;
+		if (
+			!GetFileAttributesEx(path, GetFileExInfoStandard, &attributes) ||
+			attributes.nFileSizeHigh != 0 ||
+			(
+				GetFileAttributesEx(fileName, GetFileExInfoStandard, &imageAttributes) &&
+				CompareFileTime(&attributes.ftLastWriteTime, &imageAttributes.ftLastWriteTime) < 0
+			)
+		) {
+			return false;
+		}
+
+		const UINT fileSize = attributes.nFileSizeLow;
+		if (fileSize > *bufferCapacity) {
+			Memory::release(*buffer);
+			*buffer = Memory::allocateArray<BYTE>(MemoryTag::textures, fileSize);
+			*bufferCapacity = fileSize;
+		}
+
+		CompressedTextureHeader header;
+		if (!tryLoad(path, *buffer, fileSize) || !CompressedTexture::readHeader(*buffer, fileSize, &header)) {
+			return false;
+		}
+
+		const DXGI_FORMAT dxgiFormats[] = {
+			DXGI_FORMAT_BC1_UNORM,
+			DXGI_FORMAT_BC3_UNORM,
+			DXGI_FORMAT_BC7_UNORM
 		};
+		const BlockFormat format = (BlockFormat)header.format;
+		const DXGI_FORMAT dxgiFormat = dxgiFormats[header.format];
+
+		D3D11_SUBRESOURCE_DATA subresourceData[COMPRESSED_TEXTURE_MIP_MAX] = {};
+		const BYTE *blocks = *buffer + sizeof(header);
+		for (u32 level = 0; level < header.mipCount; level++) {
+			const u32 width = CompressedTexture::mipSize(header.width, level);
+			const u32 height = CompressedTexture::mipSize(header.height, level);
+			subresourceData[level].pSysMem = blocks;
+			subresourceData[level].SysMemPitch = (width + 3) / 4 * BlockCompression::blockBytes(format);
+			blocks += BlockCompression::levelSize(format, width, height);
+		}
 
-		D3D11_BUFFER_DESC bufferDescription = {};
-		bufferDescription.Usage = D3D11_USAGE_DEFAULT;
-		bufferDescription.ByteWidth = sizeof(vertices);
-		bufferDescription.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+		D3D11_TEXTURE2D_DESC textureDescription = {};
+		textureDescription.Width = header.width;
+		textureDescription.Height = header.height;
+		textureDescription.MipLevels = header.mipCount;
+		textureDescription.ArraySize = 1;
+		textureDescription.Format = dxgiFormat;
+		textureDescription.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+		textureDescription.SampleDesc.Count = 1;
+		textureDescription.SampleDesc.Quality = 0;
+		textureDescription.Usage = D3D11_USAGE_IMMUTABLE;
 
-		D3D11_SUBRESOURCE_DATA subresourceData = {};
-		subresourceData.pSysMem = vertices;
+		HRESULT result = this->resources->device->CreateTexture2D(
+			&textureDescription, 
+			subresourceData, 
+			&spriteResource->texture2d
+		);
+		ASSERT_HRESULT(result)
 
-		ID3D11Buffer *vertexBuffer;
-		HRESULT result = this->resources->device->CreateBuffer(
-			&bufferDescription, 
-			&subresourceData, 
-			&vertexBuffer
+		spriteResource->texture2dView = this->createTexture2dView(spriteResource->texture2d, dxgiFormat, header.mipCount);
+		spriteResource->bytes = header.dataSize;
+		spriteResource->width = header.imageWidth;
+		spriteResource->height = header.imageHeight;
+		// Leaves out the edge stretched to fill the last blocks
+		spriteResource->uvRect = Vec4(
+			0.0f,
+			0.0f,
+			(f32)header.imageWidth / header.width,
+			(f32)header.imageHeight / header.height
 		);
+
+		return true;
+	}
+
+	static void prefetchMain(void *argument) {
+		Dx3dSpriteLoader *loader = (Dx3dSpriteLoader*)argument;
+
+		// NOTE: The WIC factory is free threaded and the device was created
+		// without D3D11_CREATE_DEVICE_SINGLETHREADED, so both can be used from
+		// here while the render thread draws.
+		HRESULT result = CoInitializeEx(NULL, COINIT_MULTITHREADED);
 		ASSERT_HRESULT(result)
 
-		return vertexBuffer;
+		BYTE *buffer = nullptr;
+		UINT bufferCapacity = 0;
+
+		loader->prefetchMutex.lock();
+		while (true) {
+			while (
+				!loader->prefetchStopping && 
+				(loader->prefetching == TextureAssetId::_length || loader->prefetchDone)
+			) {
+				loader->prefetchCondition.wait(&loader->prefetchMutex);
+			}
+			if (loader->prefetchStopping) {
+				break;
+			}
+
+			const TextureAssetId assetId = loader->prefetching;
+			loader->prefetchMutex.unlock();
+
+			Dx3dSpriteResource resource = {};
+			loader->loadResource(assetId, &buffer, &bufferCapacity, &resource);
+
+			loader->prefetchMutex.lock();
+			loader->prefetched = resource;
+			loader->prefetchDone = true;
+			loader->prefetchCondition.notifyAll();
+		}
+		loader->prefetchMutex.unlock();
+
+		Memory::release(buffer);
+		CoUninitialize();
+	}
+
+	// Also true when it's on the page being loaded
+	bool isPrefetching(TextureAssetId assetId) const {
+		if (this->prefetching == TextureAssetId::_length) {
+			return false;
+		}
+
+		const u8 page = this->atlas.entries[(size_t)assetId].page;
+		return this->prefetching == assetId || (
+			page != SPRITE_ATLAS_NO_PAGE && 
+			page == this->atlas.entries[(size_t)this->prefetching].page
+		);
+	}
+
+	// Installs the prefetched texture if it's done, `wait` blocks until it is
+	void collectPrefetch(bool wait) {
+		TextureAssetId assetId;
+		Dx3dSpriteResource resource;
+		{
+			ScopedLock lock(&this->prefetchMutex);
+			if (this->prefetching == TextureAssetId::_length) {
+				return;
+			}
+			while (wait && !this->prefetchDone) {
+				this->prefetchCondition.wait(&this->prefetchMutex);
+			}
+			if (!this->prefetchDone) {
+				return;
+			}
+
+			assetId = this->prefetching;
+			resource = this->prefetched;
+			this->prefetched = {};
+			this->prefetching = TextureAssetId::_length;
+			this->prefetchDone = false;
+		}
+
+		this->install(assetId, &resource);
+	}
+
+	void loadNow(TextureAssetId assetId) {
+		BYTE *buffer = nullptr;
+		UINT bufferCapacity = 0;
+
+		Dx3dSpriteResource resource = {};
+		this->loadResource(assetId, &buffer, &bufferCapacity, &resource);
+		this->install(assetId, &resource);
+
+		Memory::release(buffer);
+	}
+
+	// The texture on its own or the atlas page it's on
+	void loadResource(TextureAssetId assetId, BYTE **buffer, UINT *bufferCapacity, Dx3dSpriteResource *resource) {
+		const SpriteAtlasEntry &atlasEntry = this->atlas.entries[(size_t)assetId];
+		if (atlasEntry.page == SPRITE_ATLAS_NO_PAGE) {
+			this->loadTexture(textureNames[(size_t)assetId], buffer, bufferCapacity, resource);
+			return;
+		}
+
+		wchar_t fileName[MAX_PATH];
+		swprintf_s(fileName, MAX_PATH, SPRITE_ATLAS_PAGE_PATH, (u32)atlasEntry.page);
+		this->loadTexture(fileName, buffer, bufferCapacity, resource);
+	}
+
+	// Hands a loaded texture or page to the sprites that use it, taking over
+	// its references
+	void install(TextureAssetId assetId, Dx3dSpriteResource *resource) {
+		const u8 pageIndex = this->atlas.entries[(size_t)assetId].page;
+		if (pageIndex == SPRITE_ATLAS_NO_PAGE) {
+			Dx3dSpriteResource &spriteResource = this->resources->spriteResources[(size_t)assetId];
+			assert(!spriteResource.loaded);
+			spriteResource = *resource;
+			spriteResource.loaded = true;
+			this->residency.loaded(assetId, resource->bytes, this->frame);
+			return;
+		}
+
+		u64 pageArea = 0;
+		for (const SpriteAtlasEntry &entry : this->atlas.entries) {
+			if (entry.page == pageIndex) {
+				pageArea += (u64)entry.rect.width * entry.rect.height;
+			}
+		}
+
+		for (size_t i = 0; i < (size_t)TextureAssetId::_length; i++) {
+			const SpriteAtlasEntry &entry = this->atlas.entries[i];
+			Dx3dSpriteResource &spriteResource = this->resources->spriteResources[i];
+			if (entry.page != pageIndex || spriteResource.loaded) {
+				continue;
+			}
+
+			resource->texture2d->AddRef();
+			resource->texture2dView->AddRef();
+			spriteResource.texture2d = resource->texture2d;
+			spriteResource.texture2dView = resource->texture2dView;
+			spriteResource.width = entry.rect.width;
+			spriteResource.height = entry.rect.height;
+			spriteResource.bytes = pageArea == 0 ? 0 : (UINT)(resource->bytes * ((u64)entry.rect.width * entry.rect.height) / pageArea);
+			// Scaled by the page's own in case it was compressed with padding
+			const Vec4 uvRect = SpriteAtlas::uvRect(this->atlas, (TextureAssetId)i);
+			spriteResource.uvRect = Vec4(
+				uvRect.x * resource->uvRect.z,
+				uvRect.y * resource->uvRect.w,
+				uvRect.z * resource->uvRect.z,
+				uvRect.w * resource->uvRect.w
+			);
+			spriteResource.loaded = true;
+			this->residency.loaded((TextureAssetId)i, spriteResource.bytes, this->frame);
+		}
+
+		// Only the textures on the page keep it alive
+		RELEASE_COM_OBJ(resource->texture2d)
+		RELEASE_COM_OBJ(resource->texture2dView)
+	}
+
+	void touch(TextureAssetId assetId) {
+		const u8 pageIndex = this->atlas.entries[(size_t)assetId].page;
+		if (pageIndex == SPRITE_ATLAS_NO_PAGE) {
+			this->residency.touch(assetId, this->frame);
+			return;
+		}
+
+		for (size_t i = 0; i < (size_t)TextureAssetId::_length; i++) {
+			if (this->atlas.entries[i].page == pageIndex) {
+				this->residency.touch((TextureAssetId)i, this->frame);
+			}
+		}
+	}
+
+	// The prefetch list with every texture followed by the others on its page,
+	// so a page is only as wanted as the most wanted texture on it
+	u32 wantedTextures(const TexturePrefetchList &prefetches, TextureAssetId *wanted, u32 *requiredCount) const {
+		u32 count = 0;
+		for (u32 rank = 0; rank < prefetches.assets.length; rank++) {
+			if (rank == prefetches.requiredCount) {
+				*requiredCount = count;
+			}
+
+			const TextureAssetId assetId = prefetches.assets[rank];
+			const u8 pageIndex = this->atlas.entries[(size_t)assetId].page;
+			for (size_t i = 0; i < (size_t)TextureAssetId::_length; i++) {
+				const bool onPage = pageIndex != SPRITE_ATLAS_NO_PAGE && this->atlas.entries[i].page == pageIndex;
+				if (i != (size_t)assetId && !onPage) {
+					continue;
+				}
+
+				bool listed = false;
+				for (u32 w = 0; w < count && !listed; w++) {
+					listed = wanted[w] == (TextureAssetId)i;
+				}
+				if (!listed) {
+					wanted[count++] = (TextureAssetId)i;
+				}
+			}
+		}
+		if (prefetches.requiredCount >= prefetches.assets.length) {
+			*requiredCount = count;
+		}
+
+		return count;
+	}
+
+	// Frees textures, along with everything else on their page
+	void evict(const TextureAssetId *assetIds, u32 count) {
+		for (u32 e = 0; e < count; e++) {
+			const u8 pageIndex = this->atlas.entries[(size_t)assetIds[e]].page;
+			for (size_t i = 0; i < (size_t)TextureAssetId::_length; i++) {
+				const bool onPage = pageIndex != SPRITE_ATLAS_NO_PAGE && this->atlas.entries[i].page == pageIndex;
+				Dx3dSpriteResource &spriteResource = this->resources->spriteResources[i];
+				if ((i != (size_t)assetIds[e] && !onPage) || !spriteResource.loaded) {
+					continue;
+				}
+
+				RELEASE_COM_OBJ(spriteResource.texture2d)
+				RELEASE_COM_OBJ(spriteResource.texture2dView)
+				spriteResource = {};
+				this->residency.evicted((TextureAssetId)i);
+			}
+		}
 	}
 
 	ID3D11Texture2D *createTexture2d(
@@ -236,12 +645,13 @@ protected:
 
 	ID3D11ShaderResourceView *createTexture2dView(
 		ID3D11Texture2D *texture2d, 
-		DXGI_FORMAT dxgiFormat
+		DXGI_FORMAT dxgiFormat,
+		UINT mipLevels
 	) const {
 		D3D11_SHADER_RESOURCE_VIEW_DESC resourceViewDescription = {};
 		resourceViewDescription.Format = dxgiFormat;
 		resourceViewDescription.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-		resourceViewDescription.Texture2D.MipLevels = 1;
+		resourceViewDescription.Texture2D.MipLevels = mipLevels;
 
 		ID3D11ShaderResourceView *texture2dView;
 		HRESULT result = this->resources->device->CreateShaderResourceView(
@@ -330,7 +740,6 @@ protected:
 		for (Dx3dSpriteResource &resource : this->resources->spriteResources) {
 			RELEASE_COM_OBJ(resource.texture2d)
 			RELEASE_COM_OBJ(resource.texture2dView)
-			RELEASE_COM_OBJ(resource.vertexBuffer)
 			resource = {};
 		}
 	}
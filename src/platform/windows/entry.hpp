@@ -3,7 +3,12 @@
 #include <cstdio>
 #include <Windows.h>
 
+#include "common/camera.hpp"
+#include "common/culling.hpp"
+#include "common/frame_stats.hpp"
 #include "common/game_state.hpp"
+#include "common/render_queue.hpp"
+#include "common/render_scale.hpp"
 #include "common/window_config.hpp"
 #include "editor/editor.hpp"
 #include "frame_timing.hpp"
@@ -11,46 +16,42 @@
 #include "platform/windows/directx_renderer.hpp"
 #include "platform/windows/dx3d_sprite_loader.hpp"
 #include "platform/windows/file_saver.hpp"
+#include "platform/windows/hot_reload.hpp"
 #include "platform/windows/input_processor.hpp"
+#include "platform/windows/render_thread.hpp"
 #include "platform/windows/template_loader.hpp"
 #include "platform/windows/sound_manager.hpp"
 #include "platform/windows/utils.hpp"
 #include "types/core.hpp"
 #include "types/vector.hpp"
+#include "utils/memory.hpp"
+#include "utils/profiler.hpp"
 
 // TODO(steven): Move elsewhere
 static bool shouldClose = false;
 static bool editorOpen = false;
 static bool inFocus = true;
-static DirectXResources *directXResources = new DirectXResources{};
-static DirectXRenderer *renderer = new DirectXRenderer();
-static Dx3dSpriteLoader *loader = new Dx3dSpriteLoader();
-static SoundManager *soundManager = new SoundManager();
-static InputProcessor *inputProcessor = new InputProcessor();
+static HWND mainWindow = NULL;
+static DirectXResources *directXResources = Memory::create<DirectXResources>(MemoryTag::renderer);
+static DirectXRenderer *renderer = Memory::create<DirectXRenderer>(MemoryTag::renderer);
+static Dx3dSpriteLoader *loader = Memory::create<Dx3dSpriteLoader>(MemoryTag::textures);
+static SoundManager *soundManager = Memory::create<SoundManager>(MemoryTag::sound);
+static InputProcessor *inputProcessor = Memory::create<InputProcessor>(MemoryTag::input);
+static RenderQueue *renderQueue = Memory::create<RenderQueue>(MemoryTag::renderer);
+static RenderThread renderThread = {};
+// Handed back with each packet, so a couple of frames old
+static TextRunCacheStats textRunStats = {};
+static RenderScaleStats renderScaleStats = {};
+static FrameHitchZones renderZones = {};
+static AssetResidencyStats textureResidencyStats = {};
+static TextureSizes textureSizes = {};
+static CullStats cullStats = {};
+// The editor draws its sprites in game space without a camera of its own
+static const Camera editorCamera;
 static FrameTiming timings = {};
-
+static FrameStats frameStats = {};
 #ifdef DEBUG
-struct FrameProfile {
-	String16<64> name;
-	f32 time = 0;
-};
-
-static Array<FrameProfile, 32> profiles = {};
-
-#define PROFILE(_name, _call)                          \
-{                                                      \
-	LARGE_INTEGER start;                                 \
-	LARGE_INTEGER end;                                   \
-                                                       \
-	QueryPerformanceCounter(&start);                     \
-	_call;                                               \
-	QueryPerformanceCounter(&end);                       \
-	                                                     \
-	const f32 _diff = end.QuadPart - start.QuadPart;     \
-	profiles.push({ _name, _diff / timings.frequency }); \
-}
-#else
-#define PROFILE(_name, _call) _call;
+static HotReloader hotReloader;
 #endif
 
 LRESULT CALLBACK eventHandler(
@@ -80,8 +81,9 @@ LRESULT CALLBACK eventHandler(
 		} break;
 
 		case WM_CLOSE: {
+			// NOTE: The window is only destroyed once the render thread has
+			// stopped presenting to it.
 			shouldClose = true;
-			DestroyWindow(windowHandle);
 		} break;
 
 		case WM_DESTROY: {
@@ -113,6 +115,11 @@ LRESULT CALLBACK eventHandler(
 #endif
 		} break;
 
+		case WM_MOUSEWHEEL: {
+			GameState *gameState = (GameState *)GetWindowLongPtr(windowHandle, GWLP_USERDATA);
+			gameState->input.wheel += (f32)GET_WHEEL_DELTA_WPARAM(wParam) / WHEEL_DELTA;
+		} break;
+
 		default: {
 			result = DefWindowProc(windowHandle, message, wParam, lParam);
 		}
@@ -120,6 +127,41 @@ LRESULT CALLBACK eventHandler(
 	return result;
 }
 
+// Copies everything drawn this frame that ends up on screen into a packet for
+// the render thread and clears the game's buffers for the next frame
+void submitRenderPacket(GameState *gameState) {
+	RenderPacket *packet = renderQueue->beginWrite();
+	textRunStats = packet->textRunStats;
+	renderScaleStats = packet->renderScaleStats;
+	renderZones = packet->renderZones;
+	textureResidencyStats = packet->textureResidencyStats;
+	textureSizes = packet->textureSizes;
+
+	packet->textureLoads = gameState->textureLoadQueue;
+	SceneManifests::gatherTextures(gameState->scene, &packet->texturePrefetches);
+	packet->sprites.clear();
+	packet->uiElements.clear();
+
+	const Camera &camera = editorOpen ? editorCamera : gameState->camera;
+	packet->viewProjection = camera.getViewProjection();
+
+	cullStats = {};
+	PROFILE(
+		"Cull Sprites", 
+		Culling::cullSprites(gameState->sprites.data, gameState->sprites.length, textureSizes, camera.visibleBounds(), &packet->sprites, &cullStats)
+	)
+	PROFILE(
+		"Cull UI", 
+		Culling::cullUIElements(gameState->uiElements.data, gameState->uiElements.length, Culling::screenViewport(), &packet->uiElements, &cullStats)
+	)
+	renderQueue->submit();
+	renderThread.drawInline();
+
+	gameState->textureLoadQueue.clear();
+	gameState->sprites.clear();
+	gameState->uiElements.clear();
+}
+
 INT createWin32Window(HINSTANCE instanceHandle, INT showFlag, GameState *gameState) {
 	const LPCWSTR className = L"SBDS";
 
@@ -151,6 +193,7 @@ INT createWin32Window(HINSTANCE instanceHandle, INT showFlag, GameState *gameSta
 		return 0;
 	}
 
+	mainWindow = windowHandle;
 	ShowWindow(windowHandle, showFlag);
 
 	return 0;
@@ -165,16 +208,35 @@ INT WINAPI wWinMain(
 	HRESULT result = CoInitialize(NULL);
 	ASSERT_HRESULT(result)
 
+	Profiler::initialise();
+
+	Memory::setBudget(MemoryTag::game, 4 * MEGABYTE);
+	Memory::setBudget(MemoryTag::renderer, 1 * MEGABYTE);
+	Memory::setBudget(MemoryTag::textures, 64 * MEGABYTE);
+	Memory::setBudget(MemoryTag::sound, 64 * MEGABYTE);
+	Memory::setBudget(MemoryTag::input, 64 * KILOBYTE);
+	Memory::setBudget(MemoryTag::profiler, 16 * MEGABYTE);
+
 	LARGE_INTEGER frequency;
 	QueryPerformanceFrequency(&frequency);
 	timings.frequency = frequency.QuadPart;
 
-	GameState *gameState = new GameState {};
+	GameState *gameState = Memory::create<GameState>(MemoryTag::game);
 	createWin32Window(instanceHandle, showFlag, gameState);
 
 	Game::setup(gameState);
 
 	loadTemplates(gameState);
+#ifdef DEBUG
+	hotReloader.start(gameState);
+	renderThread.hotReloader = &hotReloader;
+#endif
+
+	// NOTE: The renderer and loader belong to the render thread from here on.
+	renderThread.queue = renderQueue;
+	renderThread.renderer = renderer;
+	renderThread.loader = loader;
+	renderThread.start();
 
 	MSG message = {};
 	while (!shouldClose) {
@@ -183,10 +245,17 @@ INT WINAPI wWinMain(
 			DispatchMessage(&message);
 		}
 
-		loader->load(&gameState->textureLoadQueue);
+#ifdef DEBUG
+		PROFILE("Hot Reload", hotReloader.applyTemplates(gameState))
+#endif
+
+		FrameLoadSnapshot frameLoads = {};
+		for (TextureAssetId assetId : gameState->textureLoadQueue) {
+			frameLoads.textures.push(assetId);
+		}
 
 		if (inFocus) {
-			PROFILE(L"Process Input", inputProcessor->process(&gameState->input))
+			PROFILE("Process Input", inputProcessor->process(&gameState->input))
 		}
 
 		if (editorOpen) {
@@ -200,24 +269,25 @@ INT WINAPI wWinMain(
 			}
 #endif
 		} else {
-			PROFILE(L"Game Update", Game::update(gameState, timings.delta))
+			const UpdateSystem sceneBefore = gameState->updateSystems[0];
+			PROFILE("Game Update", Game::update(gameState, timings.delta))
+			frameLoads.sceneChanged = gameState->updateSystems[0] != sceneBefore;
 		}
 
-		PROFILE(L"Sound", soundManager->process(&gameState->soundLoadQueue, &gameState->pendingMusicItem))
+		frameLoads.music = gameState->pendingMusicItem;
+		frameLoads.sounds = (u32)gameState->events.sound.depth();
 
-		PROFILE(L"Render Start", renderer->start())
-		PROFILE(L"  Draw Starfield", renderer->drawStarfield())
-		PROFILE(L"  Draw Sprites", renderer->drawSprites(gameState->sprites.data, gameState->sprites.length))
-		PROFILE(L"  Draw UI", renderer->drawUI(gameState->uiElements.data, gameState->uiElements.length))
-		PROFILE(L"Render Finish", renderer->finish())
+		PROFILE("Sound", soundManager->process(&gameState->events.sound, &gameState->pendingMusicItem, gameState->scene))
 
-		// Reset render buffers
-		gameState->sprites.clear();
-		gameState->uiElements.clear();
+		PROFILE("Submit Render Packet", submitRenderPacket(gameState))
+
+		gameState->events.endFrame();
+		Profiler::endFrame();
 
 		inputProcessor->updateCursor(gameState->input.cursor);
 		gameState->input.cursor = Cursor::arrow;
 		gameState->input.keyDown = '\0';
+		gameState->input.wheel = 0.0f;
 
 #ifdef DEBUG
 		UITextData text = {};
@@ -230,15 +300,109 @@ INT WINAPI wWinMain(
 
 		wchar_t textBuffer[128] = {};
 
-		for (const FrameProfile profile : profiles) {
-			swprintf_s(textBuffer, L"%s: %.5fs", profile.name.data, profile.time);
+		const f64 ticksPerSecond = Profiler::ticksPerSecond();
+		const Profiler::ZoneStats *zoneStats = Profiler::threadStats();
+		for (Profiler::ZoneId id = 0; id < Profiler::registeredZoneCount(); id++) {
+			if (zoneStats[id].lastFrameTicks == 0) {
+				continue;
+			}
+
+			swprintf_s(
+				textBuffer, 
+				L"%hs: %.3fms", 
+				Profiler::zoneName(id), 
+				Profiler::ticksToMilliseconds(zoneStats[id].lastFrameTicks, ticksPerSecond)
+			);
 			text.text = textBuffer;
 			text.position.y += text.height;
 
 			gameState->uiElements.push(text);
 		}
 
-		profiles.clear();
+		swprintf_s(
+			textBuffer, 
+			L"Frame p50/p99: %.2f/%.2fms, hitches: %llu", 
+			frameStats.rolling.percentile(50.0f) / 1e3f, 
+			frameStats.rolling.percentile(99.0f) / 1e3f, 
+			frameStats.hitchCount
+		);
+		text.text = textBuffer;
+		text.position.y += text.height;
+		gameState->uiElements.push(text);
+
+		for (size_t i = 0; i < (size_t)MemoryTag::_length; i++) {
+			const MemoryTagStats memoryStats = Memory::stats((MemoryTag)i);
+			swprintf_s(
+				textBuffer, 
+				L"Memory %hs: %lluKB (peak %lluKB)", 
+				memoryTagNames[i], 
+				memoryStats.live / KILOBYTE, 
+				memoryStats.peak / KILOBYTE
+			);
+			text.text = textBuffer;
+			text.position.y += text.height;
+			gameState->uiElements.push(text);
+		}
+
+		const RenderQueueStats renderStats = renderQueue->getStats();
+		swprintf_s(
+			textBuffer, 
+			L"Render: %.2fms, latency %.2fms (max %.2fms)", 
+			Profiler::ticksToMilliseconds(renderStats.lastRenderTicks, ticksPerSecond), 
+			Profiler::ticksToMilliseconds(renderStats.lastLatencyTicks, ticksPerSecond), 
+			Profiler::ticksToMilliseconds(renderStats.maxLatencyTicks, ticksPerSecond)
+		);
+		text.text = textBuffer;
+		text.position.y += text.height;
+		gameState->uiElements.push(text);
+
+		swprintf_s(
+			textBuffer, 
+			L"Culled: %u of %u sprites, %u of %u UI elements", 
+			cullStats.culledSprites, 
+			cullStats.sprites + cullStats.culledSprites, 
+			cullStats.culledUIElements, 
+			cullStats.uiElements + cullStats.culledUIElements
+		);
+		text.text = textBuffer;
+		text.position.y += text.height;
+		gameState->uiElements.push(text);
+
+		swprintf_s(
+			textBuffer, 
+			L"Text Runs: %u hit, %u miss, %u evicted", 
+			textRunStats.hits, 
+			textRunStats.misses, 
+			textRunStats.evictions
+		);
+		text.text = textBuffer;
+		text.position.y += text.height;
+		gameState->uiElements.push(text);
+
+		swprintf_s(
+			textBuffer, 
+			L"Render Scale: %.0f%% (GPU %.2fms, CPU %.2fms%s)", 
+			renderScaleStats.scale * 100.0f, 
+			renderScaleStats.gpuMilliseconds, 
+			renderScaleStats.cpuMilliseconds, 
+			renderScaleStats.cpuBound ? L", CPU bound" : L""
+		);
+		text.text = textBuffer;
+		text.position.y += text.height;
+		gameState->uiElements.push(text);
+
+		const AssetResidencyStats soundResidencyStats = soundManager->getResidencyStats();
+		swprintf_s(
+			textBuffer, 
+			L"Resident: textures %lluKB (%u evicted), sounds %lluKB (%u evicted)", 
+			textureResidencyStats.residentBytes / KILOBYTE, 
+			textureResidencyStats.evictions, 
+			soundResidencyStats.residentBytes / KILOBYTE, 
+			soundResidencyStats.evictions
+		);
+		text.text = textBuffer;
+		text.position.y += text.height;
+		gameState->uiElements.push(text);
 #endif
 
 		// Update delta
@@ -256,13 +420,35 @@ INT WINAPI wWinMain(
 
 			timings.delta = diff / timings.frequency;
 		}
+
+		frameStats.endFrame(timings.delta, frameLoads, renderZones);
 	}
 
-	delete loader;
-	delete renderer;
-	delete soundManager;
-	delete inputProcessor;
+	renderThread.stop();
+	DestroyWindow(mainWindow);
+
+	frameStats.dump("frame_report.txt");
+
+	if (wcsstr(cmdArgs, L"--profile") != nullptr) {
+		Profiler::exportChromeTrace("profile_trace.json");
+		Profiler::exportSummary("profile_summary.csv");
+	}
+
+#ifdef DEBUG
+	hotReloader.stop();
+#endif
+
+	Memory::destroy(loader);
+	Memory::destroy(renderer);
+	Memory::destroy(renderQueue);
+	Memory::destroy(soundManager);
+	Memory::destroy(inputProcessor);
+
+	Memory::destroy(directXResources);
+	Memory::destroy(gameState);
+
+	Profiler::shutdown();
 
-	delete directXResources;
-	delete gameState;
+	const size_t leakingTags = Memory::writeReport("memory_report.txt");
+	assert(leakingTags == 0);
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include <Windows.h>
 
 #include "platform/windows/utils.hpp"
+#include "types/core.hpp"
 
 void load(const wchar_t *filePath, void *destination, size_t size) {
 	HANDLE handle = CreateFile(
@@ -39,4 +40,39 @@ void load(const wchar_t *filePath, void *destination, size_t size) {
 	assert(succeeded);
 
 	CloseHandle(handle);
+}
+
+// Same as `load` but for files that may be mid-write (e.g. while hot
+// reloading), so failing to open or read the file isn't fatal. When
+// `bytesRead` is given the file may be shorter than `size`, otherwise it has to
+// fill the whole buffer.
+bool tryLoad(const wchar_t *filePath, void *destination, size_t size, size_t *bytesRead = nullptr) {
+	HANDLE handle = CreateFile(
+		filePath, 
+		GENERIC_READ, 
+		FILE_SHARE_READ | FILE_SHARE_WRITE, 
+		NULL, 
+		OPEN_EXISTING, 
+		FILE_ATTRIBUTE_NORMAL, 
+		NULL
+	);
+	if (handle == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	DWORD read = 0;
+	const bool succeeded = 
+		GetFileSizeEx(handle, &fileSize) &&
+		(u64)fileSize.QuadPart <= size &&
+		ReadFile(handle, destination, (DWORD)fileSize.QuadPart, &read, nullptr) &&
+		read == fileSize.QuadPart &&
+		(bytesRead != nullptr || read == size);
+
+	if (bytesRead != nullptr) {
+		*bytesRead = read;
+	}
+
+	CloseHandle(handle);
+	return succeeded;
 }
\ No newline at end of file
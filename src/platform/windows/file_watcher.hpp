@@ -0,0 +1,207 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+
+#include <Windows.h>
+
+#include "platform/windows/utils.hpp"
+#include "types/core.hpp"
+
+#define FILE_WATCH_MAX 16
+#define FILE_WATCH_DIRECTORY_MAX 4
+// How often the watched files are checked even without a change notification,
+// catches changes that were skipped while a previous reload was still waiting
+// to be applied
+#define FILE_WATCH_INTERVAL_MS 500
+// Editors tend to write a file in more than one go, give them a moment to
+// finish before reading it
+#define FILE_WATCH_SETTLE_MS 50
+
+// Runs on the watcher thread whenever the file changes. Returns whether the
+// file was reloaded, nothing is handed over to the main thread otherwise.
+typedef bool (*FileReloadCallback)(const wchar_t *path, void *context);
+
+struct FileWatch {
+	wchar_t path[MAX_PATH];
+	FILETIME lastWrite;
+	FileReloadCallback reload;
+	void *context;
+	// Set by the watcher thread once `reload` succeeded, the watcher leaves the
+	// file and what `reload` wrote alone until it's handed back with `release`
+	std::atomic<bool> ready;
+};
+
+// Watches a handful of files from a background thread, woken up by change
+// notifications on the directories they live in.
+//
+// Example:
+//
+//     fileWatcher.watchDirectory(GET_ASSET_PATH("shaders"));
+//     const size_t watch = fileWatcher.watch(path, reloadShader, &shaderReload);
+//     fileWatcher.start();
+//     ...
+//     // Once per frame on the main thread
+//     if (fileWatcher.isReady(watch)) {
+//         // Swap in whatever `reloadShader` loaded into `shaderReload`
+//         fileWatcher.release(watch);
+//     }
+//
+class FileWatcher {
+protected:
+	FileWatch files[FILE_WATCH_MAX];
+	u32 fileCount = 0;
+
+	// The first handle is the stop event, the rest are directory notifications
+	HANDLE handles[FILE_WATCH_DIRECTORY_MAX + 1] = {};
+	u32 handleCount = 0;
+	HANDLE thread = NULL;
+
+public:
+	~FileWatcher() {
+		this->stop();
+	}
+
+	// Must be called before `start`
+	void watchDirectory(const wchar_t *directory) {
+		assert(this->thread == NULL);
+		if (this->handleCount == 0) {
+			this->handles[this->handleCount++] = CreateEvent(NULL, TRUE, FALSE, NULL);
+		}
+		assert(this->handleCount < FILE_WATCH_DIRECTORY_MAX + 1);
+
+		HANDLE notification = FindFirstChangeNotification(
+			directory,
+			TRUE,
+			FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME
+		);
+		if (notification == INVALID_HANDLE_VALUE) {
+			LOG(L"Unable to watch %s for changes\n", directory)
+			return;
+		}
+		this->handles[this->handleCount++] = notification;
+	}
+
+	// Must be called before `start`, the file's directory also needs to be
+	// watched with `watchDirectory`
+	size_t watch(const wchar_t *path, FileReloadCallback reload, void *context) {
+		assert(this->thread == NULL);
+		assert(this->fileCount < FILE_WATCH_MAX);
+
+		const size_t index = this->fileCount++;
+		FileWatch &file = this->files[index];
+		wcscpy_s(file.path, MAX_PATH, path);
+		file.reload = reload;
+		file.context = context;
+		file.ready = false;
+		file.lastWrite = {};
+		getLastWrite(path, &file.lastWrite);
+
+		return index;
+	}
+
+	void start() {
+		if (this->handleCount == 0) {
+			return;
+		}
+
+		this->thread = CreateThread(NULL, 0, threadMain, this, 0, NULL);
+		assert(this->thread != NULL);
+	}
+
+	void stop() {
+		if (this->thread != NULL) {
+			SetEvent(this->handles[0]);
+			WaitForSingleObject(this->thread, INFINITE);
+			CloseHandle(this->thread);
+			this->thread = NULL;
+		}
+
+		if (this->handleCount > 0) {
+			CloseHandle(this->handles[0]);
+			for (u32 i = 1; i < this->handleCount; i++) {
+				FindCloseChangeNotification(this->handles[i]);
+			}
+			this->handleCount = 0;
+		}
+	}
+
+	// Whether the file has been reloaded, the data the reload callback wrote
+	// is safe to read until `release` is called
+	bool isReady(size_t index) const {
+		assert(index < this->fileCount);
+		return this->files[index].ready.load(std::memory_order_acquire);
+	}
+
+	// Call once finished with what the reload callback wrote, the watcher
+	// thread is free to reload the file into it again after this
+	void release(size_t index) {
+		assert(index < this->fileCount);
+		this->files[index].ready.store(false, std::memory_order_release);
+	}
+
+	const wchar_t *path(size_t index) const {
+		assert(index < this->fileCount);
+		return this->files[index].path;
+	}
+
+protected:
+	static bool getLastWrite(const wchar_t *path, FILETIME *lastWrite) {
+		WIN32_FILE_ATTRIBUTE_DATA attributes;
+		if (!GetFileAttributesEx(path, GetFileExInfoStandard, &attributes)) {
+			return false;
+		}
+
+		*lastWrite = attributes.ftLastWriteTime;
+		return true;
+	}
+
+	static DWORD WINAPI threadMain(LPVOID parameter) {
+		FileWatcher *watcher = (FileWatcher*)parameter;
+
+		while (true) {
+			const DWORD result = WaitForMultipleObjects(
+				watcher->handleCount,
+				watcher->handles,
+				FALSE,
+				FILE_WATCH_INTERVAL_MS
+			);
+
+			if (result == WAIT_OBJECT_0 || result == WAIT_FAILED) {
+				break;
+			}
+
+			if (result > WAIT_OBJECT_0 && result < WAIT_OBJECT_0 + watcher->handleCount) {
+				Sleep(FILE_WATCH_SETTLE_MS);
+				FindNextChangeNotification(watcher->handles[result - WAIT_OBJECT_0]);
+			}
+
+			watcher->poll();
+		}
+
+		return 0;
+	}
+
+	void poll() {
+		for (u32 i = 0; i < this->fileCount; i++) {
+			FileWatch &file = this->files[i];
+			if (file.ready.load(std::memory_order_acquire)) {
+				continue;
+			}
+
+			FILETIME lastWrite;
+			if (!getLastWrite(file.path, &lastWrite) || CompareFileTime(&lastWrite, &file.lastWrite) == 0) {
+				continue;
+			}
+
+			// NOTE: The write time is taken even if the reload fails so a broken
+			// file isn't retried until it's saved again.
+			file.lastWrite = lastWrite;
+			if (file.reload(file.path, file.context)) {
+				file.ready.store(true, std::memory_order_release);
+			} else {
+				LOG(L"Failed to reload %s\n", file.path)
+			}
+		}
+	}
+};
\ No newline at end of file
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <d3d11.h>
+
+#include "platform/windows/utils.hpp"
+#include "types/core.hpp"
+
+#define GPU_TIMER_FRAMES 4
+
+// Times a frame's worth of GPU work with timestamp queries. The GPU runs a
+// few frames behind so results are picked up once they're ready rather than
+// waited on, which makes them a couple of frames old.
+//
+// Example:
+//
+//     timer.begin(deviceContext);
+//     ...
+//     timer.end(deviceContext);
+//
+//     f32 milliseconds;
+//     if (timer.collect(deviceContext, &milliseconds)) {
+//         ...
+//     }
+//
+struct GpuTimer {
+	void initialise(ID3D11Device *device) {
+		D3D11_QUERY_DESC disjointDescription = {};
+		disjointDescription.Query = D3D11_QUERY_TIMESTAMP_DISJOINT;
+
+		D3D11_QUERY_DESC timestampDescription = {};
+		timestampDescription.Query = D3D11_QUERY_TIMESTAMP;
+
+		for (Frame &frame : this->frames) {
+			HRESULT result = device->CreateQuery(&disjointDescription, &frame.disjoint);
+			ASSERT_HRESULT(result)
+			result = device->CreateQuery(&timestampDescription, &frame.start);
+			ASSERT_HRESULT(result)
+			result = device->CreateQuery(&timestampDescription, &frame.end);
+			ASSERT_HRESULT(result)
+		}
+	}
+
+	void release() {
+		for (Frame &frame : this->frames) {
+			RELEASE_COM_OBJ(frame.disjoint)
+			RELEASE_COM_OBJ(frame.start)
+			RELEASE_COM_OBJ(frame.end)
+		}
+	}
+
+	void begin(ID3D11DeviceContext *deviceContext) {
+		// NOTE: If the GPU is a whole ring behind this frame goes untimed
+		// rather than stalling on the oldest.
+		Frame &frame = this->frames[this->current];
+		this->timing = !frame.pending;
+		if (!this->timing) {
+			return;
+		}
+
+		deviceContext->Begin(frame.disjoint);
+		deviceContext->End(frame.start);
+	}
+
+	void end(ID3D11DeviceContext *deviceContext) {
+		if (this->timing) {
+			Frame &frame = this->frames[this->current];
+			deviceContext->End(frame.end);
+			deviceContext->End(frame.disjoint);
+			frame.pending = true;
+		}
+
+		this->current = (this->current + 1) % GPU_TIMER_FRAMES;
+	}
+
+	// The latest frame that's finished since the last call, false if none has
+	bool collect(ID3D11DeviceContext *deviceContext, f32 *milliseconds) {
+		bool collected = false;
+
+		// Oldest first, stopping at the first one the GPU hasn't got to
+		for (u32 i = 0; i < GPU_TIMER_FRAMES; i++) {
+			Frame &frame = this->frames[(this->current + i) % GPU_TIMER_FRAMES];
+			if (!frame.pending) {
+				continue;
+			}
+
+			D3D11_QUERY_DATA_TIMESTAMP_DISJOINT disjoint;
+			if (deviceContext->GetData(frame.disjoint, &disjoint, sizeof(disjoint), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK) {
+				break;
+			}
+
+			u64 start;
+			u64 end;
+			const bool ready =
+				deviceContext->GetData(frame.start, &start, sizeof(start), D3D11_ASYNC_GETDATA_DONOTFLUSH) == S_OK &&
+				deviceContext->GetData(frame.end, &end, sizeof(end), D3D11_ASYNC_GETDATA_DONOTFLUSH) == S_OK;
+			if (!ready) {
+				break;
+			}
+			frame.pending = false;
+
+			// The clock changed speed part way through so the times are junk
+			if (disjoint.Disjoint) {
+				continue;
+			}
+
+			*milliseconds = (f32)((f64)(end - start) * 1000.0 / (f64)disjoint.Frequency);
+			collected = true;
+		}
+
+		return collected;
+	}
+
+protected:
+	struct Frame {
+		ID3D11Query *disjoint;
+		ID3D11Query *start;
+		ID3D11Query *end;
+		bool pending;
+	};
+
+	Frame frames[GPU_TIMER_FRAMES] = {};
+	u32 current = 0;
+	bool timing = false;
+};
\ No newline at end of file
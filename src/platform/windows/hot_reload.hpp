@@ -0,0 +1,118 @@
+#pragma once
+
+#include "common/game_state.hpp"
+#include "common/templates.hpp"
+#include "platform/windows/directx_renderer.hpp"
+#include "platform/windows/file_loader.hpp"
+#include "platform/windows/file_watcher.hpp"
+#include "platform/windows/template_loader.hpp"
+#include "platform/windows/utils.hpp"
+
+struct ShipTemplateReload {
+	TemplateData<Ship> *shipTemplate;
+	size_t watch;
+	// Written by the watcher thread, copied over the template at the start of
+	// the next frame
+	Ship staging;
+};
+
+struct ShaderReload {
+	ShaderId id;
+	size_t watch;
+	ShaderBlobs blobs;
+};
+
+// Picks up changes to the ship templates and shaders while the game is running.
+// Files are read and compiled on the watcher thread and only swapped in by
+// `applyTemplates` and `applyShaders` at the start of a frame on the threads
+// that use them, so nothing ever sees half loaded data.
+struct HotReloader {
+	FileWatcher watcher;
+	Array<ShipTemplateReload, 3> shipTemplates;
+	ShaderReload shaders[(size_t)ShaderId::_length];
+
+	// Must be called after the templates have been loaded
+	void start(GameState *gameState) {
+		this->watcher.watchDirectory(GET_ASSET_PATH("data/templates"));
+		this->watcher.watchDirectory(GET_ASSET_PATH("shaders"));
+
+		wchar_t filePathBuffer[100];
+		for (TemplateData<Ship> &shipTemplate : gameState->templates.ships) {
+			ShipTemplateReload reload = {};
+			reload.shipTemplate = &shipTemplate;
+			this->shipTemplates.push(reload);
+		}
+
+		// NOTE: Registered once the array is filled in since the watcher keeps a
+		// pointer to each entry.
+		for (ShipTemplateReload &reload : this->shipTemplates) {
+			getTemplatePath(*reload.shipTemplate, SHIP_TEMPLATE_SOURCE_EXTENSION, filePathBuffer, 100);
+			reload.watch = this->watcher.watch(filePathBuffer, reloadShipTemplate, &reload);
+		}
+
+		for (size_t i = 0; i < (size_t)ShaderId::_length; i++) {
+			ShaderReload &reload = this->shaders[i];
+			reload = {};
+			reload.id = (ShaderId)i;
+			reload.watch = this->watcher.watch(shaderPaths[i], reloadShader, &reload);
+		}
+
+		this->watcher.start();
+	}
+
+	// Game thread
+	void applyTemplates(GameState *gameState) {
+		for (ShipTemplateReload &reload : this->shipTemplates) {
+			if (!this->watcher.isReady(reload.watch)) {
+				continue;
+			}
+
+			const TextureAssetId previousAssetId = reload.shipTemplate->data.assetId;
+			reload.shipTemplate->data = reload.staging;
+			if (reload.staging.assetId != previousAssetId) {
+				gameState->textureLoadQueue.push(reload.staging.assetId);
+			}
+
+			// Only now can the watcher write into `staging` again
+			this->watcher.release(reload.watch);
+			LOG(L"Reloaded %s\n", this->watcher.path(reload.watch))
+		}
+	}
+
+	// Render thread
+	void applyShaders(DirectXRenderer *renderer) {
+		for (ShaderReload &reload : this->shaders) {
+			if (!this->watcher.isReady(reload.watch)) {
+				continue;
+			}
+
+			// Reads and releases the blobs before the watcher may compile into
+			// them again
+			renderer->swapShader(reload.id, &reload.blobs);
+			this->watcher.release(reload.watch);
+			LOG(L"Reloaded %s\n", this->watcher.path(reload.watch))
+		}
+	}
+
+	void stop() {
+		this->watcher.stop();
+
+		// Anything that was reloaded but never applied
+		for (ShaderReload &reload : this->shaders) {
+			releaseShaderBlobs(&reload.blobs);
+			this->watcher.release(reload.watch);
+		}
+	}
+
+protected:
+	static bool reloadShipTemplate(const wchar_t *path, void *context) {
+		ShipTemplateReload *reload = (ShipTemplateReload*)context;
+		// The cache is left alone since it's stale until the compiler is run again
+		return loadShipTemplate(path, nullptr, &reload->staging);
+	}
+
+	static bool reloadShader(const wchar_t *path, void *context) {
+		ShaderReload *reload = (ShaderReload*)context;
+		return compileShaderBlobs(path, &reload->blobs);
+	}
+};
\ No newline at end of file
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <Windows.h>
+
+#include "common/render_queue.hpp"
+#include "common/render_scale.hpp"
+#include "platform/windows/directx_renderer.hpp"
+#include "platform/windows/dx3d_sprite_loader.hpp"
+#include "platform/windows/hot_reload.hpp"
+#include "platform/windows/utils.hpp"
+#include "utils/profiler.hpp"
+#include "utils/thread.hpp"
+
+// Draws whatever the game thread submits to the queue, so presenting one
+// frame overlaps the game updating the next. Once started nothing else may
+// touch the renderer or the loader until `stop` returns.
+struct RenderThread {
+	RenderQueue *queue;
+	DirectXRenderer *renderer;
+	Dx3dSpriteLoader *loader;
+#ifdef DEBUG
+	HotReloader *hotReloader;
+#endif
+	// Drops the scene's resolution when the GPU can't keep up
+	RenderScaleController renderScale;
+	Thread thread;
+
+	void start() {
+		this->renderScale.reset();
+		if (!this->thread.start(threadMain, this)) {
+			LOG(L"Couldn't start the render thread, drawing on the game thread instead\n")
+		}
+	}
+
+	// Draws the packet just submitted when there's no render thread to,
+	// otherwise the game would wait on the queue forever. Call after every
+	// `RenderQueue::submit`.
+	void drawInline() {
+		if (this->thread.running) {
+			return;
+		}
+
+		RenderPacket *packet = this->queue->beginRead();
+		if (packet != nullptr) {
+			this->render(packet);
+			// NOTE: The zones were recorded on the game thread so the hitch
+			// already has them.
+			packet->renderZones.clear();
+			this->queue->endRead();
+		}
+	}
+
+	void stop() {
+		this->queue->close();
+		this->thread.join();
+	}
+
+protected:
+	static void threadMain(void *argument) {
+		RenderThread *renderThread = (RenderThread*)argument;
+
+		// NOTE: The loader's WIC factory is free threaded so it can be used from
+		// here even though it was created on the main thread.
+		HRESULT result = CoInitializeEx(NULL, COINIT_MULTITHREADED);
+		ASSERT_HRESULT(result)
+
+		while (RenderPacket *packet = renderThread->queue->beginRead()) {
+			renderThread->render(packet);
+			Profiler::endFrame();
+			packet->renderZones.capture();
+			renderThread->queue->endRead();
+		}
+
+		CoUninitialize();
+	}
+
+	void render(RenderPacket *packet) {
+		DirectXRenderer *renderer = this->renderer;
+		const u64 start = Profiler::now();
+
+#ifdef DEBUG
+		PROFILE("Hot Reload Shaders", this->hotReloader->applyShaders(renderer))
+#endif
+		PROFILE("Load Textures", this->loader->load(&packet->textureLoads, packet->frame))
+		PROFILE("Prefetch Textures", this->loader->prefetch(packet->texturePrefetches, packet->sprites.data, packet->sprites.length, packet->frame))
+		this->loader->getTextureSizes(&packet->textureSizes);
+
+		renderer->setViewProjection(packet->viewProjection);
+		renderer->setRenderScale(this->renderScale.getScale());
+		PROFILE("Render Start", renderer->start())
+		PROFILE("Draw Starfield", renderer->drawStarfield())
+		PROFILE("Draw Sprites", renderer->drawSprites(packet->sprites.data, packet->sprites.length))
+		PROFILE("Upscale Scene", renderer->upscaleScene())
+		PROFILE("Draw UI", renderer->drawUI(packet->uiElements.data, packet->uiElements.length))
+
+		// Up to here, presenting mostly waits for vsync
+		const f32 cpuMilliseconds = (f32)Profiler::ticksToMilliseconds(Profiler::now() - start, Profiler::ticksPerSecond());
+		PROFILE("Render Finish", renderer->finish())
+
+		f32 gpuMilliseconds;
+		if (renderer->collectGpuMilliseconds(&gpuMilliseconds)) {
+			this->renderScale.update(gpuMilliseconds, cpuMilliseconds);
+		}
+
+		packet->textRunStats = renderer->getTextRunStats();
+		packet->renderScaleStats = this->renderScale.getStats();
+		packet->textureResidencyStats = this->loader->getResidencyStats();
+	}
+};
\ No newline at end of file
@@ -3,25 +3,15 @@
 #include <xaudio2.h>
 #include <strsafe.h>
 #include "platform/windows/utils.hpp"
+#include "common/asset_residency.hpp"
+#include "common/compressed_audio.hpp"
 #include "common/game_state.hpp"
+#include "common/scene_manifest.hpp"
+#include "utils/mapped_file.hpp"
+#include "utils/memory.hpp"
+#include "utils/riff.hpp"
 
-#ifdef _XBOX // Big-Endian
-#define fourccRIFF 'RIFF'
-#define fourccDATA 'data'
-#define fourccFMT 'fmt '
-#define fourccWAVE 'WAVE'
-#define fourccXWMA 'XWMA'
-#define fourccDPDS 'dpds'
-#endif
-
-#ifndef _XBOX // Little-Endian
-#define fourccRIFF 'FFIR'
-#define fourccDATA 'atad'
-#define fourccFMT ' tmf'
-#define fourccWAVE 'EVAW'
-#define fourccXWMA 'AMWX'
-#define fourccDPDS 'sdpd'
-#endif
+#define SOUND_CACHE_BUDGET (16 * MEGABYTE)
 
 /*
 XAudio2 Features:
@@ -65,83 +55,82 @@ XAudio2 Features:
 */
 
 
-void findWaveDataChunk(HANDLE fileHandle, DWORD fourcc, DWORD *chunkSize, DWORD *chunkDataPosition) {
-	HRESULT hr = S_OK;
-	if (INVALID_SET_FILE_POINTER == SetFilePointer(fileHandle, 0, NULL, FILE_BEGIN)) {
-		ASSERT_HRESULT(HRESULT_FROM_WIN32(GetLastError()))
+// Maps a WAV and finds its samples, false if it's missing or not one XAudio2
+// can play. The samples are read straight from the mapping, so it has to stay
+// open while a voice plays them.
+bool mapWave(const wchar_t *fileName, MappedFile *file, Wave *wave, WAVEFORMATEXTENSIBLE *format) {
+	if (!file->open(fileName)) {
+		LOG(L"Couldn't open %s\n", fileName);
+		return false;
 	}
 
-	DWORD chunkType;
-	DWORD chunkDataSize;
-	DWORD riffDataSize = 0;
-	DWORD fileType;
-	DWORD bytesRead = 0;
-	DWORD readOffset = 0;
-
-	while (hr == S_OK) {
-		DWORD bytesToRead;
-		if (!ReadFile(fileHandle, &chunkType, sizeof(DWORD), &bytesToRead, NULL)) {
-			hr = (HRESULT_FROM_WIN32(GetLastError()));
-		}
-		ASSERT_HRESULT(hr)
-
-		if (!ReadFile(fileHandle, &chunkDataSize, sizeof(DWORD), &bytesToRead, NULL)) {
-			hr = (HRESULT_FROM_WIN32(GetLastError()));
-		}
-		ASSERT_HRESULT(hr)
-
-		switch (chunkType) {
-			case fourccRIFF:
-				riffDataSize = chunkDataSize;
-				chunkDataSize = 4;
-				if (!ReadFile(fileHandle, &fileType, sizeof(DWORD), &bytesToRead, NULL)) {
-					hr = (HRESULT_FROM_WIN32(GetLastError()));
-				}
-				break;
-
-			default:
-				if (INVALID_SET_FILE_POINTER == SetFilePointer(fileHandle, chunkDataSize, NULL, FILE_CURRENT)) {
-					hr = (HRESULT_FROM_WIN32(GetLastError()));
-				}
-		}
-		ASSERT_HRESULT(hr)
-
-		readOffset += sizeof(DWORD) * 2;
-
-		if (chunkType == fourcc) {
-			*chunkSize = chunkDataSize;
-			*chunkDataPosition = readOffset;
-			return;
-		}
+	const WaveError error = Riff::readWave(file->data, file->size, wave);
+	if (error != WaveError::none) {
+		LOG(L"Couldn't play %s: %hs\n", fileName, waveErrorNames[(size_t)error]);
+		file->close();
+		return false;
+	}
 
-		readOffset += chunkDataSize;
+	// Anything past WAVEFORMATEXTENSIBLE is of no use to XAudio2
+	*format = {};
+	memcpy(format, wave->format.chunk, wave->format.chunkSize < sizeof(*format) ? wave->format.chunkSize : sizeof(*format));
+	return true;
+}
 
-		if (bytesRead >= riffDataSize) {
-			ASSERT_HRESULT(S_FALSE)
-		}
+// Maps the .bsnd next to a WAV when there's one at least as new, to be played
+// in its place. The WAV doesn't have to be there. Decodes to 16-bit PCM, which
+// is what `format` is set to.
+bool mapCompressedSound(const wchar_t *fileName, MappedFile *file, CompressedAudioStream *stream, WAVEFORMATEXTENSIBLE *format) {
+	wchar_t path[MAX_PATH];
+	wchar_t *extension = nullptr;
+	if (wcscpy_s(path, MAX_PATH, fileName) != 0 || (extension = wcsrchr(path, L'.')) == nullptr) {
+		return false;
+	}
+	*extension = L'\0';
+	if (wcscat_s(path, MAX_PATH, L"" COMPRESSED_AUDIO_EXTENSION) != 0) {
+		return false;
 	}
-}
 
-void readChunkData(HANDLE fileHandle, void *buffer, DWORD bufferSize, DWORD bufferOffset) {
-	if (INVALID_SET_FILE_POINTER == SetFilePointer(fileHandle, bufferOffset, NULL, FILE_BEGIN)) {
-		ASSERT_HRESULT(HRESULT_FROM_WIN32(GetLastError()));
+	// Older than the WAV means the WAV has been edited since
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+	WIN32_FILE_ATTRIBUTE_DATA waveAttributes;
+	if (
+		!GetFileAttributesEx(path, GetFileExInfoStandard, &attributes) ||
+		(
+			GetFileAttributesEx(fileName, GetFileExInfoStandard, &waveAttributes) &&
+			CompareFileTime(&attributes.ftLastWriteTime, &waveAttributes.ftLastWriteTime) < 0
+		)
+	) {
+		return false;
 	}
 
-	DWORD bytesToRead;
-	if (!ReadFile(fileHandle, buffer, bufferSize, &bytesToRead, NULL)) {
-		ASSERT_HRESULT(HRESULT_FROM_WIN32(GetLastError()));
+	if (!file->open(path)) {
+		return false;
 	}
+	if (!CompressedAudio::open(file->data, file->size, stream)) {
+		LOG(L"Couldn't play %s: out of date, rebuild it with the audio encoder\n", path);
+		file->close();
+		return false;
+	}
+
+	const u16 channels = stream->header.channels;
+	*format = {};
+	format->Format.wFormatTag = WAVE_FORMAT_PCM;
+	format->Format.nChannels = channels;
+	format->Format.nSamplesPerSec = stream->header.sampleRate;
+	format->Format.wBitsPerSample = 16;
+	format->Format.nBlockAlign = (WORD)(channels * sizeof(s16));
+	format->Format.nAvgBytesPerSec = stream->header.sampleRate * format->Format.nBlockAlign;
+	return true;
 }
 
 // https://docs.microsoft.com/en-us/windows/win32/xaudio2/how-to--stream-a-sound-from-disk
 // 1.Create an array of read buffers.
 #define STREAMBUFFERSIZE 65536 // The size of each buffer
-#define BUFFERNUM 5 // Number of buffers
-BYTE streamBuffers[BUFFERNUM][STREAMBUFFERSIZE]; // Buffer array
+#define BUFFERNUM 5 // Number of buffers, compressed music decodes into a ring of as many
 
 IXAudio2 *musicXAudio2 = NULL;
 IXAudio2MasteringVoice *musicMasterVoice = NULL;
-int currentBufferIndex = 0;
 float backgroundMusicVolume = 0.5f;
 float soundVolume = 0.5f;
 
@@ -169,84 +158,8 @@ public:
 	}
 };
 
-void getWaveInfo(
-	const TCHAR *fileName, 
-	WAVEFORMATEXTENSIBLE *wfx, 
-	DWORD *fileType, 
-	DWORD *waveSize, 
-	HANDLE *fileHandle, 
-	DWORD *waveDataStartPosition
-) {
-	*fileHandle = CreateFile(
-		fileName,
-		GENERIC_READ,
-		FILE_SHARE_READ,
-		NULL,
-		OPEN_EXISTING,
-		0,
-		NULL
-	);
-
-	if (INVALID_HANDLE_VALUE == *fileHandle) {
-		ASSERT_HRESULT(HRESULT_FROM_WIN32(GetLastError()))
-	}
-
-	if (INVALID_SET_FILE_POINTER == SetFilePointer(*fileHandle, 0, NULL, FILE_BEGIN)) {
-		ASSERT_HRESULT(HRESULT_FROM_WIN32(GetLastError()))
-	}
-
-	DWORD chunkSize;
-	DWORD chunkPosition;
-	// Check the file type, should be fourccWAVE or 'XWMA'
-	findWaveDataChunk(*fileHandle, fourccRIFF, &chunkSize, &chunkPosition);
-	readChunkData(*fileHandle, fileType, sizeof(DWORD), chunkPosition);
-	if (*fileType != fourccWAVE) {
-		ASSERT_HRESULT(S_FALSE)
-	}
-
-	*wfx = { 0 };
-
-	// 4. Locate the 'fmt ' chunk, and copy its contents into a WAVEFORMATEXTENSIBLE structure.
-	findWaveDataChunk(*fileHandle, fourccFMT, &chunkSize, &chunkPosition);
-	readChunkData(*fileHandle, wfx, chunkSize, chunkPosition);
-
-	// 5. Locate the 'data' chunk, and read its contents into a buffer.
-	// Fill out the audio data buffer with the contents of the fourccDATA chunk.
-	findWaveDataChunk(*fileHandle, fourccDATA, waveSize, waveDataStartPosition);
-}
-
-void getStreamingData(
-	const TCHAR *fileName, 
-	WAVEFORMATEXTENSIBLE *wfx, 
-	DWORD *fileType, 
-	DWORD *waveSize, 
-	HANDLE *fileHandle, 
-	DWORD *waveDataStartPosition
-) {
-	getWaveInfo(fileName, wfx, fileType, waveSize, fileHandle, waveDataStartPosition);
-}
-
-void getWaveData(
-	const TCHAR *fileName, 
-	WAVEFORMATEXTENSIBLE *wfx, 
-	DWORD *fileType, 
-	DWORD *waveSize, 
-	BYTE **waveData
-) {
-	HANDLE fileHandle;
-	DWORD waveDataStartPosition;
-
-	getWaveInfo(fileName, wfx, fileType, waveSize, &fileHandle, &waveDataStartPosition);
-
-	*waveData = new BYTE[*waveSize];
-	readChunkData(fileHandle, *waveData, *waveSize, waveDataStartPosition);
-
-	// Close fileHandle stream now that we've loaded all the data into memory
-	CloseHandle(fileHandle);
-}
-
 struct StreamMusic {
-	TCHAR *nextFileName;
+	TCHAR *nextFileName = nullptr;
 
 	bool isChanging = false;
 	bool isPlaying = false;
@@ -266,95 +179,164 @@ struct StreamMusic {
 		nextFileName = fileName;
 
 		while (nextFileName != nullptr) {
-			WAVEFORMATEXTENSIBLE wfx = { 0 };
-			DWORD fileType, waveFileSize, waveDataStartPosition;
-			fileType = waveFileSize = waveDataStartPosition = 0;
-			HANDLE fileHandle = NULL;
-			getStreamingData(
-				nextFileName, 
-				&wfx, 
-				&fileType, 
-				&waveFileSize, 
-				&fileHandle, 
-				&waveDataStartPosition
-			);
+			const TCHAR *playingFileName = nextFileName;
+			// clear so doesn't play again
+			nextFileName = nullptr;
 
-			StreamingVoiceContext musicCallBack;
-			IXAudio2SourceVoice *musicSourceVoice = NULL;
+			WAVEFORMATEXTENSIBLE wfx;
+			MappedFile file;
+			CompressedAudioStream stream;
+			Wave wave;
+			if (mapCompressedSound(playingFileName, &file, &stream, &wfx)) {
+				streamCompressed(&stream, wfx);
+			} else if (mapWave(playingFileName, &file, &wave, &wfx)) {
+				streamWave(file, wave, wfx);
+			}
 
-			// Create source sound to submit data
-			HRESULT hr = musicXAudio2->CreateSourceVoice(
-				&musicSourceVoice, 
-				(WAVEFORMATEX*)&wfx, 
-				0, 
-				XAUDIO2_DEFAULT_FREQ_RATIO, 
-				&musicCallBack
-			); 
-			ASSERT_HRESULT(hr)
+			// The voice has been destroyed, nothing reads the mapping now
+			file.close();
+			isChanging = false;
+		}
 
-			musicSourceVoice->SetVolume(backgroundMusicVolume);
+		isPlaying = false;
+	}
 
-			int fileSize = waveFileSize;
-			int currentPos = waveDataStartPosition;
+private:
+	IXAudio2SourceVoice *createVoice(const WAVEFORMATEXTENSIBLE &wfx, StreamingVoiceContext *callback) {
+		IXAudio2SourceVoice *voice = NULL;
+
+		// Create source sound to submit data
+		HRESULT hr = musicXAudio2->CreateSourceVoice(
+			&voice, 
+			(WAVEFORMATEX*)&wfx, 
+			0, 
+			XAUDIO2_DEFAULT_FREQ_RATIO, 
+			callback
+		); 
+		ASSERT_HRESULT(hr)
 
-			// clear so doesn't play again
-			nextFileName = nullptr;
+		voice->SetVolume(backgroundMusicVolume);
+		return voice;
+	}
 
-			while (currentPos < fileSize) {
-				if (isChanging || !isAlive) {
-					break;
-				}
+	// Returns once fewer than BUFFERNUM buffers are queued, so the oldest of
+	// the last BUFFERNUM submitted is done with and can be written again
+	void submit(IXAudio2SourceVoice *voice, StreamingVoiceContext *callback, const u8 *data, u32 size) {
+		XAUDIO2_BUFFER buffer = { 0 };
+		buffer.AudioBytes = size;
+		buffer.pAudioData = data;
 
-				DWORD size = STREAMBUFFERSIZE;
-				readChunkData(fileHandle, streamBuffers[currentBufferIndex], size, currentPos);
+		// Submit memory data
+		HRESULT hr = voice->SubmitSourceBuffer(&buffer);
+		ASSERT_HRESULT(hr)
 
-				// The size of the data that has been played
-				currentPos += size;
+		//Start source sound
+		hr = voice->Start(XAUDIO2_COMMIT_NOW);
+		ASSERT_HRESULT(hr)
 
-				// The file data to be read will be assigned XAUDIO2_BUFFER
-				XAUDIO2_BUFFER buffer = { 0 };
-				buffer.AudioBytes = size;
-				buffer.pAudioData = streamBuffers[currentBufferIndex];
+		XAUDIO2_VOICE_STATE state;
+		voice->GetState(&state);
+		// Keeps a few buffers ahead of what's playing
+		while (state.BuffersQueued > BUFFERNUM - 1) {
+			WaitForSingleObject(callback->bufferEndEvent, INFINITE);
+			voice->GetState(&state);
+		}
+	}
 
-				// Submit memory data
-				hr = musicSourceVoice->SubmitSourceBuffer(&buffer);
-				ASSERT_HRESULT(hr)
+	void finish(IXAudio2SourceVoice *voice, StreamingVoiceContext *callback) {
+		XAUDIO2_VOICE_STATE state;
+		if (!isChanging) {
+			// Wait for the completion of data playback in the queue, exit the thread				
+			while (voice->GetState(&state), state.BuffersQueued > 0) {
+				WaitForSingleObject(callback->bufferEndEvent, INFINITE);
+			}
+		}
 
-				//Start source sound
-				hr = musicSourceVoice->Start(XAUDIO2_COMMIT_NOW);
-				ASSERT_HRESULT(hr)
+		// Waits for the voice to stop reading its buffers
+		voice->DestroyVoice();
+	}
 
-				XAUDIO2_VOICE_STATE state;
-				musicSourceVoice->GetState(&state);
-				// Do not let the audio data of the buffer be overwritten
-				while (state.BuffersQueued > BUFFERNUM - 1) {
-					WaitForSingleObject(musicCallBack.bufferEndEvent, INFINITE);
-					musicSourceVoice->GetState(&state);
-				}
+	void streamWave(const MappedFile &file, const Wave &wave, const WAVEFORMATEXTENSIBLE &wfx) {
+		StreamingVoiceContext musicCallBack;
+		IXAudio2SourceVoice *musicSourceVoice = createVoice(wfx, &musicCallBack);
 
-				// Recycle buffer
-				currentBufferIndex++;
-				currentBufferIndex %= BUFFERNUM;
+		// Buffers are slices of the mapping, cut on whole frames
+		const u32 sliceSize = STREAMBUFFERSIZE / wave.format.blockAlign * wave.format.blockAlign;
+		const size_t samplesOffset = wave.samples - file.data;
+		u32 currentPos = 0;
 
-				// If we're looping and we've reached the end, reset and go again
-				if (isLooping && currentPos >= fileSize) {
-					currentPos = waveDataStartPosition;
-				}
+		while (currentPos < wave.size) {
+			if (isChanging || !isAlive) {
+				break;
 			}
 
-			XAUDIO2_VOICE_STATE state;
-			if (!isChanging) {
-				// Wait for the completion of data playback in the queue, exit the thread				
-				while (musicSourceVoice->GetState(&state), state.BuffersQueued > 0) {
-					WaitForSingleObject(musicCallBack.bufferEndEvent, INFINITE);
+			const u32 size = wave.size - currentPos < sliceSize ? wave.size - currentPos : sliceSize;
+			// Paged in here rather than on the audio engine's thread
+			file.prefault(samplesOffset + currentPos, size);
+
+			submit(musicSourceVoice, &musicCallBack, wave.samples + currentPos, size);
+
+			// The size of the data that has been played
+			currentPos += size;
+
+			// If we're looping and we've reached the end, reset and go again
+			if (isLooping && currentPos >= wave.size) {
+				currentPos = 0;
+			}
+		}
+
+		finish(musicSourceVoice, &musicCallBack);
+	}
+
+	// Decodes a block at a time into the ring while the blocks before it play,
+	// which keeps the decoder as far ahead as the queue is long
+	void streamCompressed(CompressedAudioStream *stream, const WAVEFORMATEXTENSIBLE &wfx) {
+		StreamingVoiceContext musicCallBack;
+		IXAudio2SourceVoice *musicSourceVoice = createVoice(wfx, &musicCallBack);
+
+		const u32 channels = stream->header.channels;
+		const size_t slotLength = (size_t)AUDIO_BLOCK_FRAMES * channels;
+		s16 *ring = Memory::allocateArray<s16>(MemoryTag::sound, slotLength * BUFFERNUM);
+		u32 slot = 0;
+
+		while (!isChanging && isAlive) {
+			if (stream->isFinished()) {
+				if (!isLooping) {
+					break;
 				}
+				stream->rewind();
 			}
 
-			musicSourceVoice->DestroyVoice();
-			isChanging = false;
+			s16 *samples = ring + slot * slotLength;
+			const u32 frames = stream->decodeNext(samples);
+			submit(musicSourceVoice, &musicCallBack, (const u8*)samples, frames * channels * sizeof(s16));
+			slot = (slot + 1) % BUFFERNUM;
 		}
 
-		isPlaying = false;
+		finish(musicSourceVoice, &musicCallBack);
+		Memory::release(ring);
+	}
+};
+
+// Played by pointing voices at its samples, which are either in a mapped WAV
+// or decoded from a .bsnd
+struct CachedSound {
+	MappedFile file;
+	s16 *decoded;
+	WAVEFORMATEXTENSIBLE format;
+	const u8 *samples;
+	u32 size;
+
+	bool isLoaded() const {
+		return this->samples != nullptr;
+	}
+
+	void release() {
+		this->file.close();
+		Memory::release(this->decoded);
+		this->decoded = nullptr;
+		this->samples = nullptr;
+		this->size = 0;
 	}
 };
 
@@ -423,9 +405,31 @@ private:
 
 	static const int voiceBufferSize = 2;
 	IXAudio2SourceVoice *voices[voiceBufferSize] = {};
+	// What the voice in the same slot is playing, its data stays cached until
+	// the voice is destroyed
+	SoundAssetId voiceSounds[voiceBufferSize];
+
+	// Kept between plays and read ahead for the scenes coming up, so playing a
+	// sound doesn't have to wait on the disk
+	CachedSound sounds[(size_t)SoundAssetId::_length] = {};
+	// Missing or in a format that can't be played, not tried again
+	bool unplayable[(size_t)SoundAssetId::_length] = {};
+	AssetResidency<SoundAssetId> residency;
+	SoundPrefetchList soundPrefetches;
+	u64 frame = 0;
 
 public:
 	~SoundManager() {
+		for (int i = 0; i < voiceBufferSize; i++) {
+			if (voices[i] != nullptr) {
+				voices[i]->DestroyVoice();
+				voices[i] = nullptr;
+			}
+		}
+		for (CachedSound &sound : this->sounds) {
+			sound.release();
+		}
+
 		xAudio2->Release();
 
 		DWORD threadID = 0;
@@ -436,7 +440,7 @@ public:
 		// Close all thread handles and free memory allocations.
 		CloseHandle(streamMusicThread);
 		if (streamMusicData != NULL) {
-			HeapFree(GetProcessHeap(), 0, streamMusicData);
+			Memory::destroy(streamMusicData);
 
 			// Ensure address is not reused.
 			streamMusicData = NULL; 
@@ -457,6 +461,11 @@ public:
 		voiceCallbackPtr = nullptr;
 		HRESULT hr;
 
+		for (SoundAssetId &voiceSound : this->voiceSounds) {
+			voiceSound = SoundAssetId::_length;
+		}
+		this->residency.budget = SOUND_CACHE_BUDGET;
+
 		hr = XAudio2Create(&xAudio2, 0, XAUDIO2_DEFAULT_PROCESSOR);
 		ASSERT_HRESULT(hr)
 
@@ -483,10 +492,7 @@ public:
 		hr = musicXAudio2->CreateMasteringVoice(&masterVoice);
 		ASSERT_HRESULT(hr)
 
-		streamMusicData = (StreamMusic*)HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(StreamMusic));
-		if (streamMusicData == NULL) {
-			ASSERT_HRESULT(HRESULT_FROM_WIN32(GetLastError()))
-		}
+		streamMusicData = Memory::create<StreamMusic>(MemoryTag::sound);
 		streamMusicData->isAlive = true;
 		streamMusicData->isLooping = true;
 
@@ -505,10 +511,19 @@ public:
 		}
 	}
 
-	void process(SoundLoadQueue *soundQueue, MusicAssetId *musicToPlay) {
-		for (SoundAssetId assetId : *soundQueue) {
-			LPCWSTR fileName = soundNames[(size_t)assetId];
-			playGameSound(fileName);
+	void process(SoundEventQueue *soundEvents, MusicAssetId *musicToPlay, const SceneAssets &scene) {
+		this->frame++;
+
+		// Nothing a voice might still be playing can be freed
+		for (int i = 0; i < voiceBufferSize; i++) {
+			if (voices[i] != nullptr) {
+				this->residency.touch(this->voiceSounds[i], this->frame);
+			}
+		}
+
+		SoundEvent event;
+		while (soundEvents->pop(&event)) {
+			playGameSound(event.assetId);
 		}
 
 		if (*musicToPlay != MusicAssetId::none) {
@@ -516,26 +531,17 @@ public:
 			streamMusicData->playNewFile(fileName);
 		}
 
-		soundQueue->clear();
 		*musicToPlay = MusicAssetId::none;
+
+		this->prefetchSounds(scene);
 	}
 
-	void playGameSound(const TCHAR *strFileName) {
-		const TCHAR *fileName;
-		fileName = strFileName;
+	const AssetResidencyStats &getResidencyStats() const {
+		return this->residency.stats;
+	}
 
+	void playGameSound(SoundAssetId assetId) {
 		HRESULT hr;
-		WAVEFORMATEXTENSIBLE wfx;
-		DWORD fileType, waveFileSize;
-		BYTE *soundDataBuffer;
-		HANDLE fileHandle;
-		getWaveData(fileName, &wfx, &fileType, &waveFileSize, &soundDataBuffer);
-
-		XAUDIO2_BUFFER buffer = { 0 };
-		// 6. Populate an XAUDIO2_BUFFER structure.
-		buffer.AudioBytes = waveFileSize; // size of the audio buffer in bytes
-		buffer.pAudioData = soundDataBuffer; // buffer containing audio data
-		buffer.Flags = XAUDIO2_END_OF_STREAM; // tell the source voice not to expect any data after this buffer
 
 		bool canPlaySound = false;
 		int freeVoiceBufferIndex = 0;
@@ -546,6 +552,7 @@ public:
 				if (state.BuffersQueued <= 0) {
 					voices[freeVoiceBufferIndex]->DestroyVoice();
 					voices[freeVoiceBufferIndex] = nullptr;
+					voiceSounds[freeVoiceBufferIndex] = SoundAssetId::_length;
 					canPlaySound = true;
 					break;
 				}
@@ -555,7 +562,14 @@ public:
 			}
 		}
 
-		if (canPlaySound) {
+		const CachedSound *sound = canPlaySound ? this->loadSound(assetId) : nullptr;
+		if (sound != nullptr) {
+			XAUDIO2_BUFFER buffer = { 0 };
+			// 6. Populate an XAUDIO2_BUFFER structure.
+			buffer.AudioBytes = sound->size; // size of the audio buffer in bytes
+			buffer.pAudioData = sound->samples; // buffer containing audio data
+			buffer.Flags = XAUDIO2_END_OF_STREAM; // tell the source voice not to expect any data after this buffer
+
 			// https://docs.microsoft.com/en-us/windows/win32/xaudio2/how-to--play-a-sound-with-xaudio2
 			// 3. Create a source voice by calling the IXAudio2::CreateSourceVoice method on an instance of the XAudio2 engine. 
 			// The format of the voice is specified by the values set in a WAVEFORMATEX structure.
@@ -563,7 +577,7 @@ public:
 
 			hr = xAudio2->CreateSourceVoice(
 				&soundSourceVoice, 
-				(WAVEFORMATEX *)&wfx,
+				(WAVEFORMATEX *)&sound->format,
 				0, 
 				XAUDIO2_DEFAULT_FREQ_RATIO, 
 				&voiceCallback, 
@@ -590,6 +604,7 @@ public:
 			ASSERT_HRESULT(hr)
 
 			voices[freeVoiceBufferIndex] = soundSourceVoice;
+			voiceSounds[freeVoiceBufferIndex] = assetId;
 		}
 	}
 
@@ -631,4 +646,82 @@ public:
 		//device.start();
 		//while (true); // Spin forever
 	}
-};
+
+private:
+	// Null if it can't be played
+	const CachedSound *loadSound(SoundAssetId assetId) {
+		CachedSound &sound = this->sounds[(size_t)assetId];
+		if (sound.isLoaded()) {
+			this->residency.touch(assetId, this->frame);
+			return &sound;
+		}
+
+		if (this->unplayable[(size_t)assetId]) {
+			return nullptr;
+		}
+
+		const wchar_t *fileName = soundNames[(size_t)assetId];
+		CompressedAudioStream stream;
+		Wave wave;
+		if (mapCompressedSound(fileName, &sound.file, &stream, &sound.format)) {
+			// Effects are short, so they're decoded whole and the mapping
+			// let go of
+			const u32 channels = stream.header.channels;
+			sound.decoded = Memory::allocateArray<s16>(MemoryTag::sound, (size_t)stream.header.frameCount * channels);
+			s16 *write = sound.decoded;
+			for (u32 frames = stream.decodeNext(write); frames > 0; frames = stream.decodeNext(write)) {
+				write += (size_t)frames * channels;
+			}
+			sound.file.close();
+
+			sound.samples = (const u8*)sound.decoded;
+			sound.size = stream.header.frameCount * channels * sizeof(s16);
+		} else if (mapWave(fileName, &sound.file, &wave, &sound.format)) {
+			// Read now, while there's time, rather than when it's played
+			sound.file.prefault(0, sound.file.size);
+
+			sound.samples = wave.samples;
+			sound.size = wave.size;
+		} else {
+			this->unplayable[(size_t)assetId] = true;
+			return nullptr;
+		}
+
+		this->residency.loaded(assetId, sound.size, this->frame);
+		return &sound;
+	}
+
+	// Reads at most one sound a frame, so the stall is a single file rather
+	// than all of them the moment a scene starts
+	void prefetchSounds(const SceneAssets &scene) {
+		SceneManifests::gatherSounds(scene, &this->soundPrefetches);
+
+		SoundAssetId wanted[(size_t)SoundAssetId::_length];
+		u32 wantedCount = 0;
+		u32 requiredCount = 0;
+		for (u32 i = 0; i < this->soundPrefetches.assets.length; i++) {
+			const SoundAssetId assetId = this->soundPrefetches.assets[i];
+			if (!this->unplayable[(size_t)assetId]) {
+				wanted[wantedCount++] = assetId;
+				requiredCount += i < this->soundPrefetches.requiredCount ? 1 : 0;
+			}
+		}
+
+		SoundAssetId evictions[(size_t)SoundAssetId::_length];
+		u32 evictionCount = this->residency.trim(wanted, wantedCount, requiredCount, this->frame, evictions);
+		this->evict(evictions, evictionCount);
+
+		SoundAssetId next;
+		if (this->residency.nextLoad(wanted, wantedCount, this->frame, &next, evictions, &evictionCount)) {
+			this->evict(evictions, evictionCount);
+			this->loadSound(next);
+		}
+	}
+
+	void evict(const SoundAssetId *assetIds, u32 count) {
+		for (u32 i = 0; i < count; i++) {
+			this->sounds[(size_t)assetIds[i]].release();
+			this->residency.evicted(assetIds[i]);
+		}
+	}
+};
\ No newline at end of file
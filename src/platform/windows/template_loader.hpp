@@ -2,16 +2,62 @@
 
 #include "common/asset_definitions.hpp"
 #include "common/game_state.hpp"
+#include "common/ship_template.hpp"
 #include "platform/windows/file_loader.hpp"
+#include "platform/windows/utils.hpp"
+
+template<typename T>
+void getTemplatePath(const TemplateData<T> &templateData, const wchar_t *extension, wchar_t *buffer, size_t size) {
+	swprintf_s(buffer, size, GET_ASSET_PATH("data/templates/%s%s"), templateData.fileName.data, extension);
+}
+
+// Uses the compiled cache when it was built from the current source and only
+// parses the source when it's stale or missing. `cachePath` can be null to
+// always parse.
+bool loadShipTemplate(const wchar_t *sourcePath, const wchar_t *cachePath, Ship *ship) {
+	char source[SHIP_TEMPLATE_SOURCE_MAX];
+	size_t sourceLength = 0;
+	if (!tryLoad(sourcePath, source, sizeof(source), &sourceLength)) {
+		LOG(L"Unable to read %s\n", sourcePath)
+		return false;
+	}
+
+	const u64 sourceHash = ShipTemplate::hashSource(source, sourceLength);
+
+	if (cachePath != nullptr) {
+		u8 cache[SHIP_TEMPLATE_CACHE_MAX];
+		size_t cacheSize = 0;
+		if (
+			tryLoad(cachePath, cache, sizeof(cache), &cacheSize) && 
+			ShipTemplate::readCache(cache, cacheSize, sourceHash, ship)
+		) {
+			return true;
+		}
+
+		LOG(L"Template cache %s is stale, parsing the source instead\n", cachePath)
+	}
+
+	ShipTemplateError error = {};
+	if (!ShipTemplate::parse(source, sourceLength, ship, &error)) {
+		LOG(L"%s(%u): %hs\n", sourcePath, error.line, error.message)
+		return false;
+	}
+	return true;
+}
 
 void loadTemplates(GameState *gameState) {
 	ShipTemplates &shipTemplates = gameState->templates.ships;
 	shipTemplates.push({ L"Ally Ship", L"ships/ship" });
 	shipTemplates.push({ L"Enemy Ship", L"ships/enemy_ship" });
+	shipTemplates.push({ L"Gunship", L"ships/gunship" });
 
-	wchar_t filePathBuffer[100];
+	wchar_t sourcePath[100];
+	wchar_t cachePath[100];
 	for (TemplateData<Ship> &shipTemplate : shipTemplates) {
-		swprintf_s(filePathBuffer, GET_ASSET_PATH("data/templates/%s"), shipTemplate.fileName.data);
-		load(filePathBuffer, &shipTemplate.data, sizeof(Ship));
+		getTemplatePath(shipTemplate, SHIP_TEMPLATE_SOURCE_EXTENSION, sourcePath, 100);
+		getTemplatePath(shipTemplate, SHIP_TEMPLATE_CACHE_EXTENSION, cachePath, 100);
+
+		const bool loaded = loadShipTemplate(sourcePath, cachePath, &shipTemplate.data);
+		assert(loaded);
 	}
 }
\ No newline at end of file
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstring>
+#include <wchar.h>
+
+#include "renderer/bitmap_font.hpp"
+#include "types/core.hpp"
+
+#define GLYPH_ATLAS_GLYPH_COUNT (BITMAP_FONT_LAST - BITMAP_FONT_FIRST + 1)
+#define GLYPH_ATLAS_COLUMNS 16
+#define GLYPH_ATLAS_ROWS ((GLYPH_ATLAS_GLYPH_COUNT + GLYPH_ATLAS_COLUMNS - 1) / GLYPH_ATLAS_COLUMNS)
+#define GLYPH_ATLAS_WIDTH (GLYPH_ATLAS_COLUMNS * BITMAP_FONT_GLYPH_WIDTH)
+#define GLYPH_ATLAS_HEIGHT (GLYPH_ATLAS_ROWS * BITMAP_FONT_GLYPH_HEIGHT)
+
+// Top left texel of a glyph in the atlas
+struct GlyphAtlasOrigin {
+	u16 x;
+	u16 y;
+};
+
+// Every `BitmapFont` glyph rasterised once into a coverage texture, so drawing
+// text samples texels rather than unpacking the font's bits for every pixel.
+// Glyphs sit on a grid with no gap between them, whatever samples the atlas
+// has to stay within the glyph it's drawing.
+//
+// Example:
+//
+//     GlyphAtlas atlas;
+//     atlas.build();
+//
+//     const GlyphAtlasOrigin origin = GlyphAtlas::origin(L'A');
+//     const u8 coverage = atlas.texel(origin.x + 2, origin.y + 3);
+//
+struct GlyphAtlas {
+	// 0 to 255, with the top row first
+	u8 texels[GLYPH_ATLAS_WIDTH * GLYPH_ATLAS_HEIGHT];
+
+	void build() {
+		memset(this->texels, 0, sizeof(this->texels));
+
+		for (u32 i = 0; i < GLYPH_ATLAS_GLYPH_COUNT; i++) {
+			const wchar_t character = (wchar_t)(BITMAP_FONT_FIRST + i);
+			const u8 *glyph = BitmapFont::glyph(character);
+			const GlyphAtlasOrigin glyphOrigin = origin(character);
+
+			for (u32 y = 0; y < BITMAP_FONT_GLYPH_HEIGHT; y++) {
+				u8 *row = &this->texels[(glyphOrigin.y + y) * GLYPH_ATLAS_WIDTH + glyphOrigin.x];
+				for (u32 x = 0; x < BITMAP_FONT_GLYPH_WIDTH; x++) {
+					row[x] = BitmapFont::isSet(glyph, x, y) ? 255 : 0;
+				}
+			}
+		}
+	}
+
+	u8 texel(u32 x, u32 y) const {
+		return this->texels[y * GLYPH_ATLAS_WIDTH + x];
+	}
+
+	// Characters the font doesn't have get the '?' glyph like `BitmapFont`
+	static GlyphAtlasOrigin origin(wchar_t character) {
+		if (character < BITMAP_FONT_FIRST || character > BITMAP_FONT_LAST) {
+			character = L'?';
+		}
+
+		const u32 index = (u32)(character - BITMAP_FONT_FIRST);
+		GlyphAtlasOrigin result;
+		result.x = (u16)(index % GLYPH_ATLAS_COLUMNS * BITMAP_FONT_GLYPH_WIDTH);
+		result.y = (u16)(index / GLYPH_ATLAS_COLUMNS * BITMAP_FONT_GLYPH_HEIGHT);
+		return result;
+	}
+};
\ No newline at end of file
@@ -0,0 +1,1147 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <wchar.h>
+
+#include "common/asset_definitions.hpp"
+#include "common/culling.hpp"
+#include "common/sprite.hpp"
+#include "common/text_run_cache.hpp"
+#include "common/ui_element.hpp"
+#include "common/window_config.hpp"
+#include "renderer/bitmap_font.hpp"
+#include "renderer/glyph_atlas.hpp"
+#include "types/core.hpp"
+#include "types/matrix.hpp"
+#include "types/simd.hpp"
+#include "types/vector.hpp"
+#include "utils/memory.hpp"
+#include "utils/profiler.hpp"
+#include "utils/thread.hpp"
+
+#define SOFTWARE_TILE_SIZE 64
+#define SOFTWARE_THREAD_MAX 16
+#define SOFTWARE_COMMAND_MAX 1024
+#define SOFTWARE_TEXT_LINE_MAX 16
+#define SOFTWARE_TEXT_GLYPH_MAX 100
+#define SOFTWARE_GLYPH_QUAD_MAX 8192
+
+// Font pixels per line and per character, the glyph is drawn `GLYPH_TOP`
+// font pixels down from the top of its line
+#define SOFTWARE_TEXT_LINE_HEIGHT 12
+#define SOFTWARE_TEXT_ADVANCE 6
+#define SOFTWARE_TEXT_GLYPH_TOP 2
+
+struct SoftwareTexture {
+	u32 width;
+	u32 height;
+	// RGBA8 with the top row first, like the decoded images
+	u32 *pixels;
+};
+
+static_assert(
+	sizeof(UITextData::text) / sizeof(wchar_t) <= SOFTWARE_TEXT_GLYPH_MAX,
+	"A text run doesn't have room for every character"
+);
+
+struct SoftwareTextGlyph {
+	// Top left of the glyph relative to the top left of the text box
+	f32 x, y;
+	GlyphAtlasOrigin origin;
+};
+
+// Text that's been wrapped, aligned and turned into glyphs, which only
+// depends on what's in `TextRunKey` so it's kept in the text run cache
+struct SoftwareTextRun {
+	// Size of one font pixel, the font size is ten of them
+	f32 unit;
+	// Around every glyph relative to the top left of the text box
+	f32 minX, minY, maxX, maxY;
+	u32 glyphCount;
+	SoftwareTextGlyph glyphs[SOFTWARE_TEXT_GLYPH_MAX];
+};
+
+// One glyph of a run placed on the framebuffer for this frame
+struct SoftwareGlyphQuad {
+	// Top left in framebuffer pixels
+	f32 x, y;
+	GlyphAtlasOrigin origin;
+};
+
+// A run's quads, atlas texels per framebuffer pixel are the same for all of
+// them
+struct SoftwareTextCommand {
+	u32 firstQuad;
+	u32 quadCount;
+	f32 texelsPerPixelX;
+	f32 texelsPerPixelY;
+	Rgba color;
+};
+
+// A sprite's texel coordinates are affine in screen space, so they're kept as
+// the coordinates at the framebuffer origin and how much they step per pixel.
+struct SoftwareSpriteCommand {
+	const SoftwareTexture *texture;
+	f32 u, dudx, dudy;
+	f32 v, dvdx, dvdy;
+	u16 depth;
+};
+
+enum class SoftwareCommandType : u8 {
+	starfield,
+	sprite,
+	text,
+	ui
+};
+
+struct SoftwareCommand {
+	SoftwareCommandType type;
+	// Framebuffer pixels the command can touch, the max is exclusive
+	s32 minX, minY, maxX, maxY;
+	SoftwareSpriteCommand sprite;
+	SoftwareTextCommand text;
+	UIElement element;
+};
+
+// Draws the same things as `DirectXRenderer` into an RGBA8 framebuffer on the
+// CPU, so frames can be diffed and benchmarked on machines without Direct3D.
+// The draw calls only record commands, `finish` splits the framebuffer into
+// tiles that the worker threads and the calling thread take turns drawing.
+// Every tile runs through the commands in order so blending comes out the same
+// as drawing them one after the other.
+//
+// Follows what the GPU path does where it's visible: sprites are depth tested
+// (less or equal, 16 bit) against the starfield at depth zero, sampled
+// bilinearly with mirrored addressing and blended by source alpha. UI is
+// antialiased by coverage and text uses `BitmapFont` in place of DirectWrite.
+//
+// Text is wrapped and aligned into a run of glyphs once and kept in the text
+// run cache, so labels that don't change aren't laid out again every frame.
+// Each frame a run's glyphs are placed as quads, which the tiles draw from a
+// `GlyphAtlas` the font is rasterised into up front.
+//
+// Example:
+//
+//     SoftwareRenderer *renderer = Memory::create<SoftwareRenderer>(MemoryTag::renderer);
+//     renderer->initialise(screenWidth, screenHeight, 4);
+//     renderer->setTexture(TextureAssetId::ship, width, height, pixels);
+//
+//     renderer->start();
+//     renderer->drawStarfield();
+//     renderer->drawSprites(sprites.data, sprites.length);
+//     renderer->drawUI(uiElements.data, uiElements.length);
+//     renderer->finish();
+//
+//     const u32 *pixels = renderer->getPixels();
+//
+class SoftwareRenderer {
+protected:
+	u32 width = 0;
+	u32 height = 0;
+	// Framebuffer pixels per screen pixel, the game always works in screen
+	// pixels so a smaller framebuffer is just scaled down
+	f32 scaleX;
+	f32 scaleY;
+
+	u32 *colorBuffer = nullptr;
+	u16 *depthBuffer = nullptr;
+
+	// The starfield doesn't change so each tile shades it once and copies it
+	// from then on
+	u32 *starfieldBuffer = nullptr;
+	bool *starfieldTiles = nullptr;
+
+	SoftwareTexture textures[(size_t)TextureAssetId::_length] = {};
+
+	SoftwareCommand *commands = nullptr;
+	u32 commandCount = 0;
+
+	GlyphAtlas glyphAtlas;
+	TextRunCache<SoftwareTextRun, 128> textRunCache;
+	SoftwareGlyphQuad *glyphQuads = nullptr;
+	u32 glyphQuadCount = 0;
+
+	u32 tileColumns;
+	u32 tileCount;
+	std::atomic<u32> nextTile;
+
+	Thread threads[SOFTWARE_THREAD_MAX];
+	u32 workerCount = 0;
+	Mutex mutex;
+	ConditionVariable condition;
+	u64 frame = 0;
+	u32 workersDone = 0;
+	bool stopping = false;
+
+public:
+	~SoftwareRenderer() {
+		{
+			ScopedLock lock(&this->mutex);
+			this->stopping = true;
+			this->condition.notifyAll();
+		}
+
+		for (u32 i = 0; i < this->workerCount; i++) {
+			this->threads[i].join();
+		}
+
+		for (SoftwareTexture &texture : this->textures) {
+			Memory::release(texture.pixels);
+		}
+
+		Memory::release(this->colorBuffer);
+		Memory::release(this->depthBuffer);
+		Memory::release(this->starfieldBuffer);
+		Memory::release(this->starfieldTiles);
+		Memory::release(this->commands);
+		Memory::release(this->glyphQuads);
+	}
+
+	// `threadCount` includes the thread calling `finish`
+	void initialise(u32 width, u32 height, u32 threadCount) {
+		assert(this->colorBuffer == nullptr);
+		assert(width > 0 && height > 0);
+		assert(threadCount > 0 && threadCount <= SOFTWARE_THREAD_MAX);
+
+		this->width = width;
+		this->height = height;
+		this->scaleX = (f32)width / screenWidth;
+		this->scaleY = (f32)height / screenHeight;
+
+		const size_t pixelCount = (size_t)width * height;
+		this->colorBuffer = Memory::allocateArray<u32>(MemoryTag::renderer, pixelCount);
+		this->depthBuffer = Memory::allocateArray<u16>(MemoryTag::renderer, pixelCount);
+		this->starfieldBuffer = Memory::allocateArray<u32>(MemoryTag::renderer, pixelCount);
+
+		this->tileColumns = (width + SOFTWARE_TILE_SIZE - 1) / SOFTWARE_TILE_SIZE;
+		this->tileCount = this->tileColumns * ((height + SOFTWARE_TILE_SIZE - 1) / SOFTWARE_TILE_SIZE);
+		this->starfieldTiles = Memory::allocateArray<bool>(MemoryTag::renderer, this->tileCount);
+		memset(this->starfieldTiles, 0, this->tileCount * sizeof(bool));
+
+		this->commands = Memory::allocateArray<SoftwareCommand>(MemoryTag::renderer, SOFTWARE_COMMAND_MAX);
+		this->glyphQuads = Memory::allocateArray<SoftwareGlyphQuad>(MemoryTag::renderer, SOFTWARE_GLYPH_QUAD_MAX);
+		this->glyphAtlas.build();
+
+		// Tiles nobody else takes are drawn by the thread calling `finish`, so
+		// fewer workers than asked for only makes it slower
+		this->workerCount = 0;
+		while (this->workerCount < threadCount - 1 && this->threads[this->workerCount].start(workerMain, this)) {
+			this->workerCount++;
+		}
+	}
+
+	// Takes a copy of `pixels`, stands in for the texture loader
+	void setTexture(TextureAssetId assetId, u32 width, u32 height, const u32 *pixels) {
+		SoftwareTexture &texture = this->textures[(size_t)assetId];
+		Memory::release(texture.pixels);
+
+		texture.width = width;
+		texture.height = height;
+		texture.pixels = Memory::allocateArray<u32>(MemoryTag::textures, (size_t)width * height);
+		memcpy(texture.pixels, pixels, (size_t)width * height * sizeof(u32));
+	}
+
+	void start() {
+		this->commandCount = 0;
+		this->glyphQuadCount = 0;
+	}
+
+	void drawStarfield() {
+		SoftwareCommand *command = this->pushCommand(SoftwareCommandType::starfield);
+		if (command == nullptr) {
+			return;
+		}
+
+		command->minX = 0;
+		command->minY = 0;
+		command->maxX = (s32)this->width;
+		command->maxY = (s32)this->height;
+	}
+
+	void drawSprites(const Sprite *sprites, u32 bufferLength) {
+		PROFILE_ZONE("SoftwareRenderer::drawSprites");
+
+		for (u32 i = 0; i < bufferLength; i++) {
+			const Sprite &sprite = sprites[i];
+			const SoftwareTexture &texture = this->textures[(size_t)sprite.assetId];
+
+			// Outside of the depth range the GPU clips the whole quad
+			if (texture.pixels == nullptr || sprite.position.z < 0.0f || sprite.position.z > 1.0f) {
+				continue;
+			}
+
+			// Same transform as the sprite shader, flattened to 2D and taken
+			// through to framebuffer pixels with y pointing down
+			const Mat4 transform = Mat4::trs(sprite.position, -sprite.angle * (f32)M_PI / 180.0f, sprite.scale);
+			const Vec4 *columns = transform.columns;
+			const f32 m00 = this->scaleX * columns[0].x;
+			const f32 m01 = this->scaleX * columns[1].x;
+			const f32 m10 = -this->scaleY * columns[0].y;
+			const f32 m11 = -this->scaleY * columns[1].y;
+			const f32 offsetX = this->scaleX * (columns[3].x + screenWidth * 0.5f);
+			const f32 offsetY = this->scaleY * (screenHeight * 0.5f - columns[3].y);
+
+			const f32 determinant = m00 * m11 - m01 * m10;
+			if (fabsf(determinant) < 1e-12f) {
+				continue;
+			}
+
+			const f32 halfWidth = texture.width * 0.5f;
+			const f32 halfHeight = texture.height * 0.5f;
+
+			f32 minX = INFINITY, minY = INFINITY, maxX = -INFINITY, maxY = -INFINITY;
+			for (u32 corner = 0; corner < 4; corner++) {
+				const f32 x = corner & 1 ? halfWidth : -halfWidth;
+				const f32 y = corner & 2 ? halfHeight : -halfHeight;
+				const f32 screenX = m00 * x + m01 * y + offsetX;
+				const f32 screenY = m10 * x + m11 * y + offsetY;
+				minX = fminf(minX, screenX);
+				minY = fminf(minY, screenY);
+				maxX = fmaxf(maxX, screenX);
+				maxY = fmaxf(maxY, screenY);
+			}
+
+			if (!this->clipBounds(minX, minY, maxX, maxY)) {
+				continue;
+			}
+
+			SoftwareCommand *command = this->pushCommand(SoftwareCommandType::sprite);
+			if (command == nullptr) {
+				return;
+			}
+			this->setBounds(command, minX, minY, maxX, maxY);
+
+			// Screen pixel back to the sprite's local position, then to texel
+			// coordinates with texel centers on whole numbers
+			const f32 i00 = m11 / determinant;
+			const f32 i01 = -m01 / determinant;
+			const f32 i10 = -m10 / determinant;
+			const f32 i11 = m00 / determinant;
+
+			SoftwareSpriteCommand &spriteCommand = command->sprite;
+			spriteCommand.texture = &texture;
+			spriteCommand.dudx = i00;
+			spriteCommand.dudy = i01;
+			spriteCommand.u = halfWidth - 0.5f - (i00 * offsetX + i01 * offsetY);
+			spriteCommand.dvdx = -i10;
+			spriteCommand.dvdy = -i11;
+			spriteCommand.v = halfHeight - 0.5f + (i10 * offsetX + i11 * offsetY);
+			spriteCommand.depth = (u16)(sprite.position.z * 65535.0f + 0.5f);
+		}
+	}
+
+	void drawUI(const UIElement *uiElementBuffer, u32 bufferLength) {
+		PROFILE_ZONE("SoftwareRenderer::drawUI");
+
+		for (u32 i = 0; i < bufferLength; i++) {
+			const UIElement &element = uiElementBuffer[i];
+			if (element.type == UIType::text) {
+				if (!this->drawText(element.text)) {
+					break;
+				}
+				continue;
+			}
+
+			// Screen pixels to framebuffer pixels with a pixel either side for
+			// the antialiasing
+			const CullBounds bounds = Culling::elementBounds(element);
+			const f32 minX = bounds.min.x * this->scaleX - 1.0f;
+			const f32 minY = bounds.min.y * this->scaleY - 1.0f;
+			const f32 maxX = bounds.max.x * this->scaleX + 1.0f;
+			const f32 maxY = bounds.max.y * this->scaleY + 1.0f;
+			if (!this->clipBounds(minX, minY, maxX, maxY)) {
+				continue;
+			}
+
+			SoftwareCommand *command = this->pushCommand(SoftwareCommandType::ui);
+			if (command == nullptr) {
+				break;
+			}
+			this->setBounds(command, minX, minY, maxX, maxY);
+			command->element = element;
+		}
+
+		this->textRunCache.endFrame();
+	}
+
+	void finish() {
+		PROFILE_ZONE("SoftwareRenderer::finish");
+
+		this->nextTile = 0;
+		{
+			ScopedLock lock(&this->mutex);
+			this->frame++;
+			this->workersDone = 0;
+			this->condition.notifyAll();
+		}
+
+		this->drawTiles();
+
+		ScopedLock lock(&this->mutex);
+		while (this->workersDone < this->workerCount) {
+			this->condition.wait(&this->mutex);
+		}
+	}
+
+	const TextRunCacheStats &getTextRunStats() const {
+		return this->textRunCache.lastFrameStats;
+	}
+
+	// Glyphs placed since `start`
+	u32 getGlyphQuadCount() const {
+		return this->glyphQuadCount;
+	}
+
+	// RGBA8 with the top row first, valid until the next `finish`
+	const u32 *getPixels() const {
+		return this->colorBuffer;
+	}
+
+	u32 getWidth() const {
+		return this->width;
+	}
+
+	u32 getHeight() const {
+		return this->height;
+	}
+
+protected:
+	static void workerMain(void *argument) {
+		SoftwareRenderer *renderer = (SoftwareRenderer*)argument;
+		u64 frame = 0;
+
+		while (true) {
+			{
+				ScopedLock lock(&renderer->mutex);
+				while (renderer->frame == frame && !renderer->stopping) {
+					renderer->condition.wait(&renderer->mutex);
+				}
+
+				if (renderer->stopping) {
+					return;
+				}
+				frame = renderer->frame;
+			}
+
+			renderer->drawTiles();
+
+			ScopedLock lock(&renderer->mutex);
+			renderer->workersDone++;
+			renderer->condition.notifyAll();
+		}
+	}
+
+	SoftwareCommand *pushCommand(SoftwareCommandType type) {
+		if (this->commandCount == SOFTWARE_COMMAND_MAX) {
+			assert(false && "SoftwareRenderer ran out of commands");
+			return nullptr;
+		}
+
+		SoftwareCommand *command = &this->commands[this->commandCount++];
+		command->type = type;
+		return command;
+	}
+
+	bool clipBounds(f32 minX, f32 minY, f32 maxX, f32 maxY) const {
+		return maxX > 0.0f && maxY > 0.0f && minX < (f32)this->width && minY < (f32)this->height;
+	}
+
+	void setBounds(SoftwareCommand *command, f32 minX, f32 minY, f32 maxX, f32 maxY) const {
+		command->minX = (s32)fmaxf(floorf(minX), 0.0f);
+		command->minY = (s32)fmaxf(floorf(minY), 0.0f);
+		command->maxX = (s32)fminf(ceilf(maxX), (f32)this->width);
+		command->maxY = (s32)fminf(ceilf(maxY), (f32)this->height);
+	}
+
+	// Fetches the text's run from the cache, laying it out on a miss, and
+	// places its glyphs. False once there's no room left for them.
+	bool drawText(const UITextData &text) {
+		bool miss;
+		SoftwareTextRun *run = this->textRunCache.fetch(TextRunKey(text), &miss);
+		if (miss) {
+			this->createTextRun(text, run);
+		}
+
+		if (run->glyphCount == 0) {
+			return true;
+		}
+
+		const f32 minX = (text.position.x + run->minX) * this->scaleX;
+		const f32 minY = (text.position.y + run->minY) * this->scaleY;
+		const f32 maxX = (text.position.x + run->maxX) * this->scaleX;
+		const f32 maxY = (text.position.y + run->maxY) * this->scaleY;
+		if (!this->clipBounds(minX, minY, maxX, maxY)) {
+			return true;
+		}
+
+		if (this->glyphQuadCount + run->glyphCount > SOFTWARE_GLYPH_QUAD_MAX) {
+			assert(false && "SoftwareRenderer ran out of glyph quads");
+			return false;
+		}
+
+		SoftwareCommand *command = this->pushCommand(SoftwareCommandType::text);
+		if (command == nullptr) {
+			return false;
+		}
+		this->setBounds(command, minX, minY, maxX, maxY);
+
+		SoftwareTextCommand &textCommand = command->text;
+		textCommand.firstQuad = this->glyphQuadCount;
+		textCommand.quadCount = run->glyphCount;
+		textCommand.texelsPerPixelX = 1.0f / (run->unit * this->scaleX);
+		textCommand.texelsPerPixelY = 1.0f / (run->unit * this->scaleY);
+		textCommand.color = text.color;
+
+		for (u32 i = 0; i < run->glyphCount; i++) {
+			const SoftwareTextGlyph &glyph = run->glyphs[i];
+			SoftwareGlyphQuad &quad = this->glyphQuads[this->glyphQuadCount++];
+			quad.x = (text.position.x + glyph.x) * this->scaleX;
+			quad.y = (text.position.y + glyph.y) * this->scaleY;
+			quad.origin = glyph.origin;
+		}
+
+		return true;
+	}
+
+	void createTextRun(const UITextData &text, SoftwareTextRun *run) const {
+		PROFILE_ZONE("SoftwareRenderer::createTextRun");
+
+		run->unit = text.fontSize * 0.1f;
+		run->minX = INFINITY;
+		run->minY = INFINITY;
+		run->maxX = -INFINITY;
+		run->maxY = -INFINITY;
+		run->glyphCount = 0;
+
+		const f32 advance = SOFTWARE_TEXT_ADVANCE * run->unit;
+		const f32 lineHeight = SOFTWARE_TEXT_LINE_HEIGHT * run->unit;
+		const wchar_t *characters = text.text.data;
+		const u32 length = (u32)wcslen(characters);
+
+		// Greedy word wrap like DirectWrite, a word too long for the box is
+		// left to overflow it
+		u32 lineCount = 0;
+		u32 start = 0;
+		while (start <= length && lineCount < SOFTWARE_TEXT_LINE_MAX) {
+			u32 end = start;
+			u32 lastBreak = start;
+			while (end < length && characters[end] != L'\n') {
+				if (characters[end] == L' ') {
+					lastBreak = end;
+				}
+
+				if ((end - start + 1) * advance > text.width && lastBreak > start) {
+					end = lastBreak;
+					break;
+				}
+				end++;
+			}
+
+			const f32 lineWidth = (end - start) * advance;
+			f32 lineX = 0.0f;
+			if (text.horizontalAlignment == UITextAlignment::middle) {
+				lineX = (text.width - lineWidth) * 0.5f;
+			} else if (text.horizontalAlignment == UITextAlignment::end) {
+				lineX = text.width - lineWidth;
+			}
+
+			// Lines are placed from the top for now and moved down once it's
+			// known how many there are
+			for (u32 i = start; i < end; i++) {
+				if (characters[i] == L' ') {
+					continue;
+				}
+
+				SoftwareTextGlyph &glyph = run->glyphs[run->glyphCount++];
+				glyph.x = lineX + (i - start) * advance;
+				glyph.y = lineCount * lineHeight + SOFTWARE_TEXT_GLYPH_TOP * run->unit;
+				glyph.origin = GlyphAtlas::origin(characters[i]);
+			}
+			lineCount++;
+
+			// Skip the space or newline the line was broken on
+			start = end + 1;
+		}
+
+		const f32 textHeight = lineCount * lineHeight;
+		f32 offsetY = 0.0f;
+		if (text.verticalAlignment == UITextAlignment::middle) {
+			offsetY = (text.height - textHeight) * 0.5f;
+		} else if (text.verticalAlignment == UITextAlignment::end) {
+			offsetY = text.height - textHeight;
+		}
+
+		for (u32 i = 0; i < run->glyphCount; i++) {
+			SoftwareTextGlyph &glyph = run->glyphs[i];
+			glyph.y += offsetY;
+
+			run->minX = fminf(run->minX, glyph.x);
+			run->minY = fminf(run->minY, glyph.y);
+			run->maxX = fmaxf(run->maxX, glyph.x + BITMAP_FONT_GLYPH_WIDTH * run->unit);
+			run->maxY = fmaxf(run->maxY, glyph.y + BITMAP_FONT_GLYPH_HEIGHT * run->unit);
+		}
+	}
+
+	void drawTiles() {
+		PROFILE_ZONE("SoftwareRenderer::drawTiles");
+
+		u32 tile;
+		while ((tile = this->nextTile++) < this->tileCount) {
+			this->drawTile(tile);
+		}
+	}
+
+	void drawTile(u32 tile) {
+		const s32 tileMinX = (s32)(tile % this->tileColumns) * SOFTWARE_TILE_SIZE;
+		const s32 tileMinY = (s32)(tile / this->tileColumns) * SOFTWARE_TILE_SIZE;
+		const s32 tileMaxX = tileMinX + SOFTWARE_TILE_SIZE < (s32)this->width ? tileMinX + SOFTWARE_TILE_SIZE : (s32)this->width;
+		const s32 tileMaxY = tileMinY + SOFTWARE_TILE_SIZE < (s32)this->height ? tileMinY + SOFTWARE_TILE_SIZE : (s32)this->height;
+
+		// Same clear colour as the DirectX renderer
+		const u32 clearColor = packColor(0.0f, 0.2f * 255.0f, 0.4f * 255.0f, 255.0f);
+		for (s32 y = tileMinY; y < tileMaxY; y++) {
+			u32 *colors = &this->colorBuffer[(size_t)y * this->width];
+			u16 *depths = &this->depthBuffer[(size_t)y * this->width];
+			for (s32 x = tileMinX; x < tileMaxX; x++) {
+				colors[x] = clearColor;
+				depths[x] = 0xffff;
+			}
+		}
+
+		for (u32 i = 0; i < this->commandCount; i++) {
+			const SoftwareCommand &command = this->commands[i];
+			const s32 minX = command.minX > tileMinX ? command.minX : tileMinX;
+			const s32 minY = command.minY > tileMinY ? command.minY : tileMinY;
+			const s32 maxX = command.maxX < tileMaxX ? command.maxX : tileMaxX;
+			const s32 maxY = command.maxY < tileMaxY ? command.maxY : tileMaxY;
+			if (minX >= maxX || minY >= maxY) {
+				continue;
+			}
+
+			switch (command.type) {
+				case SoftwareCommandType::starfield: {
+					this->drawStarfieldTile(tile, minX, minY, maxX, maxY);
+				} break;
+
+				case SoftwareCommandType::sprite: {
+					this->drawSprite(command.sprite, minX, minY, maxX, maxY);
+				} break;
+
+				case SoftwareCommandType::text: {
+					this->drawGlyphs(command.text, minX, minY, maxX, maxY);
+				} break;
+
+				case SoftwareCommandType::ui: {
+					this->drawElement(command, minX, minY, maxX, maxY);
+				} break;
+
+				default: {
+					assert(false);
+				} break;
+			}
+		}
+	}
+
+	void drawStarfieldTile(u32 tile, s32 minX, s32 minY, s32 maxX, s32 maxY) {
+		if (!this->starfieldTiles[tile]) {
+			// NOTE: The starfield always covers whole tiles so the cache is
+			// filled for the entire tile the first time it's drawn.
+			for (s32 y = minY; y < maxY; y++) {
+				u32 *stars = &this->starfieldBuffer[(size_t)y * this->width];
+				for (s32 x = minX; x < maxX; x++) {
+					const f32 brightness = fminf(starfield((x + 0.5f) / this->scaleX, (y + 0.5f) / this->scaleY), 1.0f) * 255.0f;
+					stars[x] = packColor(brightness, brightness, brightness, 255.0f);
+				}
+			}
+			this->starfieldTiles[tile] = true;
+		}
+
+		// Drawn at depth zero so only sprites at zero show up in front of it
+		for (s32 y = minY; y < maxY; y++) {
+			const size_t row = (size_t)y * this->width;
+			memcpy(&this->colorBuffer[row + minX], &this->starfieldBuffer[row + minX], (maxX - minX) * sizeof(u32));
+			memset(&this->depthBuffer[row + minX], 0, (maxX - minX) * sizeof(u16));
+		}
+	}
+
+	void drawSprite(const SoftwareSpriteCommand &sprite, s32 minX, s32 minY, s32 maxX, s32 maxY) {
+		const SoftwareTexture *texture = sprite.texture;
+		const f32 maxU = texture->width - 0.5f;
+		const f32 maxV = texture->height - 0.5f;
+
+		for (s32 y = minY; y < maxY; y++) {
+			const f32 rowU = sprite.u + sprite.dudy * (y + 0.5f);
+			const f32 rowV = sprite.v + sprite.dvdy * (y + 0.5f);
+
+			// Narrow the row down to where the pixel centers land inside the
+			// texture rather than testing every pixel of a rotated sprite's
+			// bounding box
+			f32 spanMin = (f32)minX;
+			f32 spanMax = (f32)maxX;
+			spanRange(rowU, sprite.dudx, -0.5f, maxU, &spanMin, &spanMax);
+			spanRange(rowV, sprite.dvdx, -0.5f, maxV, &spanMin, &spanMax);
+			if (spanMin >= spanMax) {
+				continue;
+			}
+
+			const s32 startX = (s32)ceilf(spanMin);
+			const s32 endX = (s32)ceilf(spanMax);
+			u32 *colors = &this->colorBuffer[(size_t)y * this->width];
+			u16 *depths = &this->depthBuffer[(size_t)y * this->width];
+
+			s32 x = startX;
+#ifdef USE_SSE
+			const __m128 laneOffsets = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+			const __m128 du = _mm_set1_ps(sprite.dudx);
+			const __m128 dv = _mm_set1_ps(sprite.dvdx);
+			for (; x + 4 <= endX; x += 4) {
+				const __m128 pixelX = _mm_add_ps(_mm_set1_ps((f32)x), laneOffsets);
+				alignas(16) f32 us[4];
+				alignas(16) f32 vs[4];
+				_mm_store_ps(us, _mm_add_ps(_mm_set1_ps(rowU), _mm_mul_ps(pixelX, du)));
+				_mm_store_ps(vs, _mm_add_ps(_mm_set1_ps(rowV), _mm_mul_ps(pixelX, dv)));
+
+				for (s32 lane = 0; lane < 4; lane++) {
+					if (sprite.depth <= depths[x + lane]) {
+						depths[x + lane] = sprite.depth;
+						colors[x + lane] = blendTexel(colors[x + lane], sampleBilinear(texture, us[lane], vs[lane]));
+					}
+				}
+			}
+#endif
+			for (; x < endX; x++) {
+				if (sprite.depth <= depths[x]) {
+					const f32 pixelX = x + 0.5f;
+					depths[x] = sprite.depth;
+					colors[x] = blendTexel(colors[x], sampleBilinear(texture, rowU + sprite.dudx * pixelX, rowV + sprite.dvdx * pixelX));
+				}
+			}
+		}
+	}
+
+	void drawElement(const SoftwareCommand &command, s32 minX, s32 minY, s32 maxX, s32 maxY) {
+		const UIElement &element = command.element;
+		const Rgba &fillColor = element.common.color;
+
+		for (s32 y = minY; y < maxY; y++) {
+			u32 *colors = &this->colorBuffer[(size_t)y * this->width];
+			// Pixel center in screen pixels
+			const f32 pointY = (y + 0.5f) / this->scaleY;
+
+			for (s32 x = minX; x < maxX; x++) {
+				const Vec2<f32> point((x + 0.5f) / this->scaleX, pointY);
+
+				switch (element.type) {
+					case UIType::line: {
+						const UILineData &line = element.line;
+						colors[x] = blendCoverage(colors[x], fillColor, this->coverage(lineDistance(line, point)));
+					} break;
+
+					case UIType::circle: {
+						const UICircleData &circle = element.circle;
+						const Vec2<f32> offset = point - circle.position;
+						const f32 distance = offset.magnitude() - circle.radius;
+						colors[x] = blendCoverage(colors[x], fillColor, this->coverage(distance));
+
+						f32 strokeDistance = fabsf(distance) - circle.strokeWidth * 0.5f;
+						if (circle.strokeStyle == UIStrokeStyle::dotted) {
+							// Around the circle from the right hand side
+							f32 angle = atan2f(offset.y, offset.x);
+							if (angle < 0.0f) {
+								angle += 2.0f * (f32)M_PI;
+							}
+							strokeDistance = fmaxf(strokeDistance, dashDistance(angle * circle.radius, circle.strokeWidth));
+						}
+						colors[x] = blendCoverage(colors[x], circle.strokeColor, this->coverage(strokeDistance));
+					} break;
+
+					case UIType::traingle: {
+						const f32 distance = triangleDistance(element.triangle.points.data, point);
+						colors[x] = blendCoverage(colors[x], fillColor, this->coverage(distance));
+					} break;
+
+					case UIType::rectangle: {
+						const UIRectangleData &rectangle = element.rectangle;
+
+						f32 perimeterPosition;
+						const f32 distance = roundedRectangleDistance(rectangle, point, &perimeterPosition);
+						colors[x] = blendCoverage(colors[x], fillColor, this->coverage(distance));
+
+						f32 strokeDistance = fabsf(distance) - rectangle.strokeWidth * 0.5f;
+						if (rectangle.strokeStyle == UIStrokeStyle::dotted) {
+							strokeDistance = fmaxf(strokeDistance, dashDistance(perimeterPosition, rectangle.strokeWidth));
+						}
+						colors[x] = blendCoverage(colors[x], rectangle.strokeColor, this->coverage(strokeDistance));
+					} break;
+
+					default: {
+						assert(false);
+					} break;
+				}
+			}
+		}
+	}
+
+	// How much of the pixel is covered by a shape the pixel center is
+	// `distance` screen pixels outside of
+	f32 coverage(f32 distance) const {
+		const f32 result = 0.5f - distance * this->scaleX;
+		return result < 0.0f ? 0.0f : result > 1.0f ? 1.0f : result;
+	}
+
+	// Each glyph's quad is box filtered from the atlas, the pixel's footprint
+	// is clipped to the glyph so neighbouring glyphs in the atlas aren't read
+	void drawGlyphs(const SoftwareTextCommand &text, s32 minX, s32 minY, s32 maxX, s32 maxY) {
+		const f32 texelsPerPixelX = text.texelsPerPixelX;
+		const f32 texelsPerPixelY = text.texelsPerPixelY;
+		const f32 quadWidth = BITMAP_FONT_GLYPH_WIDTH / texelsPerPixelX;
+		const f32 quadHeight = BITMAP_FONT_GLYPH_HEIGHT / texelsPerPixelY;
+		// Texel coverage is 0 to 255 and the sum is over the footprint's area
+		const f32 normalise = 1.0f / (255.0f * texelsPerPixelX * texelsPerPixelY);
+
+		for (u32 i = 0; i < text.quadCount; i++) {
+			const SoftwareGlyphQuad &quad = this->glyphQuads[text.firstQuad + i];
+			const s32 startX = (s32)fmaxf(floorf(quad.x), (f32)minX);
+			const s32 startY = (s32)fmaxf(floorf(quad.y), (f32)minY);
+			const s32 endX = (s32)fminf(ceilf(quad.x + quadWidth), (f32)maxX);
+			const s32 endY = (s32)fminf(ceilf(quad.y + quadHeight), (f32)maxY);
+
+			for (s32 y = startY; y < endY; y++) {
+				u32 *colors = &this->colorBuffer[(size_t)y * this->width];
+				const f32 top = fmaxf((y - quad.y) * texelsPerPixelY, 0.0f);
+				const f32 bottom = fminf((y + 1 - quad.y) * texelsPerPixelY, (f32)BITMAP_FONT_GLYPH_HEIGHT);
+
+				for (s32 x = startX; x < endX; x++) {
+					const f32 left = fmaxf((x - quad.x) * texelsPerPixelX, 0.0f);
+					const f32 right = fminf((x + 1 - quad.x) * texelsPerPixelX, (f32)BITMAP_FONT_GLYPH_WIDTH);
+
+					f32 covered = 0.0f;
+					for (s32 row = (s32)top; row < (s32)ceilf(bottom); row++) {
+						const f32 rowCovered = fminf(bottom, row + 1.0f) - fmaxf(top, (f32)row);
+						for (s32 column = (s32)left; column < (s32)ceilf(right); column++) {
+							const u8 texel = this->glyphAtlas.texel(quad.origin.x + column, quad.origin.y + row);
+							covered += texel * rowCovered * (fminf(right, column + 1.0f) - fmaxf(left, (f32)column));
+						}
+					}
+
+					if (covered > 0.0f) {
+						colors[x] = blendCoverage(colors[x], text.color, fminf(covered * normalise, 1.0f));
+					}
+				}
+			}
+		}
+	}
+
+	// Shrinks [min, max) to the pixels whose centers put `start + step * x`
+	// inside [low, high]
+	static void spanRange(f32 start, f32 step, f32 low, f32 high, f32 *min, f32 *max) {
+		if (step == 0.0f) {
+			if (start < low || start > high) {
+				*max = *min;
+			}
+			return;
+		}
+
+		f32 first = (low - start) / step - 0.5f;
+		f32 last = (high - start) / step - 0.5f;
+		if (step < 0.0f) {
+			const f32 swap = first;
+			first = last;
+			last = swap;
+		}
+
+		*min = fmaxf(*min, first);
+		*max = fminf(*max, last + 1e-4f);
+	}
+
+	static f32 lineDistance(const UILineData &line, const Vec2<f32> &point) {
+		const Vec2<f32> direction = line.end - line.start;
+		const f32 length = direction.magnitude();
+		if (length == 0.0f) {
+			return INFINITY;
+		}
+
+		// Flat caps, so it's a rectangle along the line
+		const Vec2<f32> offset = point - line.start;
+		const f32 along = offset.dot(direction) / length;
+		const f32 across = (offset.x * direction.y - offset.y * direction.x) / length;
+		return fmaxf(fabsf(along - length * 0.5f) - length * 0.5f, fabsf(across) - line.thickness * 0.5f);
+	}
+
+	static f32 triangleDistance(const Vec2<f32> *points, const Vec2<f32> &point) {
+		const f32 area =
+			(points[1].x - points[0].x) * (points[2].y - points[0].y) -
+			(points[1].y - points[0].y) * (points[2].x - points[0].x);
+		if (area == 0.0f) {
+			return INFINITY;
+		}
+
+		// Furthest outside of the three edges, positive when outside
+		f32 distance = -INFINITY;
+		for (u32 i = 0; i < 3; i++) {
+			const Vec2<f32> &start = points[i];
+			const Vec2<f32> edge = points[(i + 1) % 3] - start;
+			const f32 length = edge.magnitude();
+			if (length == 0.0f) {
+				continue;
+			}
+
+			const Vec2<f32> offset = point - start;
+			const f32 side = (edge.x * offset.y - edge.y * offset.x) / length;
+			distance = fmaxf(distance, area > 0.0f ? -side : side);
+		}
+
+		return distance;
+	}
+
+	// Also gives how far around the outline the closest point is, going
+	// clockwise from the top left end of the top edge
+	static f32 roundedRectangleDistance(const UIRectangleData &rectangle, const Vec2<f32> &point, f32 *perimeterPosition) {
+		const f32 halfWidth = rectangle.width * 0.5f;
+		const f32 halfHeight = rectangle.height * 0.5f;
+		const f32 radius = fminf(rectangle.cornerRadius, fminf(halfWidth, halfHeight));
+		const f32 innerX = halfWidth - radius;
+		const f32 innerY = halfHeight - radius;
+
+		const f32 x = point.x - (rectangle.position.x + halfWidth);
+		const f32 y = point.y - (rectangle.position.y + halfHeight);
+		const f32 qx = fabsf(x) - innerX;
+		const f32 qy = fabsf(y) - innerY;
+		const f32 outside = sqrtf(fmaxf(qx, 0.0f) * fmaxf(qx, 0.0f) + fmaxf(qy, 0.0f) * fmaxf(qy, 0.0f));
+		const f32 distance = outside + fminf(fmaxf(qx, qy), 0.0f) - radius;
+
+		const f32 arc = radius * (f32)M_PI * 0.5f;
+		const f32 top = 2.0f * innerX;
+		const f32 side = 2.0f * innerY;
+		if (qx > 0.0f && qy > 0.0f) {
+			const f32 angle = atan2f(y - (y < 0.0f ? -innerY : innerY), x - (x < 0.0f ? -innerX : innerX));
+			if (x >= 0.0f && y < 0.0f) {
+				*perimeterPosition = top + (angle + (f32)M_PI * 0.5f) * radius;
+			} else if (x >= 0.0f) {
+				*perimeterPosition = top + arc + side + angle * radius;
+			} else if (y >= 0.0f) {
+				*perimeterPosition = 2.0f * top + 2.0f * arc + side + (angle - (f32)M_PI * 0.5f) * radius;
+			} else {
+				*perimeterPosition = 2.0f * top + 3.0f * arc + 2.0f * side + (angle + (f32)M_PI) * radius;
+			}
+		} else if (qy >= qx) {
+			*perimeterPosition = y < 0.0f ? x + innerX : top + 2.0f * arc + side + innerX - x;
+		} else {
+			*perimeterPosition = x >= 0.0f ? top + arc + y + innerY : 2.0f * top + 3.0f * arc + side + innerY - y;
+		}
+
+		return distance;
+	}
+
+	// Direct2D's dash style, dashes and gaps twice the stroke width long with
+	// flat ends. Positive between the dashes.
+	static f32 dashDistance(f32 position, f32 strokeWidth) {
+		const f32 dash = 2.0f * strokeWidth;
+		if (dash <= 0.0f) {
+			return 0.0f;
+		}
+
+		const f32 t = fmodf(position, 2.0f * dash);
+		return t <= dash ? -fminf(t, dash - t) : fminf(t - dash, 2.0f * dash - t);
+	}
+
+	// Brightness of the starfield shader at a point in screen pixels
+	static f32 starfield(f32 x, f32 y) {
+		const f32 uvX = (x - 1920.0f * 0.5f) / 1080.0f * 50.0f;
+		const f32 uvY = (y - 1080.0f * 0.5f) / 1080.0f * 50.0f;
+
+		const f32 cellX = floorf(uvX);
+		const f32 cellY = floorf(uvY);
+		const f32 gridX = uvX - cellX - 0.5f;
+		const f32 gridY = uvY - cellY - 0.5f;
+
+		f32 color = 0.0f;
+		for (s32 offsetY = -1; offsetY <= 1; offsetY++) {
+			for (s32 offsetX = -1; offsetX <= 1; offsetX++) {
+				const f32 n = hash21((s32)cellX + offsetX, (s32)cellY + offsetY);
+				const f32 size = fraction(n * 345.567f);
+
+				const f32 starX = gridX - offsetX - n;
+				const f32 starY = gridY - offsetY - fraction(n * 10.0f);
+				color += star(starX, starY, smoothstep(0.6f, 1.0f, size)) * size;
+			}
+		}
+
+		return color;
+	}
+
+	static f32 star(f32 x, f32 y, f32 flare) {
+		const f32 distance = sqrtf(x * x + y * y);
+		f32 result = 0.05f / distance;
+		result += fmaxf(0.0f, 1.0f - fabsf(x * y * 1000.0f)) * flare;
+
+		// Rotated by a quarter turn
+		const f32 c = cosf(3.1415f / 4.0f);
+		const f32 s = sinf(3.1415f / 4.0f);
+		const f32 rotatedX = x * c + y * s;
+		const f32 rotatedY = -x * s + y * c;
+		result += fmaxf(0.0f, 1.0f - fabsf(rotatedX * rotatedY * 1000.0f)) * flare;
+
+		return result * smoothstep(0.5f, 0.2f, distance);
+	}
+
+	static f32 hash21(s32 x, s32 y) {
+		f32 resultX = fraction(x * 123.34f);
+		f32 resultY = fraction(y * 456.21f);
+		const f32 d = resultX * (resultX + 45.32f) + resultY * (resultY + 45.32f);
+		resultX += d;
+		resultY += d;
+		return fraction(resultX * resultY);
+	}
+
+	static f32 fraction(f32 x) {
+		return x - floorf(x);
+	}
+
+	static f32 smoothstep(f32 edge0, f32 edge1, f32 x) {
+		f32 t = (x - edge0) / (edge1 - edge0);
+		t = t < 0.0f ? 0.0f : t > 1.0f ? 1.0f : t;
+		return t * t * (3.0f - 2.0f * t);
+	}
+
+	static u32 mirror(s32 i, s32 size) {
+		if (i < 0) {
+			i = -i - 1;
+		}
+		if (i >= size) {
+			i = 2 * size - 1 - i;
+		}
+		return (u32)(i < 0 ? 0 : i >= size ? size - 1 : i);
+	}
+
+	// Channels are 0-255
+	static u32 packColor(f32 r, f32 g, f32 b, f32 a) {
+		return
+			(u32)(r + 0.5f) |
+			(u32)(g + 0.5f) << 8 |
+			(u32)(b + 0.5f) << 16 |
+			(u32)(a + 0.5f) << 24;
+	}
+
+#ifdef USE_SSE
+	static __m128 unpack(u32 color) {
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i bytes = _mm_cvtsi32_si128((int)color);
+		return _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_unpacklo_epi8(bytes, zero), zero));
+	}
+
+	static u32 pack(__m128 color) {
+		__m128i packed = _mm_cvtps_epi32(color);
+		packed = _mm_packs_epi32(packed, packed);
+		packed = _mm_packus_epi16(packed, packed);
+		return (u32)_mm_cvtsi128_si32(packed);
+	}
+
+	static __m128 lerp(__m128 a, __m128 b, __m128 t) {
+		return _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), t));
+	}
+
+	// RGBA with channels 0-255
+	static __m128 sampleBilinear(const SoftwareTexture *texture, f32 u, f32 v) {
+		const f32 floorU = floorf(u);
+		const f32 floorV = floorf(v);
+		const s32 x = (s32)floorU;
+		const s32 y = (s32)floorV;
+		const s32 width = (s32)texture->width;
+		const s32 height = (s32)texture->height;
+
+		const u32 *row0 = &texture->pixels[(size_t)mirror(y, height) * width];
+		const u32 *row1 = &texture->pixels[(size_t)mirror(y + 1, height) * width];
+		const u32 x0 = mirror(x, width);
+		const u32 x1 = mirror(x + 1, width);
+
+		const __m128 tu = _mm_set1_ps(u - floorU);
+		const __m128 top = lerp(unpack(row0[x0]), unpack(row0[x1]), tu);
+		const __m128 bottom = lerp(unpack(row1[x0]), unpack(row1[x1]), tu);
+		return lerp(top, bottom, _mm_set1_ps(v - floorV));
+	}
+
+	// Source alpha blending for the colour, the alpha is replaced
+	static u32 blendTexel(u32 destination, __m128 texel) {
+		const __m128 alpha = _mm_shuffle_ps(texel, texel, _MM_SHUFFLE(3, 3, 3, 3));
+		__m128 result = lerp(unpack(destination), texel, _mm_mul_ps(alpha, _mm_set1_ps(1.0f / 255.0f)));
+
+		const __m128 alphaMask = _mm_castsi128_ps(_mm_set_epi32(-1, 0, 0, 0));
+		result = _mm_or_ps(_mm_and_ps(alphaMask, texel), _mm_andnot_ps(alphaMask, result));
+		return pack(result);
+	}
+
+	// Source over with straight alpha, how Direct2D composites a solid brush
+	static u32 blendCoverage(u32 destination, const Rgba &color, f32 coverage) {
+		const f32 alpha = color.a * coverage;
+		if (alpha <= 0.0f) {
+			return destination;
+		}
+
+		// Alpha blends towards fully opaque the same way the colour does
+		const __m128 source = _mm_mul_ps(_mm_set_ps(1.0f, color.b, color.g, color.r), _mm_set1_ps(255.0f));
+		return pack(lerp(unpack(destination), source, _mm_set1_ps(alpha)));
+	}
+#else
+	struct Texel {
+		f32 channels[4];
+	};
+
+	static Texel unpack(u32 color) {
+		Texel result;
+		for (u32 i = 0; i < 4; i++) {
+			result.channels[i] = (f32)((color >> (i * 8)) & 0xff);
+		}
+		return result;
+	}
+
+	static u32 pack(const Texel &texel) {
+		return packColor(texel.channels[0], texel.channels[1], texel.channels[2], texel.channels[3]);
+	}
+
+	static Texel lerp(const Texel &a, const Texel &b, f32 t) {
+		Texel result;
+		for (u32 i = 0; i < 4; i++) {
+			result.channels[i] = a.channels[i] + (b.channels[i] - a.channels[i]) * t;
+		}
+		return result;
+	}
+
+	static Texel sampleBilinear(const SoftwareTexture *texture, f32 u, f32 v) {
+		const f32 floorU = floorf(u);
+		const f32 floorV = floorf(v);
+		const s32 x = (s32)floorU;
+		const s32 y = (s32)floorV;
+		const s32 width = (s32)texture->width;
+		const s32 height = (s32)texture->height;
+
+		const u32 *row0 = &texture->pixels[(size_t)mirror(y, height) * width];
+		const u32 *row1 = &texture->pixels[(size_t)mirror(y + 1, height) * width];
+		const u32 x0 = mirror(x, width);
+		const u32 x1 = mirror(x + 1, width);
+
+		const Texel top = lerp(unpack(row0[x0]), unpack(row0[x1]), u - floorU);
+		const Texel bottom = lerp(unpack(row1[x0]), unpack(row1[x1]), u - floorU);
+		return lerp(top, bottom, v - floorV);
+	}
+
+	static u32 blendTexel(u32 destination, const Texel &texel) {
+		Texel result = lerp(unpack(destination), texel, texel.channels[3] / 255.0f);
+		result.channels[3] = texel.channels[3];
+		return pack(result);
+	}
+
+	static u32 blendCoverage(u32 destination, const Rgba &color, f32 coverage) {
+		const f32 alpha = color.a * coverage;
+		if (alpha <= 0.0f) {
+			return destination;
+		}
+
+		const Texel source = { { color.r * 255.0f, color.g * 255.0f, color.b * 255.0f, 255.0f } };
+		return pack(lerp(unpack(destination), source, alpha));
+	}
+#endif
+};
\ No newline at end of file
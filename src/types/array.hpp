@@ -23,6 +23,14 @@ struct Array {
 		return this->data;
 	}
 
+	const T *begin() const {
+		return this->data;
+	}
+
+	size_t capacity() const {
+		return Size;
+	}
+
 	void clear() {
 		this->length = 0;
 	}
@@ -31,6 +39,18 @@ struct Array {
 		return &this->data[this->length];
 	}
 
+	const T *end() const {
+		return &this->data[this->length];
+	}
+
+	// Only copies the part of `other` that's in use
+	void copyFrom(const Array<T, Size> &other) {
+		for (size_t i = 0; i < other.length; i++) {
+			this->data[i] = other.data[i];
+		}
+		this->length = other.length;
+	}
+
 	T pop() {
 		return this->data[--this->length];
 	}
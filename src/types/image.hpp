@@ -0,0 +1,11 @@
+#pragma once
+
+#include "types/core.hpp"
+
+// Pixels are 8-bit RGBA with red in the lowest byte, the same layout as
+// DXGI_FORMAT_R8G8B8A8_UNORM
+struct Image {
+	u32 width;
+	u32 height;
+	u32 *pixels;
+};
\ No newline at end of file
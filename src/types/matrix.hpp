@@ -1,5 +1,11 @@
 #pragma once
 
+#include <cmath>
+
+#include "types/core.hpp"
+#include "types/simd.hpp"
+#include "types/vector.hpp"
+
 template<typename T>
 struct Mat4x4 {
 	T x0; T y0; T z0; T w0;
@@ -7,27 +13,27 @@ struct Mat4x4 {
 	T x2; T y2; T z2; T w2;
 	T x3; T y3; T z3; T w3;
 
-	Mat4x4(
+	constexpr Mat4x4(
 		T x0 = 1, T x1 = 0, T x2 = 0, T x3 = 0,
 		T y0 = 0, T y1 = 1, T y2 = 0, T y3 = 0,
 		T z0 = 0, T z1 = 0, T z2 = 1, T z3 = 0,
 		T w0 = 0, T w1 = 0, T w2 = 0, T w3 = 1
-	) {
-		this->x0 = x0; this->x1 = x1; this->x2 = x2; this->x3 = x3;
-		this->y0 = y0; this->y1 = y1; this->y2 = y2; this->y3 = y3;
-		this->z0 = z0; this->z1 = z1; this->z2 = z2; this->z3 = z3;
-		this->w0 = w0; this->w1 = w1; this->w2 = w2; this->w3 = w3;
-	}
+	) : 
+		x0(x0), y0(y0), z0(z0), w0(w0),
+		x1(x1), y1(y1), z1(z1), w1(w1),
+		x2(x2), y2(y2), z2(z2), w2(w2),
+		x3(x3), y3(y3), z3(z3), w3(w3)
+	{}
 
-	Mat4x4<T> scale(T x = 1, T y = 1, T z = 1) const {
-		Mat4x4<f32> result = *this;
+	constexpr Mat4x4<T> scale(T x = 1, T y = 1, T z = 1) const {
+		Mat4x4<T> result = *this;
 		result.x0 *= x; result.y0 *= x; result.z0 *= x;
 		result.x1 *= y; result.y1 *= y; result.z1 *= y;
 		result.x2 *= z; result.y2 *= z; result.z2 *= z;
 		return result;
 	}
 
-	Mat4x4<T> translate(T x = 0, T y = 0, T z = 0) const {
+	constexpr Mat4x4<T> translate(T x = 0, T y = 0, T z = 0) const {
 		Mat4x4<T> result = *this;
 		result.x3 = result.x0 * x + result.x1 * y + result.x2 * z + result.x3; 
 		result.y3 = result.y0 * x + result.y1 * y + result.y2 * z + result.y3; 
@@ -36,25 +42,87 @@ struct Mat4x4 {
 	}
 
 	Mat4x4<T> rotate(T angle) const {
-		const T c = cos(angle);
-		const T s = sin(angle);
+		const T c = std::cos(angle);
+		const T s = std::sin(angle);
 
-		Mat4x4<T> rotate;
-		rotate.x0 = c;
-		rotate.y0 = s;
+		Mat4x4<T> result = *this;
+		result.x0 = this->x0 * c + this->x1 * s;
+		result.y0 = this->y0 * c + this->y1 * s;
+		result.z0 = this->z0 * c + this->z1 * s;
 
-		rotate.x1 = -s;
-		rotate.y1 = c;
+		result.x1 = this->x1 * c - this->x0 * s;
+		result.y1 = this->y1 * c - this->y0 * s;
+		result.z1 = this->z1 * c - this->z0 * s;
 
-		Mat4x4<T> result = *this;
-		result.x0 = this->x0 * rotate.x0 + this->x1 * rotate.y0;
-		result.y0 = this->y0 * rotate.x0 + this->y1 * rotate.y0;
-		result.z0 = this->z0 * rotate.x0 + this->z1 * rotate.y0;
+		return result;
+	}
+};
+
+// Column major like `Mat4x4` (and HLSL's default packing) but stored as four
+// aligned `Vec4` columns so products are done four lanes at a time.
+struct alignas(16) Mat4 {
+	Vec4 columns[4];
 
-		result.x1 = this->x0 * rotate.x1 + this->x1 * rotate.y1;
-		result.y1 = this->y0 * rotate.x1 + this->y1 * rotate.y1;
-		result.z1 = this->z0 * rotate.x1 + this->z1 * rotate.y1;
+	constexpr Mat4() : columns{ 
+		Vec4(1.0f, 0.0f, 0.0f, 0.0f), 
+		Vec4(0.0f, 1.0f, 0.0f, 0.0f), 
+		Vec4(0.0f, 0.0f, 1.0f, 0.0f), 
+		Vec4(0.0f, 0.0f, 0.0f, 1.0f) 
+	} {}
 
+	constexpr Mat4(const Vec4 &c0, const Vec4 &c1, const Vec4 &c2, const Vec4 &c3) : 
+		columns{ c0, c1, c2, c3 } 
+	{}
+
+	// Equivalent to `translate(translation).rotate(angle).scale(scale)` but
+	// built in one go rather than by three successive products.
+	static Mat4 trs(const Vec3<f32> &translation, f32 angle, const Vec2<f32> &scale) {
+		const f32 c = cosf(angle);
+		const f32 s = sinf(angle);
+
+		return Mat4(
+			Vec4(c * scale.x, s * scale.x, 0.0f, 0.0f),
+			Vec4(-s * scale.y, c * scale.y, 0.0f, 0.0f),
+			Vec4(0.0f, 0.0f, 1.0f, 0.0f),
+			Vec4(translation.x, translation.y, translation.z, 1.0f)
+		);
+	}
+
+	Vec4 operator *(const Vec4 &v) const {
+#ifdef USE_SSE
+		const __m128 m = v.load();
+		__m128 result = _mm_mul_ps(this->columns[0].load(), _mm_shuffle_ps(m, m, _MM_SHUFFLE(0, 0, 0, 0)));
+		result = _mm_add_ps(result, _mm_mul_ps(this->columns[1].load(), _mm_shuffle_ps(m, m, _MM_SHUFFLE(1, 1, 1, 1))));
+		result = _mm_add_ps(result, _mm_mul_ps(this->columns[2].load(), _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 2, 2, 2))));
+		result = _mm_add_ps(result, _mm_mul_ps(this->columns[3].load(), _mm_shuffle_ps(m, m, _MM_SHUFFLE(3, 3, 3, 3))));
 		return result;
+#else
+		return 
+			this->columns[0] * v.x + 
+			this->columns[1] * v.y + 
+			this->columns[2] * v.z + 
+			this->columns[3] * v.w;
+#endif
 	}
-};
\ No newline at end of file
+
+	Mat4 operator *(const Mat4 &other) const {
+		return Mat4(
+			*this * other.columns[0],
+			*this * other.columns[1],
+			*this * other.columns[2],
+			*this * other.columns[3]
+		);
+	}
+
+	Mat4x4<f32> toMat4x4() const {
+		const Vec4 *c = this->columns;
+		return Mat4x4<f32>(
+			c[0].x, c[1].x, c[2].x, c[3].x,
+			c[0].y, c[1].y, c[2].y, c[3].y,
+			c[0].z, c[1].z, c[2].z, c[3].z,
+			c[0].w, c[1].w, c[2].w, c[3].w
+		);
+	}
+};
+
+static_assert(sizeof(Mat4) == sizeof(Mat4x4<f32>), "Mat4 must match the Mat4x4<f32> layout");
\ No newline at end of file
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <cassert>
+
+#if defined(_MSC_VER)
+	#include <intrin.h>
+#endif
+
+#include "types/core.hpp"
+
+inline u32 lowestSetBit(u64 bits) {
+	assert(bits != 0);
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward64(&index, bits);
+	return (u32)index;
+#else
+	return (u32)__builtin_ctzll(bits);
+#endif
+}
+
+// Fixed number of slots that stay where they are for as long as they're alive.
+// Released slots go on a free list for the next `create` to reuse and
+// iterating walks a bitmask of the live slots, skipping empty ones 64 at a
+// time, so adding and removing only ever touches the one slot.
+//
+// Example:
+//
+//     Pool<Foo, 256> foos;
+//     foos.create(foo);
+//
+//     for (Foo &foo : foos) {
+//         if (shouldRemove(foo)) {
+//             foos.release(&foo);
+//         }
+//     }
+//
+// NOTE: Only the current item can be released while iterating. Items created
+// while iterating may or may not be visited.
+template<typename T, size_t Size>
+struct Pool {
+	static const size_t WORDS = (Size + 63) / 64;
+
+	template<typename U>
+	struct Iterator {
+		U *data;
+		const u64 *alive;
+		size_t word;
+		// Copy of the current word, the bits are cleared as they're visited
+		u64 bits;
+
+		U &operator *() const {
+			return this->data[this->word * 64 + lowestSetBit(this->bits)];
+		}
+
+		Iterator &operator ++() {
+			this->bits &= this->bits - 1;
+			this->skipEmpty();
+			return *this;
+		}
+
+		bool operator !=(const Iterator &other) const {
+			return this->word != other.word || this->bits != other.bits;
+		}
+
+		void skipEmpty() {
+			while (this->bits == 0 && ++this->word < WORDS) {
+				this->bits = this->alive[this->word];
+			}
+		}
+	};
+
+	size_t length = 0;
+
+	Pool() {
+		this->clear();
+	}
+
+	// Null if every slot is taken
+	T *create(const T &item) {
+		if (this->freeCount == 0) {
+			return nullptr;
+		}
+
+		const u32 slot = this->freeSlots[--this->freeCount];
+		this->alive[slot / 64] |= 1ull << (slot % 64);
+		this->length++;
+
+		this->data[slot] = item;
+		return &this->data[slot];
+	}
+
+	void release(const T *item) {
+		const size_t slot = item - this->data;
+		assert(slot < Size && this->isAlive(slot));
+
+		this->alive[slot / 64] &= ~(1ull << (slot % 64));
+		this->freeSlots[this->freeCount++] = (u32)slot;
+		this->length--;
+	}
+
+	bool isAlive(size_t slot) const {
+		return (this->alive[slot / 64] >> (slot % 64)) & 1;
+	}
+
+	size_t capacity() const {
+		return Size;
+	}
+
+	void clear() {
+		for (size_t i = 0; i < WORDS; i++) {
+			this->alive[i] = 0;
+		}
+
+		// Handed out lowest slot first
+		for (size_t i = 0; i < Size; i++) {
+			this->freeSlots[i] = (u32)(Size - 1 - i);
+		}
+		this->freeCount = Size;
+		this->length = 0;
+	}
+
+	Iterator<T> begin() {
+		Iterator<T> it = { this->data, this->alive, 0, this->alive[0] };
+		it.skipEmpty();
+		return it;
+	}
+
+	Iterator<const T> begin() const {
+		Iterator<const T> it = { this->data, this->alive, 0, this->alive[0] };
+		it.skipEmpty();
+		return it;
+	}
+
+	Iterator<T> end() {
+		return { this->data, this->alive, WORDS, 0 };
+	}
+
+	Iterator<const T> end() const {
+		return { this->data, this->alive, WORDS, 0 };
+	}
+
+protected:
+	T data[Size];
+	u64 alive[WORDS];
+	u32 freeSlots[Size];
+	size_t freeCount;
+};
\ No newline at end of file
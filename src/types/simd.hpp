@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+	#define USE_SSE
+	#include <emmintrin.h>
+	#include <xmmintrin.h>
+#endif
+
+#include "types/core.hpp"
+
+// Approximates `1 / sqrt(x)`. The hardware estimate is only good to ~12 bits
+// so one Newton-Raphson step is applied, which gets close to full f32
+// precision while still avoiding the divide and square root.
+inline f32 reciprocalSqrt(f32 x) {
+#ifdef USE_SSE
+	const f32 estimate = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(x)));
+	return estimate * (1.5f - 0.5f * x * estimate * estimate);
+#else
+	return 1.0f / sqrtf(x);
+#endif
+}
\ No newline at end of file
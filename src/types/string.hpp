@@ -2,6 +2,16 @@
 
 #include <wchar.h>
 
+#if !defined(_WIN32)
+// Only the MSVC runtime has the bounds checked functions, this is enough for
+// the headers shared with the tools to build elsewhere
+inline int wcscpy_s(wchar_t *destination, size_t size, const wchar_t *source) {
+	wcsncpy(destination, source, size - 1);
+	destination[size - 1] = L'\0';
+	return 0;
+}
+#endif
+
 template<size_t Size>
 struct String16 {
 	wchar_t data[Size];
@@ -3,79 +3,175 @@
 #include <cmath>
 
 #include "types/core.hpp"
+#include "types/simd.hpp"
 
 template<typename T>
 struct Vec2 { 
 	T x, y;
 
-	Vec2(T x = 0, T y = 0) : x(x), y(y) {}
+	constexpr Vec2(T x = 0, T y = 0) : x(x), y(y) {}
 
-	Vec2<T> operator -(const Vec2<T> &other) const {
+	constexpr Vec2<T> operator -(const Vec2<T> &other) const {
 		return Vec2<T>(this->x - other.x, this->y - other.y);
 	}
 
-	Vec2<T> operator +(const Vec2<T> &other) const {
+	constexpr Vec2<T> operator +(const Vec2<T> &other) const {
 		return Vec2<T>(this->x + other.x, this->y + other.y);
 	}
 
-	Vec2<T> operator +=(const Vec2<T> &other) {
+	constexpr Vec2<T> &operator +=(const Vec2<T> &other) {
 		return *this = *this + other;
 	}
 
-	Vec2<T> operator *(T x) const {
+	constexpr Vec2<T> operator *(T x) const {
 		return Vec2<T>(this->x * x, this->y * x);
 	}
 
+	constexpr T dot(const Vec2<T> &other) const {
+		return this->x * other.x + this->y * other.y;
+	}
+
+	// Prefer the squared versions when only comparing lengths as they avoid
+	// the square root.
+	constexpr T squaredMagnitude() const {
+		return this->dot(*this);
+	}
+
+	constexpr T squaredDistanceTo(const Vec2<T> &other) const {
+		return (*this - other).squaredMagnitude();
+	}
+
 	f32 distanceTo(const Vec2<T> &other) const {
-		return sqrt(pow(this->x - other.x, 2) + pow(this->y - other.y, 2));
+		return std::sqrt(this->squaredDistanceTo(other));
 	}
 
 	T magnitude() const {
-		return sqrt(pow(this->x, 2) + pow(this->y, 2));
+		return std::sqrt(this->squaredMagnitude());
 	}
 
 	Vec2<T> normalized() const {
-		T magnitude = this->magnitude();
-		return Vec2<T>(this->x / magnitude, this->y / magnitude);
+		return *this * reciprocalSqrt(this->squaredMagnitude());
 	}
 };
 
+// NOTE: Vec3 is uploaded as is in vertex buffers so it has to stay tightly
+// packed. Use `Vec4` for SIMD work.
 template<typename T>
 struct Vec3 : Vec2<T> { 
 	T z;
-	Vec3(T x = 0, T y = 0, T z = 0) : Vec2<T>(x, y), z(z) {}
 
-	Vec3<T> operator -(const Vec3<T> &other) const {
+	constexpr Vec3(T x = 0, T y = 0, T z = 0) : Vec2<T>(x, y), z(z) {}
+
+	constexpr Vec3<T> operator -(const Vec3<T> &other) const {
 		return Vec3<T>(this->x - other.x, this->y - other.y, this->z - other.z);
 	}
 
-	Vec3<T> operator +(const Vec3<T> &other) const {
+	constexpr Vec3<T> operator +(const Vec3<T> &other) const {
 		return Vec3<T>(this->x + other.x, this->y + other.y, this->z + other.z);
 	}
 
-	Vec3<T> &operator +=(const Vec3<T> &other) {
+	constexpr Vec3<T> &operator +=(const Vec3<T> &other) {
 		return *this = *this + other;
 	}
 
-	Vec3<T> operator *(T x) const {
+	constexpr Vec3<T> operator *(T x) const {
 		return Vec3<T>(this->x * x, this->y * x, this->z * x);
 	}
 
+	constexpr T dot(const Vec3<T> &other) const {
+		return this->x * other.x + this->y * other.y + this->z * other.z;
+	}
+
+	constexpr T squaredMagnitude() const {
+		return this->dot(*this);
+	}
+
+	constexpr T squaredDistanceTo(const Vec3<T> &other) const {
+		return (*this - other).squaredMagnitude();
+	}
+
 	f32 distanceTo(const Vec3<T> &other) const {
-		return sqrt(
-			pow(this->x - other.x, 2) + 
-			pow(this->y - other.y, 2) + 
-			pow(this->z - other.z, 2) 
-		);
+		return std::sqrt(this->squaredDistanceTo(other));
 	}
 
 	T magnitude() const {
-		return sqrt(pow(this->x, 2) + pow(this->y, 2) + pow(this->z, 2));
+		return std::sqrt(this->squaredMagnitude());
 	}
 
 	Vec3<T> normalized() const {
-		T magnitude = this->magnitude();
-		return Vec3<T>(this->x / magnitude, this->y / magnitude, this->z / magnitude);
+		return *this * reciprocalSqrt(this->squaredMagnitude());
+	}
+};
+
+static_assert(sizeof(Vec3<f32>) == 12, "Vec3<f32> must stay tightly packed");
+
+// 16 byte aligned so it can be loaded straight into an SSE register. Only
+// really worth using where several operations are chained, e.g. `Mat4`.
+struct alignas(16) Vec4 {
+	f32 x, y, z, w;
+
+	constexpr Vec4(f32 x = 0, f32 y = 0, f32 z = 0, f32 w = 0) : x(x), y(y), z(z), w(w) {}
+
+#ifdef USE_SSE
+	Vec4(__m128 m) {
+		_mm_store_ps(&this->x, m);
+	}
+
+	__m128 load() const {
+		return _mm_load_ps(&this->x);
+	}
+#endif
+
+	Vec4 operator -(const Vec4 &other) const {
+#ifdef USE_SSE
+		return _mm_sub_ps(this->load(), other.load());
+#else
+		return Vec4(this->x - other.x, this->y - other.y, this->z - other.z, this->w - other.w);
+#endif
+	}
+
+	Vec4 operator +(const Vec4 &other) const {
+#ifdef USE_SSE
+		return _mm_add_ps(this->load(), other.load());
+#else
+		return Vec4(this->x + other.x, this->y + other.y, this->z + other.z, this->w + other.w);
+#endif
+	}
+
+	Vec4 &operator +=(const Vec4 &other) {
+		return *this = *this + other;
+	}
+
+	Vec4 operator *(f32 x) const {
+#ifdef USE_SSE
+		return _mm_mul_ps(this->load(), _mm_set1_ps(x));
+#else
+		return Vec4(this->x * x, this->y * x, this->z * x, this->w * x);
+#endif
+	}
+
+	f32 dot(const Vec4 &other) const {
+#ifdef USE_SSE
+		const __m128 product = _mm_mul_ps(this->load(), other.load());
+		const __m128 swapped = _mm_shuffle_ps(product, product, _MM_SHUFFLE(2, 3, 0, 1));
+		const __m128 pairs = _mm_add_ps(product, swapped);
+		const __m128 high = _mm_movehl_ps(pairs, pairs);
+		return _mm_cvtss_f32(_mm_add_ss(pairs, high));
+#else
+		return this->x * other.x + this->y * other.y + this->z * other.z + this->w * other.w;
+#endif
+	}
+
+	f32 squaredMagnitude() const {
+		return this->dot(*this);
+	}
+
+	f32 magnitude() const {
+		return sqrtf(this->squaredMagnitude());
+	}
+
+	Vec4 normalized() const {
+		return *this * reciprocalSqrt(this->squaredMagnitude());
 	}
 };
 
@@ -106,6 +202,10 @@ struct Rgba : Rgb {
 		);
 	}
 
+	Rgba operator *(f32 x) const {
+		return Rgba(this->r * x, this->g * x, this->b * x, this->a * x);
+	}
+
 	Rgba &operator +=(const Rgba &other) {
 		return *this = *this + other;
 	}
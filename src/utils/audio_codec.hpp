@@ -0,0 +1,305 @@
+#pragma once
+
+#include <cassert>
+#include <cstring>
+
+#include "types/core.hpp"
+#include "types/simd.hpp"
+
+// A lossy codec for 16-bit audio along the lines of QOA, 3.2 bits a sample and
+// cheap enough to decode that music can be unpacked a block ahead of playback
+// on the thread that streams it.
+//
+// Every channel predicts its next sample from the last four with a sign-sign
+// LMS filter and only stores the residual, quantised to 3 bits against one of
+// 16 scale factors picked for each slice of 20 samples. A slice is a u64: the
+// scale factor in the top 4 bits then the 20 codes, first sample highest.
+//
+// Blocks decode on their own, each one starts with every channel's filter
+// state (4 history samples then 4 weights, as s16) followed by the slices,
+// interleaved by channel.
+//
+// Example:
+//
+//     AudioLms lms[2];
+//     AudioCodec::resetLms(lms, 2);
+//     u8 *block = new u8[AudioCodec::blockSize(2, frames)];
+//     AudioCodec::encodeBlock(samples, 2, frames, lms, block);
+//     AudioCodec::decodeBlock(block, 2, frames, decoded);
+//
+#define AUDIO_SLICE_LENGTH 20
+#define AUDIO_BLOCK_SLICES 256
+#define AUDIO_BLOCK_FRAMES (AUDIO_SLICE_LENGTH * AUDIO_BLOCK_SLICES)
+#define AUDIO_LMS_LENGTH 4
+#define AUDIO_LMS_SIZE (AUDIO_LMS_LENGTH * 2 * 2)
+#define AUDIO_CHANNEL_MAX 8
+
+struct AudioLms {
+	s16 history[AUDIO_LMS_LENGTH];
+	s16 weights[AUDIO_LMS_LENGTH];
+};
+
+namespace AudioCodec {
+	const s32 scaleFactors[16] = { 1, 7, 21, 45, 84, 138, 211, 304, 421, 562, 731, 928, 1157, 1419, 1715, 2048 };
+
+	// 65536 / scale factor, rounded up, so dividing is a multiply and a shift
+	const s32 reciprocals[16] = { 65536, 9363, 3121, 1457, 781, 475, 311, 216, 156, 117, 90, 71, 57, 47, 39, 32 };
+
+	// Code for a scaled residual from -8 to 8, even codes are positive
+	const u8 quantise[17] = { 7, 7, 7, 5, 5, 3, 3, 1, 0, 0, 2, 2, 4, 4, 6, 6, 6 };
+
+	// The residual each code stands for at each scale factor
+	const s32 dequantise[16][8] = {
+		{ 1, -1, 3, -3, 5, -5, 7, -7 },
+		{ 5, -5, 18, -18, 32, -32, 49, -49 },
+		{ 16, -16, 53, -53, 95, -95, 147, -147 },
+		{ 34, -34, 113, -113, 203, -203, 315, -315 },
+		{ 63, -63, 210, -210, 378, -378, 588, -588 },
+		{ 104, -104, 345, -345, 621, -621, 966, -966 },
+		{ 158, -158, 528, -528, 950, -950, 1477, -1477 },
+		{ 228, -228, 760, -760, 1368, -1368, 2128, -2128 },
+		{ 316, -316, 1053, -1053, 1895, -1895, 2947, -2947 },
+		{ 422, -422, 1405, -1405, 2529, -2529, 3934, -3934 },
+		{ 548, -548, 1828, -1828, 3290, -3290, 5117, -5117 },
+		{ 696, -696, 2320, -2320, 4176, -4176, 6496, -6496 },
+		{ 868, -868, 2893, -2893, 5207, -5207, 8099, -8099 },
+		{ 1064, -1064, 3548, -3548, 6386, -6386, 9933, -9933 },
+		{ 1286, -1286, 4288, -4288, 7718, -7718, 12005, -12005 },
+		{ 1536, -1536, 5120, -5120, 9216, -9216, 14336, -14336 }
+	};
+
+	size_t blockSize(u32 channels, u32 frames) {
+		const size_t slices = (frames + AUDIO_SLICE_LENGTH - 1) / AUDIO_SLICE_LENGTH;
+		return (size_t)channels * AUDIO_LMS_SIZE + slices * channels * sizeof(u64);
+	}
+
+	s32 clampS16(s32 value) {
+		return value < -32768 ? -32768 : (value > 32767 ? 32767 : value);
+	}
+
+	s32 sign(s32 value) {
+		return (value > 0) - (value < 0);
+	}
+
+	void resetLms(AudioLms *lms, u32 channels) {
+		for (u32 c = 0; c < channels; c++) {
+			lms[c] = {};
+			lms[c].weights[2] = -(1 << 13);
+			lms[c].weights[3] = 1 << 14;
+		}
+	}
+
+	// NOTE: Sums wrap the way _mm_madd_epi16 does so both decoders agree on
+	// any input, even a corrupt one
+	s32 predict(const AudioLms &lms) {
+		u32 sum = 0;
+		for (u32 i = 0; i < AUDIO_LMS_LENGTH; i++) {
+			sum += (u32)((s32)lms.history[i] * lms.weights[i]);
+		}
+		return (s32)sum >> 13;
+	}
+
+	void update(AudioLms *lms, s32 sample, s32 residual) {
+		const s32 delta = residual >> 4;
+		for (u32 i = 0; i < AUDIO_LMS_LENGTH; i++) {
+			lms->weights[i] = (s16)clampS16(lms->weights[i] + (lms->history[i] < 0 ? -delta : delta));
+		}
+		for (u32 i = 0; i < AUDIO_LMS_LENGTH - 1; i++) {
+			lms->history[i] = lms->history[i + 1];
+		}
+		lms->history[AUDIO_LMS_LENGTH - 1] = (s16)sample;
+	}
+
+	// Rounds away from zero, never to it unless `value` is 0
+	s32 divide(s32 value, u32 scaleFactor) {
+		const s32 result = (s32)(((s64)value * reciprocals[scaleFactor] + (1 << 15)) >> 16);
+		return result + (sign(value) - sign(result));
+	}
+
+	void writeLms(const AudioLms &lms, u8 *out) {
+		memcpy(out, lms.history, sizeof(lms.history));
+		memcpy(out + sizeof(lms.history), lms.weights, sizeof(lms.weights));
+	}
+
+	void readLms(const u8 *data, AudioLms *lms) {
+		memcpy(lms->history, data, sizeof(lms->history));
+		memcpy(lms->weights, data + sizeof(lms->history), sizeof(lms->weights));
+	}
+
+	// Tries every scale factor and keeps the one closest to the source, `lms`
+	// is left as the decoder will have it afterwards
+	u64 encodeSlice(const s16 *samples, u32 stride, u32 count, AudioLms *lms) {
+		u64 bestError = ~0ull;
+		u64 bestSlice = 0;
+		AudioLms bestLms = *lms;
+
+		for (u32 scaleFactor = 0; scaleFactor < 16; scaleFactor++) {
+			AudioLms trial = *lms;
+			u64 slice = scaleFactor;
+			u64 error = 0;
+
+			for (u32 i = 0; i < AUDIO_SLICE_LENGTH; i++) {
+				// The end of the last slice is padded out with zero codes
+				if (i >= count) {
+					slice <<= 3;
+					continue;
+				}
+
+				const s32 sample = samples[(size_t)i * stride];
+				const s32 predicted = predict(trial);
+				const s32 scaled = divide(sample - predicted, scaleFactor);
+				const s32 clamped = scaled < -8 ? -8 : (scaled > 8 ? 8 : scaled);
+				const u8 code = quantise[clamped + 8];
+				const s32 residual = dequantise[scaleFactor][code];
+				const s32 reconstructed = clampS16(predicted + residual);
+
+				const s64 difference = sample - reconstructed;
+				error += (u64)(difference * difference);
+				if (error >= bestError) {
+					break;
+				}
+
+				update(&trial, reconstructed, residual);
+				slice = (slice << 3) | code;
+			}
+
+			if (error < bestError) {
+				bestError = error;
+				bestSlice = slice;
+				bestLms = trial;
+			}
+		}
+
+		*lms = bestLms;
+		return bestSlice;
+	}
+
+	// `samples` are interleaved, `lms` carries each channel's filter on to the
+	// next block. Returns the bytes written, `blockSize`.
+	size_t encodeBlock(const s16 *samples, u32 channels, u32 frames, AudioLms *lms, u8 *out) {
+		assert(channels > 0 && channels <= AUDIO_CHANNEL_MAX);
+		assert(frames > 0 && frames <= AUDIO_BLOCK_FRAMES);
+
+		u8 *write = out;
+		for (u32 c = 0; c < channels; c++) {
+			writeLms(lms[c], write);
+			write += AUDIO_LMS_SIZE;
+		}
+
+		for (u32 start = 0; start < frames; start += AUDIO_SLICE_LENGTH) {
+			const u32 count = frames - start < AUDIO_SLICE_LENGTH ? frames - start : AUDIO_SLICE_LENGTH;
+			for (u32 c = 0; c < channels; c++) {
+				const u64 slice = encodeSlice(samples + (size_t)start * channels + c, channels, count, &lms[c]);
+				memcpy(write, &slice, sizeof(slice));
+				write += sizeof(slice);
+			}
+		}
+
+		return (size_t)(write - out);
+	}
+
+	void decodeSlice(u64 slice, u32 count, AudioLms *lms, s16 *out, u32 stride) {
+		const s32 *residuals = dequantise[slice >> 60];
+		for (u32 i = 0; i < count; i++) {
+			const s32 predicted = predict(*lms);
+			const s32 residual = residuals[(slice >> (57 - 3 * i)) & 7];
+			const s32 sample = clampS16(predicted + residual);
+			out[(size_t)i * stride] = (s16)sample;
+			update(lms, sample, residual);
+		}
+	}
+
+	void decodeChannel(const u8 *block, u32 channels, u32 channel, u32 frames, s16 *out) {
+		AudioLms lms;
+		readLms(block + channel * AUDIO_LMS_SIZE, &lms);
+
+		const u8 *slices = block + channels * AUDIO_LMS_SIZE;
+		for (u32 start = 0, index = 0; start < frames; start += AUDIO_SLICE_LENGTH, index++) {
+			const u32 count = frames - start < AUDIO_SLICE_LENGTH ? frames - start : AUDIO_SLICE_LENGTH;
+			u64 slice;
+			memcpy(&slice, slices + ((size_t)index * channels + channel) * sizeof(u64), sizeof(slice));
+			decodeSlice(slice, count, &lms, out + (size_t)start * channels + channel, channels);
+		}
+	}
+
+#ifdef USE_SSE
+	// Runs two channels' filters side by side, one in each half of the
+	// registers. Each sample depends on the one before so there's no going
+	// wider than the channels.
+	void decodeChannelPair(const u8 *block, u32 channels, u32 channel, u32 frames, s16 *out) {
+		AudioLms lms[2];
+		readLms(block + channel * AUDIO_LMS_SIZE, &lms[0]);
+		readLms(block + (channel + 1) * AUDIO_LMS_SIZE, &lms[1]);
+
+		alignas(16) s16 history[8];
+		alignas(16) s16 weights[8];
+		memcpy(history, lms[0].history, sizeof(lms[0].history));
+		memcpy(history + 4, lms[1].history, sizeof(lms[1].history));
+		memcpy(weights, lms[0].weights, sizeof(lms[0].weights));
+		memcpy(weights + 4, lms[1].weights, sizeof(lms[1].weights));
+		__m128i historyLanes = _mm_load_si128((const __m128i*)history);
+		__m128i weightLanes = _mm_load_si128((const __m128i*)weights);
+
+		const u8 *slices = block + channels * AUDIO_LMS_SIZE;
+		for (u32 start = 0, index = 0; start < frames; start += AUDIO_SLICE_LENGTH, index++) {
+			const u32 count = frames - start < AUDIO_SLICE_LENGTH ? frames - start : AUDIO_SLICE_LENGTH;
+			u64 slice0;
+			u64 slice1;
+			memcpy(&slice0, slices + ((size_t)index * channels + channel) * sizeof(u64), sizeof(slice0));
+			memcpy(&slice1, slices + ((size_t)index * channels + channel + 1) * sizeof(u64), sizeof(slice1));
+			const s32 *residuals0 = dequantise[slice0 >> 60];
+			const s32 *residuals1 = dequantise[slice1 >> 60];
+			s16 *write = out + (size_t)start * channels + channel;
+
+			for (u32 i = 0; i < count; i++) {
+				// Pairs of products summed, then the pairs summed into the
+				// bottom 32 bits of each half
+				const __m128i products = _mm_madd_epi16(historyLanes, weightLanes);
+				const __m128i sums = _mm_add_epi32(products, _mm_srli_epi64(products, 32));
+				const s32 predicted0 = _mm_cvtsi128_si32(sums) >> 13;
+				const s32 predicted1 = _mm_cvtsi128_si32(_mm_unpackhi_epi64(sums, sums)) >> 13;
+
+				const u32 shift = 57 - 3 * i;
+				const s32 residual0 = residuals0[(slice0 >> shift) & 7];
+				const s32 residual1 = residuals1[(slice1 >> shift) & 7];
+				const s32 sample0 = clampS16(predicted0 + residual0);
+				const s32 sample1 = clampS16(predicted1 + residual1);
+				write[0] = (s16)sample0;
+				write[1] = (s16)sample1;
+				write += channels;
+
+				// Deltas negated where the history is, by flipping and adding one
+				const s16 delta0 = (s16)(residual0 >> 4);
+				const s16 delta1 = (s16)(residual1 >> 4);
+				const __m128i deltas = _mm_set_epi16(delta1, delta1, delta1, delta1, delta0, delta0, delta0, delta0);
+				const __m128i signs = _mm_srai_epi16(historyLanes, 15);
+				weightLanes = _mm_adds_epi16(weightLanes, _mm_sub_epi16(_mm_xor_si128(deltas, signs), signs));
+
+				historyLanes = _mm_srli_epi64(historyLanes, 16);
+				historyLanes = _mm_insert_epi16(historyLanes, sample0, 3);
+				historyLanes = _mm_insert_epi16(historyLanes, sample1, 7);
+			}
+		}
+	}
+#endif
+
+	// Always scalar, `decodeBlock` should match it sample for sample
+	void decodeBlockScalar(const u8 *block, u32 channels, u32 frames, s16 *out) {
+		for (u32 c = 0; c < channels; c++) {
+			decodeChannel(block, channels, c, frames, out);
+		}
+	}
+
+	// `out` needs room for `frames` interleaved frames
+	void decodeBlock(const u8 *block, u32 channels, u32 frames, s16 *out) {
+		u32 c = 0;
+#ifdef USE_SSE
+		for (; c + 2 <= channels; c += 2) {
+			decodeChannelPair(block, channels, c, frames, out);
+		}
+#endif
+		for (; c < channels; c++) {
+			decodeChannel(block, channels, c, frames, out);
+		}
+	}
+};
\ No newline at end of file
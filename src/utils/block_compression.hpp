@@ -0,0 +1,718 @@
+#pragma once
+
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+#include "types/core.hpp"
+
+enum class BlockFormat : u8 {
+	// RGB and one bit of alpha, 4 bits a pixel
+	bc1,
+	// BC1's colour with 8 levels of alpha a block, 8 bits a pixel
+	bc3,
+	// RGBA from one set of endpoints with 16 steps between them, 8 bits a
+	// pixel. Only mode 6 is written or read.
+	bc7,
+	_length
+};
+
+const char *blockFormatNames[] = {
+	"bc1",
+	"bc3",
+	"bc7"
+};
+
+// Encodes and decodes 4x4 blocks of the BCn texture formats GPUs sample
+// directly. Endpoints come from the principal axis of the block's colours
+// and are refined by least squares against the indices they give, which gets
+// close to the quality of the usual offline encoders at a fraction of the
+// code. Pixels are 8-bit RGBA with red in the lowest byte.
+//
+// Example:
+//
+//     u8 blocks[BlockCompression::levelSize(BlockFormat::bc7, width, height)];
+//     BlockCompression::encodeRows(BlockFormat::bc7, pixels, width, height, 0, (height + 3) / 4, blocks);
+//     BlockCompression::decodeLevel(BlockFormat::bc7, blocks, width, height, decoded);
+//
+namespace BlockCompression {
+	#define BLOCK_REFINE_ITERATIONS 2
+
+	const u8 bc7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	u32 blockBytes(BlockFormat format) {
+		return format == BlockFormat::bc1 ? 8 : 16;
+	}
+
+	size_t levelSize(BlockFormat format, u32 width, u32 height) {
+		return (size_t)((width + 3) / 4) * ((height + 3) / 4) * blockBytes(format);
+	}
+
+	u32 channel(u32 pixel, u32 index) {
+		return (pixel >> (index * 8)) & 0xff;
+	}
+
+	u32 pack(u32 r, u32 g, u32 b, u32 a) {
+		return r | (g << 8) | (b << 16) | (a << 24);
+	}
+
+	u8 clampByte(f32 value) {
+		return (u8)(value < 0.0f ? 0 : (value > 255.0f ? 255 : (s32)(value + 0.5f)));
+	}
+
+	// Direction the block's colours spread out along most, by power
+	// iteration on their covariance. `channels` is 3 to leave out alpha.
+	void principalAxis(const f32 (*colors)[4], u32 count, u32 channels, f32 *mean, f32 *axis) {
+		for (u32 c = 0; c < 4; c++) {
+			mean[c] = 0.0f;
+			for (u32 i = 0; i < count; i++) {
+				mean[c] += colors[i][c];
+			}
+			mean[c] /= count;
+		}
+
+		f32 covariance[4][4] = {};
+		for (u32 i = 0; i < count; i++) {
+			for (u32 a = 0; a < channels; a++) {
+				for (u32 b = 0; b < channels; b++) {
+					covariance[a][b] += (colors[i][a] - mean[a]) * (colors[i][b] - mean[b]);
+				}
+			}
+		}
+
+		for (u32 c = 0; c < 4; c++) {
+			axis[c] = c < channels ? 1.0f : 0.0f;
+		}
+		for (u32 iteration = 0; iteration < 8; iteration++) {
+			f32 next[4] = {};
+			f32 length = 0.0f;
+			for (u32 a = 0; a < channels; a++) {
+				for (u32 b = 0; b < channels; b++) {
+					next[a] += covariance[a][b] * axis[b];
+				}
+				length += next[a] * next[a];
+			}
+
+			// Every colour's the same
+			if (length == 0.0f) {
+				break;
+			}
+			const f32 scale = 1.0f / sqrtf(length);
+			for (u32 c = 0; c < channels; c++) {
+				axis[c] = next[c] * scale;
+			}
+		}
+	}
+
+	// The two points on the axis the block's colours project to either end of
+	void axisEndpoints(const f32 (*colors)[4], u32 count, u32 channels, f32 *start, f32 *end) {
+		f32 mean[4];
+		f32 axis[4];
+		principalAxis(colors, count, channels, mean, axis);
+
+		f32 lowest = 0.0f;
+		f32 highest = 0.0f;
+		for (u32 i = 0; i < count; i++) {
+			f32 t = 0.0f;
+			for (u32 c = 0; c < channels; c++) {
+				t += (colors[i][c] - mean[c]) * axis[c];
+			}
+			lowest = t < lowest ? t : lowest;
+			highest = t > highest ? t : highest;
+		}
+
+		for (u32 c = 0; c < 4; c++) {
+			start[c] = mean[c] + axis[c] * lowest;
+			end[c] = mean[c] + axis[c] * highest;
+		}
+	}
+
+	// Endpoints that best fit the colours given where along the line each
+	// one sits, false if they all sit at the same place
+	bool leastSquares(const f32 (*colors)[4], const f32 *weights, u32 count, f32 *start, f32 *end) {
+		f32 aa = 0.0f;
+		f32 ab = 0.0f;
+		f32 bb = 0.0f;
+		f32 ax[4] = {};
+		f32 bx[4] = {};
+		for (u32 i = 0; i < count; i++) {
+			const f32 b = weights[i];
+			const f32 a = 1.0f - b;
+			aa += a * a;
+			ab += a * b;
+			bb += b * b;
+			for (u32 c = 0; c < 4; c++) {
+				ax[c] += a * colors[i][c];
+				bx[c] += b * colors[i][c];
+			}
+		}
+
+		const f32 determinant = aa * bb - ab * ab;
+		if (determinant < 1e-6f) {
+			return false;
+		}
+		for (u32 c = 0; c < 4; c++) {
+			start[c] = (ax[c] * bb - bx[c] * ab) / determinant;
+			end[c] = (bx[c] * aa - ax[c] * ab) / determinant;
+		}
+		return true;
+	}
+
+	u32 distance(const f32 *a, const u8 *b, u32 channels) {
+		f32 sum = 0.0f;
+		for (u32 c = 0; c < channels; c++) {
+			const f32 difference = a[c] - b[c];
+			sum += difference * difference;
+		}
+		return (u32)sum;
+	}
+
+	u16 to565(const f32 *color) {
+		const u32 r = clampByte(color[0] * 31.0f / 255.0f);
+		const u32 g = clampByte(color[1] * 63.0f / 255.0f);
+		const u32 b = clampByte(color[2] * 31.0f / 255.0f);
+		return (u16)(((r > 31 ? 31 : r) << 11) | ((g > 63 ? 63 : g) << 5) | (b > 31 ? 31 : b));
+	}
+
+	void from565(u16 color, u8 *rgb) {
+		const u32 r = (color >> 11) & 31;
+		const u32 g = (color >> 5) & 63;
+		const u32 b = color & 31;
+		rgb[0] = (u8)((r << 3) | (r >> 2));
+		rgb[1] = (u8)((g << 2) | (g >> 4));
+		rgb[2] = (u8)((b << 3) | (b >> 2));
+	}
+
+	// Four colours, or three and transparent black when `c0 <= c1` and
+	// that mode's allowed
+	void bc1Palette(u16 c0, u16 c1, bool fourColorsOnly, u8 (*palette)[4]) {
+		from565(c0, palette[0]);
+		from565(c1, palette[1]);
+		palette[0][3] = 255;
+		palette[1][3] = 255;
+
+		for (u32 c = 0; c < 3; c++) {
+			if (c0 > c1 || fourColorsOnly) {
+				palette[2][c] = (u8)((2 * palette[0][c] + palette[1][c]) / 3);
+				palette[3][c] = (u8)((palette[0][c] + 2 * palette[1][c]) / 3);
+			} else {
+				palette[2][c] = (u8)((palette[0][c] + palette[1][c]) / 2);
+				palette[3][c] = 0;
+			}
+		}
+		palette[2][3] = 255;
+		palette[3][3] = c0 > c1 || fourColorsOnly ? 255 : 0;
+	}
+
+	// Fills in the indices for a pair of endpoints and returns the error
+	u32 bc1Indices(const f32 (*colors)[4], const bool *transparent, u16 c0, u16 c1, bool fourColorsOnly, u8 *indices) {
+		u8 palette[4][4];
+		bc1Palette(c0, c1, fourColorsOnly, palette);
+		const bool threeColors = c0 <= c1 && !fourColorsOnly;
+
+		u32 error = 0;
+		for (u32 i = 0; i < 16; i++) {
+			if (transparent[i]) {
+				indices[i] = 3;
+				continue;
+			}
+
+			u32 best = 0xffffffff;
+			for (u32 p = 0; p < (threeColors ? 3u : 4u); p++) {
+				const u32 d = distance(colors[i], palette[p], 3);
+				if (d < best) {
+					best = d;
+					indices[i] = (u8)p;
+				}
+			}
+			error += best;
+		}
+		return error;
+	}
+
+	// `punchThrough` uses the three colour mode for blocks with pixels under
+	// half alpha, BC3's colour always has four
+	void encodeBc1(const u32 *pixels, u8 *output, bool punchThrough) {
+		f32 colors[16][4];
+		f32 opaque[16][4];
+		bool transparent[16];
+		u32 opaqueCount = 0;
+		for (u32 i = 0; i < 16; i++) {
+			for (u32 c = 0; c < 4; c++) {
+				colors[i][c] = (f32)channel(pixels[i], c);
+			}
+			transparent[i] = punchThrough && channel(pixels[i], 3) < 128;
+			if (!transparent[i]) {
+				memcpy(opaque[opaqueCount++], colors[i], sizeof(colors[i]));
+			}
+		}
+
+		const bool threeColors = opaqueCount < 16;
+		u16 c0 = 0;
+		u16 c1 = 0;
+		u8 indices[16] = {};
+		for (u32 i = 0; i < 16; i++) {
+			indices[i] = 3;
+		}
+
+		if (opaqueCount > 0) {
+			f32 start[4];
+			f32 end[4];
+			axisEndpoints(opaque, opaqueCount, 3, start, end);
+
+			u32 bestError = 0xffffffff;
+			for (u32 iteration = 0; iteration <= BLOCK_REFINE_ITERATIONS; iteration++) {
+				u16 a = to565(start);
+				u16 b = to565(end);
+				// The mode comes from which endpoint's bigger
+				if (threeColors ? a > b : a < b) {
+					const u16 swapped = a;
+					a = b;
+					b = swapped;
+				}
+
+				u8 candidate[16];
+				const u32 error = bc1Indices(colors, transparent, a, b, !punchThrough, candidate);
+				if (error < bestError) {
+					bestError = error;
+					c0 = a;
+					c1 = b;
+					memcpy(indices, candidate, sizeof(indices));
+				}
+				if (error == 0 || iteration == BLOCK_REFINE_ITERATIONS) {
+					break;
+				}
+
+				// Where along the line each index puts its pixel
+				const f32 fourWeights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+				const f32 threeWeights[4] = { 0.0f, 1.0f, 0.5f, 0.0f };
+				f32 weights[16];
+				u32 count = 0;
+				for (u32 i = 0; i < 16; i++) {
+					if (!transparent[i]) {
+						weights[count++] = (threeColors ? threeWeights : fourWeights)[candidate[i]];
+					}
+				}
+
+				// The weights are against c0 then c1, so the fit comes back in
+				// that order
+				f32 fitted0[4];
+				f32 fitted1[4];
+				if (!leastSquares(opaque, weights, count, fitted0, fitted1)) {
+					break;
+				}
+				memcpy(start, fitted0, sizeof(start));
+				memcpy(end, fitted1, sizeof(end));
+			}
+		}
+
+		u32 bits = 0;
+		for (u32 i = 0; i < 16; i++) {
+			bits |= (u32)indices[i] << (i * 2);
+		}
+		memcpy(output, &c0, 2);
+		memcpy(output + 2, &c1, 2);
+		memcpy(output + 4, &bits, 4);
+	}
+
+	void decodeBc1(const u8 *block, u32 *pixels, bool fourColorsOnly) {
+		u16 c0;
+		u16 c1;
+		u32 bits;
+		memcpy(&c0, block, 2);
+		memcpy(&c1, block + 2, 2);
+		memcpy(&bits, block + 4, 4);
+
+		u8 palette[4][4];
+		bc1Palette(c0, c1, fourColorsOnly, palette);
+		for (u32 i = 0; i < 16; i++) {
+			const u8 *color = palette[(bits >> (i * 2)) & 3];
+			pixels[i] = pack(color[0], color[1], color[2], color[3]);
+		}
+	}
+
+	void alphaPalette(u8 a0, u8 a1, u8 *palette) {
+		palette[0] = a0;
+		palette[1] = a1;
+		if (a0 > a1) {
+			for (u32 i = 1; i < 7; i++) {
+				palette[i + 1] = (u8)(((7 - i) * a0 + i * a1) / 7);
+			}
+		} else {
+			for (u32 i = 1; i < 5; i++) {
+				palette[i + 1] = (u8)(((5 - i) * a0 + i * a1) / 5);
+			}
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+	}
+
+	// BC3's alpha block, always in the eight value mode
+	void encodeAlpha(const u32 *pixels, u8 *output) {
+		u8 lowest = 255;
+		u8 highest = 0;
+		for (u32 i = 0; i < 16; i++) {
+			const u8 alpha = (u8)channel(pixels[i], 3);
+			lowest = alpha < lowest ? alpha : lowest;
+			highest = alpha > highest ? alpha : highest;
+		}
+
+		u8 palette[8];
+		alphaPalette(highest, lowest, palette);
+
+		u64 bits = 0;
+		if (highest != lowest) {
+			for (u32 i = 0; i < 16; i++) {
+				const s32 alpha = (s32)channel(pixels[i], 3);
+				u32 bestIndex = 0;
+				s32 best = 256;
+				for (u32 p = 0; p < 8; p++) {
+					const s32 difference = alpha > palette[p] ? alpha - palette[p] : palette[p] - alpha;
+					if (difference < best) {
+						best = difference;
+						bestIndex = p;
+					}
+				}
+				bits |= (u64)bestIndex << (i * 3);
+			}
+		}
+
+		output[0] = highest;
+		output[1] = lowest;
+		for (u32 i = 0; i < 6; i++) {
+			output[2 + i] = (u8)(bits >> (i * 8));
+		}
+	}
+
+	void decodeAlpha(const u8 *block, u32 *pixels) {
+		u8 palette[8];
+		alphaPalette(block[0], block[1], palette);
+
+		u64 bits = 0;
+		for (u32 i = 0; i < 6; i++) {
+			bits |= (u64)block[2 + i] << (i * 8);
+		}
+		for (u32 i = 0; i < 16; i++) {
+			pixels[i] = (pixels[i] & 0x00ffffff) | ((u32)palette[(bits >> (i * 3)) & 7] << 24);
+		}
+	}
+
+	struct BitStream {
+		u8 *data;
+		u32 position = 0;
+
+		void write(u32 value, u32 count) {
+			for (u32 i = 0; i < count; i++) {
+				if ((value >> i) & 1) {
+					this->data[(this->position + i) / 8] |= (u8)(1 << ((this->position + i) % 8));
+				}
+			}
+			this->position += count;
+		}
+
+		u32 read(u32 count) {
+			u32 value = 0;
+			for (u32 i = 0; i < count; i++) {
+				value |= (u32)((this->data[(this->position + i) / 8] >> ((this->position + i) % 8)) & 1) << i;
+			}
+			this->position += count;
+			return value;
+		}
+	};
+
+	// 7 bits a channel plus a shared low bit, picking whichever low bit
+	// lands closer
+	void quantiseBc7(const f32 *endpoint, u8 *quantised, u8 *pBit) {
+		f32 bestError = 1e30f;
+		for (u32 p = 0; p < 2; p++) {
+			u8 candidate[4];
+			f32 error = 0.0f;
+			for (u32 c = 0; c < 4; c++) {
+				const s32 value = (s32)((endpoint[c] - p) * 0.5f + 0.5f);
+				candidate[c] = (u8)(value < 0 ? 0 : (value > 127 ? 127 : value));
+				const f32 difference = (f32)(candidate[c] * 2 + p) - endpoint[c];
+				error += difference * difference;
+			}
+			if (error < bestError) {
+				bestError = error;
+				memcpy(quantised, candidate, 4);
+				*pBit = (u8)p;
+			}
+		}
+	}
+
+	void bc7Palette(const u8 *e0, const u8 *e1, u8 (*palette)[4]) {
+		for (u32 i = 0; i < 16; i++) {
+			for (u32 c = 0; c < 4; c++) {
+				palette[i][c] = (u8)(((64 - bc7Weights[i]) * e0[c] + bc7Weights[i] * e1[c] + 32) >> 6);
+			}
+		}
+	}
+
+	void encodeBc7(const u32 *pixels, u8 *output) {
+		f32 colors[16][4];
+		for (u32 i = 0; i < 16; i++) {
+			for (u32 c = 0; c < 4; c++) {
+				colors[i][c] = (f32)channel(pixels[i], c);
+			}
+		}
+
+		f32 start[4];
+		f32 end[4];
+		axisEndpoints(colors, 16, 4, start, end);
+
+		u8 bestEndpoints[2][4] = {};
+		u8 bestPBits[2] = {};
+		u8 bestIndices[16] = {};
+		u32 bestError = 0xffffffff;
+
+		for (u32 iteration = 0; iteration <= BLOCK_REFINE_ITERATIONS; iteration++) {
+			u8 quantised[2][4];
+			u8 pBits[2];
+			quantiseBc7(start, quantised[0], &pBits[0]);
+			quantiseBc7(end, quantised[1], &pBits[1]);
+
+			u8 e0[4];
+			u8 e1[4];
+			for (u32 c = 0; c < 4; c++) {
+				e0[c] = (u8)(quantised[0][c] * 2 + pBits[0]);
+				e1[c] = (u8)(quantised[1][c] * 2 + pBits[1]);
+			}
+
+			u8 palette[16][4];
+			bc7Palette(e0, e1, palette);
+
+			u8 indices[16];
+			u32 error = 0;
+			for (u32 i = 0; i < 16; i++) {
+				u32 best = 0xffffffff;
+				for (u32 p = 0; p < 16; p++) {
+					const u32 d = distance(colors[i], palette[p], 4);
+					if (d < best) {
+						best = d;
+						indices[i] = (u8)p;
+					}
+				}
+				error += best;
+			}
+
+			if (error < bestError) {
+				bestError = error;
+				memcpy(bestEndpoints, quantised, sizeof(quantised));
+				memcpy(bestPBits, pBits, sizeof(pBits));
+				memcpy(bestIndices, indices, sizeof(indices));
+			}
+			if (error == 0 || iteration == BLOCK_REFINE_ITERATIONS) {
+				break;
+			}
+
+			f32 weights[16];
+			for (u32 i = 0; i < 16; i++) {
+				weights[i] = bc7Weights[indices[i]] / 64.0f;
+			}
+			if (!leastSquares(colors, weights, 16, start, end)) {
+				break;
+			}
+
+			// The fit lets a channel that doesn't change drift, which would
+			// turn opaque blocks slightly transparent
+			for (u32 c = 0; c < 4; c++) {
+				bool constant = true;
+				for (u32 i = 1; i < 16; i++) {
+					constant = constant && colors[i][c] == colors[0][c];
+				}
+				if (constant) {
+					start[c] = colors[0][c];
+					end[c] = colors[0][c];
+				}
+			}
+		}
+
+		// The first index is stored a bit short, so its top bit has to be zero
+		if (bestIndices[0] >= 8) {
+			u8 swapped[4];
+			memcpy(swapped, bestEndpoints[0], 4);
+			memcpy(bestEndpoints[0], bestEndpoints[1], 4);
+			memcpy(bestEndpoints[1], swapped, 4);
+
+			const u8 pBit = bestPBits[0];
+			bestPBits[0] = bestPBits[1];
+			bestPBits[1] = pBit;
+
+			for (u8 &index : bestIndices) {
+				index = 15 - index;
+			}
+		}
+
+		memset(output, 0, 16);
+		BitStream stream = {};
+		stream.data = output;
+		stream.write(1 << 6, 7);
+		for (u32 c = 0; c < 4; c++) {
+			stream.write(bestEndpoints[0][c], 7);
+			stream.write(bestEndpoints[1][c], 7);
+		}
+		stream.write(bestPBits[0], 1);
+		stream.write(bestPBits[1], 1);
+		for (u32 i = 0; i < 16; i++) {
+			stream.write(bestIndices[i], i == 0 ? 3 : 4);
+		}
+	}
+
+	void decodeBc7(const u8 *block, u32 *pixels) {
+		BitStream stream = {};
+		stream.data = (u8*)block;
+
+		// Anything but mode 6 comes out magenta so it stands out
+		if (stream.read(7) != 1 << 6) {
+			for (u32 i = 0; i < 16; i++) {
+				pixels[i] = 0xffff00ff;
+			}
+			return;
+		}
+
+		u8 e0[4];
+		u8 e1[4];
+		for (u32 c = 0; c < 4; c++) {
+			e0[c] = (u8)(stream.read(7) << 1);
+			e1[c] = (u8)(stream.read(7) << 1);
+		}
+		const u32 p0 = stream.read(1);
+		const u32 p1 = stream.read(1);
+		for (u32 c = 0; c < 4; c++) {
+			e0[c] |= p0;
+			e1[c] |= p1;
+		}
+
+		u8 palette[16][4];
+		bc7Palette(e0, e1, palette);
+		for (u32 i = 0; i < 16; i++) {
+			const u8 *color = palette[stream.read(i == 0 ? 3 : 4)];
+			pixels[i] = pack(color[0], color[1], color[2], color[3]);
+		}
+	}
+
+	void encodeBlock(BlockFormat format, const u32 *pixels, u8 *output) {
+		switch (format) {
+			case BlockFormat::bc1: {
+				encodeBc1(pixels, output, true);
+			} break;
+
+			case BlockFormat::bc3: {
+				encodeAlpha(pixels, output);
+				encodeBc1(pixels, output + 8, false);
+			} break;
+
+			case BlockFormat::bc7: {
+				encodeBc7(pixels, output);
+			} break;
+
+			default: {
+				assert(false);
+			} break;
+		}
+	}
+
+	void decodeBlock(BlockFormat format, const u8 *block, u32 *pixels) {
+		switch (format) {
+			case BlockFormat::bc1: {
+				decodeBc1(block, pixels, false);
+			} break;
+
+			case BlockFormat::bc3: {
+				decodeBc1(block + 8, pixels, true);
+				decodeAlpha(block, pixels);
+			} break;
+
+			case BlockFormat::bc7: {
+				decodeBc7(block, pixels);
+			} break;
+
+			default: {
+				assert(false);
+			} break;
+		}
+	}
+
+	// Encodes block rows [rowStart, rowEnd) of an image, blocks hanging over
+	// the edge repeat the last row and column. Rows are independent so
+	// threads can take a range each.
+	void encodeRows(BlockFormat format, const u32 *pixels, u32 width, u32 height, u32 rowStart, u32 rowEnd, u8 *output) {
+		const u32 blocksWide = (width + 3) / 4;
+		const u32 bytes = blockBytes(format);
+
+		for (u32 blockY = rowStart; blockY < rowEnd; blockY++) {
+			for (u32 blockX = 0; blockX < blocksWide; blockX++) {
+				u32 block[16];
+				for (u32 y = 0; y < 4; y++) {
+					const u32 pixelY = blockY * 4 + y < height ? blockY * 4 + y : height - 1;
+					for (u32 x = 0; x < 4; x++) {
+						const u32 pixelX = blockX * 4 + x < width ? blockX * 4 + x : width - 1;
+						block[y * 4 + x] = pixels[(size_t)pixelY * width + pixelX];
+					}
+				}
+
+				encodeBlock(format, block, output + ((size_t)blockY * blocksWide + blockX) * bytes);
+			}
+		}
+	}
+
+	void decodeLevel(BlockFormat format, const u8 *blocks, u32 width, u32 height, u32 *pixels) {
+		const u32 blocksWide = (width + 3) / 4;
+		const u32 blocksHigh = (height + 3) / 4;
+		const u32 bytes = blockBytes(format);
+
+		for (u32 blockY = 0; blockY < blocksHigh; blockY++) {
+			for (u32 blockX = 0; blockX < blocksWide; blockX++) {
+				u32 block[16];
+				decodeBlock(format, blocks + ((size_t)blockY * blocksWide + blockX) * bytes, block);
+
+				for (u32 y = 0; y < 4 && blockY * 4 + y < height; y++) {
+					for (u32 x = 0; x < 4 && blockX * 4 + x < width; x++) {
+						pixels[(size_t)(blockY * 4 + y) * width + blockX * 4 + x] = block[y * 4 + x];
+					}
+				}
+			}
+		}
+	}
+
+	// Halves an image for the next mip, rounding odd sizes down. Colours are
+	// weighted by alpha so transparent pixels don't darken the edges.
+	void downsample(const u32 *pixels, u32 width, u32 height, u32 *output) {
+		const u32 outputWidth = width > 1 ? width / 2 : 1;
+		const u32 outputHeight = height > 1 ? height / 2 : 1;
+
+		for (u32 y = 0; y < outputHeight; y++) {
+			const u32 y0 = y * 2;
+			const u32 y1 = y * 2 + 1 < height ? y * 2 + 1 : height - 1;
+			for (u32 x = 0; x < outputWidth; x++) {
+				const u32 x0 = x * 2;
+				const u32 x1 = x * 2 + 1 < width ? x * 2 + 1 : width - 1;
+				const u32 samples[4] = {
+					pixels[(size_t)y0 * width + x0],
+					pixels[(size_t)y0 * width + x1],
+					pixels[(size_t)y1 * width + x0],
+					pixels[(size_t)y1 * width + x1]
+				};
+
+				u32 alpha = 0;
+				u32 weighted[3] = {};
+				u32 plain[3] = {};
+				for (u32 sample : samples) {
+					const u32 a = channel(sample, 3);
+					alpha += a;
+					for (u32 c = 0; c < 3; c++) {
+						weighted[c] += channel(sample, c) * a;
+						plain[c] += channel(sample, c);
+					}
+				}
+
+				u32 color[3];
+				for (u32 c = 0; c < 3; c++) {
+					color[c] = alpha > 0 ? (weighted[c] + alpha / 2) / alpha : (plain[c] + 2) / 4;
+				}
+				output[(size_t)y * outputWidth + x] = pack(color[0], color[1], color[2], (alpha + 2) / 4);
+			}
+		}
+	}
+};
\ No newline at end of file
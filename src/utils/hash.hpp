@@ -0,0 +1,14 @@
+#pragma once
+
+#include "types/core.hpp"
+
+// 64-bit FNV-1a. Pass the previous result as `hash` to hash several buffers
+// as one.
+u64 hashBytes(const void *data, size_t size, u64 hash = 0xcbf29ce484222325) {
+	const u8 *bytes = (const u8*)data;
+	for (size_t i = 0; i < size; i++) {
+		hash ^= bytes[i];
+		hash *= 0x100000001b3;
+	}
+	return hash;
+}
\ No newline at end of file
@@ -0,0 +1,587 @@
+#pragma once
+
+#include <cmath>
+#include <cstring>
+
+#include "types/core.hpp"
+#include "types/image.hpp"
+#include "utils/memory.hpp"
+
+// Decodes baseline JPEGs without WIC so tools that work on images also build
+// on Linux. Progressive and arithmetic coded files aren't handled, nor are
+// CMYK ones. Chroma is upsampled by repeating samples, so colour edges come
+// out a little blockier than WIC's.
+//
+// Example:
+//
+//     Image image;
+//     if (Jpeg::decode(fileData, fileSize, &image)) {
+//         ...
+//         Memory::release(image.pixels);
+//     }
+//
+namespace Jpeg {
+	#define JPEG_COMPONENT_MAX 3
+	#define JPEG_SIZE_MAX 16384
+
+	// Where each coefficient in the stream goes in the 8x8 block
+	const u8 zigzag[64] = {
+		0, 1, 8, 16, 9, 2, 3, 10,
+		17, 24, 32, 25, 18, 11, 4, 5,
+		12, 19, 26, 33, 40, 48, 41, 34,
+		27, 20, 13, 6, 7, 14, 21, 28,
+		35, 42, 49, 56, 57, 50, 43, 36,
+		29, 22, 15, 23, 30, 37, 44, 51,
+		58, 59, 52, 45, 38, 31, 39, 46,
+		53, 60, 61, 54, 47, 55, 62, 63
+	};
+
+	struct Huffman {
+		s32 maxCode[18];
+		s32 valueOffset[17];
+		u8 values[256];
+		bool defined;
+	};
+
+	struct Component {
+		u8 id;
+		u8 horizontal;
+		u8 vertical;
+		u8 quantisationTable;
+		u8 dcTable;
+		u8 acTable;
+		s32 dcPrediction;
+		// Whole MCUs' worth of samples, cropped when converting to RGB
+		u8 *samples;
+		u32 stride;
+	};
+
+	struct Decoder {
+		const u8 *data;
+		size_t size;
+		size_t position;
+
+		u32 bitBuffer;
+		u32 bitCount;
+		// Set once the entropy coded data runs into a marker, after that it
+		// reads zeros
+		bool markerHit;
+
+		u16 quantisation[4][64];
+		Huffman dcTables[4];
+		Huffman acTables[4];
+		Component components[JPEG_COMPONENT_MAX];
+		u32 componentCount;
+		u32 width;
+		u32 height;
+		u32 maxHorizontal;
+		u32 maxVertical;
+		u32 mcusWide;
+		u32 mcusHigh;
+		u32 restartInterval;
+		bool frameRead;
+	};
+
+	u16 readBigEndian(const u8 *data) {
+		return (u16)((data[0] << 8) | data[1]);
+	}
+
+	void fillBits(Decoder *decoder) {
+		while (decoder->bitCount <= 24) {
+			u32 byte = 0;
+			if (!decoder->markerHit && decoder->position < decoder->size) {
+				byte = decoder->data[decoder->position];
+				if (byte == 0xff) {
+					const u8 next = decoder->position + 1 < decoder->size ? decoder->data[decoder->position + 1] : 0xd9;
+					if (next == 0x00) {
+						// A stuffed zero after a literal 0xff
+						decoder->position += 2;
+					} else {
+						decoder->markerHit = true;
+						byte = 0;
+					}
+				} else {
+					decoder->position++;
+				}
+			}
+
+			decoder->bitBuffer |= byte << (24 - decoder->bitCount);
+			decoder->bitCount += 8;
+		}
+	}
+
+	u32 readBits(Decoder *decoder, u32 count) {
+		if (count == 0) {
+			return 0;
+		}
+		if (decoder->bitCount < count) {
+			fillBits(decoder);
+		}
+
+		const u32 value = decoder->bitBuffer >> (32 - count);
+		decoder->bitBuffer <<= count;
+		decoder->bitCount -= count;
+		return value;
+	}
+
+	// Turns `count` bits into the signed value they encode
+	s32 receiveExtend(Decoder *decoder, u32 count) {
+		if (count == 0) {
+			return 0;
+		}
+		const s32 value = (s32)readBits(decoder, count);
+		return value < (1 << (count - 1)) ? value - (1 << count) + 1 : value;
+	}
+
+	// -1 for a code that isn't in the table
+	s32 decodeHuffman(Decoder *decoder, const Huffman &huffman) {
+		s32 code = 0;
+		for (u32 length = 1; length <= 16; length++) {
+			code = (code << 1) | (s32)readBits(decoder, 1);
+			if (code <= huffman.maxCode[length]) {
+				return huffman.values[huffman.valueOffset[length] + code];
+			}
+		}
+		return -1;
+	}
+
+	bool readHuffmanTables(Decoder *decoder, const u8 *segment, u32 length) {
+		u32 offset = 0;
+		while (offset + 17 <= length) {
+			const u8 tableClass = segment[offset] >> 4;
+			const u8 tableId = segment[offset] & 0x0f;
+			if (tableClass > 1 || tableId > 3) {
+				return false;
+			}
+
+			const u8 *counts = segment + offset + 1;
+			u32 total = 0;
+			for (u32 i = 0; i < 16; i++) {
+				total += counts[i];
+			}
+			if (total > 256 || offset + 17 + total > length) {
+				return false;
+			}
+
+			Huffman &huffman = tableClass == 0 ? decoder->dcTables[tableId] : decoder->acTables[tableId];
+			memcpy(huffman.values, segment + offset + 17, total);
+
+			// Codes of each length are consecutive, so a code is in the table
+			// if it's no more than the biggest of its length
+			s32 code = 0;
+			s32 index = 0;
+			for (u32 length = 1; length <= 16; length++) {
+				const s32 count = counts[length - 1];
+				huffman.valueOffset[length] = index - code;
+				code += count;
+				index += count;
+				huffman.maxCode[length] = count > 0 ? code - 1 : -1;
+				code <<= 1;
+			}
+			huffman.maxCode[17] = 0x7fffffff;
+			huffman.defined = true;
+
+			offset += 17 + total;
+		}
+		return offset == length;
+	}
+
+	bool readQuantisationTables(Decoder *decoder, const u8 *segment, u32 length) {
+		u32 offset = 0;
+		while (offset < length) {
+			const u8 precision = segment[offset] >> 4;
+			const u8 tableId = segment[offset] & 0x0f;
+			const u32 tableSize = precision == 0 ? 64 : 128;
+			if (tableId > 3 || precision > 1 || offset + 1 + tableSize > length) {
+				return false;
+			}
+
+			// Kept in stream order, the same as the coefficients
+			for (u32 i = 0; i < 64; i++) {
+				decoder->quantisation[tableId][i] = precision == 0 ? segment[offset + 1 + i] : readBigEndian(segment + offset + 1 + i * 2);
+			}
+			offset += 1 + tableSize;
+		}
+		return true;
+	}
+
+	bool readFrame(Decoder *decoder, const u8 *segment, u32 length) {
+		if (length < 6 || segment[0] != 8 || decoder->frameRead) {
+			return false;
+		}
+
+		decoder->height = readBigEndian(segment + 1);
+		decoder->width = readBigEndian(segment + 3);
+		decoder->componentCount = segment[5];
+		if (
+			decoder->width == 0 || decoder->height == 0 ||
+			decoder->width > JPEG_SIZE_MAX || decoder->height > JPEG_SIZE_MAX ||
+			(decoder->componentCount != 1 && decoder->componentCount != 3) ||
+			length < 6 + decoder->componentCount * 3
+		) {
+			return false;
+		}
+
+		decoder->maxHorizontal = 1;
+		decoder->maxVertical = 1;
+		for (u32 i = 0; i < decoder->componentCount; i++) {
+			Component &component = decoder->components[i];
+			component.id = segment[6 + i * 3];
+			component.horizontal = segment[7 + i * 3] >> 4;
+			component.vertical = segment[7 + i * 3] & 0x0f;
+			component.quantisationTable = segment[8 + i * 3];
+			if (component.horizontal < 1 || component.horizontal > 2 || component.vertical < 1 || component.vertical > 2 || component.quantisationTable > 3) {
+				return false;
+			}
+			decoder->maxHorizontal = component.horizontal > decoder->maxHorizontal ? component.horizontal : decoder->maxHorizontal;
+			decoder->maxVertical = component.vertical > decoder->maxVertical ? component.vertical : decoder->maxVertical;
+		}
+
+		decoder->mcusWide = (decoder->width + decoder->maxHorizontal * 8 - 1) / (decoder->maxHorizontal * 8);
+		decoder->mcusHigh = (decoder->height + decoder->maxVertical * 8 - 1) / (decoder->maxVertical * 8);
+		for (u32 i = 0; i < decoder->componentCount; i++) {
+			Component &component = decoder->components[i];
+			component.stride = decoder->mcusWide * component.horizontal * 8;
+			const size_t sampleCount = (size_t)component.stride * decoder->mcusHigh * component.vertical * 8;
+			component.samples = Memory::allocateArray<u8>(MemoryTag::textures, sampleCount);
+			memset(component.samples, 0, sampleCount);
+		}
+
+		decoder->frameRead = true;
+		return true;
+	}
+
+	// Separable float IDCT, writes the block shifted back to 0-255
+	void inverseTransform(const f32 *coefficients, u8 *output, u32 stride) {
+		static f32 table[8][8];
+		static bool tableBuilt = false;
+		if (!tableBuilt) {
+			for (u32 x = 0; x < 8; x++) {
+				for (u32 u = 0; u < 8; u++) {
+					const f32 scale = u == 0 ? 0.70710678f : 1.0f;
+					table[x][u] = 0.5f * scale * cosf((2.0f * x + 1.0f) * u * 3.14159265f / 16.0f);
+				}
+			}
+			tableBuilt = true;
+		}
+
+		f32 rows[64];
+		for (u32 y = 0; y < 8; y++) {
+			const f32 *row = coefficients + y * 8;
+			for (u32 x = 0; x < 8; x++) {
+				f32 sum = 0.0f;
+				for (u32 u = 0; u < 8; u++) {
+					sum += table[x][u] * row[u];
+				}
+				rows[y * 8 + x] = sum;
+			}
+		}
+
+		for (u32 x = 0; x < 8; x++) {
+			for (u32 y = 0; y < 8; y++) {
+				f32 sum = 0.0f;
+				for (u32 v = 0; v < 8; v++) {
+					sum += table[y][v] * rows[v * 8 + x];
+				}
+
+				const s32 value = (s32)floorf(sum + 128.5f);
+				output[y * stride + x] = (u8)(value < 0 ? 0 : (value > 255 ? 255 : value));
+			}
+		}
+	}
+
+	bool decodeBlock(Decoder *decoder, Component *component, u32 blockX, u32 blockY) {
+		const Huffman &dcTable = decoder->dcTables[component->dcTable];
+		const Huffman &acTable = decoder->acTables[component->acTable];
+		const u16 *quantisation = decoder->quantisation[component->quantisationTable];
+
+		f32 coefficients[64] = {};
+
+		const s32 dcSize = decodeHuffman(decoder, dcTable);
+		if (dcSize < 0 || dcSize > 11) {
+			return false;
+		}
+		component->dcPrediction += receiveExtend(decoder, (u32)dcSize);
+		coefficients[0] = (f32)(component->dcPrediction * quantisation[0]);
+
+		for (u32 k = 1; k < 64;) {
+			const s32 symbol = decodeHuffman(decoder, acTable);
+			if (symbol < 0) {
+				return false;
+			}
+
+			const u32 run = (u32)symbol >> 4;
+			const u32 size = (u32)symbol & 0x0f;
+			if (size == 0) {
+				// Either sixteen zeros or the rest of the block is
+				if (run != 15) {
+					break;
+				}
+				k += 16;
+				continue;
+			}
+
+			k += run;
+			if (k > 63) {
+				return false;
+			}
+			coefficients[zigzag[k]] = (f32)(receiveExtend(decoder, size) * quantisation[k]);
+			k++;
+		}
+
+		u8 *output = component->samples + (size_t)blockY * 8 * component->stride + blockX * 8;
+		inverseTransform(coefficients, output, component->stride);
+		return true;
+	}
+
+	// Skips the RSTn marker and starts the prediction over
+	bool restart(Decoder *decoder) {
+		decoder->bitBuffer = 0;
+		decoder->bitCount = 0;
+		decoder->markerHit = false;
+
+		if (
+			decoder->position + 2 > decoder->size ||
+			decoder->data[decoder->position] != 0xff ||
+			(decoder->data[decoder->position + 1] & 0xf8) != 0xd0
+		) {
+			return false;
+		}
+		decoder->position += 2;
+
+		for (u32 i = 0; i < decoder->componentCount; i++) {
+			decoder->components[i].dcPrediction = 0;
+		}
+		return true;
+	}
+
+	bool readScan(Decoder *decoder, const u8 *segment, u32 length) {
+		if (!decoder->frameRead || length < 1) {
+			return false;
+		}
+
+		const u32 scanCount = segment[0];
+		if (scanCount < 1 || scanCount > decoder->componentCount || length < 4 + scanCount * 2) {
+			return false;
+		}
+
+		Component *scanComponents[JPEG_COMPONENT_MAX];
+		for (u32 i = 0; i < scanCount; i++) {
+			const u8 id = segment[1 + i * 2];
+			const u8 tables = segment[2 + i * 2];
+
+			scanComponents[i] = nullptr;
+			for (u32 j = 0; j < decoder->componentCount; j++) {
+				if (decoder->components[j].id == id) {
+					scanComponents[i] = &decoder->components[j];
+				}
+			}
+
+			if (scanComponents[i] == nullptr || (tables >> 4) > 3 || (tables & 0x0f) > 3) {
+				return false;
+			}
+			scanComponents[i]->dcTable = tables >> 4;
+			scanComponents[i]->acTable = tables & 0x0f;
+			scanComponents[i]->dcPrediction = 0;
+			if (!decoder->dcTables[tables >> 4].defined || !decoder->acTables[tables & 0x0f].defined) {
+				return false;
+			}
+		}
+
+		// Spectral selection and successive approximation are progressive only
+		const u8 *selection = segment + 1 + scanCount * 2;
+		if (selection[0] != 0 || selection[1] != 63 || selection[2] != 0) {
+			return false;
+		}
+
+		decoder->bitBuffer = 0;
+		decoder->bitCount = 0;
+		decoder->markerHit = false;
+
+		// A single component scan isn't interleaved, its blocks are in plain
+		// raster order covering just the component
+		u32 unitsWide = decoder->mcusWide;
+		u32 unitsHigh = decoder->mcusHigh;
+		if (scanCount == 1) {
+			const Component &component = *scanComponents[0];
+			const u32 componentWidth = (decoder->width * component.horizontal + decoder->maxHorizontal - 1) / decoder->maxHorizontal;
+			const u32 componentHeight = (decoder->height * component.vertical + decoder->maxVertical - 1) / decoder->maxVertical;
+			unitsWide = (componentWidth + 7) / 8;
+			unitsHigh = (componentHeight + 7) / 8;
+		}
+
+		u32 unitsToRestart = decoder->restartInterval;
+		for (u32 unitY = 0; unitY < unitsHigh; unitY++) {
+			for (u32 unitX = 0; unitX < unitsWide; unitX++) {
+				if (decoder->restartInterval != 0) {
+					if (unitsToRestart == 0) {
+						if (!restart(decoder)) {
+							return false;
+						}
+						unitsToRestart = decoder->restartInterval;
+					}
+					unitsToRestart--;
+				}
+
+				if (scanCount == 1) {
+					if (!decodeBlock(decoder, scanComponents[0], unitX, unitY)) {
+						return false;
+					}
+					continue;
+				}
+
+				for (u32 i = 0; i < scanCount; i++) {
+					Component *component = scanComponents[i];
+					for (u32 y = 0; y < component->vertical; y++) {
+						for (u32 x = 0; x < component->horizontal; x++) {
+							if (!decodeBlock(decoder, component, unitX * component->horizontal + x, unitY * component->vertical + y)) {
+								return false;
+							}
+						}
+					}
+				}
+			}
+		}
+
+		// Carry on from the marker that ends the scan, skipping any padding
+		// that's left of the entropy coded data
+		while (decoder->position + 1 < decoder->size) {
+			if (decoder->data[decoder->position] == 0xff) {
+				const u8 next = decoder->data[decoder->position + 1];
+				if (next != 0x00 && (next & 0xf8) != 0xd0) {
+					return true;
+				}
+			}
+			decoder->position++;
+		}
+		return false;
+	}
+
+	void convert(const Decoder &decoder, u32 *pixels) {
+		const Component &luma = decoder.components[0];
+		for (u32 y = 0; y < decoder.height; y++) {
+			u32 *row = pixels + (size_t)y * decoder.width;
+
+			if (decoder.componentCount == 1) {
+				const u8 *samples = luma.samples + (size_t)y * luma.stride;
+				for (u32 x = 0; x < decoder.width; x++) {
+					row[x] = 0xff000000 | samples[x] * 0x010101u;
+				}
+				continue;
+			}
+
+			const Component &blue = decoder.components[1];
+			const Component &red = decoder.components[2];
+			const u8 *lumaRow = luma.samples + (size_t)(y * luma.vertical / decoder.maxVertical) * luma.stride;
+			const u8 *blueRow = blue.samples + (size_t)(y * blue.vertical / decoder.maxVertical) * blue.stride;
+			const u8 *redRow = red.samples + (size_t)(y * red.vertical / decoder.maxVertical) * red.stride;
+
+			for (u32 x = 0; x < decoder.width; x++) {
+				const f32 l = lumaRow[x * luma.horizontal / decoder.maxHorizontal];
+				const f32 cb = blueRow[x * blue.horizontal / decoder.maxHorizontal] - 128.0f;
+				const f32 cr = redRow[x * red.horizontal / decoder.maxHorizontal] - 128.0f;
+
+				const s32 r = (s32)(l + 1.402f * cr + 0.5f);
+				const s32 g = (s32)(l - 0.344136f * cb - 0.714136f * cr + 0.5f);
+				const s32 b = (s32)(l + 1.772f * cb + 0.5f);
+				row[x] =
+					0xff000000 |
+					(u32)(r < 0 ? 0 : (r > 255 ? 255 : r)) |
+					((u32)(g < 0 ? 0 : (g > 255 ? 255 : g)) << 8) |
+					((u32)(b < 0 ? 0 : (b > 255 ? 255 : b)) << 16);
+			}
+		}
+	}
+
+	bool decode(const u8 *data, size_t size, Image *image) {
+		*image = {};
+		if (size < 4 || data[0] != 0xff || data[1] != 0xd8) {
+			return false;
+		}
+
+		Decoder *decoder = Memory::create<Decoder>(MemoryTag::textures);
+		*decoder = {};
+		decoder->data = data;
+		decoder->size = size;
+		decoder->position = 2;
+
+		bool succeeded = true;
+		bool finished = false;
+		while (succeeded && !finished) {
+			if (decoder->position + 2 > decoder->size || decoder->data[decoder->position] != 0xff) {
+				succeeded = false;
+				break;
+			}
+
+			const u8 marker = decoder->data[decoder->position + 1];
+			// Any number of 0xff can pad out the space before a marker
+			if (marker == 0xff) {
+				decoder->position++;
+				continue;
+			}
+			if (marker == 0xd9) {
+				finished = true;
+				break;
+			}
+
+			if (decoder->position + 4 > decoder->size) {
+				succeeded = false;
+				break;
+			}
+			const u32 length = readBigEndian(decoder->data + decoder->position + 2);
+			if (length < 2 || decoder->position + 2 + length > decoder->size) {
+				succeeded = false;
+				break;
+			}
+			const u8 *segment = decoder->data + decoder->position + 4;
+			const u32 segmentLength = length - 2;
+			decoder->position += 2 + length;
+
+			switch (marker) {
+				// Baseline and extended sequential, both Huffman coded
+				case 0xc0:
+				case 0xc1: {
+					succeeded = readFrame(decoder, segment, segmentLength);
+				} break;
+
+				case 0xc4: {
+					succeeded = readHuffmanTables(decoder, segment, segmentLength);
+				} break;
+
+				case 0xdb: {
+					succeeded = readQuantisationTables(decoder, segment, segmentLength);
+				} break;
+
+				case 0xdd: {
+					succeeded = segmentLength >= 2;
+					decoder->restartInterval = succeeded ? readBigEndian(segment) : 0;
+				} break;
+
+				case 0xda: {
+					succeeded = readScan(decoder, segment, segmentLength);
+				} break;
+
+				default: {
+					// Any other frame type is progressive, lossless or
+					// arithmetic coded
+					const bool frame = marker >= 0xc2 && marker <= 0xcf && marker != 0xc4 && marker != 0xc8 && marker != 0xcc;
+					succeeded = !frame;
+				} break;
+			}
+		}
+
+		if (succeeded && decoder->frameRead) {
+			image->width = decoder->width;
+			image->height = decoder->height;
+			image->pixels = Memory::allocateArray<u32>(MemoryTag::textures, (size_t)decoder->width * decoder->height);
+			convert(*decoder, image->pixels);
+		}
+
+		for (Component &component : decoder->components) {
+			Memory::release(component.samples);
+		}
+		Memory::destroy(decoder);
+
+		return succeeded && image->pixels != nullptr;
+	}
+};
\ No newline at end of file
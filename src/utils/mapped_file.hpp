@@ -0,0 +1,135 @@
+#pragma once
+
+#include <cassert>
+
+#include "types/core.hpp"
+
+#if defined(_WIN32)
+	#include <Windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+// A read only view of a whole file, paged in by the OS as it's read instead of
+// copied into a buffer up front. Pages that haven't been read yet fault the
+// first time they are, `prefault` reads them ahead on a thread that can afford
+// to wait.
+//
+// Example:
+//
+//     MappedFile file;
+//     if (file.open("assets/music/mars.wav")) {
+//         Riff::readWave(file.data, file.size, &wave);
+//         ...
+//         file.close();
+//     }
+//
+struct MappedFile {
+	const u8 *data = nullptr;
+	size_t size = 0;
+#if defined(_WIN32)
+	HANDLE mapping = NULL;
+#endif
+
+#if defined(_WIN32)
+	bool open(const wchar_t *path) {
+		HANDLE file = CreateFileW(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		return this->map(file);
+	}
+
+	bool open(const char *path) {
+		HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		return this->map(file);
+	}
+#else
+	bool open(const char *path) {
+		assert(this->data == nullptr);
+
+		const int file = ::open(path, O_RDONLY);
+		if (file < 0) {
+			return false;
+		}
+
+		struct stat status;
+		if (fstat(file, &status) != 0 || status.st_size <= 0) {
+			::close(file);
+			return false;
+		}
+
+		void *view = mmap(nullptr, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+		// The mapping keeps the file open
+		::close(file);
+		if (view == MAP_FAILED) {
+			return false;
+		}
+
+		this->data = (const u8*)view;
+		this->size = (size_t)status.st_size;
+		return true;
+	}
+#endif
+
+	void close() {
+		if (this->data == nullptr) {
+			return;
+		}
+
+#if defined(_WIN32)
+		UnmapViewOfFile(this->data);
+		CloseHandle(this->mapping);
+		this->mapping = NULL;
+#else
+		munmap((void*)this->data, this->size);
+#endif
+		this->data = nullptr;
+		this->size = 0;
+	}
+
+	// Touches a byte of every page in the range so reading it later doesn't
+	// stall, returns something from them so it isn't optimised away
+	u32 prefault(size_t offset, size_t length) const {
+		const size_t pageSize = 4096;
+		const size_t end = offset + length < this->size ? offset + length : this->size;
+		u32 sum = 0;
+		for (size_t i = offset; i < end; i += pageSize) {
+			sum += this->data[i];
+		}
+		return sum;
+	}
+
+#if defined(_WIN32)
+protected:
+	bool map(HANDLE file) {
+		assert(this->data == nullptr);
+		if (file == INVALID_HANDLE_VALUE) {
+			return false;
+		}
+
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart <= 0) {
+			CloseHandle(file);
+			return false;
+		}
+
+		// The mapping keeps the file open
+		this->mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		CloseHandle(file);
+		if (this->mapping == NULL) {
+			return false;
+		}
+
+		this->data = (const u8*)MapViewOfFile(this->mapping, FILE_MAP_READ, 0, 0, 0);
+		if (this->data == nullptr) {
+			CloseHandle(this->mapping);
+			this->mapping = NULL;
+			return false;
+		}
+
+		this->size = (size_t)fileSize.QuadPart;
+		return true;
+	}
+#endif
+};
\ No newline at end of file
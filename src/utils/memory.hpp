@@ -0,0 +1,182 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <utility>
+
+#include "types/core.hpp"
+
+enum class MemoryTag : u8 {
+	game,
+	renderer,
+	textures,
+	sound,
+	input,
+	profiler,
+	_length
+};
+
+const char *memoryTagNames[] = {
+	"game",
+	"renderer",
+	"textures",
+	"sound",
+	"input",
+	"profiler"
+};
+
+struct MemoryTagStats {
+	u64 live;
+	u64 peak;
+	u64 liveAllocations;
+	u64 totalAllocations;
+	u64 budget;
+};
+
+// Every heap allocation goes through here with the subsystem it belongs to so
+// that we know what each part of the game is holding on to, can catch leaks
+// at shutdown and can assert when a subsystem grows past its budget.
+//
+// Example:
+//
+//     Memory::setBudget(MemoryTag::textures, 64 * MEGABYTE);
+//
+//     BYTE *pixels = Memory::allocateArray<BYTE>(MemoryTag::textures, size);
+//     ...
+//     Memory::release(pixels);
+//
+//     Foo *foo = Memory::create<Foo>(MemoryTag::game, 1, 2);
+//     Memory::destroy(foo);
+//
+namespace Memory {
+	#define KILOBYTE 1024ull
+	#define MEGABYTE (1024ull * KILOBYTE)
+
+	// Sits in front of every allocation. Kept at 16 bytes so the memory handed
+	// out keeps the same alignment malloc gives us.
+	struct alignas(16) Header {
+		u64 size;
+		MemoryTag tag;
+	};
+
+	struct TagCounters {
+		std::atomic<u64> live;
+		std::atomic<u64> peak;
+		std::atomic<u64> liveAllocations;
+		std::atomic<u64> totalAllocations;
+		std::atomic<u64> budget;
+	};
+
+	static TagCounters counters[(size_t)MemoryTag::_length];
+
+	void setBudget(MemoryTag tag, u64 bytes) {
+		counters[(size_t)tag].budget = bytes;
+		assert(counters[(size_t)tag].live <= bytes && "Memory budget exceeded");
+	}
+
+	MemoryTagStats stats(MemoryTag tag) {
+		const TagCounters &counter = counters[(size_t)tag];
+
+		MemoryTagStats result = {};
+		result.live = counter.live.load();
+		result.peak = counter.peak.load();
+		result.liveAllocations = counter.liveAllocations.load();
+		result.totalAllocations = counter.totalAllocations.load();
+		result.budget = counter.budget.load();
+		return result;
+	}
+
+	void *allocate(MemoryTag tag, size_t size) {
+		assert(tag < MemoryTag::_length);
+
+		Header *header = (Header*)malloc(sizeof(Header) + size);
+		assert(header != nullptr);
+		header->size = size;
+		header->tag = tag;
+
+		TagCounters &counter = counters[(size_t)tag];
+		const u64 live = counter.live.fetch_add(size) + size;
+		counter.liveAllocations++;
+		counter.totalAllocations++;
+
+		u64 peak = counter.peak.load();
+		while (live > peak && !counter.peak.compare_exchange_weak(peak, live)) {}
+
+		assert((counter.budget.load() == 0 || live <= counter.budget.load()) && "Memory budget exceeded");
+
+		return header + 1;
+	}
+
+	void release(void *pointer) {
+		if (pointer == nullptr) {
+			return;
+		}
+
+		Header *header = (Header*)pointer - 1;
+		TagCounters &counter = counters[(size_t)header->tag];
+		assert(counter.live >= header->size && counter.liveAllocations > 0);
+		counter.live -= header->size;
+		counter.liveAllocations--;
+
+		free(header);
+	}
+
+	template<typename T>
+	T *allocateArray(MemoryTag tag, size_t count) {
+		return (T*)allocate(tag, sizeof(T) * count);
+	}
+
+	template<typename T, typename... Args>
+	T *create(MemoryTag tag, Args&&... args) {
+		static_assert(alignof(T) <= alignof(Header), "Memory::create doesn't support over aligned types");
+		return new (allocate(tag, sizeof(T))) T(std::forward<Args>(args)...);
+	}
+
+	template<typename T>
+	void destroy(T *pointer) {
+		if (pointer == nullptr) {
+			return;
+		}
+
+		pointer->~T();
+		release(pointer);
+	}
+
+	// Writes the per tag counters and returns how many tags still have live
+	// allocations, call once everything has been torn down to find leaks.
+	size_t writeReport(const char *path) {
+		FILE *file = fopen(path, "w");
+
+		size_t leakingTags = 0;
+		for (size_t i = 0; i < (size_t)MemoryTag::_length; i++) {
+			const MemoryTagStats tagStats = stats((MemoryTag)i);
+			if (tagStats.liveAllocations > 0) {
+				leakingTags++;
+			}
+
+			if (file == nullptr) {
+				continue;
+			}
+
+			fprintf(
+				file,
+				"%-10s live %10llu bytes in %llu allocations, peak %10llu bytes, %llu allocations in total, budget %llu%s\n",
+				memoryTagNames[i],
+				tagStats.live,
+				tagStats.liveAllocations,
+				tagStats.peak,
+				tagStats.totalAllocations,
+				tagStats.budget,
+				tagStats.liveAllocations > 0 ? " (LEAKED)" : ""
+			);
+		}
+
+		if (file != nullptr) {
+			fclose(file);
+		}
+		return leakingTags;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,751 @@
+#pragma once
+
+#include <cassert>
+#include <cstring>
+
+#include "types/core.hpp"
+#include "types/image.hpp"
+#include "utils/memory.hpp"
+
+// Reads and writes PNGs without WIC so tools that work on images also build on
+// Linux. Decoding handles the 8-bit non-interlaced images the art is saved as
+// (grey, grey alpha, RGB, RGBA and palettes), encoding always writes RGBA with
+// a fixed Huffman deflate, which is smaller than storing the pixels raw but
+// nowhere near as small as a real compressor manages.
+//
+// Example:
+//
+//     Image image;
+//     if (Png::decode(fileData, fileSize, &image)) {
+//         ...
+//         Memory::release(image.pixels);
+//     }
+//
+//     size_t size;
+//     u8 *data = Png::encode(image.pixels, image.width, image.height, &size);
+//
+namespace Png {
+	#define PNG_SIZE_MAX 16384
+	#define PNG_DEFLATE_WINDOW 32768
+	#define PNG_DEFLATE_HASH_BITS 15
+	#define PNG_DEFLATE_CHAIN_MAX 32
+
+	const u8 signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+
+	const u16 lengthBases[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+	const u8 lengthExtraBits[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+	const u16 distanceBases[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+	const u8 distanceExtraBits[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+	// The order code lengths for the code length alphabet are stored in
+	const u8 codeLengthOrder[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+	enum class ColorType : u8 {
+		grey = 0,
+		rgb = 2,
+		palette = 3,
+		greyAlpha = 4,
+		rgba = 6
+	};
+
+	u32 readBigEndian(const u8 *data) {
+		return ((u32)data[0] << 24) | ((u32)data[1] << 16) | ((u32)data[2] << 8) | data[3];
+	}
+
+	void writeBigEndian(u8 *data, u32 value) {
+		data[0] = (u8)(value >> 24);
+		data[1] = (u8)(value >> 16);
+		data[2] = (u8)(value >> 8);
+		data[3] = (u8)value;
+	}
+
+	u32 crc(const u8 *data, size_t size, u32 crc = 0) {
+		static u32 table[256];
+		static bool tableBuilt = false;
+		if (!tableBuilt) {
+			for (u32 i = 0; i < 256; i++) {
+				u32 value = i;
+				for (u32 bit = 0; bit < 8; bit++) {
+					value = value & 1 ? 0xedb88320 ^ (value >> 1) : value >> 1;
+				}
+				table[i] = value;
+			}
+			tableBuilt = true;
+		}
+
+		crc = ~crc;
+		for (size_t i = 0; i < size; i++) {
+			crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+		}
+		return ~crc;
+	}
+
+	u32 adler(const u8 *data, size_t size) {
+		u32 a = 1;
+		u32 b = 0;
+		for (size_t i = 0; i < size; i++) {
+			a = (a + data[i]) % 65521;
+			b = (b + a) % 65521;
+		}
+		return (b << 16) | a;
+	}
+
+	u8 paeth(u8 a, u8 b, u8 c) {
+		const s32 p = (s32)a + b - c;
+		const s32 pa = p > a ? p - a : a - p;
+		const s32 pb = p > b ? p - b : b - p;
+		const s32 pc = p > c ? p - c : c - p;
+		if (pa <= pb && pa <= pc) {
+			return a;
+		}
+		return pb <= pc ? b : c;
+	}
+
+	// Canonical Huffman code, decoded a bit at a time
+	struct Huffman {
+		u16 counts[16];
+		u16 symbols[288];
+	};
+
+	// Fails if the lengths ask for more codes than there's room for
+	bool buildHuffman(Huffman *huffman, const u8 *lengths, u32 count) {
+		memset(huffman->counts, 0, sizeof(huffman->counts));
+		for (u32 i = 0; i < count; i++) {
+			huffman->counts[lengths[i]]++;
+		}
+		huffman->counts[0] = 0;
+
+		s32 left = 1;
+		for (u32 length = 1; length < 16; length++) {
+			left = (left << 1) - huffman->counts[length];
+			if (left < 0) {
+				return false;
+			}
+		}
+
+		u16 offsets[16];
+		offsets[1] = 0;
+		for (u32 length = 1; length < 15; length++) {
+			offsets[length + 1] = offsets[length] + huffman->counts[length];
+		}
+		for (u32 i = 0; i < count; i++) {
+			if (lengths[i] != 0) {
+				huffman->symbols[offsets[lengths[i]]++] = (u16)i;
+			}
+		}
+		return true;
+	}
+
+	struct InflateStream {
+		const u8 *data;
+		size_t size;
+		size_t position = 0;
+		u32 bitBuffer = 0;
+		u32 bitCount = 0;
+		bool overflow = false;
+
+		u8 *output;
+		size_t outputSize;
+		size_t outputLength = 0;
+
+		u32 bits(u32 count) {
+			while (this->bitCount < count) {
+				if (this->position == this->size) {
+					this->overflow = true;
+					return 0;
+				}
+				this->bitBuffer |= (u32)this->data[this->position++] << this->bitCount;
+				this->bitCount += 8;
+			}
+
+			const u32 value = this->bitBuffer & ((1u << count) - 1);
+			this->bitBuffer >>= count;
+			this->bitCount -= count;
+			return value;
+		}
+
+		// -1 for a code that isn't in the table
+		s32 decode(const Huffman &huffman) {
+			s32 code = 0;
+			s32 first = 0;
+			s32 index = 0;
+			for (u32 length = 1; length < 16; length++) {
+				code |= this->bits(1);
+				const s32 count = huffman.counts[length];
+				if (code - first < count) {
+					return huffman.symbols[index + code - first];
+				}
+				index += count;
+				first = (first + count) << 1;
+				code <<= 1;
+			}
+			return -1;
+		}
+	};
+
+	bool inflateStored(InflateStream *stream) {
+		// Stored blocks start on a byte boundary
+		stream->bitBuffer = 0;
+		stream->bitCount = 0;
+
+		if (stream->position + 4 > stream->size) {
+			return false;
+		}
+		const u8 *header = stream->data + stream->position;
+		const u32 length = header[0] | (header[1] << 8);
+		const u32 inverse = header[2] | (header[3] << 8);
+		stream->position += 4;
+
+		if (
+			length != (~inverse & 0xffff) ||
+			stream->position + length > stream->size ||
+			stream->outputLength + length > stream->outputSize
+		) {
+			return false;
+		}
+
+		memcpy(stream->output + stream->outputLength, stream->data + stream->position, length);
+		stream->position += length;
+		stream->outputLength += length;
+		return true;
+	}
+
+	bool inflateCodes(InflateStream *stream, const Huffman &lengths, const Huffman &distances) {
+		while (true) {
+			const s32 symbol = stream->decode(lengths);
+			if (symbol < 0 || stream->overflow) {
+				return false;
+			}
+
+			if (symbol < 256) {
+				if (stream->outputLength == stream->outputSize) {
+					return false;
+				}
+				stream->output[stream->outputLength++] = (u8)symbol;
+				continue;
+			}
+
+			if (symbol == 256) {
+				return true;
+			}
+
+			const u32 lengthIndex = symbol - 257;
+			if (lengthIndex >= 29) {
+				return false;
+			}
+			const u32 length = lengthBases[lengthIndex] + stream->bits(lengthExtraBits[lengthIndex]);
+
+			const s32 distanceIndex = stream->decode(distances);
+			if (distanceIndex < 0 || distanceIndex >= 30) {
+				return false;
+			}
+			const u32 distance = distanceBases[distanceIndex] + stream->bits(distanceExtraBits[distanceIndex]);
+
+			if (stream->overflow || distance > stream->outputLength || stream->outputLength + length > stream->outputSize) {
+				return false;
+			}
+
+			// Byte at a time since the copy can overlap what it's writing
+			u8 *to = stream->output + stream->outputLength;
+			const u8 *from = to - distance;
+			for (u32 i = 0; i < length; i++) {
+				to[i] = from[i];
+			}
+			stream->outputLength += length;
+		}
+	}
+
+	bool inflateDynamic(InflateStream *stream) {
+		const u32 lengthCount = stream->bits(5) + 257;
+		const u32 distanceCount = stream->bits(5) + 1;
+		const u32 codeLengthCount = stream->bits(4) + 4;
+		if (lengthCount > 286 || distanceCount > 30) {
+			return false;
+		}
+
+		u8 lengths[286 + 30] = {};
+		for (u32 i = 0; i < codeLengthCount; i++) {
+			lengths[codeLengthOrder[i]] = (u8)stream->bits(3);
+		}
+
+		Huffman codeLengths;
+		if (!buildHuffman(&codeLengths, lengths, 19)) {
+			return false;
+		}
+
+		memset(lengths, 0, sizeof(lengths));
+		u32 index = 0;
+		while (index < lengthCount + distanceCount) {
+			const s32 symbol = stream->decode(codeLengths);
+			if (symbol < 0 || stream->overflow) {
+				return false;
+			}
+
+			if (symbol < 16) {
+				lengths[index++] = (u8)symbol;
+				continue;
+			}
+
+			u8 repeated = 0;
+			u32 repeat = 0;
+			if (symbol == 16) {
+				if (index == 0) {
+					return false;
+				}
+				repeated = lengths[index - 1];
+				repeat = 3 + stream->bits(2);
+			} else if (symbol == 17) {
+				repeat = 3 + stream->bits(3);
+			} else {
+				repeat = 11 + stream->bits(7);
+			}
+
+			if (index + repeat > lengthCount + distanceCount) {
+				return false;
+			}
+			while (repeat-- > 0) {
+				lengths[index++] = repeated;
+			}
+		}
+
+		// Without an end of block code the block can never finish
+		if (lengths[256] == 0) {
+			return false;
+		}
+
+		Huffman lengthCodes;
+		Huffman distanceCodes;
+		return
+			buildHuffman(&lengthCodes, lengths, lengthCount) &&
+			buildHuffman(&distanceCodes, lengths + lengthCount, distanceCount) &&
+			inflateCodes(stream, lengthCodes, distanceCodes);
+	}
+
+	bool inflateFixed(InflateStream *stream) {
+		static Huffman lengthCodes;
+		static Huffman distanceCodes;
+		static bool built = false;
+		if (!built) {
+			u8 lengths[288];
+			memset(lengths, 8, 144);
+			memset(lengths + 144, 9, 112);
+			memset(lengths + 256, 7, 24);
+			memset(lengths + 280, 8, 8);
+			buildHuffman(&lengthCodes, lengths, 288);
+
+			memset(lengths, 5, 30);
+			buildHuffman(&distanceCodes, lengths, 30);
+			built = true;
+		}
+
+		return inflateCodes(stream, lengthCodes, distanceCodes);
+	}
+
+	// Unpacks a zlib stream into `output`, which has to be exactly the size
+	// of what comes out
+	bool inflate(const u8 *data, size_t size, u8 *output, size_t outputSize) {
+		// No preset dictionaries and deflate is the only method
+		if (size < 6 || (data[0] & 0x0f) != 8 || ((data[0] << 8) | data[1]) % 31 != 0 || (data[1] & 0x20) != 0) {
+			return false;
+		}
+
+		InflateStream stream = {};
+		stream.data = data + 2;
+		stream.size = size - 2;
+		stream.output = output;
+		stream.outputSize = outputSize;
+
+		bool last = false;
+		while (!last) {
+			last = stream.bits(1) == 1;
+			const u32 type = stream.bits(2);
+
+			bool succeeded = false;
+			switch (type) {
+				case 0: succeeded = inflateStored(&stream); break;
+				case 1: succeeded = inflateFixed(&stream); break;
+				case 2: succeeded = inflateDynamic(&stream); break;
+			}
+
+			if (!succeeded || stream.overflow) {
+				return false;
+			}
+		}
+
+		return stream.outputLength == outputSize;
+	}
+
+	// Undoes the filter on one row in place, `previous` is null on the first
+	bool unfilter(u8 filter, u8 *row, const u8 *previous, u32 rowBytes, u32 pixelBytes) {
+		for (u32 i = 0; i < rowBytes; i++) {
+			const u8 left = i >= pixelBytes ? row[i - pixelBytes] : 0;
+			const u8 up = previous != nullptr ? previous[i] : 0;
+			const u8 upLeft = previous != nullptr && i >= pixelBytes ? previous[i - pixelBytes] : 0;
+
+			switch (filter) {
+				case 0: break;
+				case 1: row[i] += left; break;
+				case 2: row[i] += up; break;
+				case 3: row[i] += (u8)(((u32)left + up) / 2); break;
+				case 4: row[i] += paeth(left, up, upLeft); break;
+				default: return false;
+			}
+		}
+		return true;
+	}
+
+	bool decode(const u8 *data, size_t size, Image *image) {
+		*image = {};
+		if (size < sizeof(signature) || memcmp(data, signature, sizeof(signature)) != 0) {
+			return false;
+		}
+
+		u32 width = 0;
+		u32 height = 0;
+		ColorType colorType = ColorType::rgba;
+		u32 palette[256];
+		u32 paletteLength = 0;
+		for (u32 &entry : palette) {
+			entry = 0xff000000;
+		}
+
+		// The image data can be split over any number of chunks, they're
+		// joined back up before inflating
+		size_t compressedSize = 0;
+		bool headerRead = false;
+
+		size_t offset = sizeof(signature);
+		while (offset + 12 <= size) {
+			const u32 length = readBigEndian(data + offset);
+			const u8 *type = data + offset + 4;
+			const u8 *chunk = data + offset + 8;
+			if (length > size - offset - 12) {
+				return false;
+			}
+
+			if (memcmp(type, "IHDR", 4) == 0 && length == 13) {
+				width = readBigEndian(chunk);
+				height = readBigEndian(chunk + 4);
+				colorType = (ColorType)chunk[9];
+				const bool supported =
+					chunk[8] == 8 &&
+					chunk[10] == 0 &&
+					chunk[11] == 0 &&
+					chunk[12] == 0 &&
+					(colorType == ColorType::grey || colorType == ColorType::rgb || colorType == ColorType::palette || colorType == ColorType::greyAlpha || colorType == ColorType::rgba);
+				if (!supported || width == 0 || height == 0 || width > PNG_SIZE_MAX || height > PNG_SIZE_MAX) {
+					return false;
+				}
+				headerRead = true;
+			} else if (memcmp(type, "PLTE", 4) == 0 && length % 3 == 0 && length <= 768) {
+				paletteLength = length / 3;
+				for (u32 i = 0; i < paletteLength; i++) {
+					palette[i] = 0xff000000 | chunk[i * 3] | (chunk[i * 3 + 1] << 8) | (chunk[i * 3 + 2] << 16);
+				}
+			} else if (memcmp(type, "tRNS", 4) == 0 && colorType == ColorType::palette) {
+				for (u32 i = 0; i < length && i < 256; i++) {
+					palette[i] = (palette[i] & 0x00ffffff) | ((u32)chunk[i] << 24);
+				}
+			} else if (memcmp(type, "IDAT", 4) == 0) {
+				compressedSize += length;
+			} else if (memcmp(type, "IEND", 4) == 0) {
+				break;
+			}
+
+			offset += 12 + length;
+		}
+
+		if (!headerRead || compressedSize == 0 || (colorType == ColorType::palette && paletteLength == 0)) {
+			return false;
+		}
+
+		u8 *compressed = Memory::allocateArray<u8>(MemoryTag::textures, compressedSize);
+		size_t compressedLength = 0;
+		offset = sizeof(signature);
+		while (offset + 12 <= size) {
+			const u32 length = readBigEndian(data + offset);
+			if (memcmp(data + offset + 4, "IEND", 4) == 0) {
+				break;
+			}
+			if (memcmp(data + offset + 4, "IDAT", 4) == 0) {
+				memcpy(compressed + compressedLength, data + offset + 8, length);
+				compressedLength += length;
+			}
+			offset += 12 + length;
+		}
+
+		u32 channels = 4;
+		switch (colorType) {
+			case ColorType::grey: channels = 1; break;
+			case ColorType::rgb: channels = 3; break;
+			case ColorType::palette: channels = 1; break;
+			case ColorType::greyAlpha: channels = 2; break;
+			case ColorType::rgba: channels = 4; break;
+		}
+
+		// Every row starts with the byte saying how it was filtered
+		const u32 rowBytes = width * channels;
+		const size_t filteredSize = (size_t)(rowBytes + 1) * height;
+		u8 *filtered = Memory::allocateArray<u8>(MemoryTag::textures, filteredSize);
+
+		bool succeeded = inflate(compressed, compressedLength, filtered, filteredSize);
+		Memory::release(compressed);
+
+		u32 *pixels = Memory::allocateArray<u32>(MemoryTag::textures, (size_t)width * height);
+		const u8 *previous = nullptr;
+		for (u32 y = 0; y < height && succeeded; y++) {
+			u8 *row = filtered + (size_t)y * (rowBytes + 1);
+			succeeded = unfilter(row[0], row + 1, previous, rowBytes, channels);
+			previous = row + 1;
+
+			const u8 *source = row + 1;
+			u32 *destination = pixels + (size_t)y * width;
+			for (u32 x = 0; x < width; x++) {
+				const u8 *pixel = source + x * channels;
+				switch (colorType) {
+					case ColorType::grey: destination[x] = 0xff000000 | pixel[0] * 0x010101u; break;
+					case ColorType::rgb: destination[x] = 0xff000000 | pixel[0] | (pixel[1] << 8) | (pixel[2] << 16); break;
+					case ColorType::palette: destination[x] = palette[pixel[0]]; break;
+					case ColorType::greyAlpha: destination[x] = ((u32)pixel[1] << 24) | pixel[0] * 0x010101u; break;
+					case ColorType::rgba: destination[x] = pixel[0] | (pixel[1] << 8) | (pixel[2] << 16) | ((u32)pixel[3] << 24); break;
+				}
+			}
+		}
+		Memory::release(filtered);
+
+		if (!succeeded) {
+			Memory::release(pixels);
+			return false;
+		}
+
+		image->width = width;
+		image->height = height;
+		image->pixels = pixels;
+		return true;
+	}
+
+	struct BitWriter {
+		u8 *data;
+		size_t size;
+		size_t length = 0;
+		u32 bitBuffer = 0;
+		u32 bitCount = 0;
+
+		void bits(u32 value, u32 count) {
+			this->bitBuffer |= value << this->bitCount;
+			this->bitCount += count;
+			while (this->bitCount >= 8) {
+				assert(this->length < this->size);
+				this->data[this->length++] = (u8)this->bitBuffer;
+				this->bitBuffer >>= 8;
+				this->bitCount -= 8;
+			}
+		}
+
+		// Huffman codes go out most significant bit first
+		void code(u32 code, u32 count) {
+			u32 reversed = 0;
+			for (u32 i = 0; i < count; i++) {
+				reversed = (reversed << 1) | ((code >> i) & 1);
+			}
+			this->bits(reversed, count);
+		}
+
+		void flush() {
+			if (this->bitCount > 0) {
+				this->bits(0, 8 - this->bitCount);
+			}
+		}
+	};
+
+	void writeLiteral(BitWriter *writer, u32 symbol) {
+		if (symbol < 144) {
+			writer->code(0x30 + symbol, 8);
+		} else if (symbol < 256) {
+			writer->code(0x190 + symbol - 144, 9);
+		} else if (symbol < 280) {
+			writer->code(symbol - 256, 7);
+		} else {
+			writer->code(0xc0 + symbol - 280, 8);
+		}
+	}
+
+	void writeMatch(BitWriter *writer, u32 length, u32 distance) {
+		u32 lengthIndex = 28;
+		while (lengthBases[lengthIndex] > length) {
+			lengthIndex--;
+		}
+		writeLiteral(writer, 257 + lengthIndex);
+		writer->bits(length - lengthBases[lengthIndex], lengthExtraBits[lengthIndex]);
+
+		u32 distanceIndex = 29;
+		while (distanceBases[distanceIndex] > distance) {
+			distanceIndex--;
+		}
+		writer->code(distanceIndex, 5);
+		writer->bits(distance - distanceBases[distanceIndex], distanceExtraBits[distanceIndex]);
+	}
+
+	// One fixed Huffman block with greedy matches from a short hash chain,
+	// returns the zlib stream's length
+	size_t deflate(const u8 *data, size_t size, u8 *output, size_t outputSize) {
+		BitWriter writer = {};
+		writer.data = output;
+		writer.size = outputSize;
+
+		// Deflate, 32K window, no dictionary
+		writer.bits(0x78, 8);
+		writer.bits(0x01, 8);
+		writer.bits(1, 1);
+		writer.bits(1, 2);
+
+		s32 *heads = Memory::allocateArray<s32>(MemoryTag::textures, 1 << PNG_DEFLATE_HASH_BITS);
+		s32 *previous = Memory::allocateArray<s32>(MemoryTag::textures, PNG_DEFLATE_WINDOW);
+		for (u32 i = 0; i < (1 << PNG_DEFLATE_HASH_BITS); i++) {
+			heads[i] = -1;
+		}
+
+		size_t position = 0;
+		while (position < size) {
+			u32 bestLength = 0;
+			u32 bestDistance = 0;
+
+			if (position + 3 <= size) {
+				const u32 hash = ((data[position] << 16 | data[position + 1] << 8 | data[position + 2]) * 2654435761u) >> (32 - PNG_DEFLATE_HASH_BITS);
+				const size_t limit = size - position < 258 ? size - position : 258;
+
+				s32 candidate = heads[hash];
+				for (u32 chain = 0; chain < PNG_DEFLATE_CHAIN_MAX && candidate >= 0 && position - candidate <= PNG_DEFLATE_WINDOW; chain++) {
+					u32 length = 0;
+					while (length < limit && data[candidate + length] == data[position + length]) {
+						length++;
+					}
+					if (length > bestLength) {
+						bestLength = length;
+						bestDistance = (u32)(position - candidate);
+						if (length == limit) {
+							break;
+						}
+					}
+					candidate = previous[candidate % PNG_DEFLATE_WINDOW];
+				}
+
+				previous[position % PNG_DEFLATE_WINDOW] = heads[hash];
+				heads[hash] = (s32)position;
+			}
+
+			if (bestLength >= 3) {
+				writeMatch(&writer, bestLength, bestDistance);
+				// The skipped positions still go in the chains
+				for (u32 i = 1; i < bestLength && position + i + 3 <= size; i++) {
+					const size_t skipped = position + i;
+					const u32 hash = ((data[skipped] << 16 | data[skipped + 1] << 8 | data[skipped + 2]) * 2654435761u) >> (32 - PNG_DEFLATE_HASH_BITS);
+					previous[skipped % PNG_DEFLATE_WINDOW] = heads[hash];
+					heads[hash] = (s32)skipped;
+				}
+				position += bestLength;
+			} else {
+				writeLiteral(&writer, data[position]);
+				position++;
+			}
+		}
+
+		Memory::release(heads);
+		Memory::release(previous);
+
+		writeLiteral(&writer, 256);
+		writer.flush();
+
+		const u32 checksum = adler(data, size);
+		writer.bits(checksum >> 24, 8);
+		writer.bits((checksum >> 16) & 0xff, 8);
+		writer.bits((checksum >> 8) & 0xff, 8);
+		writer.bits(checksum & 0xff, 8);
+		return writer.length;
+	}
+
+	// Picks the filter for each row that leaves the smallest sum of
+	// differences, which tends to be the one that compresses best
+	void filter(const u32 *pixels, u32 width, u32 height, u8 *output) {
+		const u32 rowBytes = width * 4;
+		u8 *candidate = Memory::allocateArray<u8>(MemoryTag::textures, rowBytes);
+
+		for (u32 y = 0; y < height; y++) {
+			const u8 *row = (const u8*)(pixels + (size_t)y * width);
+			const u8 *previous = y > 0 ? row - rowBytes : nullptr;
+			u8 *destination = output + (size_t)y * (rowBytes + 1);
+
+			u32 bestCost = 0xffffffff;
+			for (u8 type = 0; type < 5; type++) {
+				u32 cost = 0;
+				for (u32 i = 0; i < rowBytes; i++) {
+					const u8 left = i >= 4 ? row[i - 4] : 0;
+					const u8 up = previous != nullptr ? previous[i] : 0;
+					const u8 upLeft = previous != nullptr && i >= 4 ? previous[i - 4] : 0;
+
+					u8 predicted = 0;
+					switch (type) {
+						case 1: predicted = left; break;
+						case 2: predicted = up; break;
+						case 3: predicted = (u8)(((u32)left + up) / 2); break;
+						case 4: predicted = paeth(left, up, upLeft); break;
+					}
+					candidate[i] = row[i] - predicted;
+					cost += (u32)(candidate[i] < 128 ? candidate[i] : 256 - candidate[i]);
+				}
+
+				if (cost < bestCost) {
+					bestCost = cost;
+					destination[0] = type;
+					memcpy(destination + 1, candidate, rowBytes);
+				}
+			}
+		}
+
+		Memory::release(candidate);
+	}
+
+	u8 *writeChunk(u8 *output, const char *type, const u8 *data, u32 length) {
+		writeBigEndian(output, length);
+		memcpy(output + 4, type, 4);
+		if (length > 0) {
+			memcpy(output + 8, data, length);
+		}
+		writeBigEndian(output + 8 + length, crc(output + 4, length + 4));
+		return output + 12 + length;
+	}
+
+	// Returns the file, release it with Memory::release
+	u8 *encode(const u32 *pixels, u32 width, u32 height, size_t *size) {
+		assert(width > 0 && height > 0 && width <= PNG_SIZE_MAX && height <= PNG_SIZE_MAX);
+
+		const size_t filteredSize = ((size_t)width * 4 + 1) * height;
+		u8 *filtered = Memory::allocateArray<u8>(MemoryTag::textures, filteredSize);
+		filter(pixels, width, height, filtered);
+
+		// A literal is at most 9 bits, plus the zlib header and checksum
+		const size_t compressedCapacity = filteredSize + filteredSize / 8 + 64;
+		u8 *compressed = Memory::allocateArray<u8>(MemoryTag::textures, compressedCapacity);
+		const size_t compressedSize = deflate(filtered, filteredSize, compressed, compressedCapacity);
+		Memory::release(filtered);
+
+		u8 header[13];
+		writeBigEndian(header, width);
+		writeBigEndian(header + 4, height);
+		header[8] = 8;
+		header[9] = (u8)ColorType::rgba;
+		header[10] = 0;
+		header[11] = 0;
+		header[12] = 0;
+
+		u8 *file = Memory::allocateArray<u8>(MemoryTag::textures, sizeof(signature) + 12 * 3 + sizeof(header) + compressedSize);
+		memcpy(file, signature, sizeof(signature));
+		u8 *end = file + sizeof(signature);
+		end = writeChunk(end, "IHDR", header, sizeof(header));
+		end = writeChunk(end, "IDAT", compressed, (u32)compressedSize);
+		end = writeChunk(end, "IEND", nullptr, 0);
+		Memory::release(compressed);
+
+		*size = end - file;
+		return file;
+	}
+};
\ No newline at end of file
@@ -0,0 +1,352 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstdio>
+
+#if defined(_WIN32)
+	#include <Windows.h>
+#else
+	#include <time.h>
+#endif
+
+#if defined(_MSC_VER)
+	#include <intrin.h>
+	#define PROFILER_USE_RDTSC
+#elif defined(__x86_64__) || defined(__i386__)
+	#include <x86intrin.h>
+	#define PROFILER_USE_RDTSC
+#endif
+
+#include "types/core.hpp"
+#include "utils/memory.hpp"
+
+#define PROFILER_ZONE_MAX 256
+#define PROFILER_THREAD_MAX 16
+#define PROFILER_RING_SIZE (1 << 16)
+
+// Scoped zone profiler. A zone is timed from where `PROFILE_ZONE` is placed to
+// the end of the enclosing scope:
+//
+//     void updateProjectiles(GameState *gameState, f32 delta) {
+//         PROFILE_ZONE("Combat::updateProjectiles");
+//         ...
+//     }
+//
+// Each zone name is registered once (the id is a function local static) so
+// the cost of a zone is two timestamps plus a write into the calling thread's
+// own ring buffer and stats, no locks or string copies. The ring buffers keep
+// the last `PROFILER_RING_SIZE` zones per thread for trace export while the
+// per-zone stats cover the whole run.
+//
+// Define PROFILER_DISABLED to compile every zone out.
+namespace Profiler {
+	typedef u16 ZoneId;
+
+	struct ZoneRecord {
+		ZoneId id;
+		u64 start;
+		u64 end;
+	};
+
+	struct ZoneStats {
+		u64 count = 0;
+		u64 totalTicks = 0;
+		u64 minTicks = (u64)-1;
+		u64 maxTicks = 0;
+		u64 frameTicks = 0;
+		u64 lastFrameTicks = 0;
+	};
+
+	struct ThreadBuffer {
+		u32 threadIndex;
+		u64 written = 0;
+		ZoneRecord records[PROFILER_RING_SIZE];
+		ZoneStats stats[PROFILER_ZONE_MAX];
+	};
+
+	static const char *zoneNames[PROFILER_ZONE_MAX];
+	static std::atomic<u32> zoneCount(0);
+	static ThreadBuffer *threads[PROFILER_THREAD_MAX];
+	static std::atomic<u32> threadCount(0);
+	static thread_local ThreadBuffer *currentThread = nullptr;
+	// Set on threads that started after every slot was taken
+	static thread_local bool currentThreadDropped = false;
+	static std::atomic<u64> droppedRecords(0);
+	// What `threadStats` gives a thread without a buffer, never written to
+	static const ZoneStats emptyStats[PROFILER_ZONE_MAX];
+
+	// Taken at the first zone so the tick counter can be calibrated against
+	// the reference clock when it's needed
+	static u64 baseTicks = 0;
+	static u64 baseNanoseconds = 0;
+
+	u64 referenceNanoseconds() {
+#if defined(_WIN32)
+		LARGE_INTEGER frequency, counter;
+		QueryPerformanceFrequency(&frequency);
+		QueryPerformanceCounter(&counter);
+		return (u64)((f64)counter.QuadPart * 1e9 / (f64)frequency.QuadPart);
+#else
+		timespec time;
+		clock_gettime(CLOCK_MONOTONIC, &time);
+		return (u64)time.tv_sec * 1000000000ull + (u64)time.tv_nsec;
+#endif
+	}
+
+	u64 now() {
+#ifdef PROFILER_USE_RDTSC
+		return __rdtsc();
+#else
+		return referenceNanoseconds();
+#endif
+	}
+
+	void initialise() {
+		if (baseNanoseconds == 0) {
+			baseTicks = now();
+			baseNanoseconds = referenceNanoseconds();
+		}
+	}
+
+	f64 ticksPerSecond() {
+#ifdef PROFILER_USE_RDTSC
+		const u64 elapsedTicks = now() - baseTicks;
+		const u64 elapsedNanoseconds = referenceNanoseconds() - baseNanoseconds;
+		if (elapsedNanoseconds == 0) {
+			return 1e9;
+		}
+		return (f64)elapsedTicks * 1e9 / (f64)elapsedNanoseconds;
+#else
+		return 1e9;
+#endif
+	}
+
+	f64 ticksToMilliseconds(u64 ticks, f64 ticksPerSecond) {
+		return (f64)ticks * 1000.0 / ticksPerSecond;
+	}
+
+	ZoneId registerZone(const char *name) {
+		const u32 id = zoneCount.fetch_add(1);
+		assert(id < PROFILER_ZONE_MAX);
+		zoneNames[id] = name;
+		return (ZoneId)id;
+	}
+
+	// Null once `PROFILER_THREAD_MAX` threads have recorded a zone. Slots
+	// aren't given back when a thread exits since the exports still read its
+	// buffer, so threads that come later have their zones dropped.
+	ThreadBuffer *threadBuffer() {
+		if (currentThread == nullptr && !currentThreadDropped) {
+			initialise();
+
+			u32 index = threadCount.load();
+			while (index < PROFILER_THREAD_MAX && !threadCount.compare_exchange_weak(index, index + 1)) {}
+			if (index == PROFILER_THREAD_MAX) {
+				currentThreadDropped = true;
+				return nullptr;
+			}
+
+			currentThread = Memory::create<ThreadBuffer>(MemoryTag::profiler);
+			currentThread->threadIndex = index;
+			threads[index] = currentThread;
+		}
+		return currentThread;
+	}
+
+	// Zones recorded on threads that didn't get a buffer
+	u64 droppedRecordCount() {
+		return droppedRecords.load();
+	}
+
+	void record(ZoneId id, u64 start, u64 end) {
+		ThreadBuffer *buffer = threadBuffer();
+		if (buffer == nullptr) {
+			droppedRecords++;
+			return;
+		}
+
+		ZoneRecord &record = buffer->records[buffer->written % PROFILER_RING_SIZE];
+		record.id = id;
+		record.start = start;
+		record.end = end;
+		buffer->written++;
+
+		const u64 ticks = end - start;
+		ZoneStats &stats = buffer->stats[id];
+		stats.count++;
+		stats.totalTicks += ticks;
+		stats.frameTicks += ticks;
+		if (ticks < stats.minTicks) stats.minTicks = ticks;
+		if (ticks > stats.maxTicks) stats.maxTicks = ticks;
+	}
+
+	struct Zone {
+		ZoneId id;
+		u64 start;
+
+		Zone(ZoneId id) : id(id), start(now()) {}
+
+		~Zone() {
+			record(this->id, this->start, now());
+		}
+	};
+
+	// Frees every thread's buffer. Only safe once no other thread will record
+	// a zone again.
+	void shutdown() {
+		const u32 count = threadCount.load();
+		for (u32 i = 0; i < count; i++) {
+			Memory::destroy(threads[i]);
+			threads[i] = nullptr;
+		}
+		threadCount = 0;
+		currentThread = nullptr;
+		currentThreadDropped = false;
+		droppedRecords = 0;
+	}
+
+	// Stats for the zones recorded on the calling thread
+	const ZoneStats *threadStats() {
+		const ThreadBuffer *buffer = threadBuffer();
+		return buffer != nullptr ? buffer->stats : emptyStats;
+	}
+
+	u32 registeredZoneCount() {
+		return zoneCount.load();
+	}
+
+	const char *zoneName(ZoneId id) {
+		return zoneNames[id];
+	}
+
+	// Moves the calling thread's per-frame totals into `lastFrameTicks`
+	void endFrame() {
+		ThreadBuffer *buffer = threadBuffer();
+		if (buffer == nullptr) {
+			return;
+		}
+
+		const u32 count = zoneCount.load();
+		for (u32 i = 0; i < count; i++) {
+			buffer->stats[i].lastFrameTicks = buffer->stats[i].frameTicks;
+			buffer->stats[i].frameTicks = 0;
+		}
+	}
+
+	// Merges every thread's stats for `id`
+	ZoneStats summarise(ZoneId id) {
+		ZoneStats result = {};
+		const u32 count = threadCount.load();
+		for (u32 i = 0; i < count; i++) {
+			const ZoneStats &stats = threads[i]->stats[id];
+			result.count += stats.count;
+			result.totalTicks += stats.totalTicks;
+			result.frameTicks += stats.frameTicks;
+			result.lastFrameTicks += stats.lastFrameTicks;
+			if (stats.minTicks < result.minTicks) result.minTicks = stats.minTicks;
+			if (stats.maxTicks > result.maxTicks) result.maxTicks = stats.maxTicks;
+		}
+		return result;
+	}
+
+	// NOTE: The exports read other threads' buffers without synchronising so
+	// they should only be called once those threads are idle (e.g. at exit).
+
+	// Writes the buffered zones in the Chrome trace event format, open with
+	// chrome://tracing or https://ui.perfetto.dev
+	bool exportChromeTrace(const char *path) {
+		FILE *file = fopen(path, "w");
+		if (file == nullptr) {
+			return false;
+		}
+
+		const f64 frequency = ticksPerSecond();
+		bool first = true;
+
+		fprintf(file, "{\"traceEvents\":[\n");
+
+		const u32 count = threadCount.load();
+		for (u32 i = 0; i < count; i++) {
+			const ThreadBuffer *buffer = threads[i];
+			const u64 available = buffer->written < PROFILER_RING_SIZE ? buffer->written : PROFILER_RING_SIZE;
+
+			for (u64 j = buffer->written - available; j < buffer->written; j++) {
+				const ZoneRecord &record = buffer->records[j % PROFILER_RING_SIZE];
+				const f64 start = (f64)(record.start - baseTicks) * 1e6 / frequency;
+				const f64 duration = (f64)(record.end - record.start) * 1e6 / frequency;
+
+				fprintf(
+					file,
+					"%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+					first ? "" : ",\n",
+					zoneNames[record.id],
+					buffer->threadIndex,
+					start,
+					duration
+				);
+				first = false;
+			}
+		}
+
+		fprintf(file, "\n],\"displayTimeUnit\":\"ms\"}\n");
+		fclose(file);
+		return true;
+	}
+
+	// Writes the per-zone stats for the whole run as CSV
+	bool exportSummary(const char *path) {
+		FILE *file = fopen(path, "w");
+		if (file == nullptr) {
+			return false;
+		}
+
+		const f64 frequency = ticksPerSecond();
+
+		fprintf(file, "zone,count,total_ms,mean_us,min_us,max_us\n");
+
+		const u32 count = zoneCount.load();
+		for (u32 i = 0; i < count; i++) {
+			const ZoneStats stats = summarise((ZoneId)i);
+			if (stats.count == 0) {
+				continue;
+			}
+
+			fprintf(
+				file,
+				"%s,%llu,%.3f,%.3f,%.3f,%.3f\n",
+				zoneNames[i],
+				stats.count,
+				ticksToMilliseconds(stats.totalTicks, frequency),
+				ticksToMilliseconds(stats.totalTicks, frequency) * 1000.0 / stats.count,
+				ticksToMilliseconds(stats.minTicks, frequency) * 1000.0,
+				ticksToMilliseconds(stats.maxTicks, frequency) * 1000.0
+			);
+		}
+
+		if (droppedRecordCount() > 0) {
+			fprintf(file, "(dropped from threads past %d),%llu,,,,\n", PROFILER_THREAD_MAX, droppedRecordCount());
+		}
+
+		fclose(file);
+		return true;
+	}
+}
+
+#define PROFILE_CONCAT_INNER(_a, _b) _a##_b
+#define PROFILE_CONCAT(_a, _b) PROFILE_CONCAT_INNER(_a, _b)
+
+#ifndef PROFILER_DISABLED
+#define PROFILE_ZONE(_name)                                                                          \
+	static const Profiler::ZoneId PROFILE_CONCAT(_profileZoneId, __LINE__) = Profiler::registerZone(_name); \
+	Profiler::Zone PROFILE_CONCAT(_profileZone, __LINE__)(PROFILE_CONCAT(_profileZoneId, __LINE__))
+#else
+#define PROFILE_ZONE(_name)
+#endif
+
+// Times a single call
+#define PROFILE(_name, _call) \
+{                             \
+	PROFILE_ZONE(_name);        \
+	_call;                      \
+}
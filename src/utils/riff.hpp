@@ -0,0 +1,254 @@
+#pragma once
+
+#include <cstring>
+
+#include "types/core.hpp"
+
+// Walks the chunks of a RIFF file already in memory (read in or mapped) and
+// picks the format and samples out of WAVs, without copying anything or
+// touching the file system. Samples point into the data passed in, so it has
+// to outlive them.
+//
+// PCM (8, 16, 24 and 32-bit), IEEE float (32 and 64-bit) and the extensible
+// format wrapping either are accepted, anything compressed isn't.
+//
+// Example:
+//
+//     Wave wave;
+//     const WaveError error = Riff::readWave(file.data, file.size, &wave);
+//     if (error != WaveError::none) {
+//         printf("%s\n", waveErrorNames[(size_t)error]);
+//     }
+//
+//     // Or any other RIFF file
+//     RiffReader reader;
+//     if (Riff::open(data, size, RIFF_FOURCC('A', 'V', 'I', ' '), &reader)) {
+//         RiffChunk chunk;
+//         while (reader.next(&chunk)) {
+//             ...
+//         }
+//     }
+//
+#define RIFF_FOURCC(_a, _b, _c, _d) ((u32)(_a) | ((u32)(_b) << 8) | ((u32)(_c) << 16) | ((u32)(_d) << 24))
+#define RIFF_ID_RIFF RIFF_FOURCC('R', 'I', 'F', 'F')
+#define RIFF_ID_WAVE RIFF_FOURCC('W', 'A', 'V', 'E')
+#define RIFF_ID_FORMAT RIFF_FOURCC('f', 'm', 't', ' ')
+#define RIFF_ID_DATA RIFF_FOURCC('d', 'a', 't', 'a')
+#define RIFF_HEADER_SIZE 12
+#define RIFF_CHUNK_HEADER_SIZE 8
+
+#define WAVE_FORMAT_TAG_PCM 0x0001
+#define WAVE_FORMAT_TAG_FLOAT 0x0003
+#define WAVE_FORMAT_TAG_EXTENSIBLE 0xfffe
+// WAVEFORMATEX, the 16 bytes every format starts with and its extra size
+#define WAVE_FORMAT_SIZE 18
+// WAVEFORMATEXTENSIBLE
+#define WAVE_FORMAT_EXTENSIBLE_SIZE 40
+
+enum class WaveError : u8 {
+	none,
+	notRiff,
+	notWave,
+	// A chunk header or the format runs past the end of the file
+	truncated,
+	missingFormat,
+	missingData,
+	unsupportedFormat,
+	// Channels, rate or block size don't add up
+	badFormat,
+	_length
+};
+
+const char *waveErrorNames[] = {
+	"none",
+	"not a RIFF file",
+	"not a WAVE file",
+	"truncated",
+	"no fmt chunk",
+	"no data chunk",
+	"unsupported format",
+	"bad format"
+};
+
+enum class SampleEncoding : u8 {
+	pcm,
+	ieeeFloat
+};
+
+struct WaveFormat {
+	SampleEncoding encoding;
+	u16 channels;
+	u32 sampleRate;
+	u16 bitsPerSample;
+	// Bytes per frame, one sample for every channel
+	u16 blockAlign;
+	// The fmt chunk as it is in the file, at least 16 bytes, for APIs that take
+	// a WAVEFORMATEX or WAVEFORMATEXTENSIBLE
+	const u8 *chunk;
+	u32 chunkSize;
+};
+
+struct Wave {
+	WaveFormat format;
+	// Whole frames only, a partial one at the end is left off
+	const u8 *samples;
+	u32 size;
+	u32 frameCount;
+};
+
+struct RiffChunk {
+	u32 id;
+	// As written, `data` may hold less when the file was cut short
+	u32 size;
+	const u8 *data;
+	// What's actually there
+	u32 available;
+};
+
+// The chunks inside the top level RIFF chunk in file order
+struct RiffReader {
+	const u8 *data;
+	size_t size;
+	size_t offset;
+	bool truncated;
+
+	bool next(RiffChunk *chunk) {
+		if (this->offset + RIFF_CHUNK_HEADER_SIZE > this->size) {
+			this->truncated = this->truncated || this->offset != this->size;
+			return false;
+		}
+
+		// Little endian whatever the platform
+		const u8 *header = this->data + this->offset;
+		chunk->id = (u32)header[0] | ((u32)header[1] << 8) | ((u32)header[2] << 16) | ((u32)header[3] << 24);
+		chunk->size = (u32)header[4] | ((u32)header[5] << 8) | ((u32)header[6] << 16) | ((u32)header[7] << 24);
+		chunk->data = this->data + this->offset + RIFF_CHUNK_HEADER_SIZE;
+
+		const size_t remaining = this->size - this->offset - RIFF_CHUNK_HEADER_SIZE;
+		chunk->available = chunk->size <= remaining ? chunk->size : (u32)remaining;
+		this->truncated = this->truncated || chunk->available < chunk->size;
+
+		// Chunks start on even offsets, odd sized ones are followed by a pad byte
+		const size_t padded = (size_t)chunk->available + (chunk->available & 1);
+		this->offset += RIFF_CHUNK_HEADER_SIZE + (padded <= remaining ? padded : remaining);
+		return true;
+	}
+};
+
+namespace Riff {
+	// The KSDATAFORMAT_SUBTYPE GUIDs all end the same way after the format tag
+	const u8 subFormatSuffix[14] = { 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xaa, 0x00, 0x38, 0x9b, 0x71 };
+
+	u16 readU16(const u8 *data) {
+		return (u16)(data[0] | (data[1] << 8));
+	}
+
+	u32 readU32(const u8 *data) {
+		return (u32)data[0] | ((u32)data[1] << 8) | ((u32)data[2] << 16) | ((u32)data[3] << 24);
+	}
+
+	// False if it isn't a RIFF file of `formType`, the size in the header is
+	// ignored in favour of the real one since streamed files leave it unset
+	bool open(const u8 *data, size_t size, u32 formType, RiffReader *reader) {
+		*reader = {};
+		if (size < RIFF_HEADER_SIZE || readU32(data) != RIFF_ID_RIFF || readU32(data + 8) != formType) {
+			return false;
+		}
+
+		reader->data = data;
+		reader->size = size;
+		reader->offset = RIFF_HEADER_SIZE;
+		return true;
+	}
+
+	WaveError readFormat(const RiffChunk &chunk, WaveFormat *format) {
+		if (chunk.available < 16 || chunk.available < chunk.size) {
+			return WaveError::truncated;
+		}
+
+		const u8 *data = chunk.data;
+		u16 tag = readU16(data);
+		format->channels = readU16(data + 2);
+		format->sampleRate = readU32(data + 4);
+		format->blockAlign = readU16(data + 12);
+		format->bitsPerSample = readU16(data + 14);
+		format->chunk = data;
+		format->chunkSize = chunk.size;
+
+		if (tag == WAVE_FORMAT_TAG_EXTENSIBLE) {
+			if (chunk.size < WAVE_FORMAT_EXTENSIBLE_SIZE || readU16(data + 16) < WAVE_FORMAT_EXTENSIBLE_SIZE - WAVE_FORMAT_SIZE) {
+				return WaveError::badFormat;
+			}
+
+			// The valid bits can be fewer than the container's, they're still
+			// played from the container
+			const u8 *subFormat = data + 24;
+			if (memcmp(subFormat + 2, subFormatSuffix, sizeof(subFormatSuffix)) != 0) {
+				return WaveError::unsupportedFormat;
+			}
+			tag = readU16(subFormat);
+		}
+
+		if (tag == WAVE_FORMAT_TAG_PCM) {
+			format->encoding = SampleEncoding::pcm;
+			const u16 bits = format->bitsPerSample;
+			if (bits != 8 && bits != 16 && bits != 24 && bits != 32) {
+				return WaveError::unsupportedFormat;
+			}
+		} else if (tag == WAVE_FORMAT_TAG_FLOAT) {
+			format->encoding = SampleEncoding::ieeeFloat;
+			if (format->bitsPerSample != 32 && format->bitsPerSample != 64) {
+				return WaveError::unsupportedFormat;
+			}
+		} else {
+			return WaveError::unsupportedFormat;
+		}
+
+		if (
+			format->channels == 0 ||
+			format->sampleRate == 0 ||
+			format->blockAlign != format->channels * (format->bitsPerSample / 8)
+		) {
+			return WaveError::badFormat;
+		}
+
+		return WaveError::none;
+	}
+
+	// A data chunk cut short (or with its size left unset by something that
+	// streamed it out) keeps what's there
+	WaveError readWave(const u8 *data, size_t size, Wave *wave) {
+		*wave = {};
+
+		RiffReader reader;
+		if (!open(data, size, RIFF_ID_WAVE, &reader)) {
+			return size >= RIFF_HEADER_SIZE && readU32(data) == RIFF_ID_RIFF ? WaveError::notWave : WaveError::notRiff;
+		}
+
+		bool formatFound = false;
+		RiffChunk chunk;
+		while (reader.next(&chunk)) {
+			if (chunk.id == RIFF_ID_FORMAT) {
+				const WaveError error = readFormat(chunk, &wave->format);
+				if (error != WaveError::none) {
+					return error;
+				}
+				formatFound = true;
+			} else if (chunk.id == RIFF_ID_DATA) {
+				if (!formatFound) {
+					return WaveError::missingFormat;
+				}
+
+				wave->frameCount = chunk.available / wave->format.blockAlign;
+				wave->size = wave->frameCount * wave->format.blockAlign;
+				wave->samples = chunk.data;
+				return WaveError::none;
+			}
+		}
+
+		if (reader.truncated) {
+			return WaveError::truncated;
+		}
+		return formatFound ? WaveError::missingData : WaveError::missingFormat;
+	}
+};
\ No newline at end of file
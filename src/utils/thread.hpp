@@ -0,0 +1,158 @@
+#pragma once
+
+#include <cassert>
+
+#if defined(_WIN32)
+	#include <Windows.h>
+#else
+	#include <pthread.h>
+#endif
+
+// Threads, a lock and a condition variable on top of what the platform
+// provides. Code shared with the tools uses these rather than <thread> and
+// <mutex>, which don't get along with the min/max macros from Windows.h.
+//
+// Example:
+//
+//     Mutex mutex;
+//     ConditionVariable condition;
+//     bool ready = false;
+//
+//     // Waiting thread
+//     {
+//         ScopedLock lock(&mutex);
+//         while (!ready) {
+//             condition.wait(&mutex);
+//         }
+//     }
+//
+//     // Signalling thread
+//     {
+//         ScopedLock lock(&mutex);
+//         ready = true;
+//         condition.notifyAll();
+//     }
+//
+struct Mutex {
+#if defined(_WIN32)
+	SRWLOCK handle = SRWLOCK_INIT;
+
+	void lock() {
+		AcquireSRWLockExclusive(&this->handle);
+	}
+
+	void unlock() {
+		ReleaseSRWLockExclusive(&this->handle);
+	}
+#else
+	pthread_mutex_t handle = PTHREAD_MUTEX_INITIALIZER;
+
+	void lock() {
+		pthread_mutex_lock(&this->handle);
+	}
+
+	void unlock() {
+		pthread_mutex_unlock(&this->handle);
+	}
+#endif
+};
+
+struct ScopedLock {
+	Mutex *mutex;
+
+	ScopedLock(Mutex *mutex) : mutex(mutex) {
+		this->mutex->lock();
+	}
+
+	~ScopedLock() {
+		this->mutex->unlock();
+	}
+};
+
+// Waits can wake up without being notified, always wait in a loop checking
+// whatever is being waited on
+struct ConditionVariable {
+#if defined(_WIN32)
+	CONDITION_VARIABLE handle = CONDITION_VARIABLE_INIT;
+
+	// `mutex` must be locked by the caller
+	void wait(Mutex *mutex) {
+		SleepConditionVariableSRW(&this->handle, &mutex->handle, INFINITE, 0);
+	}
+
+	void notifyAll() {
+		WakeAllConditionVariable(&this->handle);
+	}
+#else
+	pthread_cond_t handle = PTHREAD_COND_INITIALIZER;
+
+	// `mutex` must be locked by the caller
+	void wait(Mutex *mutex) {
+		pthread_cond_wait(&this->handle, &mutex->handle);
+	}
+
+	void notifyAll() {
+		pthread_cond_broadcast(&this->handle);
+	}
+#endif
+};
+
+typedef void (*ThreadFunction)(void *argument);
+
+struct Thread {
+	ThreadFunction function = nullptr;
+	void *argument = nullptr;
+#if defined(_WIN32)
+	HANDLE handle = NULL;
+#else
+	pthread_t handle;
+#endif
+	bool running = false;
+
+	// False if the platform couldn't start it, it's left not running so
+	// `join` does nothing and the caller has to do without it
+	bool start(ThreadFunction function, void *argument) {
+		assert(!this->running);
+		this->function = function;
+		this->argument = argument;
+
+#if defined(_WIN32)
+		this->handle = CreateThread(NULL, 0, threadMain, this, 0, NULL);
+		const bool started = this->handle != NULL;
+#else
+		const bool started = pthread_create(&this->handle, nullptr, threadMain, this) == 0;
+#endif
+		this->running = started;
+		return started;
+	}
+
+	void join() {
+		if (!this->running) {
+			return;
+		}
+
+#if defined(_WIN32)
+		WaitForSingleObject(this->handle, INFINITE);
+		CloseHandle(this->handle);
+		this->handle = NULL;
+#else
+		pthread_join(this->handle, nullptr);
+#endif
+		this->running = false;
+	}
+
+protected:
+#if defined(_WIN32)
+	static DWORD WINAPI threadMain(LPVOID parameter) {
+		Thread *thread = (Thread*)parameter;
+		thread->function(thread->argument);
+		return 0;
+	}
+#else
+	static void *threadMain(void *parameter) {
+		Thread *thread = (Thread*)parameter;
+		thread->function(thread->argument);
+		return nullptr;
+	}
+#endif
+};
\ No newline at end of file
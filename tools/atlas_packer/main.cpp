@@ -0,0 +1,474 @@
+// Packs sprite images into atlas pages so the game can draw different sprites
+// without switching textures, and writes the manifest the sprite loader reads
+// next to the pages:
+//
+//     atlas_packer [--page-size 2048] [--padding 1] [--out ./assets/img/atlas] [name[=path]...]
+//
+// Names are TextureAssetIds the way data files write them, each image is read
+// from the texture's own path unless one's given. With no names every PNG
+// texture is packed and any whose file is missing is skipped. Only PNGs are
+// read, so the JPEG backgrounds stay textures of their own.
+//
+// It prints how much of each page the images cover and how long packing
+// took. `--benchmark n` packs n random sizes between `--min-size` and
+// `--max-size` pixels `--runs` times instead, without reading or writing any
+// files. Exits with 1 if the images don't fit or any two overlap.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cwchar>
+#if defined(_WIN32)
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+#include "common/asset_definitions.hpp"
+#include "common/sprite_atlas.hpp"
+#include "types/core.hpp"
+#include "utils/memory.hpp"
+#include "utils/png.hpp"
+#include "utils/profiler.hpp"
+
+#define PACK_IMAGE_MAX SPRITE_ATLAS_ENTRY_MAX
+#define BENCHMARK_IMAGE_MAX 100000
+
+struct PackerOptions {
+	AtlasPackerConfig packer;
+	const char *outPath = ASSET_PATH SPRITE_ATLAS_DIRECTORY;
+	const char *images[PACK_IMAGE_MAX];
+	u32 imageCount = 0;
+
+	u32 benchmarkCount = 0;
+	u32 runs = 20;
+	u32 minSize = 16;
+	u32 maxSize = 256;
+};
+
+struct PackReport {
+	u32 pageCount;
+	u64 imageArea;
+	u64 paddedArea;
+	u64 pageArea;
+	f64 packMilliseconds;
+};
+
+// xorshift, so every run packs the same sizes
+struct Random {
+	u32 state = 0x9e3779b9;
+
+	u32 next(u32 range) {
+		this->state ^= this->state << 13;
+		this->state ^= this->state >> 17;
+		this->state ^= this->state << 5;
+		return this->state % range;
+	}
+};
+
+u8 *readFile(const char *path, size_t *size) {
+	FILE *file = fopen(path, "rb");
+	if (file == nullptr) {
+		return nullptr;
+	}
+
+	fseek(file, 0, SEEK_END);
+	const long length = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	u8 *data = nullptr;
+	if (length > 0) {
+		data = Memory::allocateArray<u8>(MemoryTag::textures, (size_t)length);
+		if (fread(data, 1, (size_t)length, file) != (size_t)length) {
+			Memory::release(data);
+			data = nullptr;
+		}
+	}
+
+	fclose(file);
+	*size = (size_t)length;
+	return data;
+}
+
+bool writeFile(const char *path, const void *data, size_t size) {
+	FILE *file = fopen(path, "wb");
+	if (file == nullptr) {
+		return false;
+	}
+
+	const bool succeeded = fwrite(data, 1, size, file) == size;
+	return fclose(file) == 0 && succeeded;
+}
+
+void makeDirectory(const char *path) {
+	// Fails harmlessly when it's already there, writing the files afterwards
+	// is what catches a path that can't be made
+#if defined(_WIN32)
+	_mkdir(path);
+#else
+	mkdir(path, 0755);
+#endif
+}
+
+// Every image has to be on its page and clear of the others by the padding
+bool checkPlacements(const AtlasPacker &packer, const AtlasRect *sizes, const AtlasPlacement *placements, u32 count) {
+	const s32 padding = packer.config.padding;
+
+	for (u32 i = 0; i < count; i++) {
+		const AtlasPlacement &a = placements[i];
+		if (a.page >= packer.getPageCount()) {
+			fprintf(stderr, "error: image %u is on page %u of %u\n", i, a.page, packer.getPageCount());
+			return false;
+		}
+
+		const SpriteAtlasPage page = packer.getPageSize(a.page);
+		if (
+			a.rect.width != sizes[i].width ||
+			a.rect.height != sizes[i].height ||
+			a.rect.x + a.rect.width > page.width ||
+			a.rect.y + a.rect.height > page.height
+		) {
+			fprintf(stderr, "error: image %u is off its page\n", i);
+			return false;
+		}
+
+		for (u32 j = i + 1; j < count; j++) {
+			const AtlasPlacement &b = placements[j];
+			const bool overlaps =
+				a.page == b.page &&
+				a.rect.x - padding < b.rect.x + b.rect.width + padding &&
+				b.rect.x - padding < a.rect.x + a.rect.width + padding &&
+				a.rect.y - padding < b.rect.y + b.rect.height + padding &&
+				b.rect.y - padding < a.rect.y + a.rect.height + padding;
+			if (overlaps) {
+				fprintf(stderr, "error: images %u and %u overlap\n", i, j);
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+PackReport summarise(const AtlasPacker &packer, const AtlasRect *sizes, u32 count) {
+	PackReport report = {};
+	report.pageCount = packer.getPageCount();
+
+	const u64 padding = packer.config.padding * 2;
+	for (u32 i = 0; i < count; i++) {
+		report.imageArea += (u64)sizes[i].width * sizes[i].height;
+		report.paddedArea += (sizes[i].width + padding) * (sizes[i].height + padding);
+	}
+	for (u32 page = 0; page < report.pageCount; page++) {
+		const SpriteAtlasPage size = packer.getPageSize(page);
+		report.pageArea += (u64)size.width * size.height;
+	}
+
+	return report;
+}
+
+void printReport(const AtlasPacker &packer, const PackReport &report, u32 count) {
+	for (u32 page = 0; page < report.pageCount; page++) {
+		const SpriteAtlasPage size = packer.getPageSize(page);
+		printf("page %u: %ux%u\n", page, size.width, size.height);
+	}
+
+	const f64 pageArea = report.pageArea > 0 ? (f64)report.pageArea : 1.0;
+	printf(
+		"%u images on %u pages, %.1f%% of the page area is images (%.1f%% with padding)\n",
+		count,
+		report.pageCount,
+		100.0 * report.imageArea / pageArea,
+		100.0 * report.paddedArea / pageArea
+	);
+	printf(
+		"packed in %.3fms, %.0f images a second\n",
+		report.packMilliseconds,
+		report.packMilliseconds > 0.0 ? count * 1000.0 / report.packMilliseconds : 0.0
+	);
+}
+
+bool benchmark(const PackerOptions &options, AtlasPacker *packer) {
+	const u32 count = options.benchmarkCount;
+	AtlasRect *sizes = Memory::allocateArray<AtlasRect>(MemoryTag::textures, count);
+	AtlasPlacement *placements = Memory::allocateArray<AtlasPlacement>(MemoryTag::textures, count);
+
+	Random random;
+	const u32 range = options.maxSize - options.minSize + 1;
+	for (u32 i = 0; i < count; i++) {
+		sizes[i] = { 0, 0, (u16)(options.minSize + random.next(range)), (u16)(options.minSize + random.next(range)) };
+	}
+
+	const f64 ticksPerSecond = Profiler::ticksPerSecond();
+	u64 fastest = ~0ull;
+	bool succeeded = true;
+	for (u32 run = 0; run < options.runs && succeeded; run++) {
+		const u64 start = Profiler::now();
+		succeeded = packer->pack(sizes, count, placements);
+		const u64 elapsed = Profiler::now() - start;
+		fastest = elapsed < fastest ? elapsed : fastest;
+	}
+
+	if (!succeeded) {
+		fprintf(stderr, "error: %u images don't fit in %u pages of %ux%u\n", count, SPRITE_ATLAS_PAGE_MAX, packer->config.pageWidth, packer->config.pageHeight);
+	} else {
+		succeeded = checkPlacements(*packer, sizes, placements, count);
+	}
+
+	if (succeeded) {
+		PackReport report = summarise(*packer, sizes, count);
+		report.packMilliseconds = Profiler::ticksToMilliseconds(fastest, ticksPerSecond);
+		printf("%u images from %u to %u pixels a side, fastest of %u runs\n", count, options.minSize, options.maxSize, options.runs);
+		printReport(*packer, report, count);
+	}
+
+	Memory::release(sizes);
+	Memory::release(placements);
+	return succeeded;
+}
+
+// Splits `name=path` and finds the texture, the path defaults to the
+// texture's own
+bool resolveImage(const char *argument, TextureAssetId *assetId, char *path, size_t pathSize) {
+	const char *separator = strchr(argument, '=');
+	const size_t nameLength = separator != nullptr ? (size_t)(separator - argument) : strlen(argument);
+
+	for (size_t i = 0; i < (size_t)TextureAssetId::_length; i++) {
+		if (strlen(textureAssetNames[i]) == nameLength && strncmp(textureAssetNames[i], argument, nameLength) == 0) {
+			*assetId = (TextureAssetId)i;
+			if (separator != nullptr) {
+				snprintf(path, pathSize, "%s", separator + 1);
+			} else {
+				snprintf(path, pathSize, "%ls", textureNames[i]);
+			}
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool packImages(const PackerOptions &options, AtlasPacker *packer) {
+	TextureAssetId assetIds[PACK_IMAGE_MAX];
+	Image images[PACK_IMAGE_MAX] = {};
+	AtlasRect sizes[PACK_IMAGE_MAX];
+	AtlasPlacement placements[PACK_IMAGE_MAX];
+	u32 count = 0;
+	bool succeeded = true;
+
+	if (options.imageCount == 0) {
+		for (size_t i = 0; i < (size_t)TextureAssetId::_length; i++) {
+			const size_t length = wcslen(textureNames[i]);
+			if (length > 4 && wcscmp(textureNames[i] + length - 4, L".png") == 0) {
+				assetIds[count] = (TextureAssetId)i;
+				count++;
+			}
+		}
+	}
+
+	// Decode everything up front, the packer only needs the sizes
+	u32 loaded = 0;
+	for (u32 i = 0; i < (options.imageCount > 0 ? options.imageCount : count) && succeeded; i++) {
+		char path[512];
+		TextureAssetId assetId;
+		if (options.imageCount > 0) {
+			if (!resolveImage(options.images[i], &assetId, path, sizeof(path))) {
+				fprintf(stderr, "%s: error: not a texture\n", options.images[i]);
+				succeeded = false;
+				break;
+			}
+		} else {
+			assetId = assetIds[i];
+			snprintf(path, sizeof(path), "%ls", textureNames[(size_t)assetId]);
+		}
+
+		size_t size = 0;
+		u8 *data = readFile(path, &size);
+		if (data == nullptr) {
+			if (options.imageCount == 0) {
+				printf("skipped %s, %s not found\n", textureAssetNames[(size_t)assetId], path);
+				continue;
+			}
+			fprintf(stderr, "%s: error: unable to read\n", path);
+			succeeded = false;
+			break;
+		}
+
+		Image &image = images[loaded];
+		const bool decoded = Png::decode(data, size, &image);
+		Memory::release(data);
+		if (!decoded || image.width > 0xffff || image.height > 0xffff) {
+			fprintf(stderr, "%s: error: not an 8-bit non-interlaced PNG\n", path);
+			succeeded = false;
+			break;
+		}
+
+		assetIds[loaded] = assetId;
+		sizes[loaded] = { 0, 0, (u16)image.width, (u16)image.height };
+		loaded++;
+	}
+	count = loaded;
+
+	if (succeeded && count == 0) {
+		fprintf(stderr, "error: nothing to pack\n");
+		succeeded = false;
+	}
+
+	u64 elapsed = 0;
+	if (succeeded) {
+		const u64 start = Profiler::now();
+		succeeded = packer->pack(sizes, count, placements);
+		elapsed = Profiler::now() - start;
+
+		if (!succeeded) {
+			fprintf(stderr, "error: the images don't fit in %u pages of %ux%u\n", SPRITE_ATLAS_PAGE_MAX, packer->config.pageWidth, packer->config.pageHeight);
+		} else {
+			succeeded = checkPlacements(*packer, sizes, placements, count);
+		}
+	}
+
+	SpriteAtlasManifest manifest = {};
+	if (succeeded) {
+		manifest.pageCount = packer->getPageCount();
+		for (u32 i = 0; i < count; i++) {
+			SpriteAtlasEntry &entry = manifest.entries[(size_t)assetIds[i]];
+			entry.page = placements[i].page;
+			entry.rect = placements[i].rect;
+		}
+
+		makeDirectory(options.outPath);
+	}
+
+	const size_t outLength = strlen(options.outPath);
+	const char *separator = outLength > 0 && options.outPath[outLength - 1] == '/' ? "" : "/";
+
+	for (u32 page = 0; page < manifest.pageCount && succeeded; page++) {
+		const SpriteAtlasPage size = packer->getPageSize(page);
+		manifest.pages[page] = size;
+
+		// Transparent wherever there isn't an image
+		u32 *pixels = Memory::allocateArray<u32>(MemoryTag::textures, (size_t)size.width * size.height);
+		memset(pixels, 0, (size_t)size.width * size.height * sizeof(u32));
+		for (u32 i = 0; i < count; i++) {
+			if (placements[i].page == page) {
+				SpriteAtlas::blit(pixels, size.width, size.height, placements[i].rect, images[i].pixels, packer->config.padding);
+			}
+		}
+
+		size_t fileSize;
+		u8 *file = Png::encode(pixels, size.width, size.height, &fileSize);
+		Memory::release(pixels);
+
+		char path[512];
+		snprintf(path, sizeof(path), "%s%s" SPRITE_ATLAS_PAGE_NAME, options.outPath, separator, page);
+		if (!writeFile(path, file, fileSize)) {
+			fprintf(stderr, "%s: error: unable to write\n", path);
+			succeeded = false;
+		}
+		Memory::release(file);
+	}
+
+	if (succeeded) {
+		u8 buffer[SPRITE_ATLAS_MANIFEST_MAX];
+		const size_t size = SpriteAtlas::writeManifest(manifest, buffer, sizeof(buffer));
+		assert(size > 0);
+
+		char path[512];
+		snprintf(path, sizeof(path), "%s%s" SPRITE_ATLAS_MANIFEST_NAME, options.outPath, separator);
+		if (!writeFile(path, buffer, size)) {
+			fprintf(stderr, "%s: error: unable to write\n", path);
+			succeeded = false;
+		}
+	}
+
+	if (succeeded) {
+		for (u32 i = 0; i < count; i++) {
+			const AtlasRect &rect = placements[i].rect;
+			printf("%s -> page %u at %u,%u (%ux%u)\n", textureAssetNames[(size_t)assetIds[i]], placements[i].page, rect.x, rect.y, rect.width, rect.height);
+		}
+
+		PackReport report = summarise(*packer, sizes, count);
+		report.packMilliseconds = Profiler::ticksToMilliseconds(elapsed, Profiler::ticksPerSecond());
+		printReport(*packer, report, count);
+	}
+
+	for (Image &image : images) {
+		Memory::release(image.pixels);
+	}
+	return succeeded;
+}
+
+bool parseArguments(int argumentCount, char **arguments, PackerOptions *options) {
+	for (int i = 1; i < argumentCount; i++) {
+		const char *argument = arguments[i];
+		if (strncmp(argument, "--", 2) != 0) {
+			if (options->imageCount == PACK_IMAGE_MAX) {
+				return false;
+			}
+			options->images[options->imageCount++] = argument;
+			continue;
+		}
+
+		if (i + 1 == argumentCount) {
+			return false;
+		}
+		const char *value = arguments[++i];
+		const u32 number = (u32)strtoul(value, nullptr, 10);
+
+		bool valid = true;
+		if (strcmp(argument, "--page-size") == 0) {
+			options->packer.pageWidth = (u16)number;
+			options->packer.pageHeight = (u16)number;
+			valid = number > 0 && number <= 16384;
+		} else if (strcmp(argument, "--padding") == 0) {
+			options->packer.padding = (u16)number;
+			valid = number <= 64;
+		} else if (strcmp(argument, "--out") == 0) {
+			options->outPath = value;
+		} else if (strcmp(argument, "--benchmark") == 0) {
+			options->benchmarkCount = number;
+			valid = number > 0 && number <= BENCHMARK_IMAGE_MAX;
+		} else if (strcmp(argument, "--runs") == 0) {
+			options->runs = number;
+			valid = number > 0;
+		} else if (strcmp(argument, "--min-size") == 0) {
+			options->minSize = number;
+			valid = number > 0;
+		} else if (strcmp(argument, "--max-size") == 0) {
+			options->maxSize = number;
+			valid = number > 0 && number < 0xffff;
+		} else {
+			valid = false;
+		}
+
+		if (!valid) {
+			return false;
+		}
+	}
+
+	return options->minSize <= options->maxSize;
+}
+
+int main(int argumentCount, char **arguments) {
+	PackerOptions options;
+	if (!parseArguments(argumentCount, arguments, &options)) {
+		fprintf(
+			stderr,
+			"Usage: %s [--page-size n] [--padding n] [--out directory] [name[=path]...]\n"
+			"       %s --benchmark n [--runs n] [--min-size n] [--max-size n] [--page-size n] [--padding n]\n",
+			arguments[0],
+			arguments[0]
+		);
+		return 1;
+	}
+
+	Profiler::initialise();
+
+	AtlasPacker *packer = Memory::create<AtlasPacker>(MemoryTag::textures);
+	packer->config = options.packer;
+
+	const bool succeeded = options.benchmarkCount > 0 ? benchmark(options, packer) : packImages(options, packer);
+
+	Memory::destroy(packer);
+	return succeeded ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,304 @@
+// Compresses WAVs to the game's block codec, written next to the source as a
+// .bsnd that the sound manager streams music from and loads effects from in
+// its place:
+//
+//     audio_encoder [--min-snr 20] [--rounds 5] [path...]
+//
+// PCM of any width and float are read and converted to 16-bit first. With no
+// paths every sound and music asset that exists is compressed.
+//
+// Everything is decoded again afterwards, both with the SSE decoder the game
+// uses and the scalar one, which have to agree sample for sample. The best of
+// `--rounds` decodes is reported as how many times faster than realtime it
+// ran. Exits with 1 if the decoders disagree or the signal to noise ratio
+// against the 16-bit source comes in under `--min-snr` dB.
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "common/asset_definitions.hpp"
+#include "common/compressed_audio.hpp"
+#include "types/core.hpp"
+#include "utils/audio_codec.hpp"
+#include "utils/mapped_file.hpp"
+#include "utils/memory.hpp"
+#include "utils/profiler.hpp"
+#include "utils/riff.hpp"
+
+#define ENCODE_INPUT_MAX 64
+#define ENCODE_PATH_MAX 512
+
+struct EncoderOptions {
+	f64 minSnr = 20.0;
+	u32 rounds = 5;
+	const char *inputs[ENCODE_INPUT_MAX];
+	u32 inputCount = 0;
+};
+
+bool writeFile(const char *path, const void *data, size_t size) {
+	FILE *file = fopen(path, "wb");
+	if (file == nullptr) {
+		return false;
+	}
+
+	const bool succeeded = fwrite(data, 1, size, file) == size;
+	return fclose(file) == 0 && succeeded;
+}
+
+void outputPath(const char *path, char *output, size_t outputSize) {
+	const char *extension = strrchr(path, '.');
+	const char *slash = strrchr(path, '/');
+	const size_t length = extension != nullptr && (slash == nullptr || extension > slash) ? (size_t)(extension - path) : strlen(path);
+	snprintf(output, outputSize, "%.*s" COMPRESSED_AUDIO_EXTENSION, (int)length, path);
+}
+
+s16 toS16(const WaveFormat &format, const u8 *sample) {
+	if (format.encoding == SampleEncoding::ieeeFloat) {
+		f64 value;
+		if (format.bitsPerSample == 32) {
+			f32 single;
+			memcpy(&single, sample, sizeof(single));
+			value = single;
+		} else {
+			memcpy(&value, sample, sizeof(value));
+		}
+		value = value < -1.0 ? -1.0 : (value > 1.0 ? 1.0 : value);
+		return (s16)lround(value * 32767.0);
+	}
+
+	// The top 16 bits of whatever's there, 8-bit is the only unsigned one
+	switch (format.bitsPerSample) {
+		case 8:
+			return (s16)(((s32)sample[0] - 128) << 8);
+		case 16:
+			return (s16)Riff::readU16(sample);
+		case 24:
+			return (s16)Riff::readU16(sample + 1);
+		default:
+			return (s16)Riff::readU16(sample + 2);
+	}
+}
+
+f64 snr(const s16 *source, const s16 *decoded, size_t count) {
+	f64 signal = 0.0;
+	f64 noise = 0.0;
+	for (size_t i = 0; i < count; i++) {
+		const f64 difference = (f64)source[i] - decoded[i];
+		signal += (f64)source[i] * source[i];
+		noise += difference * difference;
+	}
+	return noise > 0.0 ? 10.0 * log10(signal / noise) : INFINITY;
+}
+
+// The quickest of `rounds` decodes of the whole file, in ticks
+u64 timeDecode(const CompressedAudioHeader &header, const u8 *blocks, s16 *out, u32 rounds, bool scalar) {
+	const size_t blockSize = AudioCodec::blockSize(header.channels, AUDIO_BLOCK_FRAMES);
+
+	u64 best = ~0ull;
+	for (u32 round = 0; round < rounds; round++) {
+		const u64 start = Profiler::now();
+		for (u32 frame = 0, block = 0; frame < header.frameCount; frame += AUDIO_BLOCK_FRAMES, block++) {
+			const u32 frames = header.frameCount - frame < AUDIO_BLOCK_FRAMES ? header.frameCount - frame : AUDIO_BLOCK_FRAMES;
+			const u8 *data = blocks + (size_t)block * blockSize;
+			s16 *write = out + (size_t)frame * header.channels;
+			if (scalar) {
+				AudioCodec::decodeBlockScalar(data, header.channels, frames, write);
+			} else {
+				AudioCodec::decodeBlock(data, header.channels, frames, write);
+			}
+		}
+		const u64 ticks = Profiler::now() - start;
+		best = ticks < best ? ticks : best;
+	}
+	return best;
+}
+
+bool compressSound(const EncoderOptions &options, const char *path) {
+	MappedFile file;
+	if (!file.open(path)) {
+		fprintf(stderr, "%s: error: unable to read\n", path);
+		return false;
+	}
+
+	Wave wave;
+	const WaveError error = Riff::readWave(file.data, file.size, &wave);
+	if (error != WaveError::none || wave.frameCount == 0 || wave.format.channels > AUDIO_CHANNEL_MAX) {
+		fprintf(stderr, "%s: error: %s\n", path, error != WaveError::none ? waveErrorNames[(size_t)error] : "no samples or too many channels");
+		file.close();
+		return false;
+	}
+
+	const WaveFormat &format = wave.format;
+	const size_t sampleCount = (size_t)wave.frameCount * format.channels;
+	const u32 bytesPerSample = format.bitsPerSample / 8;
+	s16 *source = Memory::allocateArray<s16>(MemoryTag::sound, sampleCount);
+	for (size_t i = 0; i < sampleCount; i++) {
+		source[i] = toS16(format, wave.samples + i * bytesPerSample);
+	}
+	file.close();
+
+	CompressedAudioHeader header = {};
+	header.magic = COMPRESSED_AUDIO_MAGIC;
+	header.version = COMPRESSED_AUDIO_VERSION;
+	header.channels = (u8)format.channels;
+	header.sampleRate = format.sampleRate;
+	header.frameCount = wave.frameCount;
+	header.dataSize = (u32)CompressedAudio::dataSize(header.channels, header.frameCount);
+
+	const size_t outputSize = sizeof(header) + header.dataSize;
+	u8 *output = Memory::allocateArray<u8>(MemoryTag::sound, outputSize);
+	memcpy(output, &header, sizeof(header));
+
+	const u64 encodeStart = Profiler::now();
+	AudioLms lms[AUDIO_CHANNEL_MAX];
+	AudioCodec::resetLms(lms, header.channels);
+	u8 *write = output + sizeof(header);
+	for (u32 frame = 0; frame < header.frameCount; frame += AUDIO_BLOCK_FRAMES) {
+		const u32 frames = header.frameCount - frame < AUDIO_BLOCK_FRAMES ? header.frameCount - frame : AUDIO_BLOCK_FRAMES;
+		write += AudioCodec::encodeBlock(source + (size_t)frame * header.channels, header.channels, frames, lms, write);
+	}
+	const u64 encodeTicks = Profiler::now() - encodeStart;
+	assert(write == output + outputSize);
+
+	s16 *decoded = Memory::allocateArray<s16>(MemoryTag::sound, sampleCount);
+	s16 *decodedScalar = Memory::allocateArray<s16>(MemoryTag::sound, sampleCount);
+	const u8 *blocks = output + sizeof(header);
+	const u64 scalarTicks = timeDecode(header, blocks, decodedScalar, options.rounds, true);
+	const u64 simdTicks = timeDecode(header, blocks, decoded, options.rounds, false);
+	const bool agree = memcmp(decoded, decodedScalar, sampleCount * sizeof(s16)) == 0;
+	const f64 quality = snr(source, decoded, sampleCount);
+
+	// After the work so the counter has had time to be measured against
+	const f64 ticksPerSecond = Profiler::ticksPerSecond();
+	const f64 seconds = (f64)header.frameCount / header.sampleRate;
+
+	char compressedPath[ENCODE_PATH_MAX];
+	outputPath(path, compressedPath, sizeof(compressedPath));
+	bool succeeded = writeFile(compressedPath, output, outputSize);
+	if (!succeeded) {
+		fprintf(stderr, "%s: error: unable to write\n", compressedPath);
+	}
+
+	if (succeeded) {
+		printf(
+			"%s -> %s: %uch %uHz %.1fs, %.2fMB -> %.2fMB (%.1fx smaller than 16-bit) in %.1fms, SNR %.2fdB, decodes at %.0fx realtime (%.0fx scalar)\n",
+			path,
+			compressedPath,
+			(u32)header.channels,
+			header.sampleRate,
+			seconds,
+			wave.size / (1024.0 * 1024.0),
+			outputSize / (1024.0 * 1024.0),
+			sampleCount * sizeof(s16) / (f64)outputSize,
+			Profiler::ticksToMilliseconds(encodeTicks, ticksPerSecond),
+			quality,
+			seconds * ticksPerSecond / (simdTicks > 0 ? simdTicks : 1),
+			seconds * ticksPerSecond / (scalarTicks > 0 ? scalarTicks : 1)
+		);
+
+		if (!agree) {
+			fprintf(stderr, "%s: error: the SSE and scalar decoders disagree\n", path);
+			succeeded = false;
+		}
+		if (quality < options.minSnr) {
+			fprintf(stderr, "%s: error: under %.2fdB\n", path, options.minSnr);
+			succeeded = false;
+		}
+	}
+
+	Memory::release(decodedScalar);
+	Memory::release(decoded);
+	Memory::release(output);
+	Memory::release(source);
+	return succeeded;
+}
+
+// Every sound effect and music track
+bool compressAssets(const EncoderOptions &options) {
+	const wchar_t *names[(size_t)SoundAssetId::_length + (size_t)MusicAssetId::none];
+	u32 nameCount = 0;
+	for (const wchar_t *name : soundNames) {
+		names[nameCount++] = name;
+	}
+	for (const wchar_t *name : musicNames) {
+		names[nameCount++] = name;
+	}
+
+	bool succeeded = true;
+	u32 count = 0;
+	for (u32 i = 0; i < nameCount; i++) {
+		char path[ENCODE_PATH_MAX];
+		snprintf(path, sizeof(path), "%ls", names[i]);
+		FILE *file = fopen(path, "rb");
+		if (file == nullptr) {
+			printf("skipped %s, not found\n", path);
+			continue;
+		}
+		fclose(file);
+
+		succeeded = compressSound(options, path) && succeeded;
+		count++;
+	}
+
+	if (count == 0) {
+		fprintf(stderr, "error: nothing to compress\n");
+		return false;
+	}
+	return succeeded;
+}
+
+bool parseArguments(int argumentCount, char **arguments, EncoderOptions *options) {
+	for (int i = 1; i < argumentCount; i++) {
+		const char *argument = arguments[i];
+		if (strncmp(argument, "--", 2) != 0) {
+			if (options->inputCount == ENCODE_INPUT_MAX) {
+				return false;
+			}
+			options->inputs[options->inputCount++] = argument;
+			continue;
+		}
+
+		if (i + 1 == argumentCount) {
+			return false;
+		}
+		const char *value = arguments[++i];
+
+		bool valid = true;
+		if (strcmp(argument, "--min-snr") == 0) {
+			options->minSnr = strtod(value, nullptr);
+		} else if (strcmp(argument, "--rounds") == 0) {
+			options->rounds = (u32)strtoul(value, nullptr, 10);
+			valid = options->rounds > 0;
+		} else {
+			valid = false;
+		}
+
+		if (!valid) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+int main(int argumentCount, char **arguments) {
+	EncoderOptions options;
+	if (!parseArguments(argumentCount, arguments, &options)) {
+		fprintf(stderr, "Usage: %s [--min-snr dB] [--rounds n] [path...]\n", arguments[0]);
+		return 1;
+	}
+
+	Profiler::initialise();
+
+	bool succeeded = true;
+	if (options.inputCount == 0) {
+		succeeded = compressAssets(options);
+	}
+	for (u32 i = 0; i < options.inputCount; i++) {
+		succeeded = compressSound(options, options.inputs[i]) && succeeded;
+	}
+
+	return succeeded ? 0 : 1;
+}
\ No newline at end of file
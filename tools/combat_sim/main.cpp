@@ -0,0 +1,478 @@
+// Runs battles between two fleets built from ship templates without the rest
+// of the game, for balancing and as a throughput benchmark of the combat code:
+//
+//     combat_sim --fleet 20 --battles 100 --damage 0.5,1,2 --cooldown 1,0.5 assets/data/templates/ships/ship.txt assets/data/templates/ships/enemy_ship.txt
+//
+// The first template makes up the ally fleet and the second the enemy fleet,
+// both flown by the combat AI. The `--damage`, `--cooldown`, `--speed` and
+// `--health` lists scale the ally fleet's weapons and targets, every
+// combination of them is fought `--battles` times with a different seed for
+// where the ships start. Each battle is written to the CSV as a row:
+//
+//     damage,cooldown,speed,health,seed,winner,seconds,frames,allies_left,enemies_left,fired,hits,dropped,mean_frame_us,max_frame_us
+//
+// A battle always steps at 60fps and the AI runs without a time budget, so
+// the same arguments give the same results on any machine. Only the frame
+// times differ. Doesn't need anything from Windows so it also runs on Linux.
+
+#define _USE_MATH_DEFINES 1
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#include "common/ship_template.hpp"
+#include "game/combat.hpp"
+#include "utils/memory.hpp"
+#include "utils/profiler.hpp"
+#include "utils/thread.hpp"
+
+#define SIM_GRID_VALUE_MAX 8
+#define SIM_THREAD_MAX 64
+#define SIM_DELTA (1.0f / 60.0f)
+
+struct SimGridAxis {
+	f32 values[SIM_GRID_VALUE_MAX] = { 1.0f };
+	u32 length = 1;
+};
+
+enum class SimAxis {
+	damage,
+	cooldown,
+	speed,
+	health,
+	_length
+};
+
+const char *simAxisOptions[] = {
+	"--damage",
+	"--cooldown",
+	"--speed",
+	"--health"
+};
+
+struct SimConfig {
+	Ship fleets[2];
+	u32 fleetSize = 10;
+	u32 battles = 100;
+	u32 threads = 0;
+	u64 seed = 1;
+	f32 maxSeconds = 300.0f;
+	const char *outputPath = "combat_sim.csv";
+	SimGridAxis axes[(size_t)SimAxis::_length];
+};
+
+enum class SimWinner : u8 {
+	ally,
+	enemy,
+	draw
+};
+
+const char *simWinnerNames[] = {
+	"ally",
+	"enemy",
+	"draw"
+};
+
+struct BattleResult {
+	f32 scales[(size_t)SimAxis::_length];
+	u64 seed;
+	SimWinner winner;
+	f32 seconds;
+	u32 frames;
+	u32 alliesLeft;
+	u32 enemiesLeft;
+	ProjectileStats projectiles;
+	u64 totalFrameTicks;
+	u64 maxFrameTicks;
+};
+
+struct SimJob {
+	const SimConfig *config;
+	BattleResult *results;
+	u32 count;
+	std::atomic<u32> next;
+};
+
+// xorshift64*, plenty for scattering ships about
+struct SimRandom {
+	u64 state;
+
+	SimRandom(u64 seed) : state(seed * 0x9E3779B97F4A7C15ull + 1) {}
+
+	u64 next() {
+		this->state ^= this->state >> 12;
+		this->state ^= this->state << 25;
+		this->state ^= this->state >> 27;
+		return this->state * 0x2545F4914F6CDD1Dull;
+	}
+
+	// [0, 1)
+	f32 unit() {
+		return (f32)(this->next() >> 40) / (f32)(1ull << 24);
+	}
+};
+
+bool readFile(const char *path, char *buffer, size_t size, size_t *length) {
+	FILE *file = fopen(path, "rb");
+	if (file == nullptr) {
+		return false;
+	}
+
+	*length = fread(buffer, 1, size, file);
+	// One byte spare to tell a full buffer apart from a file that's too big
+	const bool succeeded = !ferror(file) && *length < size;
+	fclose(file);
+	return succeeded;
+}
+
+bool loadFleetTemplate(const char *path, Ship *ship) {
+	static char source[SHIP_TEMPLATE_SOURCE_MAX];
+	size_t sourceLength = 0;
+	if (!readFile(path, source, sizeof(source), &sourceLength)) {
+		fprintf(stderr, "%s: error: unable to read (or larger than %d bytes)\n", path, SHIP_TEMPLATE_SOURCE_MAX);
+		return false;
+	}
+
+	ShipTemplateError error = {};
+	if (!ShipTemplate::parse(source, sourceLength, ship, &error)) {
+		fprintf(stderr, "%s:%u: error: %s\n", path, error.line, error.message);
+		return false;
+	}
+
+	if (ship->targets.length == 0) {
+		fprintf(stderr, "%s: error: ship has no targets so it can never be destroyed\n", path);
+		return false;
+	}
+
+	return true;
+}
+
+// Comma separated list of positive numbers
+bool parseAxis(const char *text, SimGridAxis *axis) {
+	axis->length = 0;
+
+	while (true) {
+		char *end;
+		const f32 value = strtof(text, &end);
+		if (end == text || !(value > 0.0f) || axis->length == SIM_GRID_VALUE_MAX) {
+			return false;
+		}
+		axis->values[axis->length++] = value;
+
+		if (*end == '\0') {
+			return true;
+		}
+		if (*end != ',') {
+			return false;
+		}
+		text = end + 1;
+	}
+}
+
+HealthValue scaleHealth(HealthValue value, f32 scale) {
+	const f32 scaled = roundf((f32)value * scale);
+	return scaled < 1.0f ? 1 : scaled > 65535.0f ? 65535 : (HealthValue)scaled;
+}
+
+Ship scaleShip(Ship ship, const f32 *scales) {
+	for (Weapon &weapon : ship.weapons) {
+		weapon.damage = scaleHealth(weapon.damage, scales[(size_t)SimAxis::damage]);
+		weapon.cooldown *= scales[(size_t)SimAxis::cooldown];
+		weapon.projectileSpeed *= scales[(size_t)SimAxis::speed];
+	}
+
+	for (ShipTarget &target : ship.targets) {
+		target.maxHealth = scaleHealth(target.maxHealth, scales[(size_t)SimAxis::health]);
+		target.health = scaleHealth(target.health, scales[(size_t)SimAxis::health]);
+	}
+
+	return ship;
+}
+
+// Fleets start in two facing lines with a bit of scatter
+void spawnFleet(GameState *gameState, const Ship &shipTemplate, Faction faction, u32 size, SimRandom *random) {
+	const f32 side = faction == Faction::ally ? -1.0f : 1.0f;
+	const f32 spacing = 150.0f;
+
+	for (u32 i = 0; i < size; i++) {
+		const Vec3<f32> position(
+			((f32)i - (f32)(size - 1) * 0.5f) * spacing + (random->unit() - 0.5f) * spacing * 0.5f,
+			side * (300.0f + random->unit() * 200.0f)
+		);
+
+		const Entity ship = Combat::spawnShip(&gameState->combat, shipTemplate, faction, position);
+		gameState->combat.ai.add(ship, ShipAi{});
+	}
+}
+
+u32 shipsLeft(const CombatEntities &combat, Faction faction) {
+	u32 count = 0;
+	for (const CombatShip &ship : combat.ships) {
+		count += ship.faction == faction;
+	}
+	return count;
+}
+
+void runBattle(GameState *gameState, const SimJob &job, u32 index) {
+	const SimConfig &config = *job.config;
+	BattleResult &result = job.results[index];
+
+	// The battle index picks the grid cell and the seed within it
+	u32 cell = index / config.battles;
+	for (size_t i = 0; i < (size_t)SimAxis::_length; i++) {
+		const SimGridAxis &axis = config.axes[i];
+		result.scales[i] = axis.values[cell % axis.length];
+		cell /= axis.length;
+	}
+	result.seed = config.seed + index % config.battles;
+
+	Combat::startBattle(gameState);
+	gameState->combatAi.budgetMilliseconds = 0.0f;
+
+	SimRandom random(result.seed);
+	spawnFleet(gameState, scaleShip(config.fleets[0], result.scales), Faction::ally, config.fleetSize, &random);
+	spawnFleet(gameState, config.fleets[1], Faction::enemy, config.fleetSize, &random);
+
+	const u32 maxFrames = (u32)(config.maxSeconds / SIM_DELTA);
+	u64 totalTicks = 0;
+	u64 maxTicks = 0;
+	u32 frame = 0;
+	u32 allies = config.fleetSize;
+	u32 enemies = config.fleetSize;
+
+	while (frame < maxFrames && allies > 0 && enemies > 0) {
+		const u64 start = Profiler::now();
+		Combat::simulate(gameState, SIM_DELTA);
+		const u64 ticks = Profiler::now() - start;
+
+		gameState->events.endFrame();
+		totalTicks += ticks;
+		maxTicks = ticks > maxTicks ? ticks : maxTicks;
+		frame++;
+
+		allies = shipsLeft(gameState->combat, Faction::ally);
+		enemies = shipsLeft(gameState->combat, Faction::enemy);
+	}
+
+	result.winner =
+		allies > 0 && enemies == 0 ? SimWinner::ally :
+		enemies > 0 && allies == 0 ? SimWinner::enemy :
+		SimWinner::draw;
+	result.seconds = (f32)frame * SIM_DELTA;
+	result.frames = frame;
+	result.alliesLeft = allies;
+	result.enemiesLeft = enemies;
+	result.projectiles = gameState->projectileStats;
+	result.totalFrameTicks = totalTicks;
+	result.maxFrameTicks = maxTicks;
+}
+
+void workerMain(void *argument) {
+	SimJob *job = (SimJob*)argument;
+	GameState *gameState = Memory::create<GameState>(MemoryTag::game);
+
+	u32 index;
+	while ((index = job->next.fetch_add(1)) < job->count) {
+		runBattle(gameState, *job, index);
+	}
+
+	Memory::destroy(gameState);
+}
+
+bool writeResults(const char *path, const BattleResult *results, u32 count, f64 ticksPerSecond) {
+	FILE *file = fopen(path, "w");
+	if (file == nullptr) {
+		return false;
+	}
+
+	fprintf(file, "damage,cooldown,speed,health,seed,winner,seconds,frames,allies_left,enemies_left,fired,hits,dropped,mean_frame_us,max_frame_us\n");
+
+	for (u32 i = 0; i < count; i++) {
+		const BattleResult &result = results[i];
+		const f64 meanFrameTicks = result.frames > 0 ? (f64)result.totalFrameTicks / result.frames : 0.0;
+		fprintf(
+			file,
+			"%g,%g,%g,%g,%llu,%s,%.3f,%u,%u,%u,%u,%u,%u,%.3f,%.3f\n",
+			result.scales[(size_t)SimAxis::damage],
+			result.scales[(size_t)SimAxis::cooldown],
+			result.scales[(size_t)SimAxis::speed],
+			result.scales[(size_t)SimAxis::health],
+			(unsigned long long)result.seed,
+			simWinnerNames[(size_t)result.winner],
+			result.seconds,
+			result.frames,
+			result.alliesLeft,
+			result.enemiesLeft,
+			result.projectiles.fired,
+			result.projectiles.hits,
+			result.projectiles.dropped,
+			meanFrameTicks * 1e6 / ticksPerSecond,
+			result.maxFrameTicks * 1e6 / ticksPerSecond
+		);
+	}
+
+	return fclose(file) == 0;
+}
+
+void printUsage(const char *program) {
+	fprintf(
+		stderr,
+		"Usage: %s [options] <ally.txt> <enemy.txt>\n"
+		"  --fleet <n>          ships on each side (default 10)\n"
+		"  --battles <n>        battles for every combination of scales (default 100)\n"
+		"  --threads <n>        threads fighting battles, including the main thread (default one per core)\n"
+		"  --seed <n>           seed of the first battle in each combination (default 1)\n"
+		"  --max-time <s>       seconds before a battle is called a draw (default 300)\n"
+		"  --damage <a,b,...>   ally weapon damage scales\n"
+		"  --cooldown <a,b,...> ally weapon cooldown scales\n"
+		"  --speed <a,b,...>    ally projectile speed scales\n"
+		"  --health <a,b,...>   ally target health scales\n"
+		"  --out <path>         CSV to write (default combat_sim.csv)\n",
+		program
+	);
+}
+
+bool parseArguments(int argumentCount, char **arguments, SimConfig *config) {
+	const char *templatePaths[2] = {};
+	u32 templateCount = 0;
+
+	for (int i = 1; i < argumentCount; i++) {
+		const char *argument = arguments[i];
+
+		if (argument[0] != '-') {
+			if (templateCount == 2) {
+				return false;
+			}
+			templatePaths[templateCount++] = argument;
+			continue;
+		}
+
+		if (i + 1 == argumentCount) {
+			return false;
+		}
+		const char *value = arguments[++i];
+
+		bool valid = true;
+		if (strcmp(argument, "--fleet") == 0) {
+			config->fleetSize = (u32)strtoul(value, nullptr, 10);
+			valid = config->fleetSize > 0 && config->fleetSize * 2 <= COMBAT_SHIP_MAX;
+		} else if (strcmp(argument, "--battles") == 0) {
+			config->battles = (u32)strtoul(value, nullptr, 10);
+			valid = config->battles > 0;
+		} else if (strcmp(argument, "--threads") == 0) {
+			config->threads = (u32)strtoul(value, nullptr, 10);
+			valid = config->threads > 0 && config->threads <= SIM_THREAD_MAX;
+		} else if (strcmp(argument, "--seed") == 0) {
+			config->seed = strtoull(value, nullptr, 10);
+		} else if (strcmp(argument, "--max-time") == 0) {
+			config->maxSeconds = strtof(value, nullptr);
+			valid = config->maxSeconds > 0.0f;
+		} else if (strcmp(argument, "--out") == 0) {
+			config->outputPath = value;
+		} else {
+			valid = false;
+			for (size_t axis = 0; axis < (size_t)SimAxis::_length; axis++) {
+				if (strcmp(argument, simAxisOptions[axis]) == 0) {
+					valid = parseAxis(value, &config->axes[axis]);
+				}
+			}
+		}
+
+		if (!valid) {
+			fprintf(stderr, "error: invalid value for %s: %s\n", argument, value);
+			return false;
+		}
+	}
+
+	if (templateCount != 2) {
+		return false;
+	}
+
+	for (u32 i = 0; i < 2; i++) {
+		if (!loadFleetTemplate(templatePaths[i], &config->fleets[i])) {
+			return false;
+		}
+	}
+
+	// NOTE: Each ship takes one entity plus one for each target and weapon.
+	const size_t allyChildren = config->fleets[0].targets.length + config->fleets[0].weapons.length;
+	const size_t enemyChildren = config->fleets[1].targets.length + config->fleets[1].weapons.length;
+	const u32 entitiesPerShip = 1 + (u32)(allyChildren > enemyChildren ? allyChildren : enemyChildren);
+	if (config->fleetSize * 2 * entitiesPerShip > COMBAT_ENTITY_MAX) {
+		fprintf(stderr, "error: fleets of %u are too big for %d combat entities\n", config->fleetSize, COMBAT_ENTITY_MAX);
+		return false;
+	}
+
+	return true;
+}
+
+int main(int argumentCount, char **arguments) {
+	static SimConfig config;
+	if (!parseArguments(argumentCount, arguments, &config)) {
+		printUsage(arguments[0]);
+		return 1;
+	}
+
+	u32 cells = 1;
+	for (const SimGridAxis &axis : config.axes) {
+		cells *= axis.length;
+	}
+
+	// Zero when the platform can't tell
+	if (config.threads == 0) {
+		const u32 cores = std::thread::hardware_concurrency();
+		config.threads = cores == 0 ? 1 : cores < SIM_THREAD_MAX ? cores : SIM_THREAD_MAX;
+	}
+
+	Profiler::initialise();
+
+	SimJob job;
+	job.config = &config;
+	job.count = cells * config.battles;
+	job.results = Memory::allocateArray<BattleResult>(MemoryTag::game, job.count);
+	job.next = 0;
+
+	printf("%u battles of %u ships a side on %u threads\n", job.count, config.fleetSize, config.threads);
+
+	const u64 start = Profiler::now();
+
+	// The main thread takes battles as well, so a worker that couldn't be
+	// started only leaves the rest to take longer
+	Thread threads[SIM_THREAD_MAX];
+	u32 started = 1;
+	for (u32 i = 1; i < config.threads; i++) {
+		started += threads[i].start(workerMain, &job);
+	}
+	workerMain(&job);
+	for (u32 i = 1; i < config.threads; i++) {
+		threads[i].join();
+	}
+
+	// After the battles so the counter has had time to be measured against
+	const f64 ticksPerSecond = Profiler::ticksPerSecond();
+	const f64 seconds = (f64)(Profiler::now() - start) / ticksPerSecond;
+	if (started < config.threads) {
+		fprintf(stderr, "warning: only %u of %u threads started\n", started, config.threads);
+	}
+
+	u64 frames = 0;
+	u32 wins[3] = {};
+	for (u32 i = 0; i < job.count; i++) {
+		frames += job.results[i].frames;
+		wins[(size_t)job.results[i].winner]++;
+	}
+
+	printf("ally %u, enemy %u, draw %u\n", wins[0], wins[1], wins[2]);
+	printf("%.2fs, %.1f battles/s, %.0f frames/s\n", seconds, job.count / seconds, frames / seconds);
+
+	const bool written = writeResults(config.outputPath, job.results, job.count, ticksPerSecond);
+	if (!written) {
+		fprintf(stderr, "%s: error: unable to write\n", config.outputPath);
+	}
+
+	Memory::release(job.results);
+	return written ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,375 @@
+// Times the vector and matrix types against the ones they replaced, over
+// batches the size of a frame's sprites:
+//
+//     math_bench [--sprites 1024] [--rounds 2000]
+//
+// Lengths, distances and normalising are compared with the `pow` and divide
+// versions Vec2 used to have, and `Mat4::trs` with the translate, rotate and
+// scale chain sprite transforms used to be built with. Each round runs a
+// batch of `--sprites` through the old code and then the new, the times are
+// totalled over every round and printed per call. Exits with 1 if any result
+// differs from the old one by more than a float's worth of rounding.
+
+#define _USE_MATH_DEFINES 1
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "types/core.hpp"
+#include "types/matrix.hpp"
+#include "types/vector.hpp"
+#include "utils/memory.hpp"
+#include "utils/profiler.hpp"
+
+// Relative to the old result, which is taken as right since its lengths go
+// through `pow` and `sqrt` in double
+#define BENCH_TOLERANCE 1e-5
+
+struct BenchOptions {
+	u32 sprites = 1024;
+	u32 rounds = 2000;
+};
+
+struct SpriteTransform {
+	Vec3<f32> position;
+	// Radians
+	f32 angle;
+	Vec2<f32> scale;
+};
+
+struct BenchResult {
+	const char *name;
+	u64 legacyTicks;
+	u64 currentTicks;
+	f64 maxError;
+};
+
+namespace Legacy {
+	// Vec2 as it was
+	template<typename T>
+	struct Vec2 {
+		T x, y;
+
+		Vec2(T x = 0, T y = 0) : x(x), y(y) {}
+
+		f32 distanceTo(const Vec2<T> &other) const {
+			return sqrt(pow(this->x - other.x, 2) + pow(this->y - other.y, 2));
+		}
+
+		T magnitude() const {
+			return sqrt(pow(this->x, 2) + pow(this->y, 2));
+		}
+
+		Vec2<T> normalized() const {
+			T magnitude = this->magnitude();
+			return Vec2<T>(this->x / magnitude, this->y / magnitude);
+		}
+	};
+
+	// Mat4x4 as it was, only what sprite transforms used
+	template<typename T>
+	struct Mat4x4 {
+		T x0; T y0; T z0; T w0;
+		T x1; T y1; T z1; T w1;
+		T x2; T y2; T z2; T w2;
+		T x3; T y3; T z3; T w3;
+
+		Mat4x4(
+			T x0 = 1, T x1 = 0, T x2 = 0, T x3 = 0,
+			T y0 = 0, T y1 = 1, T y2 = 0, T y3 = 0,
+			T z0 = 0, T z1 = 0, T z2 = 1, T z3 = 0,
+			T w0 = 0, T w1 = 0, T w2 = 0, T w3 = 1
+		) {
+			this->x0 = x0; this->x1 = x1; this->x2 = x2; this->x3 = x3;
+			this->y0 = y0; this->y1 = y1; this->y2 = y2; this->y3 = y3;
+			this->z0 = z0; this->z1 = z1; this->z2 = z2; this->z3 = z3;
+			this->w0 = w0; this->w1 = w1; this->w2 = w2; this->w3 = w3;
+		}
+
+		Mat4x4<T> scale(T x = 1, T y = 1, T z = 1) const {
+			Mat4x4<f32> result = *this;
+			result.x0 *= x; result.y0 *= x; result.z0 *= x;
+			result.x1 *= y; result.y1 *= y; result.z1 *= y;
+			result.x2 *= z; result.y2 *= z; result.z2 *= z;
+			return result;
+		}
+
+		Mat4x4<T> translate(T x = 0, T y = 0, T z = 0) const {
+			Mat4x4<T> result = *this;
+			result.x3 = result.x0 * x + result.x1 * y + result.x2 * z + result.x3;
+			result.y3 = result.y0 * x + result.y1 * y + result.y2 * z + result.y3;
+			result.z3 = result.z0 * x + result.z1 * y + result.z2 * z + result.z3;
+			return result;
+		}
+
+		Mat4x4<T> rotate(T angle) const {
+			const T c = cos(angle);
+			const T s = sin(angle);
+
+			Mat4x4<T> rotate;
+			rotate.x0 = c;
+			rotate.y0 = s;
+
+			rotate.x1 = -s;
+			rotate.y1 = c;
+
+			Mat4x4<T> result = *this;
+			result.x0 = this->x0 * rotate.x0 + this->x1 * rotate.y0;
+			result.y0 = this->y0 * rotate.x0 + this->y1 * rotate.y0;
+			result.z0 = this->z0 * rotate.x0 + this->z1 * rotate.y0;
+
+			result.x1 = this->x0 * rotate.x1 + this->x1 * rotate.y1;
+			result.y1 = this->y0 * rotate.x1 + this->y1 * rotate.y1;
+			result.z1 = this->z0 * rotate.x1 + this->z1 * rotate.y1;
+
+			return result;
+		}
+	};
+};
+
+// xorshift, so every run times the same numbers
+struct Random {
+	u32 state = 0x9e3779b9;
+
+	f32 next() {
+		this->state ^= this->state << 13;
+		this->state ^= this->state >> 17;
+		this->state ^= this->state << 5;
+		return (f32)(this->state >> 8) / (f32)(1 << 24);
+	}
+
+	f32 range(f32 low, f32 high) {
+		return low + (high - low) * this->next();
+	}
+};
+
+f64 relativeError(f64 expected, f64 actual) {
+	const f64 magnitude = fabs(expected) > 1.0 ? fabs(expected) : 1.0;
+	return fabs(expected - actual) / magnitude;
+}
+
+BenchResult benchMagnitude(const BenchOptions &options, const Vec2<f32> *points) {
+	f32 *legacy = Memory::allocateArray<f32>(MemoryTag::game, options.sprites);
+	f32 *current = Memory::allocateArray<f32>(MemoryTag::game, options.sprites);
+	BenchResult result = {};
+	result.name = "magnitude";
+
+	for (u32 round = 0; round < options.rounds; round++) {
+		u64 start = Profiler::now();
+		for (u32 i = 0; i < options.sprites; i++) {
+			legacy[i] = Legacy::Vec2<f32>(points[i].x, points[i].y).magnitude();
+		}
+		result.legacyTicks += Profiler::now() - start;
+
+		start = Profiler::now();
+		for (u32 i = 0; i < options.sprites; i++) {
+			current[i] = points[i].magnitude();
+		}
+		result.currentTicks += Profiler::now() - start;
+	}
+
+	for (u32 i = 0; i < options.sprites; i++) {
+		const f64 error = relativeError(legacy[i], current[i]);
+		result.maxError = error > result.maxError ? error : result.maxError;
+	}
+
+	Memory::release(current);
+	Memory::release(legacy);
+	return result;
+}
+
+BenchResult benchDistance(const BenchOptions &options, const Vec2<f32> *points, const Vec2<f32> *others) {
+	f32 *legacy = Memory::allocateArray<f32>(MemoryTag::game, options.sprites);
+	f32 *current = Memory::allocateArray<f32>(MemoryTag::game, options.sprites);
+	BenchResult result = {};
+	result.name = "distanceTo";
+
+	for (u32 round = 0; round < options.rounds; round++) {
+		u64 start = Profiler::now();
+		for (u32 i = 0; i < options.sprites; i++) {
+			const Legacy::Vec2<f32> other(others[i].x, others[i].y);
+			legacy[i] = Legacy::Vec2<f32>(points[i].x, points[i].y).distanceTo(other);
+		}
+		result.legacyTicks += Profiler::now() - start;
+
+		start = Profiler::now();
+		for (u32 i = 0; i < options.sprites; i++) {
+			current[i] = points[i].distanceTo(others[i]);
+		}
+		result.currentTicks += Profiler::now() - start;
+	}
+
+	for (u32 i = 0; i < options.sprites; i++) {
+		const f64 error = relativeError(legacy[i], current[i]);
+		result.maxError = error > result.maxError ? error : result.maxError;
+	}
+
+	Memory::release(current);
+	Memory::release(legacy);
+	return result;
+}
+
+BenchResult benchNormalise(const BenchOptions &options, const Vec2<f32> *points) {
+	Vec2<f32> *legacy = Memory::allocateArray<Vec2<f32>>(MemoryTag::game, options.sprites);
+	Vec2<f32> *current = Memory::allocateArray<Vec2<f32>>(MemoryTag::game, options.sprites);
+	BenchResult result = {};
+	result.name = "normalized";
+
+	for (u32 round = 0; round < options.rounds; round++) {
+		u64 start = Profiler::now();
+		for (u32 i = 0; i < options.sprites; i++) {
+			const Legacy::Vec2<f32> normal = Legacy::Vec2<f32>(points[i].x, points[i].y).normalized();
+			legacy[i] = Vec2<f32>(normal.x, normal.y);
+		}
+		result.legacyTicks += Profiler::now() - start;
+
+		start = Profiler::now();
+		for (u32 i = 0; i < options.sprites; i++) {
+			current[i] = points[i].normalized();
+		}
+		result.currentTicks += Profiler::now() - start;
+	}
+
+	for (u32 i = 0; i < options.sprites; i++) {
+		const f64 errorX = relativeError(legacy[i].x, current[i].x);
+		const f64 errorY = relativeError(legacy[i].y, current[i].y);
+		const f64 error = errorX > errorY ? errorX : errorY;
+		result.maxError = error > result.maxError ? error : result.maxError;
+	}
+
+	Memory::release(current);
+	Memory::release(legacy);
+	return result;
+}
+
+BenchResult benchTransform(const BenchOptions &options, const SpriteTransform *sprites) {
+	Legacy::Mat4x4<f32> *legacy = Memory::allocateArray<Legacy::Mat4x4<f32>>(MemoryTag::game, options.sprites);
+	Mat4 *current = Memory::allocateArray<Mat4>(MemoryTag::game, options.sprites);
+	BenchResult result = {};
+	result.name = "Mat4::trs";
+
+	for (u32 round = 0; round < options.rounds; round++) {
+		u64 start = Profiler::now();
+		for (u32 i = 0; i < options.sprites; i++) {
+			const SpriteTransform &sprite = sprites[i];
+			Legacy::Mat4x4<f32> transform;
+			transform = transform.translate(sprite.position.x, sprite.position.y, sprite.position.z);
+			transform = transform.rotate(sprite.angle);
+			transform = transform.scale(sprite.scale.x, sprite.scale.y);
+			legacy[i] = transform;
+		}
+		result.legacyTicks += Profiler::now() - start;
+
+		start = Profiler::now();
+		for (u32 i = 0; i < options.sprites; i++) {
+			const SpriteTransform &sprite = sprites[i];
+			current[i] = Mat4::trs(sprite.position, sprite.angle, sprite.scale);
+		}
+		result.currentTicks += Profiler::now() - start;
+	}
+
+	// Both are column major, element for element the same layout
+	static_assert(sizeof(Legacy::Mat4x4<f32>) == sizeof(Mat4), "Legacy::Mat4x4 must match the Mat4 layout");
+	for (u32 i = 0; i < options.sprites; i++) {
+		f32 expected[16];
+		f32 actual[16];
+		memcpy(expected, &legacy[i], sizeof(expected));
+		memcpy(actual, &current[i], sizeof(actual));
+		for (u32 e = 0; e < 16; e++) {
+			const f64 error = relativeError(expected[e], actual[e]);
+			result.maxError = error > result.maxError ? error : result.maxError;
+		}
+	}
+
+	Memory::release(current);
+	Memory::release(legacy);
+	return result;
+}
+
+bool parseArguments(int argumentCount, char **arguments, BenchOptions *options) {
+	for (int i = 1; i < argumentCount; i++) {
+		const char *argument = arguments[i];
+		if (i + 1 == argumentCount) {
+			return false;
+		}
+		const u32 number = (u32)strtoul(arguments[++i], nullptr, 10);
+
+		bool valid = number > 0;
+		if (strcmp(argument, "--sprites") == 0) {
+			options->sprites = number;
+		} else if (strcmp(argument, "--rounds") == 0) {
+			options->rounds = number;
+		} else {
+			valid = false;
+		}
+
+		if (!valid) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+int main(int argumentCount, char **arguments) {
+	BenchOptions options;
+	if (!parseArguments(argumentCount, arguments, &options)) {
+		fprintf(stderr, "Usage: %s [--sprites n] [--rounds n]\n", arguments[0]);
+		return 1;
+	}
+
+	Profiler::initialise();
+
+	// Spread over a screen or so, sizes and angles anything a sprite might have
+	Random random;
+	Vec2<f32> *points = Memory::allocateArray<Vec2<f32>>(MemoryTag::game, options.sprites);
+	Vec2<f32> *others = Memory::allocateArray<Vec2<f32>>(MemoryTag::game, options.sprites);
+	SpriteTransform *sprites = Memory::allocateArray<SpriteTransform>(MemoryTag::game, options.sprites);
+	for (u32 i = 0; i < options.sprites; i++) {
+		points[i] = Vec2<f32>(random.range(-1000.0f, 1000.0f), random.range(-1000.0f, 1000.0f));
+		others[i] = Vec2<f32>(random.range(-1000.0f, 1000.0f), random.range(-1000.0f, 1000.0f));
+		sprites[i].position = Vec3<f32>(random.range(-1000.0f, 1000.0f), random.range(-1000.0f, 1000.0f), random.range(0.0f, 1.0f));
+		sprites[i].angle = random.range(-(f32)M_PI, (f32)M_PI);
+		sprites[i].scale = Vec2<f32>(random.range(8.0f, 256.0f), random.range(8.0f, 256.0f));
+	}
+
+	const BenchResult results[] = {
+		benchMagnitude(options, points),
+		benchDistance(options, points, others),
+		benchNormalise(options, points),
+		benchTransform(options, sprites)
+	};
+
+	// After the work so the counter has had time to be measured against
+	const f64 ticksPerSecond = Profiler::ticksPerSecond();
+	const f64 calls = (f64)options.sprites * options.rounds;
+
+	printf("%u sprites x %u rounds\n", options.sprites, options.rounds);
+	printf("%-12s %10s %10s %8s %10s\n", "", "old ns", "new ns", "speedup", "max error");
+
+	bool succeeded = true;
+	for (const BenchResult &result : results) {
+		const f64 legacyNanoseconds = Profiler::ticksToMilliseconds(result.legacyTicks, ticksPerSecond) * 1000000.0 / calls;
+		const f64 currentNanoseconds = Profiler::ticksToMilliseconds(result.currentTicks, ticksPerSecond) * 1000000.0 / calls;
+		printf(
+			"%-12s %10.2f %10.2f %7.2fx %10.2e\n",
+			result.name,
+			legacyNanoseconds,
+			currentNanoseconds,
+			legacyNanoseconds / currentNanoseconds,
+			result.maxError
+		);
+
+		if (result.maxError > BENCH_TOLERANCE) {
+			fprintf(stderr, "error: %s differs from the old version by more than %.0e\n", result.name, BENCH_TOLERANCE);
+			succeeded = false;
+		}
+	}
+
+	Memory::release(sprites);
+	Memory::release(others);
+	Memory::release(points);
+	return succeeded ? 0 : 1;
+}
\ No newline at end of file
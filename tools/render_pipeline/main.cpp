@@ -0,0 +1,222 @@
+// Measures how much the render thread overlaps the game thread and how much
+// latency handing frames over adds, without a GPU or a window so it also runs
+// on Linux:
+//
+//     render_pipeline --frames 600 --update-us 6000 --render-us 8000 --sprites 200 --ui 60
+//
+// The game side spins for `--update-us` and fills the game's sprite and UI
+// buffers, the render side spins for `--render-us` per packet. Both are run
+// once on a single thread, the way the game loop used to, and once through
+// the render queue with a render thread.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "common/render_queue.hpp"
+#include "types/core.hpp"
+#include "utils/profiler.hpp"
+#include "utils/thread.hpp"
+
+struct PipelineConfig {
+	u32 frames = 600;
+	u32 updateMicroseconds = 6000;
+	u32 renderMicroseconds = 8000;
+	u32 sprites = 200;
+	u32 uiElements = 60;
+};
+
+struct PipelineResult {
+	f64 frameMilliseconds;
+	f64 meanLatencyMilliseconds;
+	f64 maxLatencyMilliseconds;
+	f64 gameWaitMilliseconds;
+	f64 renderWaitMilliseconds;
+};
+
+// Stands in for the game state's render buffers
+struct FrameBuffers {
+	SpriteBuffer sprites;
+	UIElementBuffer uiElements;
+};
+
+void spin(u32 microseconds) {
+	const u64 end = Profiler::referenceNanoseconds() + (u64)microseconds * 1000;
+	while (Profiler::referenceNanoseconds() < end) {}
+}
+
+void update(const PipelineConfig &config, FrameBuffers *buffers, u32 frame) {
+	spin(config.updateMicroseconds);
+
+	for (u32 i = 0; i < config.sprites && buffers->sprites.length < buffers->sprites.capacity(); i++) {
+		Sprite sprite = {};
+		sprite.position = Vec3((f32)i, (f32)frame);
+		buffers->sprites.push(sprite);
+	}
+
+	for (u32 i = 0; i < config.uiElements && buffers->uiElements.length < buffers->uiElements.capacity(); i++) {
+		UITextData text = {};
+		text.text = L"Render pipeline";
+		text.font = L"consolas";
+		text.position = Vec2((f32)i, (f32)frame);
+		buffers->uiElements.push(text);
+	}
+}
+
+void copyFrame(FrameBuffers *buffers, RenderPacket *packet) {
+	packet->sprites.copyFrom(buffers->sprites);
+	packet->uiElements.copyFrom(buffers->uiElements);
+	buffers->sprites.clear();
+	buffers->uiElements.clear();
+}
+
+// Everything on one thread, the latency is from the end of the copy to the
+// end of drawing to match what the queue measures
+PipelineResult runSerial(const PipelineConfig &config, FrameBuffers *buffers, RenderPacket *packet) {
+	const f64 ticksPerSecond = Profiler::ticksPerSecond();
+	u64 totalLatency = 0;
+	u64 maxLatency = 0;
+
+	const u64 start = Profiler::now();
+	for (u32 frame = 0; frame < config.frames; frame++) {
+		update(config, buffers, frame);
+		copyFrame(buffers, packet);
+
+		const u64 submitted = Profiler::now();
+		spin(config.renderMicroseconds);
+
+		const u64 latency = Profiler::now() - submitted;
+		totalLatency += latency;
+		maxLatency = latency > maxLatency ? latency : maxLatency;
+	}
+	const u64 total = Profiler::now() - start;
+
+	PipelineResult result = {};
+	result.frameMilliseconds = Profiler::ticksToMilliseconds(total, ticksPerSecond) / config.frames;
+	result.meanLatencyMilliseconds = Profiler::ticksToMilliseconds(totalLatency, ticksPerSecond) / config.frames;
+	result.maxLatencyMilliseconds = Profiler::ticksToMilliseconds(maxLatency, ticksPerSecond);
+	return result;
+}
+
+struct RenderContext {
+	const PipelineConfig *config;
+	RenderQueue *queue;
+};
+
+void renderMain(void *argument) {
+	RenderContext *context = (RenderContext*)argument;
+
+	while (context->queue->beginRead() != nullptr) {
+		spin(context->config->renderMicroseconds);
+		context->queue->endRead();
+	}
+}
+
+PipelineResult runPipelined(const PipelineConfig &config, FrameBuffers *buffers, RenderQueue *queue) {
+	const f64 ticksPerSecond = Profiler::ticksPerSecond();
+
+	RenderContext context = { &config, queue };
+	Thread renderThread;
+	if (!renderThread.start(renderMain, &context)) {
+		fprintf(stderr, "error: unable to start the render thread\n");
+		exit(1);
+	}
+
+	const u64 start = Profiler::now();
+	for (u32 frame = 0; frame < config.frames; frame++) {
+		update(config, buffers, frame);
+		copyFrame(buffers, queue->beginWrite());
+		queue->submit();
+	}
+
+	// Closing lets the last packet be drawn first, so the frames are comparable
+	queue->close();
+	renderThread.join();
+	const u64 total = Profiler::now() - start;
+
+	const RenderQueueStats stats = queue->getStats();
+	PipelineResult result = {};
+	result.frameMilliseconds = Profiler::ticksToMilliseconds(total, ticksPerSecond) / config.frames;
+	result.meanLatencyMilliseconds = Profiler::ticksToMilliseconds(stats.latencyTicks, ticksPerSecond) / stats.frames;
+	result.maxLatencyMilliseconds = Profiler::ticksToMilliseconds(stats.maxLatencyTicks, ticksPerSecond);
+	result.gameWaitMilliseconds = Profiler::ticksToMilliseconds(stats.gameWaitTicks, ticksPerSecond) / config.frames;
+	result.renderWaitMilliseconds = Profiler::ticksToMilliseconds(stats.renderWaitTicks, ticksPerSecond) / config.frames;
+	return result;
+}
+
+bool parseArguments(int argumentCount, char **arguments, PipelineConfig *config) {
+	for (int i = 1; i + 1 < argumentCount; i += 2) {
+		const char *argument = arguments[i];
+		const u32 value = (u32)strtoul(arguments[i + 1], nullptr, 10);
+
+		if (strcmp(argument, "--frames") == 0 && value > 0) {
+			config->frames = value;
+		} else if (strcmp(argument, "--update-us") == 0) {
+			config->updateMicroseconds = value;
+		} else if (strcmp(argument, "--render-us") == 0) {
+			config->renderMicroseconds = value;
+		} else if (strcmp(argument, "--sprites") == 0) {
+			config->sprites = value;
+		} else if (strcmp(argument, "--ui") == 0) {
+			config->uiElements = value;
+		} else {
+			return false;
+		}
+	}
+
+	return argumentCount % 2 == 1;
+}
+
+int main(int argumentCount, char **arguments) {
+	PipelineConfig config;
+	if (!parseArguments(argumentCount, arguments, &config)) {
+		fprintf(stderr, "Usage: %s [--frames n] [--update-us n] [--render-us n] [--sprites n] [--ui n]\n", arguments[0]);
+		return 1;
+	}
+
+	Profiler::initialise();
+
+	FrameBuffers *buffers = Memory::create<FrameBuffers>(MemoryTag::game);
+	RenderQueue *queue = Memory::create<RenderQueue>(MemoryTag::renderer);
+	RenderPacket *packet = Memory::create<RenderPacket>(MemoryTag::renderer);
+
+	printf(
+		"%u frames, update %.2fms, render %.2fms, %u sprites, %u UI elements\n",
+		config.frames,
+		config.updateMicroseconds / 1e3,
+		config.renderMicroseconds / 1e3,
+		config.sprites,
+		config.uiElements
+	);
+
+	const PipelineResult serial = runSerial(config, buffers, packet);
+	const PipelineResult pipelined = runPipelined(config, buffers, queue);
+
+	printf("           frame     latency  max latency  game wait  render wait\n");
+	printf(
+		"serial     %6.2fms  %6.2fms   %6.2fms\n",
+		serial.frameMilliseconds,
+		serial.meanLatencyMilliseconds,
+		serial.maxLatencyMilliseconds
+	);
+	printf(
+		"pipelined  %6.2fms  %6.2fms   %6.2fms     %6.2fms    %6.2fms\n",
+		pipelined.frameMilliseconds,
+		pipelined.meanLatencyMilliseconds,
+		pipelined.maxLatencyMilliseconds,
+		pipelined.gameWaitMilliseconds,
+		pipelined.renderWaitMilliseconds
+	);
+
+	// How much of the shorter side was hidden behind the longer one
+	const f64 shorter = (config.updateMicroseconds < config.renderMicroseconds ? config.updateMicroseconds : config.renderMicroseconds) / 1e3;
+	if (shorter > 0.0) {
+		printf("overlap    %.0f%%\n", (serial.frameMilliseconds - pipelined.frameMilliseconds) / shorter * 100.0);
+	}
+
+	Memory::destroy(packet);
+	Memory::destroy(queue);
+	Memory::destroy(buffers);
+	Profiler::shutdown();
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,319 @@
+// Checks the render scale controller against a simulated GPU, without a GPU
+// or a window so it also runs on Linux:
+//
+//     render_scale --target-ms 14 --fixed-ms 2 --pixel-ms 12 --load 1,1.6,0.8,1.3 --lag 3
+//
+// Each frame's GPU time is `(fixed + pixel * scale^2) * load`, give or take
+// `--noise`, and reaches the controller `--lag` frames late the way timestamp
+// queries do. The load steps through the `--load` list, `--phase-frames`
+// each. For every phase it prints the scale it settled on, how often frames
+// went over the target and how often the scale changed once it should have
+// settled, next to the same load drawn at full resolution.
+//
+// It exits with 1 if once settled more than `--max-over` of a phase's frames
+// were over the target when the scale could still go down, the scale kept
+// changing, or frames were left well under the target when it could still go
+// up. `--csv` writes every frame out to plot.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "common/render_scale.hpp"
+#include "types/core.hpp"
+
+#define LOAD_PHASE_MAX 16
+#define TIMING_LAG_MAX 16
+
+struct SimulationConfig {
+	RenderScaleConfig controller;
+	f32 fixedMilliseconds = 2.0f;
+	f32 pixelMilliseconds = 12.0f;
+	f32 cpuMilliseconds = 6.0f;
+	f32 noise = 0.05f;
+	f32 loads[LOAD_PHASE_MAX] = { 1.0f, 1.6f, 0.8f, 1.3f };
+	u32 loadCount = 4;
+	u32 phaseFrames = 600;
+	// Frames at the start of a phase that don't count towards the settled
+	// figures
+	u32 settleFrames = 120;
+	u32 lag = 3;
+	f32 maxOverFraction = 0.05f;
+	u32 maxSettledChanges = 2;
+	const char *csvPath = nullptr;
+};
+
+struct PhaseResult {
+	f32 load;
+	f32 meanScale;
+	f32 minScale;
+	f32 maxScale;
+	f32 settledScale;
+	f32 settledMeanMilliseconds;
+	u32 over;
+	u32 settledOver;
+	u32 settledFrames;
+	u32 fullResolutionOver;
+	u32 changes;
+	u32 settledChanges;
+};
+
+// xorshift, so every run sees the same noise
+struct Random {
+	u32 state = 0x9e3779b9;
+
+	f32 next() {
+		this->state ^= this->state << 13;
+		this->state ^= this->state >> 17;
+		this->state ^= this->state << 5;
+		return (f32)(this->state >> 8) / (f32)(1 << 24);
+	}
+};
+
+f32 gpuMilliseconds(const SimulationConfig &config, f32 scale, f32 load, f32 noise) {
+	return (config.fixedMilliseconds + config.pixelMilliseconds * scale * scale) * load * (1.0f + noise);
+}
+
+void run(const SimulationConfig &config, PhaseResult *results, FILE *csv) {
+	RenderScaleController controller;
+	controller.config = config.controller;
+	controller.reset();
+
+	Random random;
+	// Timings still on their way back, indexed by frame
+	f32 pending[TIMING_LAG_MAX + 1] = {};
+	const f32 target = config.controller.targetMilliseconds;
+
+	u32 frame = 0;
+	for (u32 phase = 0; phase < config.loadCount; phase++) {
+		PhaseResult &result = results[phase];
+		result = {};
+		result.load = config.loads[phase];
+		result.minScale = config.controller.maxScale;
+
+		f32 scaleTotal = 0.0f;
+		f32 settledScaleTotal = 0.0f;
+		f32 settledMillisecondsTotal = 0.0f;
+
+		for (u32 i = 0; i < config.phaseFrames; i++, frame++) {
+			const f32 scale = controller.getScale();
+			const f32 noise = (random.next() * 2.0f - 1.0f) * config.noise;
+			const f32 milliseconds = gpuMilliseconds(config, scale, result.load, noise);
+			const bool settled = i >= config.settleFrames;
+
+			scaleTotal += scale;
+			result.minScale = scale < result.minScale ? scale : result.minScale;
+			result.maxScale = scale > result.maxScale ? scale : result.maxScale;
+			result.over += milliseconds > target;
+			result.fullResolutionOver += gpuMilliseconds(config, 1.0f, result.load, noise) > target;
+
+			if (settled) {
+				result.settledFrames++;
+				result.settledOver += milliseconds > target;
+				settledScaleTotal += scale;
+				settledMillisecondsTotal += milliseconds;
+			}
+
+			pending[frame % (config.lag + 1)] = milliseconds;
+
+			// What the timestamp queries have finished for by now
+			f32 reported = 0.0f;
+			if (frame >= config.lag) {
+				reported = pending[(frame - config.lag) % (config.lag + 1)];
+				const u32 changes = controller.getStats().changes;
+				controller.update(reported, config.cpuMilliseconds);
+
+				if (controller.getStats().changes != changes) {
+					result.changes++;
+					result.settledChanges += settled;
+				}
+			}
+
+			if (csv != nullptr) {
+				fprintf(csv, "%u,%.2f,%.2f,%.3f,%.3f\n", frame, result.load, scale, milliseconds, reported);
+			}
+		}
+
+		result.meanScale = scaleTotal / config.phaseFrames;
+		if (result.settledFrames > 0) {
+			result.settledScale = settledScaleTotal / result.settledFrames;
+			result.settledMeanMilliseconds = settledMillisecondsTotal / result.settledFrames;
+		}
+	}
+}
+
+// Prints why a phase failed, returns whether it passed
+bool check(const SimulationConfig &config, u32 phase, const PhaseResult &result) {
+	const RenderScaleConfig &controller = config.controller;
+	bool passed = true;
+
+	if (result.settledFrames == 0) {
+		return true;
+	}
+
+	// The controller leaves the scale alone when the CPU is what's slow
+	const bool cpuBound = config.cpuMilliseconds > controller.targetMilliseconds && config.cpuMilliseconds >= result.settledMeanMilliseconds;
+
+	const f32 overFraction = (f32)result.settledOver / result.settledFrames;
+	if (overFraction > config.maxOverFraction && result.settledScale > controller.minScale + controller.step * 0.5f && !cpuBound) {
+		printf("  phase %u: %.1f%% of frames over the target with room to scale down\n", phase, overFraction * 100.0f);
+		passed = false;
+	}
+
+	if (result.settledChanges > config.maxSettledChanges) {
+		printf("  phase %u: scale changed %u times after settling\n", phase, result.settledChanges);
+		passed = false;
+	}
+
+	// The raise threshold keeps it a bit under the target on purpose, this
+	// only catches it stalling well short
+	const f32 floor = controller.targetMilliseconds * controller.raiseThreshold * 0.75f;
+	if (result.settledMeanMilliseconds < floor && result.settledScale < controller.maxScale - controller.step * 0.5f) {
+		printf("  phase %u: settled at %.2fms with room to scale up\n", phase, result.settledMeanMilliseconds);
+		passed = false;
+	}
+
+	return passed;
+}
+
+bool parseList(const char *text, f32 *values, u32 *count) {
+	*count = 0;
+
+	while (true) {
+		char *end;
+		const f32 value = strtof(text, &end);
+		if (end == text || !(value > 0.0f) || *count == LOAD_PHASE_MAX) {
+			return false;
+		}
+		values[(*count)++] = value;
+
+		if (*end == '\0') {
+			return true;
+		}
+		if (*end != ',') {
+			return false;
+		}
+		text = end + 1;
+	}
+}
+
+bool parseArguments(int argumentCount, char **arguments, SimulationConfig *config) {
+	RenderScaleConfig &controller = config->controller;
+
+	for (int i = 1; i + 1 < argumentCount; i += 2) {
+		const char *argument = arguments[i];
+		const char *value = arguments[i + 1];
+		const f32 number = strtof(value, nullptr);
+
+		bool valid = true;
+		if (strcmp(argument, "--target-ms") == 0) {
+			controller.targetMilliseconds = number;
+			valid = number > 0.0f;
+		} else if (strcmp(argument, "--min-scale") == 0) {
+			controller.minScale = number;
+			valid = number > 0.0f && number <= 1.0f;
+		} else if (strcmp(argument, "--step") == 0) {
+			controller.step = number;
+			valid = number > 0.0f && number < 1.0f;
+		} else if (strcmp(argument, "--fixed-ms") == 0) {
+			config->fixedMilliseconds = number;
+			valid = number >= 0.0f;
+		} else if (strcmp(argument, "--pixel-ms") == 0) {
+			config->pixelMilliseconds = number;
+			valid = number > 0.0f;
+		} else if (strcmp(argument, "--cpu-ms") == 0) {
+			config->cpuMilliseconds = number;
+			valid = number >= 0.0f;
+		} else if (strcmp(argument, "--noise") == 0) {
+			config->noise = number;
+			valid = number >= 0.0f && number < 1.0f;
+		} else if (strcmp(argument, "--load") == 0) {
+			valid = parseList(value, config->loads, &config->loadCount);
+		} else if (strcmp(argument, "--phase-frames") == 0) {
+			config->phaseFrames = (u32)strtoul(value, nullptr, 10);
+			valid = config->phaseFrames > 0;
+		} else if (strcmp(argument, "--settle-frames") == 0) {
+			config->settleFrames = (u32)strtoul(value, nullptr, 10);
+		} else if (strcmp(argument, "--lag") == 0) {
+			config->lag = (u32)strtoul(value, nullptr, 10);
+			valid = config->lag <= TIMING_LAG_MAX;
+		} else if (strcmp(argument, "--max-over") == 0) {
+			config->maxOverFraction = number;
+		} else if (strcmp(argument, "--csv") == 0) {
+			config->csvPath = value;
+		} else {
+			valid = false;
+		}
+
+		if (!valid) {
+			return false;
+		}
+	}
+
+	return argumentCount % 2 == 1 && controller.minScale <= controller.maxScale;
+}
+
+int main(int argumentCount, char **arguments) {
+	SimulationConfig config;
+	if (!parseArguments(argumentCount, arguments, &config)) {
+		fprintf(
+			stderr,
+			"Usage: %s [--target-ms n] [--min-scale n] [--step n] [--fixed-ms n] [--pixel-ms n] [--cpu-ms n] [--noise n]\n"
+			"          [--load a,b,...] [--phase-frames n] [--settle-frames n] [--lag n] [--max-over n] [--csv path]\n",
+			arguments[0]
+		);
+		return 1;
+	}
+
+	FILE *csv = nullptr;
+	if (config.csvPath != nullptr) {
+		csv = fopen(config.csvPath, "w");
+		if (csv == nullptr) {
+			fprintf(stderr, "Couldn't open %s\n", config.csvPath);
+			return 1;
+		}
+		fprintf(csv, "frame,load,scale,gpu_ms,reported_ms\n");
+	}
+
+	PhaseResult results[LOAD_PHASE_MAX];
+	run(config, results, csv);
+
+	if (csv != nullptr) {
+		fclose(csv);
+	}
+
+	printf(
+		"target %.2fms, gpu %.2fms + %.2fms at full scale, %u frames a phase, timings %u frames late\n",
+		config.controller.targetMilliseconds,
+		config.fixedMilliseconds,
+		config.pixelMilliseconds,
+		config.phaseFrames,
+		config.lag
+	);
+	printf("load   scale  min   max   settled  over   settled over  full res over  changes  settled changes\n");
+
+	bool passed = true;
+	for (u32 i = 0; i < config.loadCount; i++) {
+		const PhaseResult &result = results[i];
+		printf(
+			"%4.2f   %4.2f   %4.2f  %4.2f  %4.2f     %5.1f%%  %5.1f%%        %5.1f%%         %3u      %3u\n",
+			result.load,
+			result.meanScale,
+			result.minScale,
+			result.maxScale,
+			result.settledScale,
+			100.0f * result.over / config.phaseFrames,
+			result.settledFrames > 0 ? 100.0f * result.settledOver / result.settledFrames : 0.0f,
+			100.0f * result.fullResolutionOver / config.phaseFrames,
+			result.changes,
+			result.settledChanges
+		);
+	}
+
+	for (u32 i = 0; i < config.loadCount; i++) {
+		passed = check(config, i, results[i]) && passed;
+	}
+
+	printf(passed ? "PASS\n" : "FAIL\n");
+	return passed ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,480 @@
+// Draws a fixed scene with the software renderer, for checking that what the
+// game draws hasn't changed and for benchmarking the renderer. Doesn't need
+// Direct3D so it also runs on Linux:
+//
+//     software_renderer --out golden.tga
+//     software_renderer --compare golden.tga --tolerance 2 --diff diff.tga
+//     software_renderer --frames 200 --threads 4
+//     software_renderer --frames 200 --trace trace.json --summary summary.csv
+//
+// The scene has a sprite for every texture and one of each UI primitive,
+// including dotted strokes and aligned, wrapped text. Textures are generated
+// rather than decoded from the assets so the output only depends on the
+// renderer. Comparing exits with 1 if any channel of any pixel differs by more
+// than the tolerance.
+//
+// `--trace` and `--summary` write the profiler's zones out the same way the
+// game does with `--profile`, so profiles can come from a headless build.
+
+#define _USE_MATH_DEFINES 1
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "common/ui_element_buffer.hpp"
+#include "renderer/software_renderer.hpp"
+#include "types/array.hpp"
+#include "utils/memory.hpp"
+#include "utils/profiler.hpp"
+
+struct RenderConfig {
+	u32 width = screenWidth;
+	u32 height = screenHeight;
+	u32 threads = 4;
+	u32 frames = 1;
+	u32 tolerance = 0;
+	const char *outputPath = nullptr;
+	const char *comparePath = nullptr;
+	const char *diffPath = nullptr;
+	const char *tracePath = nullptr;
+	const char *summaryPath = nullptr;
+};
+
+struct Scene {
+	Array<Sprite, 64> sprites;
+	UIElementBuffer uiElements;
+};
+
+u32 rgba(u32 r, u32 g, u32 b, u32 a) {
+	return r | g << 8 | b << 16 | a << 24;
+}
+
+// Stand ins with the same kinds of edges as the real textures: hard alpha
+// edges, soft alpha edges and opaque images
+void setTextures(SoftwareRenderer *renderer) {
+	const u32 size = 128;
+	u32 *pixels = Memory::allocateArray<u32>(MemoryTag::textures, size * size);
+
+	// Arrow shaped hull pointing up with a hard edge
+	for (u32 y = 0; y < size; y++) {
+		for (u32 x = 0; x < size; x++) {
+			const f32 across = fabsf(x + 0.5f - size * 0.5f);
+			const bool inside = across < (y + 0.5f) * 0.4f && y > 8;
+			pixels[y * size + x] = inside ? rgba(60 + x, 120 + y, 200, 255) : rgba(0, 0, 0, 0);
+		}
+	}
+	renderer->setTexture(TextureAssetId::ship, size, size, pixels);
+
+	// Disc with an alpha falloff
+	for (u32 y = 0; y < size; y++) {
+		for (u32 x = 0; x < size; x++) {
+			const f32 dx = x + 0.5f - size * 0.5f;
+			const f32 dy = y + 0.5f - size * 0.5f;
+			const f32 alpha = fmaxf(0.0f, 1.0f - sqrtf(dx * dx + dy * dy) / (size * 0.5f));
+			pixels[y * size + x] = rgba(220, 40 + y, 40, (u32)(alpha * 255.0f));
+		}
+	}
+	renderer->setTexture(TextureAssetId::enemyShip, size, size, pixels);
+
+	// Opaque checkerboards
+	for (u32 y = 0; y < size; y++) {
+		for (u32 x = 0; x < size; x++) {
+			const bool light = ((x / 16) + (y / 16)) & 1;
+			pixels[y * size + x] = light ? rgba(200, 190, 150, 255) : rgba(90, 70, 50, 255);
+		}
+	}
+	renderer->setTexture(TextureAssetId::background, size, size, pixels);
+	renderer->setTexture(TextureAssetId::marketPlace1, size, size, pixels);
+
+	Memory::release(pixels);
+}
+
+void buildScene(Scene *scene) {
+	// Behind the starfield like the game's background so never seen
+	Sprite background = {};
+	background.position = Vec3<f32>(0.0f, 0.0f, 0.9f);
+	background.scale = Vec2<f32>(15.0f, 8.5f);
+	background.assetId = TextureAssetId::background;
+	scene->sprites.push(background);
+
+	Sprite market = {};
+	market.position = Vec3<f32>(-700.0f, 300.0f);
+	market.scale = Vec2<f32>(1.5f, 1.0f);
+	market.assetId = TextureAssetId::marketPlace1;
+	scene->sprites.push(market);
+
+	for (u32 i = 0; i < 12; i++) {
+		Sprite ship = {};
+		ship.position = Vec3<f32>(-500.0f + i * 90.0f, -250.0f + (i % 3) * 60.0f);
+		ship.angle = i * 30.0f;
+		ship.scale = Vec2<f32>(0.5f + (i % 4) * 0.25f, 0.5f + (i % 4) * 0.25f);
+		ship.assetId = i % 2 == 0 ? TextureAssetId::ship : TextureAssetId::enemyShip;
+		scene->sprites.push(ship);
+	}
+
+	UITextData title = {};
+	title.text = L"Sunset Beach Delivery Service";
+	title.font = L"Arial";
+	title.fontSize = 40.0f;
+	title.position = Vec2<f32>(0.0f, 40.0f);
+	title.width = screenWidth;
+	title.height = 60.0f;
+	title.horizontalAlignment = UITextAlignment::middle;
+	title.color = Rgba(1.0f, 1.0f, 1.0f, 1.0f);
+	scene->uiElements.push(title);
+
+	UITextData small = {};
+	small.text = L"FPS: 59.94\nSprites: 14";
+	small.font = L"consolas";
+	small.fontSize = 8.0f;
+	small.position = Vec2<f32>(10.0f, 10.0f);
+	small.width = 200.0f;
+	small.height = 40.0f;
+	small.color = Rgba(0.0f, 1.0f, 0.0f, 1.0f);
+	scene->uiElements.push(small);
+
+	// Orbits and planets like the system view
+	for (u32 i = 0; i < 4; i++) {
+		UICircleData orbit = {};
+		orbit.position = Vec2<f32>(960.0f, 700.0f);
+		orbit.radius = 80.0f + i * 60.0f;
+		orbit.strokeWidth = 2.0f;
+		orbit.strokeStyle = UIStrokeStyle::dotted;
+		orbit.strokeColor = Rgba(0.6f, 0.6f, 0.8f, 0.8f);
+		scene->uiElements.push(orbit);
+
+		UICircleData planet = {};
+		planet.position = Vec2<f32>(960.0f + orbit.radius * cosf(i * 1.3f), 700.0f + orbit.radius * sinf(i * 1.3f));
+		planet.radius = 10.0f + i * 3.0f;
+		planet.color = Rgba(0.2f + i * 0.2f, 0.5f, 0.9f - i * 0.2f, 1.0f);
+		planet.strokeWidth = 3.0f;
+		planet.strokeColor = Rgba(1.0f, 1.0f, 1.0f, 1.0f);
+		scene->uiElements.push(planet);
+	}
+
+	UILineData line = {};
+	line.start = Vec2<f32>(200.0f, 900.0f);
+	line.end = Vec2<f32>(700.0f, 780.0f);
+	line.thickness = 3.0f;
+	line.color = Rgba(1.0f, 0.3f, 0.3f, 1.0f);
+	scene->uiElements.push(line);
+
+	UITriangleData triangle = {};
+	triangle.points.push(Vec2<f32>(1500.0f, 200.0f));
+	triangle.points.push(Vec2<f32>(1700.0f, 260.0f));
+	triangle.points.push(Vec2<f32>(1560.0f, 420.0f));
+	triangle.color = Rgba(0.3f, 1.0f, 0.5f, 0.7f);
+	scene->uiElements.push(triangle);
+
+	UIRectangleData panel = {};
+	panel.position = Vec2<f32>(1350.0f, 600.0f);
+	panel.width = 500.0f;
+	panel.height = 320.0f;
+	panel.cornerRadius = 20.0f;
+	panel.strokeWidth = 2.0f;
+	panel.strokeStyle = UIStrokeStyle::dotted;
+	panel.color = Rgba(0.1f, 0.1f, 0.2f, 0.6f);
+	panel.strokeColor = Rgba(0.8f, 0.8f, 1.0f, 1.0f);
+	scene->uiElements.push(panel);
+
+	UITextData wrapped = {};
+	wrapped.text = L"Fragile: 24kg of glassware for Port 7, pays 1250 credits on delivery";
+	wrapped.font = L"Arial";
+	wrapped.fontSize = 20.0f;
+	wrapped.position = Vec2<f32>(1400.0f, 700.0f);
+	wrapped.width = 400.0f;
+	wrapped.height = 200.0f;
+	wrapped.horizontalAlignment = UITextAlignment::end;
+	wrapped.verticalAlignment = UITextAlignment::end;
+	wrapped.color = Rgba(1.0f, 0.9f, 0.5f, 0.9f);
+	scene->uiElements.push(wrapped);
+
+	UIButtonData button = {};
+	button.position = Vec2<f32>(100.0f, 950.0f);
+	button.width = 150.0f;
+	button.height = 70.0f;
+	button.cornerRadius = 10.0f;
+	button.strokeWidth = 2.0f;
+	button.color = Rgba(0.2f, 0.4f, 0.2f, 1.0f);
+	button.strokeColor = Rgba(1.0f, 1.0f, 1.0f, 1.0f);
+	button.label.text = L"Accept";
+	button.label.font = L"Arial";
+	button.label.fontSize = 24.0f;
+	button.label.color = Rgba(1.0f, 1.0f, 1.0f, 1.0f);
+	scene->uiElements.push(button);
+}
+
+// Uncompressed 32 bit TGA with the top row first
+bool writeTga(const char *path, const u32 *pixels, u32 width, u32 height) {
+	FILE *file = fopen(path, "wb");
+	if (file == nullptr) {
+		return false;
+	}
+
+	u8 header[18] = {};
+	header[2] = 2;
+	header[12] = (u8)(width & 0xff);
+	header[13] = (u8)(width >> 8);
+	header[14] = (u8)(height & 0xff);
+	header[15] = (u8)(height >> 8);
+	header[16] = 32;
+	header[17] = 0x28;
+	fwrite(header, sizeof(header), 1, file);
+
+	// RGBA to the BGRA TGA expects
+	for (size_t i = 0; i < (size_t)width * height; i++) {
+		const u32 pixel = pixels[i];
+		const u8 bgra[4] = { (u8)(pixel >> 16), (u8)(pixel >> 8), (u8)pixel, (u8)(pixel >> 24) };
+		fwrite(bgra, sizeof(bgra), 1, file);
+	}
+
+	return fclose(file) == 0;
+}
+
+// Only reads back what `writeTga` writes
+u32 *readTga(const char *path, u32 *width, u32 *height) {
+	FILE *file = fopen(path, "rb");
+	if (file == nullptr) {
+		return nullptr;
+	}
+
+	u8 header[18];
+	if (fread(header, sizeof(header), 1, file) != 1 || header[2] != 2 || header[16] != 32 || header[17] != 0x28) {
+		fclose(file);
+		return nullptr;
+	}
+
+	*width = header[12] | header[13] << 8;
+	*height = header[14] | header[15] << 8;
+	fseek(file, header[0], SEEK_CUR);
+
+	const size_t count = (size_t)*width * *height;
+	u32 *pixels = Memory::allocateArray<u32>(MemoryTag::textures, count);
+	for (size_t i = 0; i < count; i++) {
+		u8 bgra[4];
+		if (fread(bgra, sizeof(bgra), 1, file) != 1) {
+			Memory::release(pixels);
+			fclose(file);
+			return nullptr;
+		}
+		pixels[i] = rgba(bgra[2], bgra[1], bgra[0], bgra[3]);
+	}
+
+	fclose(file);
+	return pixels;
+}
+
+// Returns how many pixels differ by more than the tolerance and marks them red
+// in `diff`, with the rest of the image dimmed
+u32 comparePixels(const u32 *pixels, const u32 *golden, size_t count, u32 tolerance, u32 *diff, u32 *maxDifference) {
+	u32 different = 0;
+	*maxDifference = 0;
+
+	for (size_t i = 0; i < count; i++) {
+		u32 pixelDifference = 0;
+		for (u32 channel = 0; channel < 4; channel++) {
+			const s32 a = (pixels[i] >> (channel * 8)) & 0xff;
+			const s32 b = (golden[i] >> (channel * 8)) & 0xff;
+			const u32 difference = (u32)(a > b ? a - b : b - a);
+			pixelDifference = difference > pixelDifference ? difference : pixelDifference;
+		}
+
+		*maxDifference = pixelDifference > *maxDifference ? pixelDifference : *maxDifference;
+		if (pixelDifference > tolerance) {
+			different++;
+			diff[i] = rgba(255, 0, 0, 255);
+		} else {
+			const u32 grey = (((golden[i] & 0xff) + ((golden[i] >> 8) & 0xff) + ((golden[i] >> 16) & 0xff)) / 3) / 4;
+			diff[i] = rgba(grey, grey, grey, 255);
+		}
+	}
+
+	return different;
+}
+
+void printUsage(const char *program) {
+	fprintf(
+		stderr,
+		"Usage: %s [options]\n"
+		"  --width <n>          framebuffer width (default %u)\n"
+		"  --height <n>         framebuffer height (default %u)\n"
+		"  --threads <n>        threads drawing tiles, including the main thread (default 4)\n"
+		"  --frames <n>         frames to draw for timing (default 1)\n"
+		"  --out <path>         write the last frame as a TGA\n"
+		"  --compare <path>     compare the last frame against a TGA written by --out\n"
+		"  --tolerance <n>      largest channel difference still counted as a match (default 0)\n"
+		"  --diff <path>        with --compare, write the differing pixels as a TGA\n"
+		"  --trace <path>       write the profiled zones as a Chrome trace\n"
+		"  --summary <path>     write each profiled zone's totals as CSV\n",
+		program,
+		screenWidth,
+		screenHeight
+	);
+}
+
+bool parseArguments(int argumentCount, char **arguments, RenderConfig *config) {
+	for (int i = 1; i < argumentCount; i++) {
+		const char *argument = arguments[i];
+		if (i + 1 == argumentCount) {
+			return false;
+		}
+		const char *value = arguments[++i];
+
+		bool valid = true;
+		if (strcmp(argument, "--width") == 0) {
+			config->width = (u32)strtoul(value, nullptr, 10);
+			valid = config->width > 0 && config->width <= 0xffff;
+		} else if (strcmp(argument, "--height") == 0) {
+			config->height = (u32)strtoul(value, nullptr, 10);
+			valid = config->height > 0 && config->height <= 0xffff;
+		} else if (strcmp(argument, "--threads") == 0) {
+			config->threads = (u32)strtoul(value, nullptr, 10);
+			valid = config->threads > 0 && config->threads <= SOFTWARE_THREAD_MAX;
+		} else if (strcmp(argument, "--frames") == 0) {
+			config->frames = (u32)strtoul(value, nullptr, 10);
+			valid = config->frames > 0;
+		} else if (strcmp(argument, "--tolerance") == 0) {
+			config->tolerance = (u32)strtoul(value, nullptr, 10);
+		} else if (strcmp(argument, "--out") == 0) {
+			config->outputPath = value;
+		} else if (strcmp(argument, "--compare") == 0) {
+			config->comparePath = value;
+		} else if (strcmp(argument, "--diff") == 0) {
+			config->diffPath = value;
+		} else if (strcmp(argument, "--trace") == 0) {
+			config->tracePath = value;
+		} else if (strcmp(argument, "--summary") == 0) {
+			config->summaryPath = value;
+		} else {
+			valid = false;
+		}
+
+		if (!valid) {
+			fprintf(stderr, "error: invalid value for %s: %s\n", argument, value);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+int main(int argumentCount, char **arguments) {
+	RenderConfig config;
+	if (!parseArguments(argumentCount, arguments, &config)) {
+		printUsage(arguments[0]);
+		return 1;
+	}
+
+	Profiler::initialise();
+
+	SoftwareRenderer *renderer = Memory::create<SoftwareRenderer>(MemoryTag::renderer);
+	renderer->initialise(config.width, config.height, config.threads);
+	setTextures(renderer);
+
+	Scene *scene = Memory::create<Scene>(MemoryTag::game);
+	buildScene(scene);
+
+	// The first frame also shades the starfield cache so it's timed apart
+	u64 firstFrameTicks = 0;
+	u64 totalTicks = 0;
+	u64 minTicks = (u64)-1;
+	for (u32 frame = 0; frame < config.frames; frame++) {
+		const u64 start = Profiler::now();
+
+		renderer->start();
+		renderer->drawStarfield();
+		renderer->drawSprites(scene->sprites.data, (u32)scene->sprites.length);
+		renderer->drawUI(scene->uiElements.data, (u32)scene->uiElements.length);
+		renderer->finish();
+
+		const u64 ticks = Profiler::now() - start;
+		if (frame == 0) {
+			firstFrameTicks = ticks;
+		} else {
+			totalTicks += ticks;
+			minTicks = ticks < minTicks ? ticks : minTicks;
+		}
+	}
+
+	// After the frames so the counter has had time to be measured against
+	const f64 ticksPerSecond = Profiler::ticksPerSecond();
+
+	printf(
+		"%ux%u, %u threads, %zu sprites, %zu UI elements\n",
+		config.width,
+		config.height,
+		config.threads,
+		scene->sprites.length,
+		scene->uiElements.length
+	);
+	printf("first frame  %.2fms\n", Profiler::ticksToMilliseconds(firstFrameTicks, ticksPerSecond));
+	if (config.frames > 1) {
+		printf(
+			"other frames %.2fms mean, %.2fms min\n",
+			Profiler::ticksToMilliseconds(totalTicks, ticksPerSecond) / (config.frames - 1),
+			Profiler::ticksToMilliseconds(minTicks, ticksPerSecond)
+		);
+	}
+
+	int exitCode = 0;
+	const u32 *pixels = renderer->getPixels();
+
+	if (config.outputPath != nullptr) {
+		if (!writeTga(config.outputPath, pixels, config.width, config.height)) {
+			fprintf(stderr, "%s: error: unable to write\n", config.outputPath);
+			exitCode = 1;
+		}
+	}
+
+	if (config.comparePath != nullptr) {
+		u32 goldenWidth = 0, goldenHeight = 0;
+		u32 *golden = readTga(config.comparePath, &goldenWidth, &goldenHeight);
+
+		if (golden == nullptr) {
+			fprintf(stderr, "%s: error: unable to read\n", config.comparePath);
+			exitCode = 1;
+		} else if (goldenWidth != config.width || goldenHeight != config.height) {
+			fprintf(stderr, "%s: error: is %ux%u, expected %ux%u\n", config.comparePath, goldenWidth, goldenHeight, config.width, config.height);
+			exitCode = 1;
+		} else {
+			const size_t count = (size_t)config.width * config.height;
+			u32 *diff = Memory::allocateArray<u32>(MemoryTag::textures, count);
+
+			u32 maxDifference;
+			const u32 different = comparePixels(pixels, golden, count, config.tolerance, diff, &maxDifference);
+			printf(
+				"compare      %u of %zu pixels differ by more than %u (largest difference %u)\n",
+				different,
+				count,
+				config.tolerance,
+				maxDifference
+			);
+
+			if (config.diffPath != nullptr && !writeTga(config.diffPath, diff, config.width, config.height)) {
+				fprintf(stderr, "%s: error: unable to write\n", config.diffPath);
+			}
+
+			exitCode = different > 0 ? 1 : exitCode;
+			Memory::release(diff);
+		}
+
+		Memory::release(golden);
+	}
+
+	// The workers are idle between frames so their zones can be read
+	if (config.tracePath != nullptr && !Profiler::exportChromeTrace(config.tracePath)) {
+		fprintf(stderr, "%s: error: unable to write\n", config.tracePath);
+		exitCode = 1;
+	}
+	if (config.summaryPath != nullptr && !Profiler::exportSummary(config.summaryPath)) {
+		fprintf(stderr, "%s: error: unable to write\n", config.summaryPath);
+		exitCode = 1;
+	}
+
+	Memory::destroy(scene);
+	Memory::destroy(renderer);
+	Profiler::shutdown();
+	return exitCode;
+}
\ No newline at end of file
@@ -0,0 +1,88 @@
+// Validates ship templates and compiles them into the binary cache the game
+// loads at startup. Each cache is written next to its source:
+//
+//     template_compiler assets/data/templates/ships/ship.txt assets/data/templates/ships/enemy_ship.txt
+//
+// Exits with 1 if any template failed to compile.
+
+#include <cstdio>
+#include <cstring>
+
+#include "common/ship_template.hpp"
+
+bool readFile(const char *path, char *buffer, size_t size, size_t *length) {
+	FILE *file = fopen(path, "rb");
+	if (file == nullptr) {
+		return false;
+	}
+
+	*length = fread(buffer, 1, size, file);
+	// One byte spare to tell a full buffer apart from a file that's too big
+	const bool succeeded = !ferror(file) && *length < size;
+	fclose(file);
+	return succeeded;
+}
+
+bool writeFile(const char *path, const void *data, size_t size) {
+	FILE *file = fopen(path, "wb");
+	if (file == nullptr) {
+		return false;
+	}
+
+	const bool succeeded = fwrite(data, 1, size, file) == size;
+	return fclose(file) == 0 && succeeded;
+}
+
+bool compile(const char *sourcePath) {
+	static char source[SHIP_TEMPLATE_SOURCE_MAX];
+	size_t sourceLength = 0;
+	if (!readFile(sourcePath, source, sizeof(source), &sourceLength)) {
+		fprintf(stderr, "%s: error: unable to read (or larger than %d bytes)\n", sourcePath, SHIP_TEMPLATE_SOURCE_MAX);
+		return false;
+	}
+
+	Ship ship;
+	ShipTemplateError error = {};
+	if (!ShipTemplate::parse(source, sourceLength, &ship, &error)) {
+		fprintf(stderr, "%s:%u: error: %s\n", sourcePath, error.line, error.message);
+		return false;
+	}
+
+	u8 cache[SHIP_TEMPLATE_CACHE_MAX];
+	const size_t cacheSize = ShipTemplate::writeCache(ship, ShipTemplate::hashSource(source, sourceLength), cache, sizeof(cache));
+	if (cacheSize == 0) {
+		fprintf(stderr, "%s: error: cache is larger than %d bytes\n", sourcePath, SHIP_TEMPLATE_CACHE_MAX);
+		return false;
+	}
+
+	// Swap the source extension for the cache one
+	char cachePath[512];
+	const char *extension = strrchr(sourcePath, '.');
+	const size_t stemLength = extension != nullptr ? (size_t)(extension - sourcePath) : strlen(sourcePath);
+	if (snprintf(cachePath, sizeof(cachePath), "%.*s%ls", (int)stemLength, sourcePath, SHIP_TEMPLATE_CACHE_EXTENSION) >= (int)sizeof(cachePath)) {
+		fprintf(stderr, "%s: error: path is too long\n", sourcePath);
+		return false;
+	}
+
+	if (!writeFile(cachePath, cache, cacheSize)) {
+		fprintf(stderr, "%s: error: unable to write\n", cachePath);
+		return false;
+	}
+
+	printf("%s -> %s (%zu bytes)\n", sourcePath, cachePath, cacheSize);
+	return true;
+}
+
+int main(int argumentCount, char **arguments) {
+	if (argumentCount < 2) {
+		fprintf(stderr, "Usage: %s <template.txt>...\n", arguments[0]);
+		return 1;
+	}
+
+	bool succeeded = true;
+	for (int i = 1; i < argumentCount; i++) {
+		succeeded &= compile(arguments[i]);
+	}
+
+	return succeeded ? 0 : 1;
+}
\ No newline at end of file
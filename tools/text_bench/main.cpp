@@ -0,0 +1,269 @@
+// Draws a screen laid out like the package menu's pickup screen with the
+// software renderer, for benchmarking text and checking the text run cache
+// keeps it from being laid out again every frame. Doesn't need Direct3D so it
+// also runs on Linux:
+//
+//     text_bench --frames 600 --packages 4 --changing 1 --threads 4
+//
+// `--changing` labels get new text every frame, like a clock or the debug
+// overlay, and the rest stay the same. Prints the cache's hits, misses and
+// evictions per frame and how long laying out and placing glyphs took against
+// drawing them. Exits with 1 if a frame after the first missed the cache for
+// anything other than the changing labels.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <wchar.h>
+
+#include "common/ui_element_buffer.hpp"
+#include "renderer/software_renderer.hpp"
+#include "types/core.hpp"
+#include "utils/memory.hpp"
+#include "utils/profiler.hpp"
+
+#define BENCH_PACKAGE_MAX 12
+#define BENCH_CHANGING_MAX 8
+
+struct BenchConfig {
+	u32 width = screenWidth;
+	u32 height = screenHeight;
+	u32 threads = 4;
+	u32 frames = 600;
+	u32 packages = 4;
+	u32 changing = 1;
+};
+
+struct BenchTotals {
+	u64 hits = 0;
+	u64 misses = 0;
+	u64 evictions = 0;
+	u64 glyphs = 0;
+	u64 layoutTicks = 0;
+	u64 drawTicks = 0;
+	u32 unexpectedMisses = 0;
+};
+
+const wchar_t *destinations[] = {
+	L"Port 7",
+	L"Sunset Beach",
+	L"Kepler Station",
+	L"Mars",
+	L"The Belt",
+	L"Titan Docks"
+};
+
+UITextData label(const wchar_t *text, f32 fontSize, f32 width, Vec2<f32> position) {
+	UITextData result = {};
+	result.text = text;
+	result.color = Rgba(1.0f, 1.0f, 1.0f, 1.0f);
+	result.font = L"consolas";
+	result.fontSize = fontSize;
+	result.width = width;
+	result.height = 30.0f;
+	result.position = position;
+	result.horizontalAlignment = UITextAlignment::start;
+	result.verticalAlignment = UITextAlignment::middle;
+	return result;
+}
+
+UIButtonData button(const wchar_t *text, Vec2<f32> position) {
+	UIButtonData result = {};
+	result.label.text = text;
+	result.label.font = L"consolas";
+	result.label.fontSize = 24.0f;
+	result.label.color = Rgba(1.0f, 1.0f, 1.0f, 1.0f);
+	result.color = Rgba(0.0f, 0.0f, 0.0f, 1.0f);
+	result.height = 70.0f;
+	result.width = 150.0f;
+	result.cornerRadius = 10.0f;
+	result.strokeColor = Rgba(0.62f, 0.62f, 0.62f, 1.0f);
+	result.strokeWidth = 5.0f;
+	result.position = position;
+	return result;
+}
+
+// Same text, sizes and positions as `PackageMenu::drawPackages`
+void buildScreen(const BenchConfig &config, u32 frame, UIElementBuffer *uiElements) {
+	uiElements->clear();
+
+	uiElements->push(label(L"Sunset Beach", 40.0f, 200.0f, Vec2<f32>(screenWidth / 2.0f - 100.0f, 20.0f)));
+
+	const f32 packageWidth = 200.0f;
+	const f32 packagePadding = 80.0f;
+	const f32 totalWidth = config.packages * packageWidth + (config.packages - 1) * packagePadding;
+	const f32 startX = screenWidth / 2.0f - totalWidth / 2.0f;
+
+	for (u32 i = 0; i < config.packages; i++) {
+		const f32 x = startX + i * (packageWidth + packagePadding);
+		f32 y = screenHeight / 2.0f - 20.0f;
+		wchar_t text[100];
+
+		swprintf(text, 100, L"Package %u", i + 1);
+		uiElements->push(label(text, 40.0f, 200.0f, Vec2<f32>(x, y)));
+
+		y += 50.0f;
+		swprintf(text, 100, L"Weight: %f", 12.5f + i * 3.25f);
+		uiElements->push(label(text, 20.0f, 200.0f, Vec2<f32>(x, y)));
+
+		y += 30.0f;
+		swprintf(text, 100, L"Destination: %ls", destinations[i % (sizeof(destinations) / sizeof(destinations[0]))]);
+		uiElements->push(label(text, 20.0f, 250.0f, Vec2<f32>(x, y)));
+
+		y += 30.0f;
+		swprintf(text, 100, L"Value: %u", 250 + i * 125);
+		uiElements->push(label(text, 20.0f, 200.0f, Vec2<f32>(x, y)));
+
+		y += 30.0f;
+		uiElements->push(button(L"SELECT", Vec2<f32>(x, y)));
+	}
+
+	uiElements->push(button(L"RETURN", Vec2<f32>(screenWidth / 2.0f - 75.0f, screenHeight - 90.0f)));
+
+	for (u32 i = 0; i < config.changing; i++) {
+		wchar_t text[100];
+		swprintf(text, 100, L"Clock %u: day %u, %02u:%02u", i + 1, frame / 1440, frame / 60 % 24, frame % 60);
+		uiElements->push(label(text, 8.0f, 200.0f, Vec2<f32>(10.0f, 10.0f + i * 12.0f)));
+	}
+}
+
+void printUsage(const char *program) {
+	fprintf(
+		stderr,
+		"Usage: %s [options]\n"
+		"  --width <n>          framebuffer width (default %u)\n"
+		"  --height <n>         framebuffer height (default %u)\n"
+		"  --threads <n>        threads drawing tiles, including the main thread (default 4)\n"
+		"  --frames <n>         frames to draw (default 600)\n"
+		"  --packages <n>       packages on the screen, up to %u (default 4)\n"
+		"  --changing <n>       labels with new text every frame, up to %u (default 1)\n",
+		program,
+		screenWidth,
+		screenHeight,
+		BENCH_PACKAGE_MAX,
+		BENCH_CHANGING_MAX
+	);
+}
+
+bool parseArguments(int argumentCount, char **arguments, BenchConfig *config) {
+	for (int i = 1; i < argumentCount; i++) {
+		const char *argument = arguments[i];
+		if (i + 1 == argumentCount) {
+			return false;
+		}
+		const char *value = arguments[++i];
+
+		bool valid = true;
+		if (strcmp(argument, "--width") == 0) {
+			config->width = (u32)strtoul(value, nullptr, 10);
+			valid = config->width > 0 && config->width <= 0xffff;
+		} else if (strcmp(argument, "--height") == 0) {
+			config->height = (u32)strtoul(value, nullptr, 10);
+			valid = config->height > 0 && config->height <= 0xffff;
+		} else if (strcmp(argument, "--threads") == 0) {
+			config->threads = (u32)strtoul(value, nullptr, 10);
+			valid = config->threads > 0 && config->threads <= SOFTWARE_THREAD_MAX;
+		} else if (strcmp(argument, "--frames") == 0) {
+			config->frames = (u32)strtoul(value, nullptr, 10);
+			valid = config->frames > 1;
+		} else if (strcmp(argument, "--packages") == 0) {
+			config->packages = (u32)strtoul(value, nullptr, 10);
+			valid = config->packages > 0 && config->packages <= BENCH_PACKAGE_MAX;
+		} else if (strcmp(argument, "--changing") == 0) {
+			config->changing = (u32)strtoul(value, nullptr, 10);
+			valid = config->changing <= BENCH_CHANGING_MAX;
+		} else {
+			valid = false;
+		}
+
+		if (!valid) {
+			fprintf(stderr, "error: invalid value for %s: %s\n", argument, value);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+int main(int argumentCount, char **arguments) {
+	BenchConfig config;
+	if (!parseArguments(argumentCount, arguments, &config)) {
+		printUsage(arguments[0]);
+		return 1;
+	}
+
+	Profiler::initialise();
+
+	SoftwareRenderer *renderer = Memory::create<SoftwareRenderer>(MemoryTag::renderer);
+	renderer->initialise(config.width, config.height, config.threads);
+
+	UIElementBuffer *uiElements = Memory::create<UIElementBuffer>(MemoryTag::game);
+	u32 textCount = 0;
+
+	// The first frame fills the cache so it's counted apart
+	TextRunCacheStats firstFrame = {};
+	BenchTotals totals;
+	for (u32 frame = 0; frame < config.frames; frame++) {
+		buildScreen(config, frame, uiElements);
+
+		const u64 start = Profiler::now();
+		renderer->start();
+		renderer->drawUI(uiElements->data, (u32)uiElements->length);
+		const u64 placed = Profiler::now();
+		renderer->finish();
+		const u64 end = Profiler::now();
+
+		const TextRunCacheStats &stats = renderer->getTextRunStats();
+		if (frame == 0) {
+			firstFrame = stats;
+			textCount = stats.hits + stats.misses;
+			continue;
+		}
+
+		totals.hits += stats.hits;
+		totals.misses += stats.misses;
+		totals.evictions += stats.evictions;
+		totals.glyphs += renderer->getGlyphQuadCount();
+		totals.layoutTicks += placed - start;
+		totals.drawTicks += end - placed;
+		totals.unexpectedMisses += stats.misses > config.changing;
+	}
+
+	// After the frames so the counter has had time to be measured against
+	const f64 ticksPerSecond = Profiler::ticksPerSecond();
+	const f64 frames = config.frames - 1;
+
+	printf(
+		"%ux%u, %u threads, %u packages, %u text runs, %u changing\n",
+		config.width,
+		config.height,
+		config.threads,
+		config.packages,
+		textCount,
+		config.changing
+	);
+	printf("first frame  %u hits, %u misses, %u evictions\n", firstFrame.hits, firstFrame.misses, firstFrame.evictions);
+	printf(
+		"other frames %.2f hits, %.2f misses, %.2f evictions, %.1f%% hit rate, %.0f glyphs\n",
+		totals.hits / frames,
+		totals.misses / frames,
+		totals.evictions / frames,
+		totals.hits + totals.misses > 0 ? 100.0 * totals.hits / (totals.hits + totals.misses) : 0.0,
+		totals.glyphs / frames
+	);
+	printf(
+		"             %.1fus laying out and placing glyphs, %.2fms drawing\n",
+		Profiler::ticksToMilliseconds(totals.layoutTicks, ticksPerSecond) * 1000.0 / frames,
+		Profiler::ticksToMilliseconds(totals.drawTicks, ticksPerSecond) / frames
+	);
+
+	int exitCode = 0;
+	if (totals.unexpectedMisses > 0) {
+		fprintf(stderr, "error: %u frames missed the cache for text that didn't change\n", totals.unexpectedMisses);
+		exitCode = 1;
+	}
+
+	Memory::destroy(uiElements);
+	Memory::destroy(renderer);
+	return exitCode;
+}
\ No newline at end of file
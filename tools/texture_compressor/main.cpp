@@ -0,0 +1,422 @@
+// Compresses textures to BC1, BC3 or BC7 with a full mip chain, written next
+// to the source image as a .btex the sprite loader uploads without decoding:
+//
+//     texture_compressor [--format auto] [--mips 0] [--threads 4] [--min-psnr 30] [path...]
+//
+// PNGs and baseline JPEGs are read. With no paths every texture that exists is
+// compressed, along with the atlas pages, skipping textures that are packed
+// into a page. `auto` picks BC1 for opaque images and BC3 for ones with
+// alpha, BC7 is worth asking for on opaque images with smooth gradients that
+// band in BC1. `--mips 0` goes all the way down to 1x1.
+//
+// Mips of atlas pages blend neighbouring sprites together once they're a
+// few levels down, pack with more `--padding` if that shows.
+//
+// The top mip is decoded again afterwards and compared with the source, for
+// colour that's premultiplied by alpha so the colour of transparent pixels
+// doesn't count. Exits with 1 if either comes in under `--min-psnr` dB.
+
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "common/asset_definitions.hpp"
+#include "common/compressed_texture.hpp"
+#include "common/sprite_atlas.hpp"
+#include "types/core.hpp"
+#include "types/image.hpp"
+#include "utils/block_compression.hpp"
+#include "utils/jpeg.hpp"
+#include "utils/memory.hpp"
+#include "utils/png.hpp"
+#include "utils/profiler.hpp"
+#include "utils/thread.hpp"
+
+#define COMPRESS_IMAGE_MAX 64
+#define COMPRESS_THREAD_MAX 64
+#define COMPRESS_PATH_MAX 512
+
+struct CompressorOptions {
+	// _length picks per image
+	BlockFormat format = BlockFormat::_length;
+	u32 mips = 0;
+	u32 threads = 4;
+	f64 minPsnr = 30.0;
+	const char *images[COMPRESS_IMAGE_MAX];
+	u32 imageCount = 0;
+};
+
+struct EncodeLevel {
+	const u32 *pixels;
+	u32 width;
+	u32 height;
+	u8 *output;
+	// Block rows of the levels before this one
+	u32 firstRow;
+	u32 rowCount;
+};
+
+// Threads take block rows in turn until they run out, small mips included
+struct EncodeJob {
+	BlockFormat format;
+	EncodeLevel levels[COMPRESSED_TEXTURE_MIP_MAX];
+	u32 levelCount;
+	u32 rowCount;
+	std::atomic<u32> next;
+};
+
+u8 *readFile(const char *path, size_t *size) {
+	FILE *file = fopen(path, "rb");
+	if (file == nullptr) {
+		return nullptr;
+	}
+
+	fseek(file, 0, SEEK_END);
+	const long length = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	u8 *data = nullptr;
+	if (length > 0) {
+		data = Memory::allocateArray<u8>(MemoryTag::textures, (size_t)length);
+		if (fread(data, 1, (size_t)length, file) != (size_t)length) {
+			Memory::release(data);
+			data = nullptr;
+		}
+	}
+
+	fclose(file);
+	*size = (size_t)length;
+	return data;
+}
+
+bool writeFile(const char *path, const void *data, size_t size) {
+	FILE *file = fopen(path, "wb");
+	if (file == nullptr) {
+		return false;
+	}
+
+	const bool succeeded = fwrite(data, 1, size, file) == size;
+	return fclose(file) == 0 && succeeded;
+}
+
+bool decodeImage(const u8 *data, size_t size, Image *image) {
+	if (size >= 2 && data[0] == 0xff && data[1] == 0xd8) {
+		return Jpeg::decode(data, size, image);
+	}
+	return Png::decode(data, size, image);
+}
+
+void outputPath(const char *path, char *output, size_t outputSize) {
+	const char *extension = strrchr(path, '.');
+	const char *slash = strrchr(path, '/');
+	const size_t length = extension != nullptr && (slash == nullptr || extension > slash) ? (size_t)(extension - path) : strlen(path);
+	snprintf(output, outputSize, "%.*s" COMPRESSED_TEXTURE_EXTENSION, (int)length, path);
+}
+
+void encodeWorker(void *argument) {
+	EncodeJob *job = (EncodeJob*)argument;
+
+	u32 level = 0;
+	for (u32 row = job->next++; row < job->rowCount; row = job->next++) {
+		while (row >= job->levels[level].firstRow + job->levels[level].rowCount) {
+			level++;
+		}
+
+		const EncodeLevel &encodeLevel = job->levels[level];
+		const u32 levelRow = row - encodeLevel.firstRow;
+		BlockCompression::encodeRows(job->format, encodeLevel.pixels, encodeLevel.width, encodeLevel.height, levelRow, levelRow + 1, encodeLevel.output);
+	}
+}
+
+f64 psnr(f64 squaredError, u64 samples) {
+	return squaredError > 0.0 ? 10.0 * log10(255.0 * 255.0 * samples / squaredError) : INFINITY;
+}
+
+// Compares the source with what the GPU will sample from the top mip
+void measure(const Image &image, const u32 *decoded, u32 decodedWidth, f64 *colorPsnr, f64 *alphaPsnr) {
+	f64 colorError = 0.0;
+	f64 alphaError = 0.0;
+	for (u32 y = 0; y < image.height; y++) {
+		for (u32 x = 0; x < image.width; x++) {
+			const u32 source = image.pixels[(size_t)y * image.width + x];
+			const u32 result = decoded[(size_t)y * decodedWidth + x];
+			const f64 sourceAlpha = BlockCompression::channel(source, 3);
+			const f64 resultAlpha = BlockCompression::channel(result, 3);
+
+			for (u32 c = 0; c < 3; c++) {
+				const f64 difference = (BlockCompression::channel(source, c) * sourceAlpha - BlockCompression::channel(result, c) * resultAlpha) / 255.0;
+				colorError += difference * difference;
+			}
+			alphaError += (sourceAlpha - resultAlpha) * (sourceAlpha - resultAlpha);
+		}
+	}
+
+	const u64 pixelCount = (u64)image.width * image.height;
+	*colorPsnr = psnr(colorError, pixelCount * 3);
+	*alphaPsnr = psnr(alphaError, pixelCount);
+}
+
+bool compressImage(const CompressorOptions &options, const char *path) {
+	size_t size = 0;
+	u8 *data = readFile(path, &size);
+	if (data == nullptr) {
+		fprintf(stderr, "%s: error: unable to read\n", path);
+		return false;
+	}
+
+	Image image = {};
+	const bool decoded = decodeImage(data, size, &image);
+	Memory::release(data);
+	if (!decoded || image.width > 0xfffc || image.height > 0xfffc) {
+		fprintf(stderr, "%s: error: not an 8-bit PNG or baseline JPEG\n", path);
+		Memory::release(image.pixels);
+		return false;
+	}
+
+	bool hasAlpha = false;
+	for (size_t i = 0; i < (size_t)image.width * image.height && !hasAlpha; i++) {
+		hasAlpha = BlockCompression::channel(image.pixels[i], 3) != 255;
+	}
+	const BlockFormat format = options.format != BlockFormat::_length ? options.format : (hasAlpha ? BlockFormat::bc3 : BlockFormat::bc1);
+
+	CompressedTextureHeader header = {};
+	header.magic = COMPRESSED_TEXTURE_MAGIC;
+	header.version = COMPRESSED_TEXTURE_VERSION;
+	header.format = (u8)format;
+	header.width = (u16)((image.width + 3) & ~3u);
+	header.height = (u16)((image.height + 3) & ~3u);
+	header.imageWidth = (u16)image.width;
+	header.imageHeight = (u16)image.height;
+
+	const u32 fullMipCount = CompressedTexture::fullMipCount(header.width, header.height);
+	header.mipCount = (u8)(options.mips > 0 && options.mips < fullMipCount ? options.mips : fullMipCount);
+	header.dataSize = (u32)CompressedTexture::dataSize(format, header.width, header.height, header.mipCount);
+
+	const u64 start = Profiler::now();
+
+	// Blocks hanging over the edge would be filled in the same way, but the
+	// smaller mips need whole blocks to come from the image
+	u32 *mips[COMPRESSED_TEXTURE_MIP_MAX] = {};
+	mips[0] = Memory::allocateArray<u32>(MemoryTag::textures, (size_t)header.width * header.height);
+	for (u32 y = 0; y < header.height; y++) {
+		const u32 sourceY = y < image.height ? y : image.height - 1;
+		for (u32 x = 0; x < header.width; x++) {
+			const u32 sourceX = x < image.width ? x : image.width - 1;
+			mips[0][(size_t)y * header.width + x] = image.pixels[(size_t)sourceY * image.width + sourceX];
+		}
+	}
+
+	for (u32 level = 1; level < header.mipCount; level++) {
+		const u32 width = CompressedTexture::mipSize(header.width, level);
+		const u32 height = CompressedTexture::mipSize(header.height, level);
+		mips[level] = Memory::allocateArray<u32>(MemoryTag::textures, (size_t)width * height);
+		BlockCompression::downsample(
+			mips[level - 1],
+			CompressedTexture::mipSize(header.width, level - 1),
+			CompressedTexture::mipSize(header.height, level - 1),
+			mips[level]
+		);
+	}
+
+	const size_t fileSize = sizeof(header) + header.dataSize;
+	u8 *file = Memory::allocateArray<u8>(MemoryTag::textures, fileSize);
+	memcpy(file, &header, sizeof(header));
+
+	EncodeJob *job = Memory::create<EncodeJob>(MemoryTag::textures);
+	job->format = format;
+	job->levelCount = header.mipCount;
+	job->rowCount = 0;
+	job->next = 0;
+
+	u8 *output = file + sizeof(header);
+	for (u32 level = 0; level < header.mipCount; level++) {
+		EncodeLevel &encodeLevel = job->levels[level];
+		encodeLevel.pixels = mips[level];
+		encodeLevel.width = CompressedTexture::mipSize(header.width, level);
+		encodeLevel.height = CompressedTexture::mipSize(header.height, level);
+		encodeLevel.output = output;
+		encodeLevel.firstRow = job->rowCount;
+		encodeLevel.rowCount = (encodeLevel.height + 3) / 4;
+
+		job->rowCount += encodeLevel.rowCount;
+		output += BlockCompression::levelSize(format, encodeLevel.width, encodeLevel.height);
+	}
+
+	// The main thread takes rows as well
+	Thread threads[COMPRESS_THREAD_MAX];
+	for (u32 i = 1; i < options.threads; i++) {
+		threads[i].start(encodeWorker, job);
+	}
+	encodeWorker(job);
+	for (u32 i = 1; i < options.threads; i++) {
+		threads[i].join();
+	}
+
+	const f64 milliseconds = Profiler::ticksToMilliseconds(Profiler::now() - start, Profiler::ticksPerSecond());
+
+	// Reuses the top mip's pixels, they're not needed any more
+	BlockCompression::decodeLevel(format, file + sizeof(header), header.width, header.height, mips[0]);
+	f64 colorPsnr;
+	f64 alphaPsnr;
+	measure(image, mips[0], header.width, &colorPsnr, &alphaPsnr);
+
+	char compressedPath[COMPRESS_PATH_MAX];
+	outputPath(path, compressedPath, sizeof(compressedPath));
+	bool succeeded = writeFile(compressedPath, file, fileSize);
+	if (!succeeded) {
+		fprintf(stderr, "%s: error: unable to write\n", compressedPath);
+	}
+
+	if (succeeded) {
+		char alpha[32] = "opaque";
+		if (hasAlpha) {
+			snprintf(alpha, sizeof(alpha), "alpha %.2fdB", alphaPsnr);
+		}
+
+		const f64 rgbaSize = (f64)image.width * image.height * 4.0;
+		printf(
+			"%s -> %s: %s %ux%u, %u mips, %.2fMB (%.1fx smaller than RGBA8 without mips) in %.1fms, colour %.2fdB, %s\n",
+			path,
+			compressedPath,
+			blockFormatNames[(size_t)format],
+			image.width,
+			image.height,
+			(u32)header.mipCount,
+			fileSize / (1024.0 * 1024.0),
+			rgbaSize / fileSize,
+			milliseconds,
+			colorPsnr,
+			alpha
+		);
+
+		if (colorPsnr < options.minPsnr || alphaPsnr < options.minPsnr) {
+			fprintf(stderr, "%s: error: under %.2fdB\n", path, options.minPsnr);
+			succeeded = false;
+		}
+	}
+
+	Memory::destroy(job);
+	Memory::release(file);
+	for (u32 *mip : mips) {
+		Memory::release(mip);
+	}
+	Memory::release(image.pixels);
+	return succeeded;
+}
+
+// Every texture that isn't in the atlas, then the atlas pages
+bool compressAssets(const CompressorOptions &options) {
+	SpriteAtlasManifest manifest = {};
+	size_t manifestSize = 0;
+	u8 *manifestData = readFile(ASSET_PATH SPRITE_ATLAS_DIRECTORY SPRITE_ATLAS_MANIFEST_NAME, &manifestSize);
+	if (manifestData != nullptr && !SpriteAtlas::readManifest(manifestData, manifestSize, &manifest)) {
+		printf("skipped the atlas, its manifest is out of date\n");
+		manifest = {};
+	}
+	Memory::release(manifestData);
+
+	bool succeeded = true;
+	u32 count = 0;
+	for (size_t i = 0; i < (size_t)TextureAssetId::_length; i++) {
+		if (manifest.entries[i].page != SPRITE_ATLAS_NO_PAGE) {
+			continue;
+		}
+
+		char path[COMPRESS_PATH_MAX];
+		snprintf(path, sizeof(path), "%ls", textureNames[i]);
+		FILE *file = fopen(path, "rb");
+		if (file == nullptr) {
+			printf("skipped %s, %s not found\n", textureAssetNames[i], path);
+			continue;
+		}
+		fclose(file);
+
+		succeeded = compressImage(options, path) && succeeded;
+		count++;
+	}
+
+	for (u32 page = 0; page < manifest.pageCount; page++) {
+		char path[COMPRESS_PATH_MAX];
+		snprintf(path, sizeof(path), ASSET_PATH SPRITE_ATLAS_DIRECTORY SPRITE_ATLAS_PAGE_NAME, page);
+		succeeded = compressImage(options, path) && succeeded;
+		count++;
+	}
+
+	if (count == 0) {
+		fprintf(stderr, "error: nothing to compress\n");
+		return false;
+	}
+	return succeeded;
+}
+
+bool parseArguments(int argumentCount, char **arguments, CompressorOptions *options) {
+	for (int i = 1; i < argumentCount; i++) {
+		const char *argument = arguments[i];
+		if (strncmp(argument, "--", 2) != 0) {
+			if (options->imageCount == COMPRESS_IMAGE_MAX) {
+				return false;
+			}
+			options->images[options->imageCount++] = argument;
+			continue;
+		}
+
+		if (i + 1 == argumentCount) {
+			return false;
+		}
+		const char *value = arguments[++i];
+		const u32 number = (u32)strtoul(value, nullptr, 10);
+
+		bool valid = true;
+		if (strcmp(argument, "--format") == 0) {
+			options->format = BlockFormat::_length;
+			for (size_t format = 0; format < (size_t)BlockFormat::_length; format++) {
+				if (strcmp(value, blockFormatNames[format]) == 0) {
+					options->format = (BlockFormat)format;
+				}
+			}
+			valid = options->format != BlockFormat::_length || strcmp(value, "auto") == 0;
+		} else if (strcmp(argument, "--mips") == 0) {
+			options->mips = number;
+			valid = number <= COMPRESSED_TEXTURE_MIP_MAX;
+		} else if (strcmp(argument, "--threads") == 0) {
+			options->threads = number;
+			valid = number > 0 && number <= COMPRESS_THREAD_MAX;
+		} else if (strcmp(argument, "--min-psnr") == 0) {
+			options->minPsnr = strtod(value, nullptr);
+		} else {
+			valid = false;
+		}
+
+		if (!valid) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+int main(int argumentCount, char **arguments) {
+	CompressorOptions options;
+	if (!parseArguments(argumentCount, arguments, &options)) {
+		fprintf(
+			stderr,
+			"Usage: %s [--format auto|bc1|bc3|bc7] [--mips n] [--threads n] [--min-psnr dB] [path...]\n",
+			arguments[0]
+		);
+		return 1;
+	}
+
+	Profiler::initialise();
+
+	bool succeeded = true;
+	if (options.imageCount == 0) {
+		succeeded = compressAssets(options);
+	}
+	for (u32 i = 0; i < options.imageCount; i++) {
+		succeeded = compressImage(options, options.images[i]) && succeeded;
+	}
+
+	return succeeded ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,522 @@
+// Benchmarks the RIFF parser the sound manager reads WAVs with against the
+// seek and read per chunk header it used to do:
+//
+//     wav_bench [--generate 2000] [--rounds 3] [--dir wav_bench_corpus] [path...]
+//
+// Writes `--generate` small WAVs covering every format that's accepted and a
+// few that aren't (odd sized chunks, extensible formats, truncated data,
+// ADPCM, missing chunks), then finds the samples in each of them `--rounds`
+// times both ways. Paths passed in are timed as well and have their formats
+// printed. Exits with 1 if the parser gets any generated file wrong.
+//
+// The old way goes through unbuffered stdio so every 4 byte read is a call
+// into the OS, like the ReadFiles it made, and skips chunks the same way,
+// without the pad byte after odd sized ones.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(_WIN32)
+	#include <direct.h>
+#else
+	#include <sys/stat.h>
+#endif
+
+#include "types/core.hpp"
+#include "utils/mapped_file.hpp"
+#include "utils/memory.hpp"
+#include "utils/profiler.hpp"
+#include "utils/riff.hpp"
+
+#define BENCH_PATH_MAX 512
+#define BENCH_FILE_MAX 10000
+#define BENCH_INPUT_MAX 64
+// Big enough for the largest generated file
+#define BENCH_WAVE_MAX (64 * KILOBYTE)
+
+struct BenchOptions {
+	u32 generate = 2000;
+	u32 rounds = 3;
+	const char *directory = "wav_bench_corpus";
+	const char *inputs[BENCH_INPUT_MAX];
+	u32 inputCount = 0;
+};
+
+// What the parser should make of a generated file
+struct Expected {
+	WaveError error;
+	SampleEncoding encoding;
+	u16 channels;
+	u16 bitsPerSample;
+	u32 frameCount;
+};
+
+struct BenchTotals {
+	u64 ticks = 0;
+	// Reads and seeks
+	u64 calls = 0;
+	u32 found = 0;
+};
+
+// Everything little endian, as RIFF is
+struct WaveWriter {
+	u8 *data;
+	u32 length;
+
+	void u16le(u16 value) {
+		this->data[this->length++] = (u8)value;
+		this->data[this->length++] = (u8)(value >> 8);
+	}
+
+	void u32le(u32 value) {
+		this->u16le((u16)value);
+		this->u16le((u16)(value >> 16));
+	}
+
+	void chunk(u32 id, u32 size) {
+		this->u32le(id);
+		this->u32le(size);
+	}
+
+	void bytes(u8 value, u32 count) {
+		memset(this->data + this->length, value, count);
+		this->length += count;
+	}
+
+	void format(u16 tag, u16 channels, u32 sampleRate, u16 bitsPerSample, u16 blockAlign) {
+		this->u16le(tag);
+		this->u16le(channels);
+		this->u32le(sampleRate);
+		this->u32le(sampleRate * blockAlign);
+		this->u16le(blockAlign);
+		this->u16le(bitsPerSample);
+	}
+
+	// WAVEFORMATEXTENSIBLE with a KSDATAFORMAT_SUBTYPE of `subFormat`
+	void extensible(u16 subFormat, u16 channels, u32 sampleRate, u16 bitsPerSample) {
+		this->chunk(RIFF_ID_FORMAT, WAVE_FORMAT_EXTENSIBLE_SIZE);
+		this->format(WAVE_FORMAT_TAG_EXTENSIBLE, channels, sampleRate, bitsPerSample, channels * bitsPerSample / 8);
+		this->u16le(WAVE_FORMAT_EXTENSIBLE_SIZE - WAVE_FORMAT_SIZE);
+		this->u16le(bitsPerSample);
+		this->u32le(channels == 6 ? 0x3f : 0x3);
+		this->u16le(subFormat);
+		memcpy(this->data + this->length, Riff::subFormatSuffix, sizeof(Riff::subFormatSuffix));
+		this->length += sizeof(Riff::subFormatSuffix);
+	}
+};
+
+void makeDirectory(const char *path) {
+#if defined(_WIN32)
+	_mkdir(path);
+#else
+	mkdir(path, 0755);
+#endif
+}
+
+bool writeFile(const char *path, const void *data, size_t size) {
+	FILE *file = fopen(path, "wb");
+	if (file == nullptr) {
+		return false;
+	}
+
+	const bool succeeded = fwrite(data, 1, size, file) == size;
+	return fclose(file) == 0 && succeeded;
+}
+
+// One of ten kinds of file in turn, each a different length
+u32 synthesise(u32 index, u8 *data, Expected *expected) {
+	WaveWriter writer = { data, 0 };
+	writer.chunk(RIFF_ID_RIFF, 0);
+	writer.u32le(RIFF_ID_WAVE);
+
+	const u32 frames = 500 + index * 37 % 3000;
+	*expected = {};
+	expected->encoding = SampleEncoding::pcm;
+	expected->frameCount = frames;
+
+	u16 channels = 2;
+	u16 bits = 16;
+	switch (index % 10) {
+		case 0:
+			// What most editors write, an odd sized LIST chunk ahead of the data
+			writer.chunk(RIFF_ID_FORMAT, 16);
+			writer.format(WAVE_FORMAT_TAG_PCM, 2, 44100, 16, 4);
+			writer.chunk(RIFF_FOURCC('L', 'I', 'S', 'T'), 13);
+			writer.bytes('i', 13);
+			writer.bytes(0, 1);
+			break;
+		case 1:
+			channels = 1;
+			bits = 8;
+			writer.chunk(RIFF_ID_FORMAT, WAVE_FORMAT_SIZE);
+			writer.format(WAVE_FORMAT_TAG_PCM, 1, 22050, 8, 1);
+			writer.u16le(0);
+			writer.chunk(RIFF_FOURCC('J', 'U', 'N', 'K'), 28);
+			writer.bytes(0, 28);
+			break;
+		case 2:
+			bits = 24;
+			writer.chunk(RIFF_ID_FORMAT, 16);
+			writer.format(WAVE_FORMAT_TAG_PCM, 2, 48000, 24, 6);
+			break;
+		case 3:
+			bits = 32;
+			expected->encoding = SampleEncoding::ieeeFloat;
+			writer.chunk(RIFF_ID_FORMAT, WAVE_FORMAT_SIZE);
+			writer.format(WAVE_FORMAT_TAG_FLOAT, 2, 48000, 32, 8);
+			writer.u16le(0);
+			writer.chunk(RIFF_FOURCC('f', 'a', 'c', 't'), 4);
+			writer.u32le(frames);
+			break;
+		case 4:
+			channels = 6;
+			writer.extensible(WAVE_FORMAT_TAG_PCM, 6, 48000, 16);
+			break;
+		case 5:
+			bits = 32;
+			expected->encoding = SampleEncoding::ieeeFloat;
+			writer.extensible(WAVE_FORMAT_TAG_FLOAT, 2, 44100, 32);
+			break;
+		case 6:
+			// Cut off part way through a frame, only whole ones are kept
+			writer.chunk(RIFF_ID_FORMAT, 16);
+			writer.format(WAVE_FORMAT_TAG_PCM, 2, 44100, 16, 4);
+			writer.chunk(RIFF_ID_DATA, frames * 4);
+			writer.bytes((u8)index, frames * 2 + 3);
+			expected->frameCount = (frames * 2 + 3) / 4;
+			expected->channels = 2;
+			expected->bitsPerSample = 16;
+			return writer.length;
+		case 7:
+			writer.chunk(RIFF_ID_FORMAT, 16);
+			writer.format(0x0002, 2, 44100, 4, 2048);
+			expected->error = WaveError::unsupportedFormat;
+			break;
+		case 8:
+			writer.chunk(RIFF_ID_FORMAT, 16);
+			writer.format(WAVE_FORMAT_TAG_PCM, 2, 44100, 16, 4);
+			writer.chunk(RIFF_FOURCC('L', 'I', 'S', 'T'), 8);
+			writer.bytes('i', 8);
+			expected->error = WaveError::missingData;
+			return writer.length;
+		case 9:
+			writer.chunk(RIFF_ID_FORMAT, 16);
+			writer.format(WAVE_FORMAT_TAG_PCM, 2, 44100, 16, 3);
+			expected->error = WaveError::badFormat;
+			break;
+	}
+
+	expected->channels = channels;
+	expected->bitsPerSample = bits;
+
+	const u32 size = frames * channels * bits / 8;
+	writer.chunk(RIFF_ID_DATA, size);
+	writer.bytes((u8)index, size);
+	if (size % 2 == 1) {
+		writer.bytes(0, 1);
+	}
+
+	// The RIFF chunk's size, everything after its header
+	const u32 riffSize = writer.length - RIFF_CHUNK_HEADER_SIZE;
+	memcpy(data + 4, &riffSize, sizeof(riffSize));
+	return writer.length;
+}
+
+bool matches(const Expected &expected, WaveError error, const Wave &wave) {
+	if (error != expected.error) {
+		return false;
+	}
+	return
+		error != WaveError::none || (
+			wave.format.encoding == expected.encoding &&
+			wave.format.channels == expected.channels &&
+			wave.format.bitsPerSample == expected.bitsPerSample &&
+			wave.frameCount == expected.frameCount &&
+			wave.size == expected.frameCount * wave.format.blockAlign
+		);
+}
+
+// findWaveDataChunk as it was: back to the start, then a read for every
+// chunk's id and size and a seek over its data
+bool legacyFindChunk(FILE *file, u32 fourcc, u32 *chunkSize, u32 *chunkPosition, u64 *calls) {
+	(*calls)++;
+	if (fseek(file, 0, SEEK_SET) != 0) {
+		return false;
+	}
+
+	u32 offset = 0;
+	while (true) {
+		u32 chunkType;
+		u32 dataSize;
+		*calls += 2;
+		if (fread(&chunkType, sizeof(u32), 1, file) != 1 || fread(&dataSize, sizeof(u32), 1, file) != 1) {
+			return false;
+		}
+
+		if (chunkType == RIFF_ID_RIFF) {
+			u32 fileType;
+			(*calls)++;
+			if (fread(&fileType, sizeof(u32), 1, file) != 1) {
+				return false;
+			}
+			dataSize = 4;
+		} else {
+			(*calls)++;
+			if (fseek(file, dataSize, SEEK_CUR) != 0) {
+				return false;
+			}
+		}
+
+		offset += 8;
+		if (chunkType == fourcc) {
+			*chunkSize = dataSize;
+			*chunkPosition = offset;
+			return true;
+		}
+		offset += dataSize;
+	}
+}
+
+// getWaveInfo as it was, up to knowing where the samples are
+bool legacyFindSamples(const char *path, u32 *sampleSize, u64 *calls) {
+	FILE *file = fopen(path, "rb");
+	if (file == nullptr) {
+		return false;
+	}
+	setvbuf(file, nullptr, _IONBF, 0);
+
+	u32 chunkSize;
+	u32 chunkPosition;
+	u32 fileType = 0;
+	u8 format[WAVE_FORMAT_EXTENSIBLE_SIZE];
+	bool found = legacyFindChunk(file, RIFF_ID_RIFF, &chunkSize, &chunkPosition, calls);
+	if (found) {
+		*calls += 2;
+		found = fseek(file, chunkPosition, SEEK_SET) == 0 && fread(&fileType, sizeof(u32), 1, file) == 1 && fileType == RIFF_ID_WAVE;
+	}
+	if (found) {
+		found = legacyFindChunk(file, RIFF_ID_FORMAT, &chunkSize, &chunkPosition, calls);
+	}
+	if (found) {
+		*calls += 2;
+		const size_t size = chunkSize < sizeof(format) ? chunkSize : sizeof(format);
+		found = fseek(file, chunkPosition, SEEK_SET) == 0 && fread(format, 1, size, file) == size;
+	}
+	if (found) {
+		found = legacyFindChunk(file, RIFF_ID_DATA, sampleSize, &chunkPosition, calls);
+	}
+
+	fclose(file);
+	return found;
+}
+
+bool mappedFindSamples(const char *path, Wave *wave, WaveError *error) {
+	MappedFile file;
+	if (!file.open(path)) {
+		*error = WaveError::notRiff;
+		return false;
+	}
+
+	*error = Riff::readWave(file.data, file.size, wave);
+	file.close();
+	return *error == WaveError::none;
+}
+
+bool parseArguments(int argumentCount, char **arguments, BenchOptions *options) {
+	for (int i = 1; i < argumentCount; i++) {
+		const char *argument = arguments[i];
+		if (strncmp(argument, "--", 2) != 0) {
+			if (options->inputCount == BENCH_INPUT_MAX) {
+				return false;
+			}
+			options->inputs[options->inputCount++] = argument;
+			continue;
+		}
+
+		if (i + 1 == argumentCount) {
+			return false;
+		}
+		const char *value = arguments[++i];
+		const u32 number = (u32)strtoul(value, nullptr, 10);
+
+		bool valid = true;
+		if (strcmp(argument, "--generate") == 0) {
+			options->generate = number;
+			valid = number <= BENCH_FILE_MAX;
+		} else if (strcmp(argument, "--rounds") == 0) {
+			options->rounds = number;
+			valid = number > 0;
+		} else if (strcmp(argument, "--dir") == 0) {
+			options->directory = value;
+		} else {
+			valid = false;
+		}
+
+		if (!valid) {
+			return false;
+		}
+	}
+
+	return options->generate > 0 || options->inputCount > 0;
+}
+
+void printTotals(const char *name, const BenchTotals &totals, u32 fileCount, f64 ticksPerSecond) {
+	const f64 milliseconds = Profiler::ticksToMilliseconds(totals.ticks, ticksPerSecond);
+	printf(
+		"  %-12s %9.2fms, %6.2fus a file, %5.1f reads and seeks a file, samples found in %u\n",
+		name,
+		milliseconds,
+		milliseconds * 1e3 / fileCount,
+		(f64)totals.calls / fileCount,
+		totals.found
+	);
+}
+
+int main(int argumentCount, char **arguments) {
+	BenchOptions options;
+	if (!parseArguments(argumentCount, arguments, &options)) {
+		fprintf(stderr, "Usage: %s [--generate n] [--rounds n] [--dir path] [path...]\n", arguments[0]);
+		return 1;
+	}
+
+	Profiler::initialise();
+
+	const u32 fileCount = options.generate + options.inputCount;
+	char (*paths)[BENCH_PATH_MAX] = (char(*)[BENCH_PATH_MAX])Memory::allocateArray<char>(MemoryTag::sound, (size_t)fileCount * BENCH_PATH_MAX);
+	Expected *expected = Memory::allocateArray<Expected>(MemoryTag::sound, options.generate > 0 ? options.generate : 1);
+	u8 *wave = Memory::allocateArray<u8>(MemoryTag::sound, BENCH_WAVE_MAX);
+
+	u64 generatedBytes = 0;
+	if (options.generate > 0) {
+		makeDirectory(options.directory);
+	}
+	for (u32 i = 0; i < options.generate; i++) {
+		snprintf(paths[i], BENCH_PATH_MAX, "%s/%05u.wav", options.directory, i);
+		const u32 size = synthesise(i, wave, &expected[i]);
+		if (!writeFile(paths[i], wave, size)) {
+			fprintf(stderr, "Couldn't write %s\n", paths[i]);
+			return 1;
+		}
+		generatedBytes += size;
+	}
+	if (options.generate > 0) {
+		printf("Generated %u files (%.1fKB) in %s\n", options.generate, generatedBytes / 1024.0, options.directory);
+	}
+
+	for (u32 i = 0; i < options.inputCount; i++) {
+		snprintf(paths[options.generate + i], BENCH_PATH_MAX, "%s", options.inputs[i]);
+
+		Wave parsed;
+		WaveError error;
+		if (!mappedFindSamples(options.inputs[i], &parsed, &error)) {
+			printf("%s: %s\n", options.inputs[i], waveErrorNames[(size_t)error]);
+			continue;
+		}
+		printf(
+			"%s: %s %u-bit, %u channels, %uHz, %u frames (%.2fs)\n",
+			options.inputs[i],
+			parsed.format.encoding == SampleEncoding::pcm ? "PCM" : "float",
+			parsed.format.bitsPerSample,
+			parsed.format.channels,
+			parsed.format.sampleRate,
+			parsed.frameCount,
+			(f64)parsed.frameCount / parsed.format.sampleRate
+		);
+	}
+
+	// Checked once up front so the timed rounds only time
+	u32 wrong = 0;
+	u32 legacyWrong = 0;
+	for (u32 i = 0; i < options.generate; i++) {
+		Wave parsed;
+		WaveError error;
+		mappedFindSamples(paths[i], &parsed, &error);
+		if (!matches(expected[i], error, parsed)) {
+			fprintf(stderr, "%s: expected %s, got %s\n", paths[i], waveErrorNames[(size_t)expected[i].error], waveErrorNames[(size_t)error]);
+			wrong++;
+		}
+
+		u64 calls = 0;
+		u32 sampleSize = 0;
+		const bool found = legacyFindSamples(paths[i], &sampleSize, &calls);
+		legacyWrong += found != (expected[i].error == WaveError::none) ? 1 : 0;
+	}
+
+	// Already mapped and paged in, just the parsing
+	MappedFile *files = Memory::allocateArray<MappedFile>(MemoryTag::sound, fileCount);
+	for (u32 i = 0; i < fileCount; i++) {
+		files[i] = {};
+		files[i].open(paths[i]);
+		files[i].prefault(0, files[i].size);
+	}
+
+	BenchTotals legacy;
+	BenchTotals mapped;
+	BenchTotals parsed;
+	for (u32 round = 0; round < options.rounds; round++) {
+		BenchTotals roundLegacy;
+		u64 start = Profiler::now();
+		for (u32 i = 0; i < fileCount; i++) {
+			u32 sampleSize;
+			roundLegacy.found += legacyFindSamples(paths[i], &sampleSize, &roundLegacy.calls) ? 1 : 0;
+		}
+		roundLegacy.ticks = Profiler::now() - start;
+
+		BenchTotals roundMapped;
+		start = Profiler::now();
+		for (u32 i = 0; i < fileCount; i++) {
+			Wave parsed;
+			WaveError error;
+			roundMapped.found += mappedFindSamples(paths[i], &parsed, &error) ? 1 : 0;
+		}
+		roundMapped.ticks = Profiler::now() - start;
+
+		BenchTotals roundParsed;
+		start = Profiler::now();
+		for (u32 i = 0; i < fileCount; i++) {
+			Wave parsedWave;
+			roundParsed.found += Riff::readWave(files[i].data, files[i].size, &parsedWave) == WaveError::none ? 1 : 0;
+		}
+		roundParsed.ticks = Profiler::now() - start;
+
+		// The best round, the others are the same work with colder caches or
+		// more going on in the background
+		if (round == 0 || roundLegacy.ticks < legacy.ticks) {
+			legacy = roundLegacy;
+		}
+		if (round == 0 || roundMapped.ticks < mapped.ticks) {
+			mapped = roundMapped;
+		}
+		if (round == 0 || roundParsed.ticks < parsed.ticks) {
+			parsed = roundParsed;
+		}
+	}
+
+	// Measured against the wall clock since `initialise`, more accurate the
+	// longer that's been
+	const f64 ticksPerSecond = Profiler::ticksPerSecond();
+	printf("Found the samples in %u files, best of %u rounds:\n", fileCount, options.rounds);
+	printTotals("seek + read", legacy, fileCount, ticksPerSecond);
+	printTotals("mapped", mapped, fileCount, ticksPerSecond);
+	printTotals("parse only", parsed, fileCount, ticksPerSecond);
+	printf("  mapped %.1fx faster, the rest is opening and mapping\n", mapped.ticks > 0 ? (f64)legacy.ticks / mapped.ticks : 0.0);
+	if (options.generate > 0) {
+		printf(
+			"Generated files read correctly: %u of %u mapped, %u of %u the old way\n",
+			options.generate - wrong,
+			options.generate,
+			options.generate - legacyWrong,
+			options.generate
+		);
+	}
+
+	for (u32 i = 0; i < fileCount; i++) {
+		files[i].close();
+	}
+	Memory::release(files);
+	Memory::release(wave);
+	Memory::release(expected);
+	Memory::release(paths);
+	return wrong == 0 ? 0 : 1;
+}
\ No newline at end of file